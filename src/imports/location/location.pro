@@ -23,6 +23,7 @@ HEADERS += \
            qdeclarativepolylinemapitem_p.h \
            qdeclarativeroutemapitem_p.h \
            qgeomapitemgeometry_p.h \
+           qgeomapitembatch_p.h \
            qdeclarativegeomapcopyrightsnotice_p.h \
            qdeclarativegeomapgesturearea_p.h \
            error_messages.h \
@@ -47,6 +48,7 @@ SOURCES += \
            qdeclarativepolylinemapitem.cpp \
            qdeclarativeroutemapitem.cpp \
            qgeomapitemgeometry.cpp \
+           qgeomapitembatch.cpp \
            qdeclarativegeomapcopyrightsnotice.cpp \
            qdeclarativegeomapgesturearea.cpp \
            error_messages.cpp \
@@ -56,8 +58,6 @@ include(declarativeplaces/declarativeplaces.pri)
 
 load(qml_plugin)
 
-LIBS_PRIVATE += -L$$MODULE_BASE_OUTDIR/lib -lpoly2tri$$qtPlatformTargetSuffix()
-
 OTHER_FILES += \
     plugin.json \
     qmldir
@@ -35,6 +35,7 @@
 #include "qdeclarativegeomapquickitem_p.h"
 #include "qdeclarativepolygonmapitem_p.h"
 #include "qgeocameracapabilities_p.h"
+#include "qgeopolygontessellator_p.h"
 #include "qgeoprojection_p.h"
 
 #include <cmath>
@@ -45,9 +46,6 @@
 
 #include "qdoublevector2d_p.h"
 
-/* poly2tri triangulator includes */
-#include "../../3rdparty/poly2tri/common/shapes.h"
-#include "../../3rdparty/poly2tri/sweep/cdt.h"
 
 QT_BEGIN_NAMESPACE
 
@@ -140,6 +138,10 @@ void QGeoMapCircleGeometry::updateScreenPointsInvert(const QGeoMap &map)
     if (!screenDirty_)
         return;
 
+    // covers the whole map, so it is rebuilt on every change
+    clipped_ = true;
+    coveredRect_ = QRectF();
+
     if (map.width() == 0 || map.height() == 0) {
         clear();
         return;
@@ -182,54 +184,13 @@ void QGeoMapCircleGeometry::updateScreenPointsInvert(const QGeoMap &map)
 
     screenOutline_ = ppiBorder;
 
-    std::vector<p2t::Point*> borderPts;
-    borderPts.reserve(4);
-
-    std::vector<p2t::Point*> curPts;
-    curPts.reserve(ppi.elementCount());
-    for (int i = 0; i < ppi.elementCount(); ++i) {
-        const QPainterPath::Element e = ppi.elementAt(i);
-        if (e.isMoveTo() || i == ppi.elementCount() - 1
-                || (qAbs(e.x - curPts.front()->x) < 0.1
-                    && qAbs(e.y - curPts.front()->y) < 0.1)) {
-            if (curPts.size() > 2) {
-                for (int j = 0; j < 4; ++j) {
-                    const QPainterPath::Element e2 = ppiBorder.elementAt(j);
-                    borderPts.push_back(new p2t::Point(e2.x, e2.y));
-                }
-                p2t::CDT *cdt = new p2t::CDT(borderPts);
-                cdt->AddHole(curPts);
-                cdt->Triangulate();
-                std::vector<p2t::Triangle*> tris = cdt->GetTriangles();
-                screenVertices_.reserve(screenVertices_.size() + int(tris.size()));
-                for (size_t i = 0; i < tris.size(); ++i) {
-                    p2t::Triangle *t = tris.at(i);
-                    for (int j = 0; j < 3; ++j) {
-                        p2t::Point *p = t->GetPoint(j);
-                        screenVertices_ << QPointF(p->x, p->y);
-                    }
-                }
-                delete cdt;
-            }
-            curPts.clear();
-            curPts.reserve(ppi.elementCount() - i);
-            curPts.push_back(new p2t::Point(e.x, e.y));
-        } else if (e.isLineTo()) {
-            curPts.push_back(new p2t::Point(e.x, e.y));
-        } else {
-            qWarning("Unhandled element type in circle painterpath");
-        }
-    }
-
-    if (curPts.size() > 0) {
-        qDeleteAll(curPts.begin(), curPts.end());
-        curPts.clear();
-    }
-
-    if (borderPts.size() > 0) {
-        qDeleteAll(borderPts.begin(), borderPts.end());
-        borderPts.clear();
-    }
+    // the circle is a hole in the square of the world
+    QGeoPolygonTessellator *tessellator = polygonTessellator();
+    tessellator->clear();
+    tessellator->addPath(ppiBorder);
+    tessellator->addPath(ppi);
+    tessellator->tessellate();
+    setScreenTriangles(*tessellator, QPointF());
 
     screenBounds_ = ppiBorder.boundingRect();
 
@@ -438,8 +399,11 @@ QSGNode *QDeclarativeCircleMapItem::updateMapItemPaintNode(QSGNode *oldNode, Upd
 
     MapPolygonNode *node = static_cast<MapPolygonNode *>(oldNode);
 
-    if (!node)
+    // the geometry may have gone to the map's batches so far
+    if (!node) {
         node = new MapPolygonNode();
+        dirtyMaterial_ = true;
+    }
 
     //TODO: update only material
     if (geometry_.isScreenDirty() || borderGeometry_.isScreenDirty() || dirtyMaterial_) {
@@ -453,6 +417,23 @@ QSGNode *QDeclarativeCircleMapItem::updateMapItemPaintNode(QSGNode *oldNode, Upd
     return node;
 }
 
+/*!
+    \internal
+*/
+bool QDeclarativeCircleMapItem::updateMapItemBatch(QGeoMapItemBatchNode *batch, bool force)
+{
+    if (force || geometry_.isScreenDirty() || borderGeometry_.isScreenDirty() || dirtyMaterial_) {
+        batch->setItemPart(batchId(), 0, GL_TRIANGLES, color_, geometry_);
+        batch->setItemPart(batchId(), 1, GL_TRIANGLE_STRIP, border_.color(), borderGeometry_);
+        geometry_.setPreserveGeometry(false);
+        borderGeometry_.setPreserveGeometry(false);
+        geometry_.markClean();
+        borderGeometry_.markClean();
+        dirtyMaterial_ = false;
+    }
+    return true;
+}
+
 /*!
     \internal
 */
@@ -509,31 +490,42 @@ void QDeclarativeCircleMapItem::afterViewportChanged(const QGeoMapViewportChange
     if (event.mapSize.width() <= 0 || event.mapSize.height() <= 0)
         return;
 
-    // if the scene is tilted, we must regenerate our geometry every frame
-    if (map()->cameraCapabilities().supportsTilting()
-            && (event.cameraData.tilt() > 0.1
-                || event.cameraData.tilt() < -0.1)) {
-        geometry_.markSourceDirty();
-        borderGeometry_.markSourceDirty();
-    }
-
-    // if the scene is rolled, we must regen too
-    if (map()->cameraCapabilities().supportsRolling()
-            && (event.cameraData.roll() > 0.1
-                || event.cameraData.roll() < -0.1)) {
-        geometry_.markSourceDirty();
-        borderGeometry_.markSourceDirty();
-    }
-
-    // otherwise, only regen on rotate, resize and zoom
-    if (event.bearingChanged || event.mapSizeChanged || event.zoomLevelChanged) {
+    const bool drawBorder = border_.color() != Qt::transparent && border_.width() > 0;
+
+    // circles around a pole change their shape as they move
+    QGeoMapViewportChangeEvent::ChangeType changeType = event.changeType;
+    if (event.centerChanged && crossEarthPole(center_, radius_))
+        changeType = QGeoMapViewportChangeEvent::ArbitraryChange;
+
+    switch (changeType) {
+    case QGeoMapViewportChangeEvent::NoChange:
+    case QGeoMapViewportChangeEvent::Translation:
+        // panning only moves the item, until the viewport leaves the area
+        // the screen geometry was clipped to
+        if (!geometry_.isScreenDirty() && !borderGeometry_.isScreenDirty()
+                && geometry_.coversViewport(geometry_.viewport(*map()))
+                && (!drawBorder || borderGeometry_.coversViewport(
+                        borderGeometry_.viewport(*map(), border_.width())))) {
+            polish();
+            return;
+        }
+        break;
+    case QGeoMapViewportChangeEvent::IntegerZoomChange:
+        // the source points were thinned out for the old zoom level, which
+        // is still fine enough after zooming out
+        if (event.zoomLevelDelta < 0
+                && !geometry_.isSourceDirty() && !borderGeometry_.isSourceDirty()) {
+            const qreal factor = std::pow(2.0, qRound(event.zoomLevelDelta));
+            if (geometry_.scaleSourcePoints(factor) && borderGeometry_.scaleSourcePoints(factor))
+                break;
+        }
         geometry_.markSourceDirty();
         borderGeometry_.markSourceDirty();
-    }
-
-    if (event.centerChanged && crossEarthPole(center_, radius_)) {
+        break;
+    default:
         geometry_.markSourceDirty();
         borderGeometry_.markSourceDirty();
+        break;
     }
 
     geometry_.markScreenDirty();
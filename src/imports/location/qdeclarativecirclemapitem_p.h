@@ -89,6 +89,7 @@ Q_SIGNALS:
 
 protected:
     void geometryChanged(const QRectF &newGeometry, const QRectF &oldGeometry) Q_DECL_OVERRIDE;
+    bool updateMapItemBatch(QGeoMapItemBatchNode *batch, bool force) Q_DECL_OVERRIDE;
 
 protected Q_SLOTS:
     void updateMapItemAssumeDirty();
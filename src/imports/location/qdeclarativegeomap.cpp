@@ -45,6 +45,7 @@
 #include "qgeocameradata_p.h"
 #include "qgeocameracapabilities_p.h"
 #include "qgeomapcontroller_p.h"
+#include "qgeoprojection_p.h"
 #include <cmath>
 
 #include <QtPositioning/QGeoCoordinate>
@@ -184,7 +185,11 @@ QDeclarativeGeoMap::QDeclarativeGeoMap(QQuickItem *parent)
         componentCompleted_(false),
         mappingManagerInitialized_(false),
         touchTimer_(-1),
-        map_(0)
+        map_(0),
+        mercatorPerPixel_(0.0),
+        mapItemBatching_(false),
+        mapItemBatch_(0),
+        frameStatistics_(new QGeoMapFrameStatisticsCollector)
 {
     QLOC_TRACE0;
     setAcceptHoverEvents(false);
@@ -209,6 +214,12 @@ QDeclarativeGeoMap::~QDeclarativeGeoMap()
             mapItems_.at(i).data()->setMap(0,0);
     }
     mapItems_.clear();
+    mapItemIndex_.clear();
+    activeMapItems_.clear();
+
+    // the scene graph deletes the node later on
+    if (mapItemBatch_)
+        mapItemBatch_->detach();
 
     delete copyrightsWPtr_.data();
     copyrightsWPtr_.clear();
@@ -404,15 +415,26 @@ QSGNode *QDeclarativeGeoMap::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeDa
     }
 
     QSGSimpleRectNode *root = static_cast<QSGSimpleRectNode *>(oldNode);
-    if (!root)
+    if (!root) {
         root = new QSGSimpleRectNode(boundingRect(), QColor::fromRgbF(0.9, 0.9, 0.9));
-    else
+        mapItemBatch_ = new QGeoMapItemBatchNode(&mapItemBatch_, frameStatistics_);
+        root->appendChildNode(mapItemBatch_);
+    } else {
         root->setRect(boundingRect());
+    }
 
-    QSGNode *content = root->childCount() ? root->firstChild() : 0;
+    // the map content goes below the batched map items
+    QSGNode *content = root->firstChild() != mapItemBatch_ ? root->firstChild() : 0;
     content = map_->updateSceneGraph(content, window());
-    if (content && root->childCount() == 0)
-        root->appendChildNode(content);
+    if (content && !content->parent())
+        root->prependChildNode(content);
+
+    if (mapItemBatch_) {
+        foreach (quint64 id, releasedBatchItems_)
+            mapItemBatch_->removeItem(id);
+        mapItemBatch_->setOpacity(mapItemOpacity());
+    }
+    releasedBatchItems_.clear();
 
     return root;
 }
@@ -477,6 +499,8 @@ void QDeclarativeGeoMap::mappingManagerInitialized()
             this,
             SLOT(update()));
     connect(map_, SIGNAL(minimumZoomChanged()), this, SIGNAL(minimumZoomLevelChanged()));
+    connect(map_, SIGNAL(cameraDataChanged(QGeoCameraData)),
+            this, SLOT(mapCameraDataChanged(QGeoCameraData)));
     connect(map_->mapController(),
             SIGNAL(centerChanged(QGeoCoordinate)),
             this,
@@ -515,8 +539,10 @@ void QDeclarativeGeoMap::mappingManagerInitialized()
     // Any map items that were added before the plugin was ready
     // need to have setMap called again
     foreach (const QPointer<QDeclarativeGeoMapItemBase> &item, mapItems_) {
-        if (item)
+        if (item) {
             item.data()->setMap(this, map_);
+            mapItemIndex_.insertUnbounded(item.data());
+        }
     }
 }
 
@@ -865,8 +891,10 @@ void QDeclarativeGeoMap::addMapItem(QDeclarativeGeoMapItemBase *item)
         return;
     updateMutex_.lock();
     item->setParentItem(this);
-    if (map_)
+    if (map_) {
         item->setMap(this, map_);
+        mapItemIndex_.insertUnbounded(item);
+    }
     mapItems_.append(item);
     emit mapItemsChanged();
     updateMutex_.unlock();
@@ -893,6 +921,76 @@ QList<QObject *> QDeclarativeGeoMap::mapItems()
     return ret;
 }
 
+/*!
+    \qmlproperty bool QtLocation::Map::mapItemBatching
+
+    This property holds whether the map draws its \l MapPolyline, \l MapRoute,
+    \l MapPolygon and \l MapCircle items through shared batches.
+
+    Items with the same color are merged into one vertex buffer and drawn
+    together, which keeps the number of draw calls low for maps showing
+    thousands of such items. When an item changes, only its own part of the
+    buffer is rewritten.
+
+    Batched items are drawn above the map but below all other map items, and
+    overlapping batched items of different colors are not necessarily
+    stacked in declaration order. Items with an opacity other than 1, a
+    \c z other than 0, or a scale or rotation are not batched and are drawn
+    as usual.
+
+    The default value is false.
+*/
+void QDeclarativeGeoMap::setMapItemBatching(bool batching)
+{
+    if (mapItemBatching_ == batching)
+        return;
+
+    mapItemBatching_ = batching;
+
+    // every item has to move in or out of the batches
+    foreach (const QPointer<QDeclarativeGeoMapItemBase> &item, mapItems_) {
+        if (item)
+            item.data()->update();
+    }
+    update();
+    emit mapItemBatchingChanged();
+}
+
+bool QDeclarativeGeoMap::mapItemBatching() const
+{
+    return mapItemBatching_;
+}
+
+/*!
+    \internal
+
+    Returns what the map items contributed to the last rendered frame: the
+    number of batches, of batched and unbatched items, and of the draw calls
+    they needed. Can be called from any thread.
+*/
+QGeoMapFrameStatistics QDeclarativeGeoMap::frameStatistics() const
+{
+    return frameStatistics_->statistics();
+}
+
+/*!
+    \internal
+
+    Returns the frame statistics as a map, for tests and tools written in QML.
+*/
+QVariantMap QDeclarativeGeoMap::frameStatisticsMap() const
+{
+    const QGeoMapFrameStatistics statistics = frameStatistics();
+    QVariantMap map;
+    map.insert(QStringLiteral("batches"), statistics.batches);
+    map.insert(QStringLiteral("batchedItems"), statistics.batchedItems);
+    map.insert(QStringLiteral("unbatchedItems"), statistics.unbatchedItems);
+    map.insert(QStringLiteral("drawCalls"), statistics.drawCalls);
+    map.insert(QStringLiteral("vertices"), statistics.vertices);
+    map.insert(QStringLiteral("uploadedVertices"), statistics.uploadedVertices);
+    return map;
+}
+
 /*!
     \qmlmethod void QtLocation::Map::removeMapItem(MapItem item)
 
@@ -913,6 +1011,8 @@ void QDeclarativeGeoMap::removeMapItem(QDeclarativeGeoMapItemBase *ptr)
     updateMutex_.lock();
     item.data()->setParentItem(0);
     item.data()->setMap(0, 0);
+    mapItemIndex_.remove(ptr);
+    activeMapItems_.remove(ptr);
     // these can be optimized for perf, as we already check the 'contains' above
     mapItems_.removeOne(item);
     emit mapItemsChanged();
@@ -939,6 +1039,8 @@ void QDeclarativeGeoMap::clearMapItems()
         }
     }
     mapItems_.clear();
+    mapItemIndex_.clear();
+    activeMapItems_.clear();
     emit mapItemsChanged();
     updateMutex_.unlock();
 }
@@ -1108,10 +1210,11 @@ void QDeclarativeGeoMap::fitViewportToMapItemsRefine(bool refine)
             }
         }
 
-        topLeftX = item->position().x();
-        topLeftY = item->position().y();
-        bottomRightX = topLeftX + item->width();
-        bottomRightY = topLeftY + item->height();
+        const QRectF itemRect = mapItemScreenRect(item);
+        topLeftX = itemRect.left();
+        topLeftY = itemRect.top();
+        bottomRightX = itemRect.right();
+        bottomRightY = itemRect.bottom();
 
         if (itemCount == 0) {
             minX = topLeftX;
@@ -1162,6 +1265,163 @@ void QDeclarativeGeoMap::fitViewportToMapItemsRefine(bool refine)
         fitViewportToMapItemsRefine(false);
 }
 
+/*!
+    \internal
+
+    Brings the screen to mercator mapping up to date with the camera. Returns
+    false if the view is tilted or rotated, where screen rectangles do not map
+    to mercator rectangles and the item index cannot be used.
+*/
+bool QDeclarativeGeoMap::updateMercatorTransform()
+{
+    if (!map_ || width() <= 0 || height() <= 0)
+        return false;
+
+    const QGeoCameraData cameraData = map_->cameraData();
+    if (cameraData.tilt() != 0.0 || cameraData.bearing() != 0.0 || cameraData.roll() != 0.0)
+        return false;
+
+    const QSizeF mapSize(width(), height());
+    if (mercatorPerPixel_ > 0.0 && cameraData == transformCameraData_ && mapSize == transformMapSize_)
+        return true;
+
+    const QDoubleVector2D center(width() / 2.0, height() / 2.0);
+    const double step = qMax(1.0, width() / 4.0);
+    const QGeoCoordinate centerCoordinate = map_->screenPositionToCoordinate(center, false);
+    const QGeoCoordinate stepCoordinate =
+            map_->screenPositionToCoordinate(center + QDoubleVector2D(step, 0.0), false);
+    if (!centerCoordinate.isValid() || !stepCoordinate.isValid())
+        return false;
+
+    mercatorCenter_ = QGeoProjection::coordToMercator(centerCoordinate);
+    double dx = QGeoProjection::coordToMercator(stepCoordinate).x() - mercatorCenter_.x();
+    dx -= std::floor(dx);
+
+    transformCameraData_ = cameraData;
+    transformMapSize_ = mapSize;
+    mercatorPerPixel_ = dx / step;
+    return mercatorPerPixel_ > 0.0 && qIsFinite(mercatorPerPixel_);
+}
+
+/*!
+    \internal
+
+    Called when \a item has moved or changed size on screen, so its bounds in
+    the item index follow it.
+*/
+void QDeclarativeGeoMap::updateMapItemBounds(QDeclarativeGeoMapItemBase *item)
+{
+    if (!mapItemIndex_.contains(item))
+        return;
+
+    if (!updateMercatorTransform()) {
+        mapItemIndex_.insertUnbounded(item);
+        return;
+    }
+
+    const double s = mercatorPerPixel_;
+    const QRectF bounds(mercatorCenter_.x() + (item->x() - width() / 2.0) * s,
+                        mercatorCenter_.y() + (item->y() - height() / 2.0) * s,
+                        item->width() * s,
+                        item->height() * s);
+    mapItemIndex_.insert(item, bounds);
+}
+
+/*!
+    \internal
+
+    Returns where \a item is on screen for the current camera. Items away
+    from the viewport do not follow the camera, so they are placed from the
+    item index instead of their own position.
+*/
+QRectF QDeclarativeGeoMap::mapItemScreenRect(QDeclarativeGeoMapItemBase *item)
+{
+    if (activeMapItems_.contains(item) || !mapItemIndex_.isBounded(item)
+            || !updateMercatorTransform())
+        return QRectF(item->position(), QSizeF(item->width(), item->height()));
+
+    QRectF bounds = mapItemIndex_.bounds(item);
+
+    // use the copy of the world closest to the viewport
+    const double offset = bounds.center().x() - mercatorCenter_.x();
+    bounds.translate(-std::floor(offset + 0.5), 0.0);
+
+    const double s = mercatorPerPixel_;
+    return QRectF(width() / 2.0 + (bounds.left() - mercatorCenter_.x()) / s,
+                  height() / 2.0 + (bounds.top() - mercatorCenter_.y()) / s,
+                  bounds.width() / s,
+                  bounds.height() / s);
+}
+
+/*!
+    \internal
+
+    Map items fade out when zooming out below level 3.
+*/
+qreal QDeclarativeGeoMap::mapItemOpacity() const
+{
+    if (zoomLevel() > 3.0)
+        return 1.0;
+    else if (zoomLevel() > 2.0)
+        return zoomLevel() - 2.0;
+    else
+        return 0.0;
+}
+
+/*!
+    \internal
+
+    Queues the batched geometry of the item with \a id for removal the next
+    time the scene graph is synchronized.
+*/
+void QDeclarativeGeoMap::releaseBatchedMapItem(quint64 id)
+{
+    releasedBatchItems_.insert(id);
+    update();
+}
+
+/*!
+    \internal
+
+    Forwards camera changes to the map items. Only the items whose bounds come
+    within half a viewport of the visible area are updated, plus the ones that
+    were updated last time, so that items leaving the viewport are moved off
+    screen before they stop following the camera.
+*/
+void QDeclarativeGeoMap::mapCameraDataChanged(const QGeoCameraData &cameraData)
+{
+    const QSizeF mapSize(width(), height());
+    const bool sizeChanged = mapSize != lastMapSize_;
+    lastMapSize_ = mapSize;
+
+    QSet<QDeclarativeGeoMapItemBase *> active;
+    if (!sizeChanged && updateMercatorTransform()) {
+        const double s = mercatorPerPixel_;
+        const QRectF viewport(mercatorCenter_.x() - width() * s,
+                              mercatorCenter_.y() - height() * s,
+                              2.0 * width() * s,
+                              2.0 * height() * s);
+        const QVector<QObject *> nearby = mapItemIndex_.query(viewport);
+        active.reserve(nearby.size());
+        foreach (QObject *item, nearby)
+            active.insert(static_cast<QDeclarativeGeoMapItemBase *>(item));
+    } else {
+        foreach (const QPointer<QDeclarativeGeoMapItemBase> &item, mapItems_) {
+            if (item)
+                active.insert(item.data());
+        }
+    }
+
+    QSet<QDeclarativeGeoMapItemBase *> dispatch = activeMapItems_;
+    dispatch.unite(active);
+    activeMapItems_ = active;
+
+    foreach (QDeclarativeGeoMapItemBase *item, dispatch) {
+        if (mapItemIndex_.contains(item))
+            item->baseCameraDataChanged(cameraData);
+    }
+}
+
 #include "moc_qdeclarativegeomap_p.cpp"
 
 QT_END_NAMESPACE
@@ -63,6 +63,8 @@
 
 #include "qgeocameradata_p.h"
 #include "qgeomap_p.h"
+#include "qgeomapitemindex_p.h"
+#include "qgeomapitembatch_p.h"
 #include "qdeclarativegeomaptype_p.h"
 
 QT_BEGIN_NAMESPACE
@@ -97,6 +99,7 @@ class QDeclarativeGeoMap : public QQuickItem
     Q_PROPERTY(QQmlListProperty<QDeclarativeGeoMapType> supportedMapTypes READ supportedMapTypes NOTIFY supportedMapTypesChanged)
     Q_PROPERTY(QGeoCoordinate center READ center WRITE setCenter NOTIFY centerChanged)
     Q_PROPERTY(QList<QObject *> mapItems READ mapItems NOTIFY mapItemsChanged)
+    Q_PROPERTY(bool mapItemBatching READ mapItemBatching WRITE setMapItemBatching NOTIFY mapItemBatchingChanged)
     Q_INTERFACES(QQmlParserStatus)
 
 public:
@@ -136,6 +139,12 @@ public:
     Q_INVOKABLE void clearMapItems();
     QList<QObject *> mapItems();
 
+    void setMapItemBatching(bool batching);
+    bool mapItemBatching() const;
+
+    QGeoMapFrameStatistics frameStatistics() const;
+    Q_INVOKABLE QVariantMap frameStatisticsMap() const;
+
     Q_INVOKABLE QGeoCoordinate toCoordinate(const QPointF &screenPosition) const;
     Q_INVOKABLE QPointF toScreenPosition(const QGeoCoordinate &coordinate) const;
 
@@ -169,6 +178,7 @@ Q_SIGNALS:
     void minimumZoomLevelChanged();
     void maximumZoomLevelChanged();
     void mapItemsChanged();
+    void mapItemBatchingChanged();
 
 private Q_SLOTS:
     void updateMapDisplay(const QRectF &target);
@@ -177,11 +187,17 @@ private Q_SLOTS:
     void pluginReady();
     void onMapChildrenChanged();
     void onMinimumZoomLevelChanged();
+    void mapCameraDataChanged(const QGeoCameraData &cameraData);
 
 private:
     void setupMapView(QDeclarativeGeoMapItemView *view);
     void populateMap();
     void fitViewportToMapItemsRefine(bool refine);
+    bool updateMercatorTransform();
+    void updateMapItemBounds(QDeclarativeGeoMapItemBase *item);
+    QRectF mapItemScreenRect(QDeclarativeGeoMapItemBase *item);
+    qreal mapItemOpacity() const;
+    void releaseBatchedMapItem(quint64 id);
 
     QDeclarativeGeoServiceProvider *plugin_;
     QGeoServiceProvider *serviceProvider_;
@@ -207,8 +223,27 @@ private:
 
     QList<QPointer<QDeclarativeGeoMapItemBase> > mapItems_;
 
+    // viewport changes only go to the items near the viewport
+    QGeoMapItemIndex mapItemIndex_;
+    QSet<QDeclarativeGeoMapItemBase *> activeMapItems_;
+    QSizeF lastMapSize_;
+
+    // maps screen positions to mercator for the camera it was computed for
+    QGeoCameraData transformCameraData_;
+    QSizeF transformMapSize_;
+    QDoubleVector2D mercatorCenter_;
+    double mercatorPerPixel_;
+
+    // the batch node lives in the scene graph and is only touched while it
+    // is synchronized; items dropped in between are queued up for it
+    bool mapItemBatching_;
+    QGeoMapItemBatchNode *mapItemBatch_;
+    QSet<quint64> releasedBatchItems_;
+    QSharedPointer<QGeoMapFrameStatisticsCollector> frameStatistics_;
+
     QMutex updateMutex_;
     friend class QDeclarativeGeoMapItem;
+    friend class QDeclarativeGeoMapItemBase;
     friend class QDeclarativeGeoMapItemView;
     friend class QDeclarativeGeoMapGestureArea;
     Q_DISABLE_COPY(QDeclarativeGeoMap)
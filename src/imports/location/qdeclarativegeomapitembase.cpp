@@ -33,6 +33,7 @@
 
 #include "qdeclarativegeomapitembase_p.h"
 #include "qgeocameradata_p.h"
+#include "qgeomapitembatch_p.h"
 #include <QtQml/QQmlInfo>
 #include <QtQuick/QSGOpacityNode>
 #include <QtQuick/private/qquickmousearea_p.h>
@@ -40,7 +41,9 @@
 QT_BEGIN_NAMESPACE
 
 QGeoMapViewportChangeEvent::QGeoMapViewportChangeEvent()
-    : zoomLevelChanged(false),
+    : changeType(ArbitraryChange),
+      zoomLevelDelta(0.0),
+      zoomLevelChanged(false),
       centerChanged(false),
       mapSizeChanged(false),
       tiltChanged(false),
@@ -61,6 +64,8 @@ QGeoMapViewportChangeEvent &QGeoMapViewportChangeEvent::operator=(const QGeoMapV
 
     cameraData = other.cameraData;
     mapSize = other.mapSize;
+    changeType = other.changeType;
+    zoomLevelDelta = other.zoomLevelDelta;
     zoomLevelChanged = other.zoomLevelChanged;
     centerChanged = other.centerChanged;
     mapSizeChanged = other.mapSizeChanged;
@@ -72,11 +77,22 @@ QGeoMapViewportChangeEvent &QGeoMapViewportChangeEvent::operator=(const QGeoMapV
 }
 
 QDeclarativeGeoMapItemBase::QDeclarativeGeoMapItemBase(QQuickItem *parent)
-:   QQuickItem(parent), map_(0), quickMap_(0), visibleOnMap_(true)
+:   QQuickItem(parent), map_(0), quickMap_(0), visibleOnMap_(true), batched_(false)
 {
+    // items are created on the GUI thread only
+    static quint64 lastBatchId = 0;
+    batchId_ = ++lastBatchId;
+
     setFiltersChildMouseEvents(true);
     connect(this, SIGNAL(childrenChanged()),
             this, SLOT(afterChildrenChanged()));
+
+    // these decide whether the item can be drawn through the map's batches
+    connect(this, SIGNAL(visibleChanged()), this, SLOT(batchingStateChanged()));
+    connect(this, SIGNAL(opacityChanged()), this, SLOT(batchingStateChanged()));
+    connect(this, SIGNAL(zChanged()), this, SLOT(batchingStateChanged()));
+    connect(this, SIGNAL(scaleChanged()), this, SLOT(batchingStateChanged()));
+    connect(this, SIGNAL(rotationChanged()), this, SLOT(batchingStateChanged()));
 }
 
 QDeclarativeGeoMapItemBase::~QDeclarativeGeoMapItemBase()
@@ -118,22 +134,54 @@ void QDeclarativeGeoMapItemBase::setMap(QDeclarativeGeoMap *quickMap, QGeoMap *m
         return;
     if (quickMap && quickMap_)
         return; // don't allow association to more than one map
-    if (quickMap_)
+    if (quickMap_) {
         quickMap_->disconnect(this);
+        quickMap_->releaseBatchedMapItem(batchId_);
+    }
     if (map_)
         map_->disconnect(this);
 
     quickMap_ = quickMap;
+    if (quickMap_)
+        quickMap_->releasedBatchItems_.remove(batchId_);
     map_ = map;
 
+    // camera changes are forwarded by the map, see QDeclarativeGeoMap::mapCameraDataChanged()
     if (map_ && quickMap_) {
-        connect(map_, SIGNAL(cameraDataChanged(QGeoCameraData)),
-                this, SLOT(baseCameraDataChanged(QGeoCameraData)));
         lastSize_ = QSizeF(quickMap_->width(), quickMap_->height());
         lastCameraData_ = map_->cameraData();
     }
 }
 
+/*!
+    \internal
+
+    Classifies \a event by how the screen geometry of an item relates to the
+    one it had before. Under an untilted, unrolled camera a change of the
+    center only translates it, and a change of the zoom level only scales it
+    around the item's origin; whole zoom levels scale it by a power of two,
+    which is exact. Anything else, including a resize, needs a rebuild.
+*/
+static QGeoMapViewportChangeEvent::ChangeType viewportChangeType(const QGeoMapViewportChangeEvent &event)
+{
+    if (event.mapSizeChanged || event.bearingChanged || event.tiltChanged || event.rollChanged)
+        return QGeoMapViewportChangeEvent::ArbitraryChange;
+
+    if (!event.zoomLevelChanged && !event.centerChanged)
+        return QGeoMapViewportChangeEvent::NoChange;
+
+    if (qAbs(event.cameraData.tilt()) > 0.1 || qAbs(event.cameraData.roll()) > 0.1)
+        return QGeoMapViewportChangeEvent::ArbitraryChange;
+
+    if (event.zoomLevelChanged) {
+        if (qFuzzyCompare(event.zoomLevelDelta, qreal(qRound(event.zoomLevelDelta))))
+            return QGeoMapViewportChangeEvent::IntegerZoomChange;
+        return QGeoMapViewportChangeEvent::ArbitraryChange;
+    }
+
+    return QGeoMapViewportChangeEvent::Translation;
+}
+
 /*!
     \internal
 */
@@ -157,12 +205,74 @@ void QDeclarativeGeoMapItemBase::baseCameraDataChanged(const QGeoCameraData &cam
     if (cameraData.zoomLevel() != lastCameraData_.zoomLevel())
         evt.zoomLevelChanged = true;
 
+    evt.zoomLevelDelta = cameraData.zoomLevel() - lastCameraData_.zoomLevel();
+    evt.changeType = viewportChangeType(evt);
+
     lastSize_ = evt.mapSize;
     lastCameraData_ = cameraData;
 
     afterViewportChanged(evt);
 }
 
+/*!
+    \internal
+*/
+void QDeclarativeGeoMapItemBase::geometryChanged(const QRectF &newGeometry, const QRectF &oldGeometry)
+{
+    QQuickItem::geometryChanged(newGeometry, oldGeometry);
+    if (quickMap_)
+        quickMap_->updateMapItemBounds(this);
+
+    // batched vertices are stored in map coordinates
+    if (newGeometry.topLeft() != oldGeometry.topLeft())
+        update();
+}
+
+/*!
+    \internal
+*/
+void QDeclarativeGeoMapItemBase::batchingStateChanged()
+{
+    if (!quickMap_)
+        return;
+
+    // hidden items are not synchronized, so the map has to drop them
+    if (isVisible())
+        quickMap_->releasedBatchItems_.remove(batchId_);
+    else
+        quickMap_->releaseBatchedMapItem(batchId_);
+    update();
+}
+
+/*!
+    \internal
+
+    Returns whether the item can currently be drawn through the batches of
+    its map. Items that are faded, scaled, rotated or explicitly stacked
+    draw through their own nodes.
+*/
+bool QDeclarativeGeoMapItemBase::isBatchable() const
+{
+    return quickMap_->mapItemBatching_
+            && opacity() == 1.0 && z() == 0.0
+            && scale() == 1.0 && rotation() == 0.0;
+}
+
+/*!
+    \internal
+
+    Hands the screen geometry of the item over to \a batch. Subclasses that
+    can be batched reimplement this and return true; \a force is set when
+    the batch does not hold the item's geometry yet, in which case it has to
+    be handed over even if it is clean.
+*/
+bool QDeclarativeGeoMapItemBase::updateMapItemBatch(QGeoMapItemBatchNode *batch, bool force)
+{
+    Q_UNUSED(batch);
+    Q_UNUSED(force);
+    return false;
+}
+
 /*!
     \internal
 */
@@ -181,12 +291,7 @@ void QDeclarativeGeoMapItemBase::setPositionOnMap(const QGeoCoordinate &coordina
 */
 float QDeclarativeGeoMapItemBase::zoomLevelOpacity() const
 {
-    if (quickMap_->zoomLevel() > 3.0)
-        return 1.0;
-    else if (quickMap_->zoomLevel() > 2.0)
-        return quickMap_->zoomLevel() - 2.0;
-    else
-        return 0.0;
+    return quickMap_->mapItemOpacity();
 }
 
 bool QDeclarativeGeoMapItemBase::childMouseEventFilter(QQuickItem *item, QEvent *event)
@@ -222,11 +327,27 @@ bool QDeclarativeGeoMapItemBase::visibleOnMap() const
 */
 QSGNode *QDeclarativeGeoMapItemBase::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *pd)
 {
+    QGeoMapItemBatchNode *batch = quickMap_ ? quickMap_->mapItemBatch_ : 0;
+
     if (!map_ || !quickMap_ || !visibleOnMap_) {
+        if (batch)
+            batch->removeItem(batchId_);
+        batched_ = false;
         delete oldNode;
         return 0;
     }
 
+    if (batch && isBatchable()) {
+        bool force = !batched_ || !batch->containsItem(batchId_);
+        batch->setItemOffset(batchId_, mapToItem(quickMap_, QPointF()));
+        if (updateMapItemBatch(batch, force)) {
+            batched_ = true;
+            delete oldNode;
+            return 0;
+        }
+    }
+    batched_ = false;
+
     QSGOpacityNode *opn = static_cast<QSGOpacityNode *>(oldNode);
     if (!opn)
         opn = new QSGOpacityNode();
@@ -243,6 +364,9 @@ QSGNode *QDeclarativeGeoMapItemBase::updatePaintNode(QSGNode *oldNode, UpdatePai
         delete oldN;
     }
 
+    if (batch)
+        batch->setItemUnbatched(batchId_, QGeoMapItemBatchNode::drawCalls(opn));
+
     return opn;
 }
 
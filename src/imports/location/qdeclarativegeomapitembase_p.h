@@ -40,9 +40,18 @@
 
 QT_BEGIN_NAMESPACE
 
+class QGeoMapItemBatchNode;
+
 class QGeoMapViewportChangeEvent
 {
 public:
+    enum ChangeType {
+        NoChange,
+        Translation,            // only the center moved
+        IntegerZoomChange,      // zoomed by whole levels, possibly around another center
+        ArbitraryChange
+    };
+
     explicit QGeoMapViewportChangeEvent();
     QGeoMapViewportChangeEvent(const QGeoMapViewportChangeEvent &other);
     QGeoMapViewportChangeEvent &operator=(const QGeoMapViewportChangeEvent &other);
@@ -50,6 +59,9 @@ public:
     QGeoCameraData cameraData;
     QSizeF mapSize;
 
+    ChangeType changeType;
+    qreal zoomLevelDelta;
+
     bool zoomLevelChanged;
     bool centerChanged;
     bool mapSizeChanged;
@@ -79,21 +91,33 @@ protected Q_SLOTS:
     virtual void afterViewportChanged(const QGeoMapViewportChangeEvent &event) = 0;
 
 protected:
+    void geometryChanged(const QRectF &newGeometry, const QRectF &oldGeometry) Q_DECL_OVERRIDE;
     float zoomLevelOpacity() const;
     bool childMouseEventFilter(QQuickItem *item, QEvent *event);
     void setVisibleOnMap(bool visible);
     bool visibleOnMap() const;
 
+    virtual bool updateMapItemBatch(QGeoMapItemBatchNode *batch, bool force);
+    quint64 batchId() const { return batchId_; }
+
 private Q_SLOTS:
     void baseCameraDataChanged(const QGeoCameraData &camera);
+    void batchingStateChanged();
 
 private:
+    bool isBatchable() const;
+
     QGeoMap *map_;
     QDeclarativeGeoMap *quickMap_;
 
     QSizeF lastSize_;
     QGeoCameraData lastCameraData_;
     bool visibleOnMap_;
+
+    quint64 batchId_;
+    bool batched_;              // only used while the scene graph is synchronized
+
+    friend class QDeclarativeGeoMap;
 };
 
 QT_END_NAMESPACE
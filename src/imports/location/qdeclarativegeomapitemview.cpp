@@ -35,12 +35,23 @@
 #include "qdeclarativegeomap_p.h"
 #include "qdeclarativegeomapitembase_p.h"
 
+#include "qgeoprojection_p.h"
+
 #include <QtCore/QAbstractItemModel>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QTimer>
+#include <QtCore/qnumeric.h>
 #include <QtQml/QQmlContext>
 #include <QtQml/private/qqmlopenmetaobject_p.h>
+#include <QtPositioning/QGeoRectangle>
 
 QT_BEGIN_NAMESPACE
 
+// time spent instantiating delegates per event loop pass in virtualized mode
+static const int CreationBudgetMs = 4;
+// delegates kept around for reuse after leaving the viewport
+static const int MaximumPoolSize = 256;
+
 /*!
     \qmltype MapItemView
     \instantiates QDeclarativeGeoMapItemView
@@ -64,12 +75,23 @@ QT_BEGIN_NAMESPACE
     \snippet declarative/maps.qml QtLocation import
     \codeline
     \snippet declarative/maps.qml MapRoute
+
+    \section2 Large Models
+
+    By default a map item is created for every row of the model up front.
+    For models with many rows, set \l virtualized and \l coordinateRole:
+    map items are then only created for rows near the visible part of the
+    map, a few at a time, and reused as the map moves.
 */
 
 QDeclarativeGeoMapItemView::QDeclarativeGeoMapItemView(QQuickItem *parent)
     : QObject(parent), componentCompleted_(false), delegate_(0),
-      itemModel_(0), map_(0), fitViewport_(false)
+      itemModel_(0), map_(0), fitViewport_(false), virtualized_(false),
+      coordinateRoleId_(-1), updateTimer_(new QTimer(this)), viewportDirty_(false)
 {
+    updateTimer_->setSingleShot(true);
+    updateTimer_->setInterval(0);
+    connect(updateTimer_, SIGNAL(timeout()), this, SLOT(processPendingRows()));
 }
 
 QDeclarativeGeoMapItemView::~QDeclarativeGeoMapItemView()
@@ -108,6 +130,8 @@ void QDeclarativeGeoMapItemView::setModel(const QVariant &model)
                    this, SLOT(itemModelRowsRemoved(QModelIndex,int,int)));
         disconnect(itemModel_, SIGNAL(rowsInserted(QModelIndex,int,int)),
                    this, SLOT(itemModelRowsInserted(QModelIndex,int,int)));
+        disconnect(itemModel_, SIGNAL(dataChanged(QModelIndex,QModelIndex)),
+                   this, SLOT(itemModelDataChanged(QModelIndex,QModelIndex)));
 
         itemModel_ = 0;
     }
@@ -119,6 +143,8 @@ void QDeclarativeGeoMapItemView::setModel(const QVariant &model)
                 this, SLOT(itemModelRowsRemoved(QModelIndex,int,int)));
         connect(itemModel_, SIGNAL(rowsInserted(QModelIndex,int,int)),
                 this, SLOT(itemModelRowsInserted(QModelIndex,int,int)));
+        connect(itemModel_, SIGNAL(dataChanged(QModelIndex,QModelIndex)),
+                this, SLOT(itemModelDataChanged(QModelIndex,QModelIndex)));
     }
 
     repopulate();
@@ -143,6 +169,24 @@ void QDeclarativeGeoMapItemView::itemModelRowsInserted(const QModelIndex &index,
     if (!componentCompleted_ || !map_ || !delegate_ || !itemModel_)
         return;
 
+    if (virtualized_) {
+        const int count = end - start + 1;
+        if (rowItems_.size() + count != itemModel_->rowCount()) {
+            resetRows();
+        } else {
+            rowPositions_.insert(start, count, QDoubleVector2D());
+            rowItems_.insert(start, count, 0);
+            for (int i = start; i <= end; ++i)
+                readRowPosition(i);
+            updateRowIndices(end + 1);
+        }
+        viewportDirty_ = true;
+        scheduleUpdate();
+        if (fitViewport_)
+            fitViewportToRows();
+        return;
+    }
+
     QDeclarativeGeoMapItemBase *mapItem;
     for (int i = start; i <= end; ++i) {
         mapItem = createItemFromItemModel(i);
@@ -166,6 +210,25 @@ void QDeclarativeGeoMapItemView::itemModelRowsRemoved(const QModelIndex &index,
     if (!componentCompleted_ || !map_ || !delegate_ || !itemModel_)
         return;
 
+    if (virtualized_) {
+        const int count = end - start + 1;
+        if (end >= rowItems_.size()) {
+            removeInstantiatedItems();
+            resetRows();
+        } else {
+            for (int i = end; i >= start; --i)
+                releaseRow(i);
+            rowPositions_.remove(start, count);
+            rowItems_.remove(start, count);
+            updateRowIndices(start);
+        }
+        viewportDirty_ = true;
+        scheduleUpdate();
+        if (fitViewport_)
+            fitViewportToRows();
+        return;
+    }
+
     for (int i = end; i >= start; --i) {
         QDeclarativeGeoMapItemBase *mapItem = mapItemList_.takeAt(i);
         Q_ASSERT(mapItem);
@@ -178,6 +241,30 @@ void QDeclarativeGeoMapItemView::itemModelRowsRemoved(const QModelIndex &index,
         fitViewport();
 }
 
+/*!
+    \internal
+
+    In virtualized mode, picks up moved coordinates and refreshes the
+    delegates of the changed rows.
+*/
+void QDeclarativeGeoMapItemView::itemModelDataChanged(const QModelIndex &topLeft,
+                                                      const QModelIndex &bottomRight)
+{
+    if (!virtualized_ || !itemModel_ || rowItems_.isEmpty())
+        return;
+
+    const int last = qMin(bottomRight.row(), rowItems_.size() - 1);
+    for (int row = qMax(0, topLeft.row()); row <= last; ++row) {
+        readRowPosition(row);
+        if (QDeclarativeGeoMapItemBase *item = rowItems_.at(row)) {
+            const DelegateData data = delegateData_.value(item);
+            setItemModelData(data.context, data.modelMetaObject, row);
+        }
+    }
+    viewportDirty_ = true;
+    scheduleUpdate();
+}
+
 /*!
     \qmlproperty Component QtLocation::MapItemView::delegate
 
@@ -222,6 +309,59 @@ void QDeclarativeGeoMapItemView::setAutoFitViewport(const bool &fitViewport)
     emit autoFitViewportChanged();
 }
 
+/*!
+    \qmlproperty bool QtLocation::MapItemView::virtualized
+
+    This property controls whether map items are only created for the model
+    rows near the visible part of the map. The position of each row is read
+    from \l coordinateRole.
+
+    When set, delegates are created a few at a time over several frames,
+    and delegates of rows that move out of view are reused for rows that
+    move into view. Delegates should therefore not keep state of their own
+    beyond what they get from the model. Rows without a valid coordinate
+    always get a map item.
+
+    Defaults to false.
+*/
+bool QDeclarativeGeoMapItemView::isVirtualized() const
+{
+    return virtualized_;
+}
+
+void QDeclarativeGeoMapItemView::setVirtualized(bool virtualized)
+{
+    if (virtualized == virtualized_)
+        return;
+
+    virtualized_ = virtualized;
+    repopulate();
+    emit virtualizedChanged();
+}
+
+/*!
+    \qmlproperty string QtLocation::MapItemView::coordinateRole
+
+    This property holds the name of the model role which holds the
+    coordinate of each row, as used by \l virtualized. The role may also
+    hold an object with a \c coordinate property.
+*/
+QString QDeclarativeGeoMapItemView::coordinateRole() const
+{
+    return coordinateRole_;
+}
+
+void QDeclarativeGeoMapItemView::setCoordinateRole(const QString &role)
+{
+    if (role == coordinateRole_)
+        return;
+
+    coordinateRole_ = role;
+    if (virtualized_)
+        repopulate();
+    emit coordinateRoleChanged();
+}
+
 /*!
     \internal
 */
@@ -242,6 +382,11 @@ void QDeclarativeGeoMapItemView::setMapData(QDeclarativeGeoMap *map)
     if (!map || map_) // changing map on the fly not supported
         return;
     map_ = map;
+
+    connect(map_, SIGNAL(centerChanged(QGeoCoordinate)), this, SLOT(viewportChanged()));
+    connect(map_, SIGNAL(zoomLevelChanged(qreal)), this, SLOT(viewportChanged()));
+    connect(map_, SIGNAL(widthChanged()), this, SLOT(viewportChanged()));
+    connect(map_, SIGNAL(heightChanged()), this, SLOT(viewportChanged()));
 }
 
 /*!
@@ -256,6 +401,19 @@ void QDeclarativeGeoMapItemView::removeInstantiatedItems()
         map_->removeMapItem(mapItem);
     }
     mapItemList_.clear();
+
+    foreach (QDeclarativeGeoMapItemBase *mapItem, rowItems_) {
+        if (!mapItem)
+            continue;
+        mapItem->deleteLater();
+        map_->removeMapItem(mapItem);
+    }
+    foreach (QDeclarativeGeoMapItemBase *mapItem, itemPool_)
+        mapItem->deleteLater();
+    rowItems_.fill(0);
+    itemPool_.clear();
+    pendingRows_.clear();
+    delegateData_.clear();
 }
 
 /*!
@@ -270,6 +428,14 @@ void QDeclarativeGeoMapItemView::repopulate()
     if (!componentCompleted_ || !map_ || !delegate_ || !itemModel_)
         return;
 
+    if (virtualized_) {
+        resetRows();
+        scheduleUpdate();
+        if (fitViewport_)
+            fitViewportToRows();
+        return;
+    }
+
     // Iterate model data and instantiate delegates.
     for (int i = 0; i < itemModel_->rowCount(); ++i) {
         QDeclarativeGeoMapItemBase *mapItem = createItemFromItemModel(i);
@@ -300,21 +466,9 @@ QDeclarativeGeoMapItemBase *QDeclarativeGeoMapItemView::createItemFromItemModel(
     QObject *model = new QObject(this);
     QQmlOpenMetaObject *modelMetaObject = new QQmlOpenMetaObject(model);
 
-    QHashIterator<int, QByteArray> iterator(itemModel_->roleNames());
     QQmlContext *itemContext = new QQmlContext(qmlContext(this));
-    while (iterator.hasNext()) {
-        iterator.next();
-        QVariant modelData = itemModel_->data(index, iterator.key());
-        if (!modelData.isValid())
-            continue;
-
-        itemContext->setContextProperty(QString::fromLatin1(iterator.value().constData()),
-                                        modelData);
-
-        modelMetaObject->setValue(iterator.value(), modelData);
-    }
     itemContext->setContextProperty(QStringLiteral("model"), model);
-    itemContext->setContextProperty(QStringLiteral("index"), modelRow);
+    setItemModelData(itemContext, modelMetaObject, modelRow);
 
     QObject *obj = delegate_->create(itemContext);
 
@@ -331,9 +485,304 @@ QDeclarativeGeoMapItemBase *QDeclarativeGeoMapItemView::createItemFromItemModel(
     }
     itemContext->setParent(declMapObj);
     model->setParent(declMapObj);
+
+    if (virtualized_) {
+        DelegateData data;
+        data.context = itemContext;
+        data.modelMetaObject = modelMetaObject;
+        delegateData_.insert(declMapObj, data);
+    }
     return declMapObj;
 }
 
+/*!
+    \internal
+
+    Exposes the roles of \a modelRow to a delegate through \a context and
+    the model object of \a modelMetaObject. Also used to point a reused
+    delegate at another row.
+*/
+void QDeclarativeGeoMapItemView::setItemModelData(QQmlContext *context,
+                                                  QQmlOpenMetaObject *modelMetaObject,
+                                                  int modelRow)
+{
+    QModelIndex index = itemModel_->index(modelRow, 0); // column 0
+
+    QHashIterator<int, QByteArray> iterator(itemModel_->roleNames());
+    while (iterator.hasNext()) {
+        iterator.next();
+        const QString name = QString::fromLatin1(iterator.value().constData());
+        QVariant modelData = itemModel_->data(index, iterator.key());
+        if (!modelData.isValid()) {
+            // do not leave a value behind from the previous row of a reused delegate
+            if (!context->contextProperty(name).isValid())
+                continue;
+            modelData = QVariant();
+        }
+
+        context->setContextProperty(name, modelData);
+        modelMetaObject->setValue(iterator.value(), modelData);
+    }
+    context->setContextProperty(QStringLiteral("index"), modelRow);
+}
+
+/*!
+    \internal
+
+    Rereads the rows of the model for virtualized mode. No delegates are
+    created here, that is left to processPendingRows().
+*/
+void QDeclarativeGeoMapItemView::resetRows()
+{
+    rowPositions_.clear();
+    rowItems_.clear();
+    pendingRows_.clear();
+    coordinateRoleId_ = -1;
+
+    if (!itemModel_)
+        return;
+
+    const QByteArray roleName = coordinateRole_.toUtf8();
+    QHashIterator<int, QByteArray> iterator(itemModel_->roleNames());
+    while (iterator.hasNext()) {
+        iterator.next();
+        if (iterator.value() == roleName) {
+            coordinateRoleId_ = iterator.key();
+            break;
+        }
+    }
+    if (coordinateRoleId_ < 0 && !coordinateRole_.isEmpty())
+        qWarning() << "QDeclarativeGeoMapItemView model has no role" << coordinateRole_;
+
+    const int rows = itemModel_->rowCount();
+    rowPositions_.resize(rows);
+    rowItems_.fill(0, rows);
+    for (int row = 0; row < rows; ++row)
+        readRowPosition(row);
+
+    viewportDirty_ = true;
+}
+
+/*!
+    \internal
+*/
+void QDeclarativeGeoMapItemView::readRowPosition(int row)
+{
+    QDoubleVector2D position(qQNaN(), qQNaN());
+    if (coordinateRoleId_ >= 0) {
+        const QVariant data = itemModel_->data(itemModel_->index(row, 0), coordinateRoleId_);
+        QGeoCoordinate coordinate = data.value<QGeoCoordinate>();
+        if (QObject *object = data.value<QObject *>())
+            coordinate = object->property("coordinate").value<QGeoCoordinate>();
+        if (coordinate.isValid())
+            position = QGeoProjection::coordToMercator(coordinate);
+    }
+    rowPositions_[row] = position;
+}
+
+/*!
+    \internal
+
+    Rows without a coordinate are always considered in view.
+*/
+bool QDeclarativeGeoMapItemView::rowInViewport(int row, const QRectF &viewport) const
+{
+    const QDoubleVector2D &position = rowPositions_.at(row);
+    if (!qIsFinite(position.x()) || !qIsFinite(position.y()))
+        return true;
+    return QGeoMapItemIndex::intersects(QRectF(position.x(), position.y(), 0.0, 0.0), viewport);
+}
+
+/*!
+    \internal
+
+    Returns in \a viewport the visible part of the map in mercator, grown by
+    \a margin times its size on each side. Returns false if the map cannot
+    tell, like when it is not ready or the view is tilted.
+*/
+bool QDeclarativeGeoMapItemView::viewportRect(double margin, QRectF *viewport) const
+{
+    if (!map_ || !map_->updateMercatorTransform())
+        return false;
+
+    const double s = map_->mercatorPerPixel_;
+    const double halfWidth = map_->width() * (0.5 + margin) * s;
+    const double halfHeight = map_->height() * (0.5 + margin) * s;
+    *viewport = QRectF(map_->mercatorCenter_.x() - halfWidth,
+                       map_->mercatorCenter_.y() - halfHeight,
+                       2.0 * halfWidth, 2.0 * halfHeight);
+    return true;
+}
+
+/*!
+    \internal
+
+    Gives \a row a map item, reusing a pooled delegate when there is one.
+*/
+QDeclarativeGeoMapItemBase *QDeclarativeGeoMapItemView::instantiateRow(int row)
+{
+    QDeclarativeGeoMapItemBase *mapItem = 0;
+    if (!itemPool_.isEmpty()) {
+        mapItem = itemPool_.takeLast();
+        const DelegateData data = delegateData_.value(mapItem);
+        setItemModelData(data.context, data.modelMetaObject, row);
+    } else {
+        mapItem = createItemFromItemModel(row);
+        if (!mapItem)
+            return 0;
+    }
+
+    rowItems_[row] = mapItem;
+    map_->addMapItem(mapItem);
+    return mapItem;
+}
+
+/*!
+    \internal
+*/
+void QDeclarativeGeoMapItemView::releaseRow(int row)
+{
+    QDeclarativeGeoMapItemBase *mapItem = rowItems_.at(row);
+    if (!mapItem)
+        return;
+
+    rowItems_[row] = 0;
+    map_->removeMapItem(mapItem);
+
+    if (itemPool_.size() < MaximumPoolSize) {
+        itemPool_.append(mapItem);
+    } else {
+        delegateData_.remove(mapItem);
+        mapItem->deleteLater();
+    }
+}
+
+/*!
+    \internal
+
+    Keeps the index context property of the delegates from row \a from on
+    in step with the model after rows were inserted or removed.
+*/
+void QDeclarativeGeoMapItemView::updateRowIndices(int from)
+{
+    for (int row = from; row < rowItems_.size(); ++row) {
+        if (QDeclarativeGeoMapItemBase *mapItem = rowItems_.at(row))
+            delegateData_.value(mapItem).context->setContextProperty(QStringLiteral("index"), row);
+    }
+}
+
+/*!
+    \internal
+*/
+void QDeclarativeGeoMapItemView::scheduleUpdate()
+{
+    if (!updateTimer_->isActive())
+        updateTimer_->start();
+}
+
+/*!
+    \internal
+*/
+void QDeclarativeGeoMapItemView::viewportChanged()
+{
+    if (!virtualized_)
+        return;
+
+    viewportDirty_ = true;
+    scheduleUpdate();
+}
+
+/*!
+    \internal
+
+    Brings the instantiated rows in line with the viewport. Rows well out of
+    view give their delegates back to the pool, and rows coming into view
+    get one, for at most CreationBudgetMs per pass so that large models do
+    not block the event loop.
+*/
+void QDeclarativeGeoMapItemView::processPendingRows()
+{
+    if (!virtualized_ || !componentCompleted_ || !map_ || !delegate_ || !itemModel_)
+        return;
+
+    if (viewportDirty_) {
+        QRectF wanted;
+        QRectF kept;
+        const bool culling = viewportRect(0.5, &wanted) && viewportRect(1.0, &kept);
+
+        // without a laid out map there is nothing to compare against yet
+        if (!culling && (!map_->map_ || map_->width() <= 0 || map_->height() <= 0))
+            return;
+
+        viewportDirty_ = false;
+        pendingRows_.clear();
+
+        // walk backwards so the rows are created in model order below
+        for (int row = rowItems_.size() - 1; row >= 0; --row) {
+            if (rowItems_.at(row)) {
+                if (culling && !rowInViewport(row, kept))
+                    releaseRow(row);
+            } else if (!culling || rowInViewport(row, wanted)) {
+                pendingRows_.append(row);
+            }
+        }
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    while (!pendingRows_.isEmpty() && timer.elapsed() < CreationBudgetMs) {
+        const int row = pendingRows_.takeLast();
+        if (!rowItems_.at(row) && !instantiateRow(row)) {
+            pendingRows_.clear();
+            break;
+        }
+    }
+
+    if (!pendingRows_.isEmpty())
+        updateTimer_->start();
+}
+
+/*!
+    \internal
+
+    Fits the viewport to the coordinates of all rows in virtualized mode,
+    where most rows have no map item to fit to.
+*/
+void QDeclarativeGeoMapItemView::fitViewportToRows()
+{
+    if (!map_ || !fitViewport_)
+        return;
+
+    bool found = false;
+    double minX = 0.0;
+    double maxX = 0.0;
+    double minY = 0.0;
+    double maxY = 0.0;
+    foreach (const QDoubleVector2D &position, rowPositions_) {
+        if (!qIsFinite(position.x()) || !qIsFinite(position.y()))
+            continue;
+        if (!found) {
+            minX = maxX = position.x();
+            minY = maxY = position.y();
+            found = true;
+        } else {
+            minX = qMin(minX, position.x());
+            maxX = qMax(maxX, position.x());
+            minY = qMin(minY, position.y());
+            maxY = qMax(maxY, position.y());
+        }
+    }
+
+    if (!found) {
+        fitViewport();
+        return;
+    }
+
+    const QGeoRectangle bounds(QGeoProjection::mercatorToCoord(QDoubleVector2D(minX, minY)),
+                               QGeoProjection::mercatorToCoord(QDoubleVector2D(maxX, maxY)));
+    map_->fitViewportToGeoShape(QVariant::fromValue(bounds));
+}
+
 #include "moc_qdeclarativegeomapitemview_p.cpp"
 
 QT_END_NAMESPACE
@@ -35,13 +35,19 @@
 #define QDECLARATIVEGEOMAPITEMVIEW_H
 
 #include <QtCore/QModelIndex>
+#include <QtCore/QHash>
+#include <QtCore/QVector>
 #include <QtQml/QQmlParserStatus>
 #include <QtQml/qqml.h>
+#include <QtPositioning/private/qdoublevector2d_p.h>
 
 QT_BEGIN_NAMESPACE
 
 class QAbstractItemModel;
 class QQmlComponent;
+class QQmlContext;
+class QQmlOpenMetaObject;
+class QTimer;
 class QQuickItem;
 class QDeclarativeGeoMap;
 class QDeclarativeGeoMapItemBase;
@@ -55,6 +61,8 @@ class QDeclarativeGeoMapItemView : public QObject, public QQmlParserStatus
     Q_PROPERTY(QVariant model READ model WRITE setModel NOTIFY modelChanged)
     Q_PROPERTY(QQmlComponent *delegate READ delegate WRITE setDelegate NOTIFY delegateChanged)
     Q_PROPERTY(bool autoFitViewport READ autoFitViewport WRITE setAutoFitViewport NOTIFY autoFitViewportChanged)
+    Q_PROPERTY(bool virtualized READ isVirtualized WRITE setVirtualized NOTIFY virtualizedChanged)
+    Q_PROPERTY(QString coordinateRole READ coordinateRole WRITE setCoordinateRole NOTIFY coordinateRoleChanged)
 
 public:
     explicit QDeclarativeGeoMapItemView(QQuickItem *parent = 0);
@@ -69,6 +77,12 @@ public:
     bool autoFitViewport() const;
     void setAutoFitViewport(const bool &);
 
+    bool isVirtualized() const;
+    void setVirtualized(bool virtualized);
+
+    QString coordinateRole() const;
+    void setCoordinateRole(const QString &role);
+
     void setMapData(QDeclarativeGeoMap *);
     void repopulate();
     void removeInstantiatedItems();
@@ -84,16 +98,39 @@ Q_SIGNALS:
     void modelChanged();
     void delegateChanged();
     void autoFitViewportChanged();
+    void virtualizedChanged();
+    void coordinateRoleChanged();
 
 private:
     QDeclarativeGeoMapItemBase *createItemFromItemModel(int modelRow);
+    void setItemModelData(QQmlContext *context, QQmlOpenMetaObject *modelMetaObject, int modelRow);
 
     void fitViewport();
 
+    // virtualized mode
+    struct DelegateData
+    {
+        QQmlContext *context;
+        QQmlOpenMetaObject *modelMetaObject;
+    };
+
+    void resetRows();
+    void readRowPosition(int row);
+    bool rowInViewport(int row, const QRectF &viewport) const;
+    bool viewportRect(double margin, QRectF *viewport) const;
+    QDeclarativeGeoMapItemBase *instantiateRow(int row);
+    void releaseRow(int row);
+    void updateRowIndices(int from);
+    void scheduleUpdate();
+    void fitViewportToRows();
+
 private Q_SLOTS:
     void itemModelReset();
     void itemModelRowsInserted(const QModelIndex &index, int start, int end);
     void itemModelRowsRemoved(const QModelIndex &index, int start, int end);
+    void itemModelDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight);
+    void viewportChanged();
+    void processPendingRows();
 
 private:
     bool componentCompleted_;
@@ -102,6 +139,17 @@ private:
     QDeclarativeGeoMap *map_;
     QList<QDeclarativeGeoMapItemBase *> mapItemList_;
     bool fitViewport_;
+
+    bool virtualized_;
+    QString coordinateRole_;
+    int coordinateRoleId_;
+    QVector<QDoubleVector2D> rowPositions_;
+    QVector<QDeclarativeGeoMapItemBase *> rowItems_;
+    QVector<int> pendingRows_;
+    QList<QDeclarativeGeoMapItemBase *> itemPool_;
+    QHash<QDeclarativeGeoMapItemBase *, DelegateData> delegateData_;
+    QTimer *updateTimer_;
+    bool viewportDirty_;
 };
 
 QT_END_NAMESPACE
@@ -157,8 +157,6 @@ void QDeclarativeGeoMapQuickItem::setMap(QDeclarativeGeoMap *quickMap, QGeoMap *
     if (map && quickMap) {
         connect(quickMap, SIGNAL(heightChanged()), this, SLOT(updateMapItemAssumeDirty()));
         connect(quickMap, SIGNAL(widthChanged()), this, SLOT(updateMapItemAssumeDirty()));
-        connect(map, SIGNAL(cameraDataChanged(QGeoCameraData)),
-                this, SLOT(updateMapItemAssumeDirty()));
         polish();
     }
 }
@@ -342,6 +340,7 @@ void QDeclarativeGeoMapQuickItem::updatePolish()
 void QDeclarativeGeoMapQuickItem::afterViewportChanged(const QGeoMapViewportChangeEvent &event)
 {
     Q_UNUSED(event);
+    updateMapItemAssumeDirty();
 }
 
 /*!
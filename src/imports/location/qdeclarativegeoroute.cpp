@@ -41,6 +41,7 @@
 #include <QtQml/qqmlinfo.h>
 #include <QtQml/private/qqmlengine_p.h>
 #include <QtPositioning/QGeoRectangle>
+#include <QtLocation/private/qgeoroute_p.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -88,23 +89,26 @@ QDeclarativeGeoRoute::QDeclarativeGeoRoute(const QGeoRoute &route, QObject *pare
 
 QDeclarativeGeoRoute::~QDeclarativeGeoRoute() {}
 
+/*!
+    \internal
+
+    The segment objects are created when first accessed, a route with
+    thousands of segments is mostly read through its path.
+*/
 void QDeclarativeGeoRoute::init()
 {
-    QGeoRouteSegment segment = route_.firstRouteSegment();
-    while (segment.isValid()) {
-        QDeclarativeGeoRouteSegment *routeSegment = new QDeclarativeGeoRouteSegment(segment, this);
-        QQmlEngine::setContextForObject(routeSegment, QQmlEngine::contextForObject(this));
-        segments_.append(routeSegment);
-        segment = segment.nextRouteSegment();
-    }
+    const int count = QGeoRoutePrivate::segmentCount(route_);
+    segments_.reserve(count);
+    for (int i = 0; i < count; ++i)
+        segments_.append(0);
 }
 
 /*!
     \internal
 */
-QList<QGeoCoordinate> QDeclarativeGeoRoute::routePath()
+QGeoCoordinateArray QDeclarativeGeoRoute::routePath()
 {
-    return route_.path();
+    return QGeoRoutePrivate::compactPath(route_);
 }
 
 /*!
@@ -164,9 +168,10 @@ QJSValue QDeclarativeGeoRoute::path() const
     QV4::ExecutionEngine *v4 = QQmlEnginePrivate::getV4Engine(engine);
 
     QV4::Scope scope(v4);
-    QV4::Scoped<QV4::ArrayObject> pathArray(scope, v4->newArrayObject(route_.path().length()));
-    for (int i = 0; i < route_.path().length(); ++i) {
-        const QGeoCoordinate &c = route_.path().at(i);
+    QGeoCoordinateArray routePath = QGeoRoutePrivate::compactPath(route_);
+    QV4::Scoped<QV4::ArrayObject> pathArray(scope, v4->newArrayObject(routePath.size()));
+    for (int i = 0; i < routePath.size(); ++i) {
+        const QGeoCoordinate c = routePath.at(i);
 
         QV4::ScopedValue cv(scope, v4->fromVariant(QVariant::fromValue(c)));
         pathArray->putIndexed(i, cv);
@@ -180,8 +185,9 @@ void QDeclarativeGeoRoute::setPath(const QJSValue &value)
     if (!value.isArray())
         return;
 
-    QList<QGeoCoordinate> pathList;
+    QGeoCoordinateArray pathList;
     quint32 length = value.property(QStringLiteral("length")).toUInt();
+    pathList.reserve(length);
     for (quint32 i = 0; i < length; ++i) {
         bool ok;
         QGeoCoordinate c = parseCoordinate(value.property(i), &ok);
@@ -194,10 +200,10 @@ void QDeclarativeGeoRoute::setPath(const QJSValue &value)
         pathList.append(c);
     }
 
-    if (route_.path() == pathList)
+    if (QGeoRoutePrivate::compactPath(route_) == pathList)
         return;
 
-    route_.setPath(pathList);
+    QGeoRoutePrivate::setCompactPath(route_, pathList);
 
     emit pathChanged();
 }
@@ -242,7 +248,7 @@ int QDeclarativeGeoRoute::segments_count(QQmlListProperty<QDeclarativeGeoRouteSe
 */
 QDeclarativeGeoRouteSegment *QDeclarativeGeoRoute::segments_at(QQmlListProperty<QDeclarativeGeoRouteSegment> *prop, int index)
 {
-    return static_cast<QDeclarativeGeoRoute *>(prop->object)->segments_.at(index);
+    return static_cast<QDeclarativeGeoRoute *>(prop->object)->segmentAt(index);
 }
 
 /*!
@@ -253,6 +259,20 @@ void QDeclarativeGeoRoute::segments_clear(QQmlListProperty<QDeclarativeGeoRouteS
     static_cast<QDeclarativeGeoRoute *>(prop->object)->clearSegments();
 }
 
+/*!
+    \internal
+*/
+QDeclarativeGeoRouteSegment *QDeclarativeGeoRoute::segmentAt(int index)
+{
+    QDeclarativeGeoRouteSegment *routeSegment = segments_.at(index);
+    if (!routeSegment && index < QGeoRoutePrivate::segmentCount(route_)) {
+        routeSegment = new QDeclarativeGeoRouteSegment(QGeoRoutePrivate::segmentAt(route_, index), this);
+        QQmlEngine::setContextForObject(routeSegment, QQmlEngine::contextForObject(this));
+        segments_[index] = routeSegment;
+    }
+    return routeSegment;
+}
+
 /*!
     \internal
 */
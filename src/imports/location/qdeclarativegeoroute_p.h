@@ -39,6 +39,7 @@
 #include <QtCore/QObject>
 #include <QtQml/QQmlListProperty>
 #include <QtLocation/QGeoRoute>
+#include <QtPositioning/private/qgeocoordinatearray_p.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -79,7 +80,8 @@ private:
     static void segments_clear(QQmlListProperty<QDeclarativeGeoRouteSegment> *prop);
 
     void init();
-    QList<QGeoCoordinate> routePath();
+    QDeclarativeGeoRouteSegment *segmentAt(int index);
+    QGeoCoordinateArray routePath();
 
     QGeoRoute route_;
     QList<QDeclarativeGeoRouteSegment *> segments_;
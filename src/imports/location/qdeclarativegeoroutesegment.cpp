@@ -38,6 +38,7 @@
 #include <QtQml/private/qqmlengine_p.h>
 #include <private/qqmlvaluetypewrapper_p.h>
 #include <private/qjsvalue_p.h>
+#include <QtLocation/private/qgeoroutesegment_p.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -147,10 +148,15 @@ QJSValue QDeclarativeGeoRouteSegment::path() const
     QQmlEngine *engine = context->engine();
     QV4::ExecutionEngine *v4 = QQmlEnginePrivate::getV4Engine(engine);
 
+    // read the points straight from the buffer the route's segments share
+    const QGeoCoordinateArray buffer = QGeoRouteSegmentPrivate::pathBuffer(segment_);
+    const int offset = QGeoRouteSegmentPrivate::pathOffset(segment_);
+    const int length = QGeoRouteSegmentPrivate::pathLength(segment_);
+
     QV4::Scope scope(v4);
-    QV4::Scoped<QV4::ArrayObject> pathArray(scope, v4->newArrayObject(segment_.path().length()));
-    for (int i = 0; i < segment_.path().length(); ++i) {
-        const QGeoCoordinate &c = segment_.path().at(i);
+    QV4::Scoped<QV4::ArrayObject> pathArray(scope, v4->newArrayObject(length));
+    for (int i = 0; i < length; ++i) {
+        const QGeoCoordinate c = buffer.at(offset + i);
 
         QV4::ScopedValue cv(scope, v4->fromVariant(QVariant::fromValue(c)));
         pathArray->putIndexed(i, cv);
@@ -33,11 +33,14 @@
 
 #include "qdeclarativepolygonmapitem_p.h"
 #include "qgeocameracapabilities_p.h"
+#include "qgeopolygontessellator_p.h"
 #include "qlocationutils_p.h"
 #include "error_messages.h"
 #include "locationvaluetypehelper_p.h"
 
 #include <QtCore/QScopedValueRollback>
+#include <QtCore/QThreadPool>
+#include <QtCore/QThreadStorage>
 #include <QtGui/private/qtriangulator_p.h>
 #include <QtQml/QQmlInfo>
 #include <QtQml/QQmlContext>
@@ -47,15 +50,15 @@
 #include <QPainter>
 #include <QPainterPath>
 #include <qnumeric.h>
+#include <cmath>
 
 #include "qdoublevector2d_p.h"
 
-/* poly2tri triangulator includes */
-#include "../../3rdparty/poly2tri/common/shapes.h"
-#include "../../3rdparty/poly2tri/sweep/cdt.h"
 
 QT_BEGIN_NAMESPACE
 
+Q_GLOBAL_STATIC(QThreadStorage<QGeoPolygonTessellator *>, mapPolygonTessellators)
+
 /*!
     \qmltype MapPolygon
     \instantiates QDeclarativePolygonMapItem
@@ -151,6 +154,18 @@ void QGeoMapPolygonGeometry::updateSourcePoints(const QGeoMap &map,
     if (!sourceDirty_)
         return;
 
+    updateSourcePoints(map, QGeoCoordinateArray(path));
+}
+
+/*!
+    \internal
+*/
+void QGeoMapPolygonGeometry::updateSourcePoints(const QGeoMap &map,
+                                                const QGeoCoordinateArray &path)
+{
+    if (!sourceDirty_)
+        return;
+
     double minX = -1.0;
 
     // build the actual path
@@ -162,13 +177,17 @@ void QGeoMapPolygonGeometry::updateSourcePoints(const QGeoMap &map,
     if (preserveGeometry_ )
         unwrapBelowX = map.coordinateToScreenPosition(geoLeftBound_, false).x();
 
-    for (int i = 0; i < path.size(); ++i) {
-        const QGeoCoordinate &coord = path.at(i);
+    // project the whole path with one camera setup
+    QVector<QDoubleVector2D> projected(path.size());
+    map.coordinatesToScreenPositions(path, projected.data(), false);
 
-        if (!coord.isValid())
+    QGeoCoordinate coord;
+
+    for (int i = 0; i < path.size(); ++i) {
+        if (!path.isValid(i))
             continue;
 
-        QDoubleVector2D point = map.coordinateToScreenPosition(coord, false);
+        QDoubleVector2D point = projected.at(i);
 
         // We can get NaN if the map isn't set up correctly, or the projection
         // is faulty -- probably best thing to do is abort
@@ -178,13 +197,15 @@ void QGeoMapPolygonGeometry::updateSourcePoints(const QGeoMap &map,
         // unwrap x to preserve geometry if moved to border of map
         if (preserveGeometry_ && point.x() < unwrapBelowX
                 && !qFuzzyCompare(point.x(), unwrapBelowX)
-                && !qFuzzyCompare(geoLeftBound_.longitude(), coord.longitude()))
+                && !qFuzzyCompare(geoLeftBound_.longitude(), path.longitude(i))) {
+            path.coordinateAt(i, &coord);
             point.setX(unwrapBelowX + geoDistanceToScreenWidth(map, geoLeftBound_, coord));
+        }
 
         if (i == 0) {
             origin = point;
             minX = point.x();
-            srcOrigin_ = coord;
+            srcOrigin_ = path.at(i);
             srcPath_.moveTo(point.toPointF() - origin.toPointF());
             lastPoint = point;
         } else {
@@ -207,6 +228,16 @@ void QGeoMapPolygonGeometry::updateSourcePoints(const QGeoMap &map,
     geoLeftBound_ = map.screenPositionToCoordinate(QDoubleVector2D(minX, 0), false);
 }
 
+/*!
+    \internal
+*/
+bool QGeoMapPolygonGeometry::scaleSourcePoints(qreal factor)
+{
+    srcPath_ = QTransform::fromScale(factor, factor).map(srcPath_);
+    sourceBounds_ = srcPath_.boundingRect();
+    return true;
+}
+
 /*!
     \internal
 */
@@ -215,109 +246,127 @@ void QGeoMapPolygonGeometry::updateScreenPoints(const QGeoMap &map)
     if (!screenDirty_)
         return;
 
-    if (map.width() == 0 || map.height() == 0) {
+    updateScreenPoints(viewport(map));
+}
+
+/*!
+    \internal
+
+    The screen pass proper. It only reads \a mapViewport and this geometry,
+    so it may run on a worker thread on a private copy of the geometry.
+*/
+void QGeoMapPolygonGeometry::updateScreenPoints(const QGeoMapItemViewport &mapViewport)
+{
+    if (!screenDirty_)
+        return;
+
+    if (mapViewport.mapSize.width() == 0 || mapViewport.mapSize.height() == 0) {
+        clipped_ = true;
+        coveredRect_ = QRectF();
         clear();
         return;
     }
 
-    QDoubleVector2D origin = map.coordinateToScreenPosition(srcOrigin_, false);
-
-    // Create the viewport rect in the same coordinate system
+    // Create the clip rect in the same coordinate system
     // as the actual points
-    QRectF viewport(0, 0, map.width(), map.height());
-    viewport.translate(-1 * origin.toPointF());
+    QRectF viewport = sourceClipRect(mapViewport);
 
-    QPainterPath vpPath;
-    vpPath.addRect(viewport);
-
-    QPainterPath ppi;
-    if (clipToViewport_)
-        ppi = srcPath_.intersected(vpPath); // get the clipped version of the path
-    else ppi = srcPath_;
+    clipped_ = clipToViewport_;
+    coveredRect_ = viewport;
 
     clear();
 
+    QGeoPolygonTessellator *tessellator = polygonTessellator();
+    tessellator->clear();
+    if (clipToViewport_)
+        tessellator->setClipRect(viewport);
+    tessellator->addPath(srcPath_);
+    tessellator->tessellate();
+
     // a polygon requires at least 3 points;
-    if (ppi.elementCount() < 3)
+    if (tessellator->ringCount() == 0) {
+        screenOutline_ = QPainterPath();
+        screenBounds_ = QRectF();
         return;
-
-    // Intersection between the viewport and a concave polygon can create multiple polygons
-    // joined by a line at the viewport border, and poly2tri does not triangulate this very well
-    // so use the full src path if the resulting polygon is concave.
-    if (clipToViewport_) {
-        int changeInX = 0;
-        int changeInY = 0;
-        QPainterPath::Element e1 = ppi.elementAt(1);
-        QPainterPath::Element e = ppi.elementAt(0);
-        QVector2D edgeA(e1.x - e.x ,e1.y - e.y);
-        for (int i = 2; i <= ppi.elementCount(); ++i) {
-            e = ppi.elementAt(i % ppi.elementCount());
-            if (e.x == e1.x && e.y == e1.y)
-                continue;
-            QVector2D edgeB(e.x - e1.x, e.y - e1.y);
-            if ((edgeA.x() < 0) == (edgeB.x() >= 0))
-                changeInX++;
-            if ((edgeA.y() < 0) == (edgeB.y() >= 0))
-                changeInY++;
-            edgeA = edgeB;
-            e1 = e;
-        }
-        if (changeInX > 2 || changeInY > 2) // polygon is concave
-            ppi = srcPath_;
     }
 
     // translate the path into top-left-centric coordinates
-    QRectF bb = ppi.boundingRect();
-    ppi.translate(-bb.left(), -bb.top());
-    firstPointOffset_ = -1 * bb.topLeft();
-
-    ppi.closeSubpath();
-
-    screenOutline_ = ppi;
-
-    std::vector<p2t::Point*> curPts;
-    curPts.reserve(ppi.elementCount());
-    for (int i = 0; i < ppi.elementCount(); ++i) {
-        const QPainterPath::Element e = ppi.elementAt(i);
-        if (e.isMoveTo() || i == ppi.elementCount() - 1
-                || (qAbs(e.x - curPts.front()->x) < 0.1
-                    && qAbs(e.y - curPts.front()->y) < 0.1)) {
-            if (curPts.size() > 2) {
-                p2t::CDT *cdt = new p2t::CDT(curPts);
-                cdt->Triangulate();
-                std::vector<p2t::Triangle*> tris = cdt->GetTriangles();
-                screenVertices_.reserve(screenVertices_.size() + int(tris.size()));
-                for (size_t i = 0; i < tris.size(); ++i) {
-                    p2t::Triangle *t = tris.at(i);
-                    for (int j = 0; j < 3; ++j) {
-                        p2t::Point *p = t->GetPoint(j);
-                        screenVertices_ << QPointF(p->x, p->y);
-                    }
-                }
-                delete cdt;
-            }
-            curPts.clear();
-            curPts.reserve(ppi.elementCount() - i);
-            curPts.push_back(new p2t::Point(e.x, e.y));
-        } else if (e.isLineTo()) {
-            curPts.push_back(new p2t::Point(e.x, e.y));
-        } else {
-            qWarning("Unhandled element type in polygon painterpath");
-        }
+    const QVector<QPointF> &vertices = tessellator->vertices();
+    double minX = vertices.first().x();
+    double minY = vertices.first().y();
+    double maxX = minX;
+    double maxY = minY;
+    for (int i = 1; i < vertices.size(); ++i) {
+        minX = qMin(minX, vertices.at(i).x());
+        minY = qMin(minY, vertices.at(i).y());
+        maxX = qMax(maxX, vertices.at(i).x());
+        maxY = qMax(maxY, vertices.at(i).y());
+    }
+    const QPointF offset(-minX, -minY);
+    firstPointOffset_ = offset;
+
+    setScreenTriangles(*tessellator, offset);
+
+    screenOutline_ = QPainterPath();
+    for (int r = 0; r < tessellator->ringCount(); ++r) {
+        const int start = tessellator->ringStart(r);
+        const int end = start + tessellator->ringSize(r);
+        screenOutline_.moveTo(vertices.at(start) + offset);
+        for (int i = start + 1; i < end; ++i)
+            screenOutline_.lineTo(vertices.at(i) + offset);
+        screenOutline_.closeSubpath();
     }
 
-    if (curPts.size() > 0) {
-        qDeleteAll(curPts.begin(), curPts.end());
-        curPts.clear();
+    screenBounds_ = QRectF(0, 0, maxX - minX, maxY - minY);
+}
+
+/*!
+    \internal
+
+    Copies the triangles of \a tessellator, moved by \a offset, into the
+    screen geometry. They are indexed unless there are too many vertices
+    for 16 bit indices.
+*/
+void QGeoMapPolygonGeometry::setScreenTriangles(const QGeoPolygonTessellator &tessellator,
+                                                const QPointF &offset)
+{
+    const QVector<QPointF> &vertices = tessellator.vertices();
+    const QVector<quint32> &indices = tessellator.indices();
+
+    // copied rather than shared, so the tessellator keeps its buffers
+    if (vertices.size() <= 0xffff) {
+        screenVertices_.resize(vertices.size());
+        for (int i = 0; i < vertices.size(); ++i)
+            screenVertices_[i] = vertices.at(i) + offset;
+        screenIndices_.resize(indices.size());
+        for (int i = 0; i < indices.size(); ++i)
+            screenIndices_[i] = indices.at(i);
+    } else {
+        screenVertices_.resize(indices.size());
+        for (int i = 0; i < indices.size(); ++i)
+            screenVertices_[i] = vertices.at(indices.at(i)) + offset;
+        screenIndices_.clear();
     }
+}
 
-    screenBounds_ = ppi.boundingRect();
+/*!
+    \internal
 
+    Returns the tessellator of the calling thread. Its buffers outlive the
+    frame, so a polygon of unchanged size is tessellated without allocating.
+*/
+QGeoPolygonTessellator *QGeoMapPolygonGeometry::polygonTessellator()
+{
+    if (!mapPolygonTessellators()->hasLocalData())
+        mapPolygonTessellators()->setLocalData(new QGeoPolygonTessellator);
+    return mapPolygonTessellators()->localData();
 }
 
 QDeclarativePolygonMapItem::QDeclarativePolygonMapItem(QQuickItem *parent)
 :   QDeclarativeGeoMapItemBase(parent), color_(Qt::transparent), dirtyMaterial_(true),
-    updatingGeometry_(false)
+    notifier_(new QGeoMapItemGeometryNotifier(this, "geometryJobFinished")),
+    rebuildRequested_(false), updatingGeometry_(false),
+    pathRevision_(0), pendingRevision_(0)
 {
     setFlag(ItemHasContents, true);
     QObject::connect(&border_, SIGNAL(colorChanged(QColor)),
@@ -337,6 +386,7 @@ void QDeclarativePolygonMapItem::handleBorderUpdated()
 
 QDeclarativePolygonMapItem::~QDeclarativePolygonMapItem()
 {
+    notifier_->detach();
 }
 
 /*!
@@ -421,6 +471,7 @@ void QDeclarativePolygonMapItem::setPath(const QJSValue &value)
 
     path_ = pathList;
 
+    ++pathRevision_;
     geometry_.markSourceDirty();
     borderGeometry_.markSourceDirty();
     polish();
@@ -439,6 +490,7 @@ void QDeclarativePolygonMapItem::addCoordinate(const QGeoCoordinate &coordinate)
 {
     path_.append(coordinate);
 
+    ++pathRevision_;
     geometry_.markSourceDirty();
     borderGeometry_.markSourceDirty();
     polish();
@@ -470,6 +522,7 @@ void QDeclarativePolygonMapItem::removeCoordinate(const QGeoCoordinate &coordina
     }
     path_.removeAt(index);
 
+    ++pathRevision_;
     geometry_.markSourceDirty();
     borderGeometry_.markSourceDirty();
     polish();
@@ -508,21 +561,37 @@ QSGNode *QDeclarativePolygonMapItem::updateMapItemPaintNode(QSGNode *oldNode, Up
     Q_UNUSED(data);
     MapPolygonNode *node = static_cast<MapPolygonNode *>(oldNode);
 
-    if (!node)
+    // the geometry may have gone to the map's batches so far
+    if (!node) {
         node = new MapPolygonNode();
+        dirtyMaterial_ = true;
+    }
 
     //TODO: update only material
-    if (geometry_.isScreenDirty() || borderGeometry_.isScreenDirty() || dirtyMaterial_) {
-        node->update(color_, border_.color(), &geometry_, &borderGeometry_);
-        geometry_.setPreserveGeometry(false);
-        borderGeometry_.setPreserveGeometry(false);
-        geometry_.markClean();
-        borderGeometry_.markClean();
+    if (displayedGeometry_.isScreenDirty() || displayedBorderGeometry_.isScreenDirty() || dirtyMaterial_) {
+        node->update(color_, border_.color(), &displayedGeometry_, &displayedBorderGeometry_);
+        displayedGeometry_.markClean();
+        displayedBorderGeometry_.markClean();
         dirtyMaterial_ = false;
     }
     return node;
 }
 
+/*!
+    \internal
+*/
+bool QDeclarativePolygonMapItem::updateMapItemBatch(QGeoMapItemBatchNode *batch, bool force)
+{
+    if (force || displayedGeometry_.isScreenDirty() || displayedBorderGeometry_.isScreenDirty() || dirtyMaterial_) {
+        batch->setItemPart(batchId(), 0, GL_TRIANGLES, color_, displayedGeometry_);
+        batch->setItemPart(batchId(), 1, GL_TRIANGLE_STRIP, border_.color(), displayedBorderGeometry_);
+        displayedGeometry_.markClean();
+        displayedBorderGeometry_.markClean();
+        dirtyMaterial_ = false;
+    }
+    return true;
+}
+
 /*!
     \internal
 */
@@ -531,31 +600,115 @@ void QDeclarativePolygonMapItem::updatePolish()
     if (!map() || path_.count() == 0)
         return;
 
-    QScopedValueRollback<bool> rollback(updatingGeometry_);
-    updatingGeometry_ = true;
+    const bool drawBorder = border_.color() != Qt::transparent && border_.width() > 0;
 
-    geometry_.updateSourcePoints(*map(), path_);
-    geometry_.updateScreenPoints(*map());
+    if (path_.count() < QGeoMapItemGeometryJob::MinimumPoints && !pendingGeometry_) {
+        geometry_.updateSourcePoints(*map(), path_);
+        geometry_.updateScreenPoints(*map());
 
-    QList<QGeoCoordinate> closedPath = path_;
-    closedPath << closedPath.first();
-    borderGeometry_.clear();
-    borderGeometry_.updateSourcePoints(*map(), closedPath);
+        QList<QGeoCoordinate> closedPath = path_;
+        closedPath << closedPath.first();
+        borderGeometry_.updateSourcePoints(*map(), closedPath);
 
-    if (border_.color() != Qt::transparent && border_.width() > 0)
-        borderGeometry_.updateScreenPoints(*map(), border_.width());
+        // the border is kept while it does not have to be rebuilt
+        if (drawBorder)
+            borderGeometry_.updateScreenPoints(*map(), border_.width());
+        else
+            borderGeometry_.clear();
+
+        showGeometry(geometry_, borderGeometry_);
+        geometry_.setPreserveGeometry(false);
+        borderGeometry_.setPreserveGeometry(false);
+        geometry_.markClean();
+        borderGeometry_.markClean();
+        return;
+    }
+
+    // Large polygons are triangulated on a worker thread. Until the job
+    // reports back the item keeps showing the last geometry, moved along
+    // with the map.
+    if (pendingGeometry_) {
+        rebuildRequested_ = true;
+    } else if (geometry_.isScreenDirty() || borderGeometry_.isScreenDirty()) {
+        geometry_.updateSourcePoints(*map(), path_);
+
+        QList<QGeoCoordinate> closedPath = path_;
+        closedPath << closedPath.first();
+        borderGeometry_.clear();
+        borderGeometry_.updateSourcePoints(*map(), closedPath);
+
+        pendingGeometry_ = QSharedPointer<QGeoMapPolygonGeometry>(new QGeoMapPolygonGeometry(geometry_));
+        pendingBorderGeometry_ = QSharedPointer<QGeoMapPolylineGeometry>(new QGeoMapPolylineGeometry(borderGeometry_));
+
+        pendingRevision_ = pathRevision_;
+        QGeoMapItemGeometryJob *job = new QGeoMapItemGeometryJob(notifier_);
+        job->addGeometry(pendingGeometry_, geometry_.viewport(*map()));
+        if (drawBorder)
+            job->addGeometry(pendingBorderGeometry_, borderGeometry_.viewport(*map(), border_.width()));
+        QGeoMapItemGeometryJob::threadPool()->start(job);
+
+        geometry_.setPreserveGeometry(false);
+        borderGeometry_.setPreserveGeometry(false);
+        geometry_.markClean();
+        borderGeometry_.markClean();
+    }
+
+    if (displayedGeometry_.origin().isValid()) {
+        QScopedValueRollback<bool> rollback(updatingGeometry_);
+        updatingGeometry_ = true;
+        setPositionOnMap(displayedGeometry_.origin(),
+                         -1 * displayedGeometry_.sourceBoundingBox().topLeft());
+    }
+}
+
+/*!
+    \internal
+*/
+void QDeclarativePolygonMapItem::showGeometry(const QGeoMapPolygonGeometry &geometry,
+                                              const QGeoMapPolylineGeometry &borderGeometry)
+{
+    QScopedValueRollback<bool> rollback(updatingGeometry_);
+    updatingGeometry_ = true;
+
+    displayedGeometry_ = geometry;
+    displayedBorderGeometry_ = borderGeometry;
 
     QList<QGeoMapItemGeometry *> geoms;
-    geoms << &geometry_ << &borderGeometry_;
+    geoms << &displayedGeometry_ << &displayedBorderGeometry_;
     QRectF combined = QGeoMapItemGeometry::translateToCommonOrigin(geoms);
 
     setWidth(combined.width());
     setHeight(combined.height());
 
-    setPositionOnMap(path_.at(0), -1 * geometry_.sourceBoundingBox().topLeft());
+    setPositionOnMap(displayedGeometry_.origin(),
+                     -1 * displayedGeometry_.sourceBoundingBox().topLeft());
     update();
 }
 
+/*!
+    \internal
+*/
+void QDeclarativePolygonMapItem::geometryJobFinished()
+{
+    if (!pendingGeometry_)
+        return;
+
+    QSharedPointer<QGeoMapPolygonGeometry> finished = pendingGeometry_;
+    QSharedPointer<QGeoMapPolylineGeometry> finishedBorder = pendingBorderGeometry_;
+    pendingGeometry_.clear();
+    pendingBorderGeometry_.clear();
+    // a result for a path which has changed since is dropped, the
+    // rebuild below replaces it
+    if (map() && pendingRevision_ == pathRevision_)
+        showGeometry(*finished, *finishedBorder);
+
+    // the path or the viewport changed while the job was running
+    if (rebuildRequested_) {
+        rebuildRequested_ = false;
+        polish();
+    }
+}
+
 /*!
     \internal
 */
@@ -564,27 +717,39 @@ void QDeclarativePolygonMapItem::afterViewportChanged(const QGeoMapViewportChang
     if (event.mapSize.width() <= 0 || event.mapSize.height() <= 0)
         return;
 
-    // if the scene is tilted, we must regenerate our geometry every frame
-    if (map()->cameraCapabilities().supportsTilting()
-            && (event.cameraData.tilt() > 0.1
-                || event.cameraData.tilt() < -0.1)) {
+    const bool drawBorder = border_.color() != Qt::transparent && border_.width() > 0;
+
+    switch (event.changeType) {
+    case QGeoMapViewportChangeEvent::NoChange:
+    case QGeoMapViewportChangeEvent::Translation:
+        // panning only moves the item, until the viewport leaves the area
+        // the screen geometry was clipped to
+        if (!pendingGeometry_ && !geometry_.isScreenDirty() && !borderGeometry_.isScreenDirty()
+                && displayedGeometry_.coversViewport(displayedGeometry_.viewport(*map()))
+                && (!drawBorder || displayedBorderGeometry_.coversViewport(
+                        displayedBorderGeometry_.viewport(*map(), border_.width())))) {
+            polish();
+            return;
+        }
+        break;
+    case QGeoMapViewportChangeEvent::IntegerZoomChange:
+        // the source points were thinned out for the old zoom level, which
+        // is still fine enough after zooming out
+        if (event.zoomLevelDelta < 0
+                && !geometry_.isSourceDirty() && !borderGeometry_.isSourceDirty()) {
+            const qreal factor = std::pow(2.0, qRound(event.zoomLevelDelta));
+            if (geometry_.scaleSourcePoints(factor) && borderGeometry_.scaleSourcePoints(factor))
+                break;
+        }
         geometry_.markSourceDirty();
         borderGeometry_.markSourceDirty();
-    }
-
-    // if the scene is rolled, we must regen too
-    if (map()->cameraCapabilities().supportsRolling()
-            && (event.cameraData.roll() > 0.1
-                || event.cameraData.roll() < -0.1)) {
+        break;
+    default:
         geometry_.markSourceDirty();
         borderGeometry_.markSourceDirty();
+        break;
     }
 
-    // otherwise, only regen on rotate, resize and zoom
-    if (event.bearingChanged || event.mapSizeChanged || event.zoomLevelChanged) {
-        geometry_.markSourceDirty();
-        borderGeometry_.markSourceDirty();
-    }
     geometry_.setPreserveGeometry(true, geometry_.geoLeftBound());
     borderGeometry_.setPreserveGeometry(true, borderGeometry_.geoLeftBound());
     geometry_.markScreenDirty();
@@ -597,7 +762,7 @@ void QDeclarativePolygonMapItem::afterViewportChanged(const QGeoMapViewportChang
 */
 bool QDeclarativePolygonMapItem::contains(const QPointF &point) const
 {
-    return (geometry_.contains(point) || borderGeometry_.contains(point));
+    return (displayedGeometry_.contains(point) || displayedBorderGeometry_.contains(point));
 }
 
 /*!
@@ -610,7 +775,7 @@ void QDeclarativePolygonMapItem::geometryChanged(const QRectF &newGeometry, cons
         return;
     }
 
-    QDoubleVector2D newPoint = QDoubleVector2D(x(),y()) + QDoubleVector2D(geometry_.firstPointOffset());
+    QDoubleVector2D newPoint = QDoubleVector2D(x(),y()) + QDoubleVector2D(displayedGeometry_.firstPointOffset());
     QGeoCoordinate newCoordinate = map()->screenPositionToCoordinate(newPoint, false);
     if (newCoordinate.isValid()) {
         double firstLongitude = path_.at(0).longitude();
@@ -644,6 +809,7 @@ void QDeclarativePolygonMapItem::geometryChanged(const QRectF &newGeometry, cons
                            + newCoordinate.longitude() - firstLongitude));
         geometry_.setPreserveGeometry(true, leftBoundCoord);
         borderGeometry_.setPreserveGeometry(true, leftBoundCoord);
+        ++pathRevision_;
         geometry_.markSourceDirty();
         borderGeometry_.markSourceDirty();
         polish();
@@ -44,6 +44,7 @@
 QT_BEGIN_NAMESPACE
 
 class MapPolygonNode;
+class QGeoPolygonTessellator;
 
 class QGeoMapPolygonGeometry : public QGeoMapItemGeometry
 {
@@ -54,10 +55,18 @@ public:
 
     void updateSourcePoints(const QGeoMap &map,
                             const QList<QGeoCoordinate> &path);
+    void updateSourcePoints(const QGeoMap &map,
+                            const QGeoCoordinateArray &path);
 
     void updateScreenPoints(const QGeoMap &map);
+    void updateScreenPoints(const QGeoMapItemViewport &viewport) Q_DECL_OVERRIDE;
+
+    bool scaleSourcePoints(qreal factor) Q_DECL_OVERRIDE;
 
 protected:
+    void setScreenTriangles(const QGeoPolygonTessellator &tessellator, const QPointF &offset);
+    static QGeoPolygonTessellator *polygonTessellator();
+
     QPainterPath srcPath_;
     bool assumeSimple_;
 };
@@ -99,13 +108,19 @@ Q_SIGNALS:
 
 protected:
     void geometryChanged(const QRectF &newGeometry, const QRectF &oldGeometry) Q_DECL_OVERRIDE;
+    bool updateMapItemBatch(QGeoMapItemBatchNode *batch, bool force) Q_DECL_OVERRIDE;
 
 protected Q_SLOTS:
     void handleBorderUpdated();
     void afterViewportChanged(const QGeoMapViewportChangeEvent &event);
 
+private Q_SLOTS:
+    void geometryJobFinished();
+
 private:
     void pathPropertyChanged();
+    void showGeometry(const QGeoMapPolygonGeometry &geometry,
+                      const QGeoMapPolylineGeometry &borderGeometry);
 
     QDeclarativeMapLineProperties border_;
     QList<QGeoCoordinate> path_;
@@ -113,7 +128,15 @@ private:
     bool dirtyMaterial_;
     QGeoMapPolygonGeometry geometry_;
     QGeoMapPolylineGeometry borderGeometry_;
+    QGeoMapPolygonGeometry displayedGeometry_;
+    QGeoMapPolylineGeometry displayedBorderGeometry_;
+    QSharedPointer<QGeoMapPolygonGeometry> pendingGeometry_;
+    QSharedPointer<QGeoMapPolylineGeometry> pendingBorderGeometry_;
+    QSharedPointer<QGeoMapItemGeometryNotifier> notifier_;
+    bool rebuildRequested_;
     bool updatingGeometry_;
+    int pathRevision_;
+    int pendingRevision_;
 };
 
 //////////////////////////////////////////////////////////////////////
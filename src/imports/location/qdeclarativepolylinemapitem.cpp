@@ -32,13 +32,17 @@
  ****************************************************************************/
 
 #include "qdeclarativepolylinemapitem_p.h"
+#include "qgeosimplifiedpath_p.h"
 #include "qgeocameracapabilities_p.h"
 #include "qlocationutils_p.h"
 #include "error_messages.h"
 #include "locationvaluetypehelper_p.h"
 #include "qdoublevector2d_p.h"
 
+#include <cmath>
+
 #include <QtCore/QScopedValueRollback>
+#include <QtCore/QThreadPool>
 #include <QtQml/QQmlInfo>
 #include <QtQml/QQmlContext>
 #include <QtQml/private/qqmlengine_p.h>
@@ -181,6 +185,18 @@ QGeoMapPolylineGeometry::QGeoMapPolylineGeometry()
 */
 void QGeoMapPolylineGeometry::updateSourcePoints(const QGeoMap &map,
                                                  const QList<QGeoCoordinate> &path)
+{
+    if (!sourceDirty_)
+        return;
+
+    updateSourcePoints(map, QGeoCoordinateArray(path));
+}
+
+/*!
+    \internal
+*/
+void QGeoMapPolylineGeometry::updateSourcePoints(const QGeoMap &map,
+                                                 const QGeoCoordinateArray &path)
 {
     bool foundValid = false;
     double minX = -1.0;
@@ -203,13 +219,18 @@ void QGeoMapPolylineGeometry::updateSourcePoints(const QGeoMap &map,
     if (preserveGeometry_)
         unwrapBelowX = map.coordinateToScreenPosition(geoLeftBound_, false).x();
 
-    for (int i = 0; i < path.size(); ++i) {
-        const QGeoCoordinate &coord = path.at(i);
+    // project the whole path with one camera setup
+    QVector<QDoubleVector2D> projected(path.size());
+    map.coordinatesToScreenPositions(path, projected.data(), false);
 
-        if (!coord.isValid())
+    // reused for every point, so that walking the path does not allocate
+    QGeoCoordinate coord;
+
+    for (int i = 0; i < path.size(); ++i) {
+        if (!path.isValid(i))
             continue;
 
-        QDoubleVector2D point = map.coordinateToScreenPosition(coord, false);
+        QDoubleVector2D point = projected.at(i);
 
         // We can get NaN if the map isn't set up correctly, or the projection
         // is faulty -- probably best thing to do is abort
@@ -218,13 +239,15 @@ void QGeoMapPolylineGeometry::updateSourcePoints(const QGeoMap &map,
 
         // unwrap x to preserve geometry if moved to border of map
         if (preserveGeometry_ && point.x() < unwrapBelowX
-                && !qFuzzyCompare(geoLeftBound_.longitude(), coord.longitude())
-                && !qFuzzyCompare(point.x(), unwrapBelowX))
+                && !qFuzzyCompare(geoLeftBound_.longitude(), path.longitude(i))
+                && !qFuzzyCompare(point.x(), unwrapBelowX)) {
+            path.coordinateAt(i, &coord);
             point.setX(unwrapBelowX + geoDistanceToScreenWidth(map, geoLeftBound_, coord));
+        }
 
         if (!foundValid) {
             foundValid = true;
-            srcOrigin_ = coord;
+            srcOrigin_ = path.at(i);
             origin = point;
             point = QDoubleVector2D(0,0);
 
@@ -374,6 +397,19 @@ static void clipPathToRect(const QVector<qreal> &points,
     }
 }
 
+/*!
+    \internal
+*/
+bool QGeoMapPolylineGeometry::scaleSourcePoints(qreal factor)
+{
+    for (int i = 0; i < srcPoints_.size(); ++i)
+        srcPoints_[i] *= factor;
+
+    sourceBounds_ = QRectF(sourceBounds_.topLeft() * factor,
+                           sourceBounds_.bottomRight() * factor);
+    return true;
+}
+
 /*!
     \internal
 */
@@ -383,18 +419,34 @@ void QGeoMapPolylineGeometry::updateScreenPoints(const QGeoMap &map,
     if (!screenDirty_)
         return;
 
-    QPointF origin = map.coordinateToScreenPosition(srcOrigin_, false).toPointF();
+    updateScreenPoints(viewport(map, strokeWidth));
+}
+
+/*!
+    \internal
+
+    The screen pass proper. It only reads \a mapViewport and this geometry,
+    so it may run on a worker thread on a private copy of the geometry.
+*/
+void QGeoMapPolylineGeometry::updateScreenPoints(const QGeoMapItemViewport &mapViewport)
+{
+    if (!screenDirty_)
+        return;
+
+    const QPointF origin = mapViewport.origin;
+    const qreal strokeWidth = mapViewport.strokeWidth;
+
+    clipped_ = true;
+    coveredRect_ = QRectF();
 
     if (!qIsFinite(origin.x()) || !qIsFinite(origin.y())) {
         clear();
         return;
     }
 
-    // Create the viewport rect in the same coordinate system
+    // Create the clip rect in the same coordinate system
     // as the actual points
-    QRectF viewport(0, 0, map.width(), map.height());
-    viewport.adjust(-strokeWidth, -strokeWidth, strokeWidth, strokeWidth);
-    viewport.translate(-1 * origin);
+    QRectF viewport = sourceClipRect(mapViewport);
 
     // Perform clipping to the viewport limits
     QVector<qreal> points;
@@ -402,9 +454,11 @@ void QGeoMapPolylineGeometry::updateScreenPoints(const QGeoMap &map,
 
     if (clipToViewport_) {
         clipPathToRect(srcPoints_, srcPointTypes_, viewport, points, types);
+        coveredRect_ = viewport;
     } else {
         points = srcPoints_;
         types = srcPointTypes_;
+        clipped_ = false;
     }
 
     QVectorPath vp(points.data(), types.size(), types.data());
@@ -444,7 +498,11 @@ void QGeoMapPolylineGeometry::updateScreenPoints(const QGeoMap &map,
 }
 
 QDeclarativePolylineMapItem::QDeclarativePolylineMapItem(QQuickItem *parent)
-:   QDeclarativeGeoMapItemBase(parent), dirtyMaterial_(true), updatingGeometry_(false)
+:   QDeclarativeGeoMapItemBase(parent), dirtyMaterial_(true),
+    notifier_(new QGeoMapItemGeometryNotifier(this, "geometryJobFinished")),
+    simplificationNotifier_(new QGeoMapItemGeometryNotifier(this, "simplificationJobFinished")),
+    rebuildRequested_(false), resimplifyRequested_(false), updatingGeometry_(false),
+    pathRevision_(0), pendingRevision_(0)
 {
     setFlag(ItemHasContents, true);
     QObject::connect(&line_, SIGNAL(colorChanged(QColor)),
@@ -455,6 +513,8 @@ QDeclarativePolylineMapItem::QDeclarativePolylineMapItem(QQuickItem *parent)
 
 QDeclarativePolylineMapItem::~QDeclarativePolylineMapItem()
 {
+    notifier_->detach();
+    simplificationNotifier_->detach();
 }
 
 /*!
@@ -493,9 +553,9 @@ QJSValue QDeclarativePolylineMapItem::path() const
     QV4::ExecutionEngine *v4 = QQmlEnginePrivate::getV4Engine(engine);
 
     QV4::Scope scope(v4);
-    QV4::Scoped<QV4::ArrayObject> pathArray(scope, v4->newArrayObject(path_.length()));
-    for (int i = 0; i < path_.length(); ++i) {
-        const QGeoCoordinate &c = path_.at(i);
+    QV4::Scoped<QV4::ArrayObject> pathArray(scope, v4->newArrayObject(path_.size()));
+    for (int i = 0; i < path_.size(); ++i) {
+        const QGeoCoordinate c = path_.at(i);
 
         QV4::ScopedValue cv(scope, v4->fromVariant(QVariant::fromValue(c)));
         pathArray->putIndexed(i, cv);
@@ -509,8 +569,9 @@ void QDeclarativePolylineMapItem::setPath(const QJSValue &value)
     if (!value.isArray())
         return;
 
-    QList<QGeoCoordinate> pathList;
+    QGeoCoordinateArray pathList;
     quint32 length = value.property(QStringLiteral("length")).toUInt();
+    pathList.reserve(length);
     for (quint32 i = 0; i < length; ++i) {
         bool ok;
         QGeoCoordinate c = parseCoordinate(value.property(i), &ok);
@@ -527,7 +588,9 @@ void QDeclarativePolylineMapItem::setPath(const QJSValue &value)
         return;
 
     path_ = pathList;
+    simplifyPath();
 
+    ++pathRevision_;
     geometry_.markSourceDirty();
     polish();
     emit pathChanged();
@@ -544,7 +607,9 @@ void QDeclarativePolylineMapItem::setPath(const QJSValue &value)
 void QDeclarativePolylineMapItem::addCoordinate(const QGeoCoordinate &coordinate)
 {
     path_.append(coordinate);
+    simplifyPath();
 
+    ++pathRevision_;
     geometry_.markSourceDirty();
     polish();
     emit pathChanged();
@@ -568,12 +633,14 @@ void QDeclarativePolylineMapItem::removeCoordinate(const QGeoCoordinate &coordin
         return;
     }
 
-    if (path_.count() < index + 1) {
+    if (path_.size() < index + 1) {
         qmlInfo(this) << COORD_NOT_BELONG_TO << QStringLiteral("PolylineMapItem");
         return;
     }
     path_.removeAt(index);
+    simplifyPath();
 
+    ++pathRevision_;
     geometry_.markSourceDirty();
     polish();
     emit pathChanged();
@@ -608,15 +675,15 @@ void QDeclarativePolylineMapItem::geometryChanged(const QRectF &newGeometry, con
         return;
     }
 
-    QDoubleVector2D newPoint = QDoubleVector2D(x(),y()) + QDoubleVector2D(geometry_.firstPointOffset());
+    QDoubleVector2D newPoint = QDoubleVector2D(x(),y()) + QDoubleVector2D(displayedGeometry_.firstPointOffset());
     QGeoCoordinate newCoordinate = map()->screenPositionToCoordinate(newPoint, false);
     if (newCoordinate.isValid()) {
-        double firstLongitude = path_.at(0).longitude();
-        double firstLatitude = path_.at(0).latitude();
+        double firstLongitude = path_.longitude(0);
+        double firstLatitude = path_.latitude(0);
         double minMaxLatitude = firstLatitude;
         // prevent dragging over valid min and max latitudes
-        for (int i = 0; i < path_.count(); ++i) {
-            double newLatitude = path_.at(i).latitude()
+        for (int i = 0; i < path_.size(); ++i) {
+            double newLatitude = path_.latitude(i)
                     + newCoordinate.latitude() - firstLatitude;
             if (!QLocationUtils::isValidLat(newLatitude)) {
                 if (qAbs(newLatitude) > qAbs(minMaxLatitude)) {
@@ -626,20 +693,22 @@ void QDeclarativePolylineMapItem::geometryChanged(const QRectF &newGeometry, con
         }
         // calculate offset needed to re-position the item within map border
         double offsetLatitude = minMaxLatitude - QLocationUtils::clipLat(minMaxLatitude);
-        for (int i = 0; i < path_.count(); ++i) {
-            QGeoCoordinate coord = path_.at(i);
+        for (int i = 0; i < path_.size(); ++i) {
             // handle dateline crossing
-            coord.setLongitude(QLocationUtils::wrapLong(coord.longitude()
-                               + newCoordinate.longitude() - firstLongitude));
-            coord.setLatitude(coord.latitude()
-                              + newCoordinate.latitude() - firstLatitude - offsetLatitude);
-            path_.replace(i, coord);
+            double longitude = QLocationUtils::wrapLong(path_.longitude(i)
+                               + newCoordinate.longitude() - firstLongitude);
+            double latitude = path_.latitude(i)
+                              + newCoordinate.latitude() - firstLatitude - offsetLatitude;
+            path_.replace(i, latitude, longitude, path_.altitude(i));
         }
 
         QGeoCoordinate leftBoundCoord = geometry_.geoLeftBound();
         leftBoundCoord.setLongitude(QLocationUtils::wrapLong(leftBoundCoord.longitude()
                            + newCoordinate.longitude() - firstLongitude));
+        simplifyPath();
+
         geometry_.setPreserveGeometry(true, leftBoundCoord);
+        ++pathRevision_;
         geometry_.markSourceDirty();
         polish();
         emit pathChanged();
@@ -657,24 +726,31 @@ void QDeclarativePolylineMapItem::afterViewportChanged(const QGeoMapViewportChan
     if (event.mapSize.width() <= 0 || event.mapSize.height() <= 0)
         return;
 
-    // if the scene is tilted, we must regenerate our geometry every frame
-    if (map()->cameraCapabilities().supportsTilting()
-            && (event.cameraData.tilt() > 0.1
-                || event.cameraData.tilt() < -0.1)) {
+    switch (event.changeType) {
+    case QGeoMapViewportChangeEvent::NoChange:
+    case QGeoMapViewportChangeEvent::Translation:
+        // panning only moves the item, until the viewport leaves the area
+        // the screen geometry was clipped to
+        if (!pendingGeometry_ && !geometry_.isScreenDirty()
+                && displayedGeometry_.coversViewport(displayedGeometry_.viewport(*map(), line_.width()))) {
+            polish();
+            return;
+        }
+        break;
+    case QGeoMapViewportChangeEvent::IntegerZoomChange:
+        // the source points were thinned out for the old zoom level, which
+        // is still fine enough after zooming out, unless there is a coarser
+        // level of detail to project instead
+        if (event.zoomLevelDelta < 0 && !geometry_.isSourceDirty() && !simplifiedPath_
+                && geometry_.scaleSourcePoints(std::pow(2.0, qRound(event.zoomLevelDelta))))
+            break;
         geometry_.markSourceDirty();
-    }
-
-    // if the scene is rolled, we must regen too
-    if (map()->cameraCapabilities().supportsRolling()
-            && (event.cameraData.roll() > 0.1
-                || event.cameraData.roll() < -0.1)) {
+        break;
+    default:
         geometry_.markSourceDirty();
+        break;
     }
 
-    // otherwise, only regen on rotate, resize and zoom
-    if (event.bearingChanged || event.mapSizeChanged || event.zoomLevelChanged) {
-        geometry_.markSourceDirty();
-    }
     geometry_.setPreserveGeometry(true, geometry_.geoLeftBound());
     geometry_.markScreenDirty();
     polish();
@@ -685,22 +761,151 @@ void QDeclarativePolylineMapItem::afterViewportChanged(const QGeoMapViewportChan
 */
 void QDeclarativePolylineMapItem::updatePolish()
 {
-    if (!map() || path_.count() == 0)
+    if (!map() || path_.isEmpty())
+        return;
+
+    if (path_.size() < QGeoMapItemGeometryJob::MinimumPoints && !pendingGeometry_) {
+        updateSourcePoints();
+        geometry_.updateScreenPoints(*map(), line_.width());
+        showGeometry(geometry_);
+        geometry_.setPreserveGeometry(false);
+        geometry_.markClean();
+        return;
+    }
+
+    // Long paths are stroked on a worker thread. Until the job reports back
+    // the item keeps showing the last geometry, moved along with the map.
+    if (pendingGeometry_) {
+        rebuildRequested_ = true;
+    } else if (geometry_.isScreenDirty()) {
+        updateSourcePoints();
+
+        pendingGeometry_ = QSharedPointer<QGeoMapPolylineGeometry>(new QGeoMapPolylineGeometry(geometry_));
+        pendingRevision_ = pathRevision_;
+        QGeoMapItemGeometryJob *job = new QGeoMapItemGeometryJob(notifier_);
+        job->addGeometry(pendingGeometry_, geometry_.viewport(*map(), line_.width()));
+        QGeoMapItemGeometryJob::threadPool()->start(job);
+
+        geometry_.setPreserveGeometry(false);
+        geometry_.markClean();
+    }
+
+    if (displayedGeometry_.origin().isValid()) {
+        QScopedValueRollback<bool> rollback(updatingGeometry_);
+        updatingGeometry_ = true;
+        setPositionOnMap(displayedGeometry_.origin(),
+                         -1 * displayedGeometry_.sourceBoundingBox().topLeft());
+    }
+}
+
+/*!
+    \internal
+
+    Projects the path, or for long paths the level of detail which the
+    current zoom level resolves.
+*/
+void QDeclarativePolylineMapItem::updateSourcePoints()
+{
+    if (!geometry_.isSourceDirty())
+        return;
+
+    const double worldWidth = QGeoMapItemGeometry::worldWidth(*map());
+    if (simplifiedPath_ && worldWidth > 0.0) {
+        const int level = QGeoSimplifiedPath::levelForWorldSize(worldWidth);
+        geometry_.updateSourcePoints(*map(), simplifiedPath_->path(level));
+    } else {
+        geometry_.updateSourcePoints(*map(), path_);
+    }
+}
+
+/*!
+    \internal
+
+    Starts building the levels of detail of a long path on a worker thread.
+    Until they are ready the item projects the whole path.
+*/
+void QDeclarativePolylineMapItem::simplifyPath()
+{
+    simplifiedPath_.clear();
+
+    if (pendingSimplifiedPath_) {
+        resimplifyRequested_ = true;
+        return;
+    }
+
+    if (path_.size() < QGeoSimplifiedPath::MinimumPoints)
+        return;
+
+    pendingSimplifiedPath_ = QSharedPointer<QGeoSimplifiedPath>(new QGeoSimplifiedPath);
+    QGeoPathSimplificationJob *job = new QGeoPathSimplificationJob(path_, pendingSimplifiedPath_,
+                                                                   simplificationNotifier_);
+    QGeoMapItemGeometryJob::threadPool()->start(job);
+}
+
+/*!
+    \internal
+*/
+void QDeclarativePolylineMapItem::simplificationJobFinished()
+{
+    if (!pendingSimplifiedPath_)
         return;
 
+    QSharedPointer<QGeoSimplifiedPath> finished = pendingSimplifiedPath_;
+    pendingSimplifiedPath_.clear();
+
+    // the path changed while the job was running
+    if (resimplifyRequested_) {
+        resimplifyRequested_ = false;
+        simplifyPath();
+        return;
+    }
+
+    simplifiedPath_ = finished;
+    geometry_.markSourceDirty();
+    geometry_.markScreenDirty();
+    polish();
+}
+
+/*!
+    \internal
+*/
+void QDeclarativePolylineMapItem::showGeometry(const QGeoMapPolylineGeometry &geometry)
+{
     QScopedValueRollback<bool> rollback(updatingGeometry_);
     updatingGeometry_ = true;
 
-    geometry_.updateSourcePoints(*map(), path_);
-    geometry_.updateScreenPoints(*map(), line_.width());
+    displayedGeometry_ = geometry;
 
-    setWidth(geometry_.sourceBoundingBox().width());
-    setHeight(geometry_.sourceBoundingBox().height());
+    setWidth(displayedGeometry_.sourceBoundingBox().width());
+    setHeight(displayedGeometry_.sourceBoundingBox().height());
 
-    setPositionOnMap(path_.at(0), -1 * geometry_.sourceBoundingBox().topLeft());
+    setPositionOnMap(displayedGeometry_.origin(),
+                     -1 * displayedGeometry_.sourceBoundingBox().topLeft());
     update();
 }
 
+/*!
+    \internal
+*/
+void QDeclarativePolylineMapItem::geometryJobFinished()
+{
+    if (!pendingGeometry_)
+        return;
+
+    QSharedPointer<QGeoMapPolylineGeometry> finished = pendingGeometry_;
+    pendingGeometry_.clear();
+    // a result for a path which has changed since is dropped, the
+    // rebuild below replaces it
+    if (map() && pendingRevision_ == pathRevision_)
+        showGeometry(*finished);
+
+    // the path or the viewport changed while the job was running
+    if (rebuildRequested_) {
+        rebuildRequested_ = false;
+        polish();
+    }
+}
+
 /*!
     \internal
 */
@@ -710,22 +915,37 @@ QSGNode *QDeclarativePolylineMapItem::updateMapItemPaintNode(QSGNode *oldNode, U
 
     MapPolylineNode *node = static_cast<MapPolylineNode *>(oldNode);
 
+    // the geometry may have gone to the map's batches so far
     if (!node) {
         node = new MapPolylineNode();
+        dirtyMaterial_ = true;
     }
 
     //TODO: update only material
-    if (geometry_.isScreenDirty() || dirtyMaterial_) {
-        node->update(line_.color(), &geometry_);
-        geometry_.setPreserveGeometry(false);
-        geometry_.markClean();
+    if (displayedGeometry_.isScreenDirty() || dirtyMaterial_) {
+        node->update(line_.color(), &displayedGeometry_);
+        displayedGeometry_.markClean();
+        dirtyMaterial_ = false;
     }
     return node;
 }
 
+/*!
+    \internal
+*/
+bool QDeclarativePolylineMapItem::updateMapItemBatch(QGeoMapItemBatchNode *batch, bool force)
+{
+    if (force || displayedGeometry_.isScreenDirty() || dirtyMaterial_) {
+        batch->setItemPart(batchId(), 0, GL_TRIANGLE_STRIP, line_.color(), displayedGeometry_);
+        displayedGeometry_.markClean();
+        dirtyMaterial_ = false;
+    }
+    return true;
+}
+
 bool QDeclarativePolylineMapItem::contains(const QPointF &point) const
 {
-    return geometry_.contains(point);
+    return displayedGeometry_.contains(point);
 }
 
 //////////////////////////////////////////////////////////////////////
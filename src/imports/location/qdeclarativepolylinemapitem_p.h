@@ -37,6 +37,8 @@
 #include "qdeclarativegeomapitembase_p.h"
 #include "qgeomapitemgeometry_p.h"
 
+#include <QtPositioning/private/qgeocoordinatearray_p.h>
+
 #include <QSGGeometryNode>
 #include <QSGFlatColorMaterial>
 
@@ -76,9 +78,14 @@ public:
 
     void updateSourcePoints(const QGeoMap &map,
                             const QList<QGeoCoordinate> &path);
+    void updateSourcePoints(const QGeoMap &map,
+                            const QGeoCoordinateArray &path);
 
     void updateScreenPoints(const QGeoMap &map,
                             qreal strokeWidth);
+    void updateScreenPoints(const QGeoMapItemViewport &viewport) Q_DECL_OVERRIDE;
+
+    bool scaleSourcePoints(qreal factor) Q_DECL_OVERRIDE;
 
 private:
     QVector<qreal> srcPoints_;
@@ -119,20 +126,38 @@ Q_SIGNALS:
 
 protected:
     void geometryChanged(const QRectF &newGeometry, const QRectF &oldGeometry) Q_DECL_OVERRIDE;
+    bool updateMapItemBatch(QGeoMapItemBatchNode *batch, bool force) Q_DECL_OVERRIDE;
 
 protected Q_SLOTS:
     void updateAfterLinePropertiesChanged();
     void afterViewportChanged(const QGeoMapViewportChangeEvent &event);
 
+private Q_SLOTS:
+    void geometryJobFinished();
+    void simplificationJobFinished();
+
 private:
     void pathPropertyChanged();
+    void simplifyPath();
+    void updateSourcePoints();
+    void showGeometry(const QGeoMapPolylineGeometry &geometry);
 
     QDeclarativeMapLineProperties line_;
-    QList<QGeoCoordinate> path_;
+    QGeoCoordinateArray path_;
     QColor color_;
     bool dirtyMaterial_;
     QGeoMapPolylineGeometry geometry_;
+    QGeoMapPolylineGeometry displayedGeometry_;
+    QSharedPointer<QGeoMapPolylineGeometry> pendingGeometry_;
+    QSharedPointer<QGeoMapItemGeometryNotifier> notifier_;
+    QSharedPointer<QGeoSimplifiedPath> simplifiedPath_;
+    QSharedPointer<QGeoSimplifiedPath> pendingSimplifiedPath_;
+    QSharedPointer<QGeoMapItemGeometryNotifier> simplificationNotifier_;
+    bool rebuildRequested_;
+    bool resimplifyRequested_;
     bool updatingGeometry_;
+    int pathRevision_;
+    int pendingRevision_;
 };
 
 //////////////////////////////////////////////////////////////////////
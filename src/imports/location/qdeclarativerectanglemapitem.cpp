@@ -116,10 +116,15 @@ struct Vertex
 
 QGeoMapRectangleGeometry::QGeoMapRectangleGeometry()
 {
+    setAssumeSimple(true);
 }
 
 /*!
     \internal
+
+    Fills the rectangle through the polygon tessellator, which clips it to
+    the viewport first. A rectangle larger than the map at a high zoom level
+    is then drawn with its visible part only.
 */
 void QGeoMapRectangleGeometry::updatePoints(const QGeoMap &map,
                                             const QGeoCoordinate &topLeft,
@@ -128,44 +133,14 @@ void QGeoMapRectangleGeometry::updatePoints(const QGeoMap &map,
     if (!screenDirty_ && !sourceDirty_)
         return;
 
-    QDoubleVector2D tl = map.coordinateToScreenPosition(topLeft, false);
-    QDoubleVector2D br = map.coordinateToScreenPosition(bottomRight, false);
-
-    // We can get NaN if the map isn't set up correctly, or the projection
-    // is faulty -- probably best thing to do is abort
-    if (!qIsFinite(tl.x()) || !qIsFinite(tl.y()))
-        return;
-    if (!qIsFinite(br.x()) || !qIsFinite(br.y()))
-        return;
-
-    if ( preserveGeometry_ ) {
-        double unwrapBelowX = map.coordinateToScreenPosition(geoLeftBound_, false).x();
-        if (br.x() < unwrapBelowX)
-            br.setX(tl.x() + screenBounds_.width());
-    }
-
-    QRectF re(tl.toPointF(), br.toPointF());
-    re.translate(-1 * tl.toPointF());
-
-    clear();
-    screenVertices_.reserve(6);
-
-    screenVertices_ << re.topLeft();
-    screenVertices_ << re.topRight();
-    screenVertices_ << re.bottomLeft();
-
-    screenVertices_ << re.topRight();
-    screenVertices_ << re.bottomLeft();
-    screenVertices_ << re.bottomRight();
-
-    firstPointOffset_ = QPointF(0,0);
-    srcOrigin_ = topLeft;
-    screenBounds_ = re;
-
-    screenOutline_ = QPainterPath();
-    screenOutline_.addRect(re);
+    QList<QGeoCoordinate> path;
+    path << topLeft;
+    path << QGeoCoordinate(topLeft.latitude(), bottomRight.longitude());
+    path << bottomRight;
+    path << QGeoCoordinate(bottomRight.latitude(), topLeft.longitude());
 
-    geoLeftBound_ = topLeft;
+    updateSourcePoints(map, path);
+    updateScreenPoints(map);
 }
 
 QDeclarativeRectangleMapItem::QDeclarativeRectangleMapItem(QQuickItem *parent)
@@ -37,12 +37,13 @@
 #include "qdeclarativegeomapitembase_p.h"
 #include "qgeomapitemgeometry_p.h"
 #include "qdeclarativepolylinemapitem_p.h"
+#include "qdeclarativepolygonmapitem_p.h"
 #include <QSGGeometryNode>
 #include <QSGFlatColorMaterial>
 
 QT_BEGIN_NAMESPACE
 
-class QGeoMapRectangleGeometry : public QGeoMapItemGeometry
+class QGeoMapRectangleGeometry : public QGeoMapPolygonGeometry
 {
 public:
     QGeoMapRectangleGeometry();
@@ -133,7 +133,7 @@ void QDeclarativeRouteMapItem::setRoute(QDeclarativeGeoRoute *route)
     if (route_) {
         path_ = route_->routePath();
     } else {
-        path_ = QList<QGeoCoordinate>();
+        path_ = QGeoCoordinateArray();
     }
 
     geometry_.markSourceDirty();
@@ -198,7 +198,9 @@ void QDeclarativeRouteMapItem::updatePolish()
     QGeoRectangle r = map()->visibleRegion();
 
     bool cull = true;
-    foreach (const QGeoCoordinate &c, path_) {
+    QGeoCoordinate c;
+    for (int i = 0; i < path_.size(); ++i) {
+        path_.coordinateAt(i, &c);
         if (r.contains(c)) {
             cull = false;
             break;
@@ -78,7 +78,7 @@ protected Q_SLOTS:
 private:
     QDeclarativeMapLineProperties line_;
     QDeclarativeGeoRoute *route_;
-    QList<QGeoCoordinate> path_;
+    QGeoCoordinateArray path_;
     bool dirtyMaterial_;
     QGeoMapPolylineGeometry geometry_;
 };
@@ -0,0 +1,448 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtLocation module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia. For licensing terms and
+** conditions see http://qt.digia.com/licensing. For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights. These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qgeomapitembatch_p.h"
+#include "qgeomapitemgeometry_p.h"
+#include <QtQuick/QSGFlatColorMaterial>
+#include <QtCore/QMutexLocker>
+
+QT_BEGIN_NAMESPACE
+
+QGeoMapFrameStatistics::QGeoMapFrameStatistics()
+:   batches(0), batchedItems(0), unbatchedItems(0), drawCalls(0),
+    vertices(0), uploadedVertices(0)
+{
+}
+
+/*!
+    \internal
+*/
+void QGeoMapFrameStatisticsCollector::publish(const QGeoMapFrameStatistics &statistics)
+{
+    QMutexLocker locker(&mutex_);
+    statistics_ = statistics;
+}
+
+/*!
+    \internal
+*/
+QGeoMapFrameStatistics QGeoMapFrameStatisticsCollector::statistics() const
+{
+    QMutexLocker locker(&mutex_);
+    return statistics_;
+}
+
+/*!
+    \internal
+    \class QGeoMapItemBatchNode
+
+    Draws the polylines, polygons and circles of a map that share a drawing
+    mode and a color through one geometry node each, instead of one node per
+    item. Items hand over their screen geometry while the scene graph is
+    synchronized; the shared vertex buffers are written in preprocess(), where
+    only the parts that changed are rewritten unless the layout of a batch
+    changed.
+
+    Triangle strips are joined with degenerate triangles, so every strip part
+    carries a copy of its first and last vertex. Fill batches are drawn before
+    strip batches, which keeps borders above fills.
+
+    \a owner is cleared when the node is destroyed together with the rest of
+    the map's scene graph.
+*/
+QGeoMapItemBatchNode::QGeoMapItemBatchNode(QGeoMapItemBatchNode **owner,
+                                           const QSharedPointer<QGeoMapFrameStatisticsCollector> &collector)
+:   owner_(owner), collector_(collector), statisticsDirty_(true)
+{
+    setFlag(UsePreprocess);
+}
+
+QGeoMapItemBatchNode::~QGeoMapItemBatchNode()
+{
+    if (owner_)
+        *owner_ = 0;
+    qDeleteAll(items_);
+    qDeleteAll(batches_);
+}
+
+/*!
+    \internal
+
+    Called when the owner goes away before the node.
+*/
+void QGeoMapItemBatchNode::detach()
+{
+    owner_ = 0;
+}
+
+/*!
+    \internal
+*/
+QGeoMapItemBatchNode::Item *QGeoMapItemBatchNode::item(quint64 id)
+{
+    Item *item = items_.value(id);
+    if (!item) {
+        item = new Item;
+        for (int i = 0; i < MaximumParts; ++i)
+            item->parts[i].item = item;
+        items_.insert(id, item);
+    }
+    return item;
+}
+
+/*!
+    \internal
+
+    Moves all parts of \a item so that they are drawn at \a offset in map
+    coordinates.
+*/
+void QGeoMapItemBatchNode::setItemOffset(quint64 item, const QPointF &offset)
+{
+    Item *it = this->item(item);
+    if (it->offset == offset)
+        return;
+
+    it->offset = offset;
+    for (int i = 0; i < MaximumParts; ++i) {
+        Part &part = it->parts[i];
+        if (part.batch && !part.batch->layoutDirty) {
+            part.dirty = true;
+            part.batch->dirty = true;
+        }
+    }
+}
+
+/*!
+    \internal
+
+    Replaces the vertices of \a part of \a item with the screen vertices of
+    \a shape, which are relative to the item. A part keeps its place in the
+    vertex buffer as long as its batch and vertex count stay the same.
+*/
+void QGeoMapItemBatchNode::setItemPart(quint64 item, int part, GLenum drawingMode,
+                                       const QColor &color, const QGeoMapItemGeometry &shape)
+{
+    Q_ASSERT(part >= 0 && part < MaximumParts);
+
+    Item *it = this->item(item);
+    if (it->unbatchedDrawCalls) {
+        it->unbatchedDrawCalls = 0;
+        statisticsDirty_ = true;
+    }
+
+    Part &p = it->parts[part];
+    if (shape.size() == 0 || color.alpha() == 0) {
+        detachPart(&p);
+        return;
+    }
+
+    const QVector<QPointF> vx = shape.vertices();
+    const QVector<quint32> ix = shape.indices();
+    const bool strip = (drawingMode == GL_TRIANGLE_STRIP);
+    const int count = shape.isIndexed() ? ix.size() : vx.size();
+
+    QVector<QSGGeometry::Point2D> vertices(strip ? count + 2 : count);
+    QSGGeometry::Point2D *dest = vertices.data();
+    if (strip)
+        ++dest;
+    for (int i = 0; i < count; ++i) {
+        const QPointF &v = vx.at(shape.isIndexed() ? ix.at(i) : i);
+        dest[i].set(v.x(), v.y());
+    }
+    if (strip) {
+        vertices[0] = vertices.at(1);
+        vertices[count + 1] = vertices.at(count);
+    }
+
+    Batch *batch = batchFor(drawingMode, color.rgba());
+    if (p.batch == batch && p.vertices.size() == vertices.size()) {
+        p.vertices = vertices;
+        if (!batch->layoutDirty) {
+            p.dirty = true;
+            batch->dirty = true;
+        }
+        return;
+    }
+
+    detachPart(&p);
+    p.vertices = vertices;
+    p.batch = batch;
+    batch->parts.append(&p);
+    batch->layoutDirty = true;
+    statisticsDirty_ = true;
+}
+
+/*!
+    \internal
+
+    Records that \a item draws itself through \a drawCalls geometry nodes of
+    its own, and takes its parts out of the batches.
+*/
+void QGeoMapItemBatchNode::setItemUnbatched(quint64 item, int drawCalls)
+{
+    Item *it = this->item(item);
+    for (int i = 0; i < MaximumParts; ++i)
+        detachPart(&it->parts[i]);
+
+    if (it->unbatchedDrawCalls != drawCalls) {
+        it->unbatchedDrawCalls = drawCalls;
+        statisticsDirty_ = true;
+    }
+}
+
+/*!
+    \internal
+*/
+void QGeoMapItemBatchNode::removeItem(quint64 item)
+{
+    Item *it = items_.take(item);
+    if (!it)
+        return;
+
+    for (int i = 0; i < MaximumParts; ++i)
+        detachPart(&it->parts[i]);
+    delete it;
+    statisticsDirty_ = true;
+}
+
+/*!
+    \internal
+*/
+bool QGeoMapItemBatchNode::containsItem(quint64 item) const
+{
+    return items_.contains(item);
+}
+
+/*!
+    \internal
+*/
+void QGeoMapItemBatchNode::detachPart(Part *part)
+{
+    if (!part->batch)
+        return;
+
+    part->batch->parts.removeOne(part);
+    part->batch->layoutDirty = true;
+    part->batch = 0;
+    part->vertices.clear();
+    part->offset = -1;
+    part->dirty = false;
+    statisticsDirty_ = true;
+}
+
+/*!
+    \internal
+*/
+QGeoMapItemBatchNode::Batch *QGeoMapItemBatchNode::batchFor(GLenum drawingMode, QRgb color)
+{
+    const quint64 key = (quint64(drawingMode) << 32) | color;
+    Batch *batch = batchIndex_.value(key);
+    if (batch)
+        return batch;
+
+    batch = new Batch;
+    batch->drawingMode = drawingMode;
+    batch->color = color;
+
+    QSGGeometry *geometry = new QSGGeometry(QSGGeometry::defaultAttributes_Point2D(), 0);
+    geometry->setDrawingMode(drawingMode);
+    geometry->setVertexDataPattern(QSGGeometry::DynamicPattern);
+
+    QSGFlatColorMaterial *material = new QSGFlatColorMaterial;
+    material->setColor(QColor::fromRgba(color));
+
+    batch->node = new QSGGeometryNode;
+    batch->node->setGeometry(geometry);
+    batch->node->setMaterial(material);
+    batch->node->setFlags(QSGNode::OwnsGeometry | QSGNode::OwnsMaterial);
+
+    // fills go below all strips
+    QSGNode *firstStrip = 0;
+    if (drawingMode != GL_TRIANGLE_STRIP) {
+        foreach (Batch *b, batches_) {
+            if (b->drawingMode == GL_TRIANGLE_STRIP) {
+                firstStrip = b->node;
+                break;
+            }
+        }
+    }
+    if (firstStrip)
+        insertChildNodeBefore(batch->node, firstStrip);
+    else
+        appendChildNode(batch->node);
+
+    batches_.append(batch);
+    batchIndex_.insert(key, batch);
+    return batch;
+}
+
+/*!
+    \internal
+*/
+void QGeoMapItemBatchNode::writePart(QSGGeometry::Point2D *dest, const Part *part)
+{
+    const float dx = part->item->offset.x();
+    const float dy = part->item->offset.y();
+    const QSGGeometry::Point2D *src = part->vertices.constData();
+    for (int i = 0; i < part->vertices.size(); ++i)
+        dest[i].set(src[i].x + dx, src[i].y + dy);
+}
+
+/*!
+    \internal
+
+    Lays out \a batch from scratch if parts were added, removed or resized,
+    otherwise rewrites only the parts that changed. The number of vertices
+    written is added to \a uploaded.
+*/
+void QGeoMapItemBatchNode::writeBatch(Batch *batch, int *uploaded)
+{
+    QSGGeometry *geometry = batch->node->geometry();
+
+    if (batch->layoutDirty) {
+        int count = 0;
+        foreach (const Part *part, batch->parts)
+            count += part->vertices.size();
+
+        geometry->allocate(count);
+        QSGGeometry::Point2D *data = geometry->vertexDataAsPoint2D();
+        int offset = 0;
+        foreach (Part *part, batch->parts) {
+            part->offset = offset;
+            part->dirty = false;
+            writePart(data + offset, part);
+            offset += part->vertices.size();
+        }
+        batch->vertexCount = count;
+        *uploaded += count;
+    } else if (batch->dirty) {
+        QSGGeometry::Point2D *data = geometry->vertexDataAsPoint2D();
+        foreach (Part *part, batch->parts) {
+            if (!part->dirty)
+                continue;
+            part->dirty = false;
+            writePart(data + part->offset, part);
+            *uploaded += part->vertices.size();
+        }
+    } else {
+        return;
+    }
+
+    batch->layoutDirty = false;
+    batch->dirty = false;
+    geometry->markVertexDataDirty();
+    batch->node->markDirty(QSGNode::DirtyGeometry);
+}
+
+/*!
+    \internal
+*/
+void QGeoMapItemBatchNode::preprocess()
+{
+    int uploaded = 0;
+
+    QList<Batch *>::iterator i = batches_.begin();
+    while (i != batches_.end()) {
+        Batch *batch = *i;
+        if (batch->parts.isEmpty()) {
+            batchIndex_.remove((quint64(batch->drawingMode) << 32) | batch->color);
+            removeChildNode(batch->node);
+            delete batch->node;
+            delete batch;
+            i = batches_.erase(i);
+            statisticsDirty_ = true;
+            continue;
+        }
+        writeBatch(batch, &uploaded);
+        ++i;
+    }
+
+    if (statisticsDirty_ || uploaded)
+        publishStatistics(uploaded);
+}
+
+/*!
+    \internal
+*/
+void QGeoMapItemBatchNode::publishStatistics(int uploaded)
+{
+    QGeoMapFrameStatistics statistics;
+    statistics.batches = batches_.size();
+    statistics.drawCalls = batches_.size();
+    statistics.uploadedVertices = uploaded;
+
+    foreach (const Batch *batch, batches_)
+        statistics.vertices += batch->vertexCount;
+
+    foreach (const Item *item, items_) {
+        if (item->unbatchedDrawCalls) {
+            ++statistics.unbatchedItems;
+            statistics.drawCalls += item->unbatchedDrawCalls;
+            continue;
+        }
+        for (int i = 0; i < MaximumParts; ++i) {
+            if (item->parts[i].batch) {
+                ++statistics.batchedItems;
+                break;
+            }
+        }
+    }
+
+    if (collector_)
+        collector_->publish(statistics);
+    statisticsDirty_ = false;
+}
+
+/*!
+    \internal
+
+    Returns the number of non-empty geometry nodes in the subtree of \a node
+    that the renderer would draw.
+*/
+int QGeoMapItemBatchNode::drawCalls(const QSGNode *node)
+{
+    if (!node || node->isSubtreeBlocked())
+        return 0;
+
+    int count = 0;
+    if (node->type() == QSGNode::GeometryNode) {
+        const QSGGeometry *geometry = static_cast<const QSGGeometryNode *>(node)->geometry();
+        if (geometry && geometry->vertexCount() > 0)
+            ++count;
+    }
+    for (const QSGNode *child = node->firstChild(); child; child = child->nextSibling())
+        count += drawCalls(child);
+    return count;
+}
+
+QT_END_NAMESPACE
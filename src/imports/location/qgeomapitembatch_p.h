@@ -0,0 +1,152 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtLocation module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia. For licensing terms and
+** conditions see http://qt.digia.com/licensing. For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights. These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QGEOMAPITEMBATCH_H
+#define QGEOMAPITEMBATCH_H
+
+#include <QtQuick/QSGNode>
+#include <QtQuick/QSGGeometry>
+#include <QColor>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QPointF>
+#include <QSharedPointer>
+#include <QVector>
+
+QT_BEGIN_NAMESPACE
+
+class QGeoMapItemGeometry;
+
+/* What the map items contributed to the last rendered frame */
+struct QGeoMapFrameStatistics
+{
+    QGeoMapFrameStatistics();
+
+    int batches;            // shared geometry nodes holding batched items
+    int batchedItems;
+    int unbatchedItems;     // items drawing through their own nodes
+    int drawCalls;          // batches plus the geometry nodes of unbatched items
+    int vertices;           // vertices held by the batches
+    int uploadedVertices;   // vertices rewritten for the frame
+};
+
+/* Hands the statistics from the render thread to the GUI thread */
+class QGeoMapFrameStatisticsCollector
+{
+public:
+    void publish(const QGeoMapFrameStatistics &statistics);
+    QGeoMapFrameStatistics statistics() const;
+
+private:
+    mutable QMutex mutex_;
+    QGeoMapFrameStatistics statistics_;
+};
+
+class QGeoMapItemBatchNode : public QSGOpacityNode
+{
+public:
+    enum { MaximumParts = 2 };
+
+    QGeoMapItemBatchNode(QGeoMapItemBatchNode **owner,
+                         const QSharedPointer<QGeoMapFrameStatisticsCollector> &collector);
+    ~QGeoMapItemBatchNode();
+
+    void detach();
+
+    void setItemOffset(quint64 item, const QPointF &offset);
+    void setItemPart(quint64 item, int part, GLenum drawingMode,
+                     const QColor &color, const QGeoMapItemGeometry &shape);
+    void setItemUnbatched(quint64 item, int drawCalls);
+    void removeItem(quint64 item);
+    bool containsItem(quint64 item) const;
+
+    void preprocess() Q_DECL_OVERRIDE;
+
+    static int drawCalls(const QSGNode *node);
+
+private:
+    struct Batch;
+    struct Item;
+
+    struct Part
+    {
+        Part() : item(0), batch(0), offset(-1), dirty(false) {}
+
+        Item *item;
+        Batch *batch;
+        QVector<QSGGeometry::Point2D> vertices;
+        int offset;             // first vertex of the part in the batch
+        bool dirty;
+    };
+
+    struct Item
+    {
+        Item() : unbatchedDrawCalls(0) {}
+
+        QPointF offset;
+        Part parts[MaximumParts];
+        int unbatchedDrawCalls;
+    };
+
+    struct Batch
+    {
+        Batch() : node(0), vertexCount(0), layoutDirty(true), dirty(false) {}
+
+        GLenum drawingMode;
+        QRgb color;
+        QSGGeometryNode *node;
+        QList<Part *> parts;
+        int vertexCount;
+        bool layoutDirty;       // parts were added, removed or resized
+        bool dirty;             // some parts were rewritten in place
+    };
+
+    Item *item(quint64 id);
+    Batch *batchFor(GLenum drawingMode, QRgb color);
+    void detachPart(Part *part);
+    static void writePart(QSGGeometry::Point2D *dest, const Part *part);
+    void writeBatch(Batch *batch, int *uploaded);
+    void publishStatistics(int uploaded);
+
+    QGeoMapItemBatchNode **owner_;
+    QSharedPointer<QGeoMapFrameStatisticsCollector> collector_;
+    QHash<quint64, Item *> items_;
+    QList<Batch *> batches_;
+    QHash<quint64, Batch *> batchIndex_;
+    bool statisticsDirty_;
+};
+
+QT_END_NAMESPACE
+
+#endif // QGEOMAPITEMBATCH_H
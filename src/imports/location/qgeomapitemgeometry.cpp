@@ -34,16 +34,110 @@
 #include "qgeomapitemgeometry_p.h"
 #include "qdeclarativegeomap_p.h"
 #include "qlocationutils_p.h"
+#include "qgeosimplifiedpath_p.h"
 #include <QtQuick/QSGGeometry>
 #include "qdoublevector2d_p.h"
+#include <QtCore/QThreadPool>
+#include <QtCore/QMutexLocker>
 
 QT_BEGIN_NAMESPACE
 
+Q_GLOBAL_STATIC(QThreadPool, mapItemGeometryThreadPool)
+
 QGeoMapItemGeometry::QGeoMapItemGeometry()
-:   sourceDirty_(true), screenDirty_(true), clipToViewport_(true), preserveGeometry_(false)
+:   sourceDirty_(true), screenDirty_(true), clipToViewport_(true), preserveGeometry_(false),
+    clipped_(true)
+{
+}
+
+QGeoMapItemGeometry::~QGeoMapItemGeometry()
 {
 }
 
+/*!
+    \internal
+
+    Captures the parts of \a map the screen pass depends on, so that the pass
+    itself can run without touching the map.
+*/
+QGeoMapItemViewport QGeoMapItemGeometry::viewport(const QGeoMap &map, qreal strokeWidth) const
+{
+    QGeoMapItemViewport result;
+    result.origin = map.coordinateToScreenPosition(srcOrigin_, false).toPointF();
+    result.mapSize = QSizeF(map.width(), map.height());
+    result.strokeWidth = strokeWidth;
+    return result;
+}
+
+/*!
+    \internal
+
+    Rebuilds the screen geometry from the source geometry for \a viewport.
+    Geometries that are cheap to build in one step, like rectangles, keep
+    this default, which does nothing.
+*/
+void QGeoMapItemGeometry::updateScreenPoints(const QGeoMapItemViewport &viewport)
+{
+    Q_UNUSED(viewport);
+}
+
+/*!
+    \internal
+
+    Returns whether the screen geometry built last still holds everything
+    that is visible in \a viewport, which is the case as long as a panned
+    viewport stays within the area the geometry was clipped to.
+*/
+bool QGeoMapItemGeometry::coversViewport(const QGeoMapItemViewport &viewport) const
+{
+    if (!clipped_)
+        return true;
+    return coveredRect_.contains(sourceViewport(viewport));
+}
+
+/*!
+    \internal
+
+    Scales the source points by \a factor instead of projecting them again,
+    which is what a change of the zoom level amounts to under an untilted
+    camera. Returns false if the geometry does not support this, in which
+    case nothing is changed.
+*/
+bool QGeoMapItemGeometry::scaleSourcePoints(qreal factor)
+{
+    Q_UNUSED(factor);
+    return false;
+}
+
+/*!
+    \internal
+
+    Returns the map area of \a viewport, grown by its stroke width and by
+    \a margin times its size, in the coordinates of the source points.
+*/
+QRectF QGeoMapItemGeometry::sourceViewport(const QGeoMapItemViewport &viewport, qreal margin)
+{
+    const qreal dx = viewport.strokeWidth + margin * viewport.mapSize.width();
+    const qreal dy = viewport.strokeWidth + margin * viewport.mapSize.height();
+
+    QRectF rect(QPointF(0, 0), viewport.mapSize);
+    rect.adjust(-dx, -dy, dx, dy);
+    rect.translate(-1 * viewport.origin);
+    return rect;
+}
+
+/*!
+    \internal
+
+    Returns the area the screen passes clip to. It reaches half a viewport
+    beyond each edge, so that panning can reuse the screen geometry until
+    the viewport has moved that far.
+*/
+QRectF QGeoMapItemGeometry::sourceClipRect(const QGeoMapItemViewport &viewport)
+{
+    return sourceViewport(viewport, 0.5);
+}
+
 /*!
     \internal
 */
@@ -134,4 +228,119 @@ double QGeoMapItemGeometry::geoDistanceToScreenWidth(const QGeoMap &map,
     return halfScreenDist.x() * 2.0;
 }
 
+/*!
+    \internal
+
+    Returns the width in pixels of the whole world at the center of \a map,
+    or 0 if the map cannot tell.
+*/
+double QGeoMapItemGeometry::worldWidth(const QGeoMap &map)
+{
+    const double span = 100.0;
+    const QDoubleVector2D center(map.width() / 2.0, map.height() / 2.0);
+    const QGeoCoordinate left = map.screenPositionToCoordinate(center - QDoubleVector2D(span / 2.0, 0), false);
+    const QGeoCoordinate right = map.screenPositionToCoordinate(center + QDoubleVector2D(span / 2.0, 0), false);
+    if (!left.isValid() || !right.isValid())
+        return 0.0;
+
+    // the map may be rotated, which only makes the result larger
+    const double degrees = qAbs(QLocationUtils::wrapLong(right.longitude() - left.longitude()));
+    if (qFuzzyIsNull(degrees))
+        return 0.0;
+
+    return span * 360.0 / degrees;
+}
+
+/*!
+    \internal
+*/
+QGeoMapItemGeometryNotifier::QGeoMapItemGeometryNotifier(QObject *item, const char *slot)
+:   item_(item), slot_(slot)
+{
+}
+
+/*!
+    \internal
+
+    Called by the item when it is destroyed; jobs still running afterwards
+    finish without reporting back.
+*/
+void QGeoMapItemGeometryNotifier::detach()
+{
+    QMutexLocker locker(&mutex_);
+    item_ = 0;
+}
+
+/*!
+    \internal
+*/
+void QGeoMapItemGeometryNotifier::notify()
+{
+    QMutexLocker locker(&mutex_);
+    if (item_)
+        QMetaObject::invokeMethod(item_, slot_, Qt::QueuedConnection);
+}
+
+/*!
+    \internal
+
+    Builds the screen geometry of one or more map item geometries on a worker
+    thread. The geometries are private copies, owned jointly with the item, so
+    the item keeps drawing its current geometry until the job reports back.
+*/
+QGeoMapItemGeometryJob::QGeoMapItemGeometryJob(const QSharedPointer<QGeoMapItemGeometryNotifier> &notifier)
+:   notifier_(notifier)
+{
+}
+
+/*!
+    \internal
+*/
+void QGeoMapItemGeometryJob::addGeometry(const QSharedPointer<QGeoMapItemGeometry> &geometry,
+                                         const QGeoMapItemViewport &viewport)
+{
+    geometries_.append(geometry);
+    viewports_.append(viewport);
+}
+
+/*!
+    \internal
+*/
+void QGeoMapItemGeometryJob::run()
+{
+    for (int i = 0; i < geometries_.size(); ++i)
+        geometries_.at(i)->updateScreenPoints(viewports_.at(i));
+    notifier_->notify();
+}
+
+/*!
+    \internal
+*/
+QThreadPool *QGeoMapItemGeometryJob::threadPool()
+{
+    return mapItemGeometryThreadPool();
+}
+
+/*!
+    \internal
+
+    Builds the levels of detail of a long path on a worker thread, into
+    \a result, which the item must not read before it is notified.
+*/
+QGeoPathSimplificationJob::QGeoPathSimplificationJob(const QGeoCoordinateArray &path,
+                                                     const QSharedPointer<QGeoSimplifiedPath> &result,
+                                                     const QSharedPointer<QGeoMapItemGeometryNotifier> &notifier)
+:   path_(path), result_(result), notifier_(notifier)
+{
+}
+
+/*!
+    \internal
+*/
+void QGeoPathSimplificationJob::run()
+{
+    *result_ = QGeoSimplifiedPath(path_);
+    notifier_->notify();
+}
+
 QT_END_NAMESPACE
@@ -41,16 +41,43 @@
 #include <QGeoCoordinate>
 #include <QVector2D>
 #include <QList>
+#include <QSizeF>
+#include <QMutex>
+#include <QRunnable>
+#include <QSharedPointer>
+
+#include <QtPositioning/private/qgeocoordinatearray_p.h>
 
 QT_BEGIN_NAMESPACE
 
 class QSGGeometry;
+class QGeoSimplifiedPath;
 class QGeoMap;
+class QThreadPool;
+class QObject;
+
+/* What the screen pass needs to know about the map, captured on the GUI thread */
+struct QGeoMapItemViewport
+{
+    QPointF origin;
+    QSizeF mapSize;
+    qreal strokeWidth;
+};
 
 class QGeoMapItemGeometry
 {
 public:
     QGeoMapItemGeometry();
+    virtual ~QGeoMapItemGeometry();
+
+    QGeoMapItemViewport viewport(const QGeoMap &map, qreal strokeWidth = 0) const;
+    virtual void updateScreenPoints(const QGeoMapItemViewport &viewport);
+
+    bool coversViewport(const QGeoMapItemViewport &viewport) const;
+    virtual bool scaleSourcePoints(qreal factor);
+
+    static QRectF sourceViewport(const QGeoMapItemViewport &viewport, qreal margin = 0.0);
+    static QRectF sourceClipRect(const QGeoMapItemViewport &viewport);
 
     inline bool isSourceDirty() const { return sourceDirty_; }
     inline bool isScreenDirty() const { return screenDirty_; }
@@ -107,6 +134,7 @@ public:
                                            const QGeoCoordinate &toCoord);
 
     static QRectF translateToCommonOrigin(const QList<QGeoMapItemGeometry *> &geoms);
+    static double worldWidth(const QGeoMap &map);
 
 
 protected:
@@ -127,6 +155,59 @@ protected:
 
     QVector<QPointF> screenVertices_;
     QVector<quint32> screenIndices_;
+
+    // the source area the screen geometry was clipped to, if it was clipped
+    QRectF coveredRect_;
+    bool clipped_;
+};
+
+class QGeoMapItemGeometryNotifier
+{
+public:
+    QGeoMapItemGeometryNotifier(QObject *item, const char *slot);
+
+    void detach();
+    void notify();
+
+private:
+    QMutex mutex_;
+    QObject *item_;
+    const char *slot_;
+};
+
+class QGeoMapItemGeometryJob : public QRunnable
+{
+public:
+    /* Paths shorter than this are cheaper to build in place */
+    enum { MinimumPoints = 1000 };
+
+    explicit QGeoMapItemGeometryJob(const QSharedPointer<QGeoMapItemGeometryNotifier> &notifier);
+
+    void addGeometry(const QSharedPointer<QGeoMapItemGeometry> &geometry,
+                     const QGeoMapItemViewport &viewport);
+    void run();
+
+    static QThreadPool *threadPool();
+
+private:
+    QSharedPointer<QGeoMapItemGeometryNotifier> notifier_;
+    QList<QSharedPointer<QGeoMapItemGeometry> > geometries_;
+    QList<QGeoMapItemViewport> viewports_;
+};
+
+class QGeoPathSimplificationJob : public QRunnable
+{
+public:
+    QGeoPathSimplificationJob(const QGeoCoordinateArray &path,
+                              const QSharedPointer<QGeoSimplifiedPath> &result,
+                              const QSharedPointer<QGeoMapItemGeometryNotifier> &notifier);
+
+    void run();
+
+private:
+    QGeoCoordinateArray path_;
+    QSharedPointer<QGeoSimplifiedPath> result_;
+    QSharedPointer<QGeoMapItemGeometryNotifier> notifier_;
 };
 
 QT_END_NAMESPACE
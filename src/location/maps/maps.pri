@@ -29,7 +29,11 @@ PRIVATE_HEADERS += \
                     maps/qgeocodingmanager_p.h \
                     maps/qgeomaneuver_p.h \
                     maps/qgeomapcontroller_p.h \
+                    maps/qgeomapitemindex_p.h \
                     maps/qgeomapscene_p.h \
+                    maps/qgeopolygontessellator_p.h \
+                    maps/qgeoreplyparser_p.h \
+                    maps/qgeosimplifiedpath_p.h \
                     maps/qgeotilerequestmanager_p.h \
                     maps/qgeomap_p.h \
                     maps/qgeomapdata_p.h \
@@ -50,15 +54,20 @@ PRIVATE_HEADERS += \
                     maps/qgeoroutereply_p.h \
                     maps/qgeorouterequest_p.h \
                     maps/qgeoroutesegment_p.h \
+                    maps/qgeoroutetracker_p.h \
                     maps/qgeoroutingmanagerengine_p.h \
                     maps/qgeoroutingmanager_p.h \
                     maps/qgeoserviceprovider_p.h \
                     maps/qgeotilecache_p.h \
+                    maps/qgeotilepackstore_p.h \
+                    maps/qgeotileprefetcher_p.h \
+                    maps/qgeotileregiondownload_p.h \
                     maps/qgeotiledmapreply_p.h \
                     maps/qgeotiledmapreply_p_p.h \
                     maps/qgeotilespec_p.h \
                     maps/qgeotilespec_p_p.h \
-                    maps/qcache3q_p.h
+                    maps/qcache3q_p.h \
+                    maps/qconcurrentcache3q_p.h
 
 SOURCES += \
             maps/qgeocameracapabilities.cpp \
@@ -69,7 +78,11 @@ SOURCES += \
             maps/qgeocodingmanagerengine.cpp \
             maps/qgeomaneuver.cpp \
             maps/qgeomapcontroller.cpp \
+            maps/qgeomapitemindex.cpp \
             maps/qgeomapscene.cpp \
+            maps/qgeopolygontessellator.cpp \
+            maps/qgeoreplyparser.cpp \
+            maps/qgeosimplifiedpath.cpp \
             maps/qgeotilerequestmanager.cpp \
             maps/qgeomap.cpp \
             maps/qgeomapdata.cpp \
@@ -83,11 +96,15 @@ SOURCES += \
             maps/qgeoroutereply.cpp \
             maps/qgeorouterequest.cpp \
             maps/qgeoroutesegment.cpp \
+            maps/qgeoroutetracker.cpp \
             maps/qgeoroutingmanager.cpp \
             maps/qgeoroutingmanagerengine.cpp \
             maps/qgeoserviceprovider.cpp \
             maps/qgeoserviceproviderfactory.cpp \
             maps/qgeotilecache.cpp \
+            maps/qgeotilepackstore.cpp \
+            maps/qgeotileprefetcher.cpp \
+            maps/qgeotileregiondownload.cpp \
             maps/qgeotiledmapreply.cpp \
             maps/qgeotilespec.cpp
 
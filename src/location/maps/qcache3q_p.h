@@ -157,6 +157,12 @@ public:
     bool insert(const Key &key, QSharedPointer<T> object, int cost = 1);
     QSharedPointer<T> object(const Key &key) const;
     QSharedPointer<T> operator[](const Key &key) const;
+    // unlike object() this does not count as a request for the key
+    inline bool contains(const Key &key) const
+    {
+        Node *n = lookup_.value(key, 0);
+        return n && n->q != q1_evicted_;
+    }
 
     void remove(const Key &key);
 
@@ -165,8 +171,13 @@ public:
     // Copy data directly into a queue. Designed for single use after construction
     void deserializeQueue(int queueNumber, const QList<Key> &keys,
                           const QList<QSharedPointer<T> > &values, const QList<int> &costs);
+    void deserializeQueue(int queueNumber, const QList<Key> &keys,
+                          const QList<QSharedPointer<T> > &values, const QList<int> &costs,
+                          const QList<quint64> &pops);
     // Copy data from specific queue into list
     void serializeQueue(int queueNumber, QList<QSharedPointer<T> > &buffer);
+    void serializeQueue(int queueNumber, QList<Key> &keys, QList<QSharedPointer<T> > &values,
+                        QList<int> &costs, QList<quint64> &pops);
 
 private:
     int maxCost_, minRecent_, maxOldPopular_;
@@ -220,24 +231,57 @@ void QCache3Q<Key,T,EvPolicy>::serializeQueue(int queueNumber, QList<QSharedPoin
         buffer.append(node->v);
 }
 
+template <class Key, class T, class EvPolicy>
+void QCache3Q<Key,T,EvPolicy>::serializeQueue(int queueNumber, QList<Key> &keys,
+                                              QList<QSharedPointer<T> > &values,
+                                              QList<int> &costs, QList<quint64> &pops)
+{
+    Q_ASSERT(queueNumber >= 1 && queueNumber <= 4);
+    Queue *queue = queueNumber == 1 ? q1_ :
+                   queueNumber == 2 ? q2_ :
+                   queueNumber == 3 ? q3_ :
+                                      q1_evicted_;
+    for (Node *node = queue->f; node; node = node->n) {
+        keys.append(node->k);
+        values.append(node->v);
+        costs.append(node->cost);
+        pops.append(node->pop);
+    }
+}
+
 template <class Key, class T, class EvPolicy>
 void QCache3Q<Key,T,EvPolicy>::deserializeQueue(int queueNumber, const QList<Key> &keys,
                        const QList<QSharedPointer<T> > &values, const QList<int> &costs)
+{
+    deserializeQueue(queueNumber, keys, values, costs, QList<quint64>());
+}
+
+template <class Key, class T, class EvPolicy>
+void QCache3Q<Key,T,EvPolicy>::deserializeQueue(int queueNumber, const QList<Key> &keys,
+                       const QList<QSharedPointer<T> > &values, const QList<int> &costs,
+                       const QList<quint64> &pops)
 {
     Q_ASSERT(queueNumber >= 1 && queueNumber <= 4);
     int bufferSize = keys.size();
     if (bufferSize == 0)
         return;
-    clear();
     Queue *queue = queueNumber == 1 ? q1_ :
                    queueNumber == 2 ? q2_ :
                    queueNumber == 3 ? q3_ :
                                       q1_evicted_;
-    for (int i = 0; i<bufferSize; ++i) {
+    // the lists are in front to back order, as written by serializeQueue()
+    for (int i = bufferSize - 1; i >= 0; --i) {
+        if (lookup_.contains(keys[i])) {
+            // duplicates are dropped as if they had been removed
+            if (values[i])
+                EvPolicy::aboutToBeRemoved(keys[i], values[i]);
+            continue;
+        }
         Node *node = new Node;
         node->v = values[i];
         node->k = keys[i];
         node->cost = costs[i];
+        node->pop = (i < pops.size()) ? pops[i] : 0;
         link_front(node, queue);
         lookup_[keys[i]] = node;
     }
@@ -414,8 +458,10 @@ void QCache3Q<Key,T,EvPolicy>::remove(const Key &key)
         return;
     }
     Node *n = lookup_[key];
+    // check before unlinking, unlink() resets the queue pointer
+    bool evicted = (n->q == q1_evicted_);
     unlink(n);
-    if (n->q != q1_evicted_)
+    if (!evicted)
         EvPolicy::aboutToBeRemoved(n->k, n->v);
     lookup_.remove(key);
     delete n;
@@ -0,0 +1,310 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtLocation module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia. For licensing terms and
+** conditions see http://qt.digia.com/licensing. For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights. These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QCONCURRENTCACHE3Q_H
+#define QCONCURRENTCACHE3Q_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+
+#include "qcache3q_p.h"
+
+#include <QtCore/qmutex.h>
+#include <QtCore/qatomic.h>
+#include <QtCore/qvector.h>
+
+QT_BEGIN_NAMESPACE
+
+/*
+ * QConcurrentCache3Q
+ *
+ * A thread-safe variant of QCache3Q. Keys are distributed over a fixed number
+ * of shards by their hash, each shard being a plain QCache3Q with its own
+ * lock and an equal part of the total cost budget. The 3Q admission and
+ * eviction rules therefore apply per shard, and threads working on keys in
+ * different shards never wait for each other.
+ *
+ * Eviction policy callbacks are invoked with the lock of the shard held, so
+ * they must not call back into the cache.
+ *
+ * The hit and miss counters are kept outside of the shards as atomics and
+ * can be read at any time without taking a lock.
+ */
+template <class Key, class T, class EvPolicy = QCache3QDefaultEvictionPolicy<Key,T> >
+class QConcurrentCache3Q
+{
+private:
+    struct Shard
+    {
+        QMutex mutex;
+        QCache3Q<Key,T,EvPolicy> cache;
+    };
+
+    QVector<Shard *> shards_;
+    int maxCost_;
+    mutable QAtomicInt hitCount_;
+    mutable QAtomicInt missCount_;
+
+    inline Shard *shard(const Key &key) const
+    {
+        return shards_.at(qHash(key) % uint(shards_.size()));
+    }
+
+public:
+    explicit QConcurrentCache3Q(int maxCost = 100, int shardCount = 8);
+    ~QConcurrentCache3Q();
+
+    inline int maxCost() const { return maxCost_; }
+    void setMaxCost(int maxCost);
+
+    int promoteAt() const;
+    void setPromoteAt(int p);
+
+    int totalCost() const;
+    inline int shardCount() const { return shards_.size(); }
+    inline int hitCount() const { return hitCount_.load(); }
+    inline int missCount() const { return missCount_.load(); }
+
+    void clear();
+    bool insert(const Key &key, QSharedPointer<T> object, int cost = 1);
+    QSharedPointer<T> object(const Key &key) const;
+    inline QSharedPointer<T> operator[](const Key &key) const { return object(key); }
+    bool contains(const Key &key) const;
+
+    void remove(const Key &key);
+
+    void printStats();
+
+    // Same as for QCache3Q, the queues of all shards are concatenated
+    void deserializeQueue(int queueNumber, const QList<Key> &keys,
+                          const QList<QSharedPointer<T> > &values, const QList<int> &costs);
+    void deserializeQueue(int queueNumber, const QList<Key> &keys,
+                          const QList<QSharedPointer<T> > &values, const QList<int> &costs,
+                          const QList<quint64> &pops);
+    void serializeQueue(int queueNumber, QList<QSharedPointer<T> > &buffer);
+    void serializeQueue(int queueNumber, QList<Key> &keys, QList<QSharedPointer<T> > &values,
+                        QList<int> &costs, QList<quint64> &pops);
+
+private:
+    Q_DISABLE_COPY(QConcurrentCache3Q)
+};
+
+template <class Key, class T, class EvPolicy>
+QConcurrentCache3Q<Key,T,EvPolicy>::QConcurrentCache3Q(int maxCost, int shardCount)
+    : maxCost_(maxCost)
+{
+    Q_ASSERT(shardCount > 0);
+    shards_.reserve(shardCount);
+    for (int i = 0; i < shardCount; ++i) {
+        Shard *s = new Shard;
+        s->cache.setMaxCost(maxCost / shardCount);
+        shards_.append(s);
+    }
+}
+
+template <class Key, class T, class EvPolicy>
+QConcurrentCache3Q<Key,T,EvPolicy>::~QConcurrentCache3Q()
+{
+    qDeleteAll(shards_);
+}
+
+template <class Key, class T, class EvPolicy>
+void QConcurrentCache3Q<Key,T,EvPolicy>::setMaxCost(int maxCost)
+{
+    maxCost_ = maxCost;
+    for (int i = 0; i < shards_.size(); ++i) {
+        QMutexLocker locker(&shards_[i]->mutex);
+        shards_[i]->cache.setMaxCost(maxCost / shards_.size());
+    }
+}
+
+template <class Key, class T, class EvPolicy>
+int QConcurrentCache3Q<Key,T,EvPolicy>::promoteAt() const
+{
+    QMutexLocker locker(&shards_[0]->mutex);
+    return shards_[0]->cache.promoteAt();
+}
+
+template <class Key, class T, class EvPolicy>
+void QConcurrentCache3Q<Key,T,EvPolicy>::setPromoteAt(int p)
+{
+    for (int i = 0; i < shards_.size(); ++i) {
+        QMutexLocker locker(&shards_[i]->mutex);
+        shards_[i]->cache.setPromoteAt(p);
+    }
+}
+
+template <class Key, class T, class EvPolicy>
+int QConcurrentCache3Q<Key,T,EvPolicy>::totalCost() const
+{
+    int cost = 0;
+    for (int i = 0; i < shards_.size(); ++i) {
+        QMutexLocker locker(&shards_[i]->mutex);
+        cost += shards_[i]->cache.totalCost();
+    }
+    return cost;
+}
+
+template <class Key, class T, class EvPolicy>
+void QConcurrentCache3Q<Key,T,EvPolicy>::clear()
+{
+    for (int i = 0; i < shards_.size(); ++i) {
+        QMutexLocker locker(&shards_[i]->mutex);
+        shards_[i]->cache.clear();
+    }
+}
+
+template <class Key, class T, class EvPolicy>
+bool QConcurrentCache3Q<Key,T,EvPolicy>::insert(const Key &key, QSharedPointer<T> object, int cost)
+{
+    Shard *s = shard(key);
+    QMutexLocker locker(&s->mutex);
+    return s->cache.insert(key, object, cost);
+}
+
+template <class Key, class T, class EvPolicy>
+QSharedPointer<T> QConcurrentCache3Q<Key,T,EvPolicy>::object(const Key &key) const
+{
+    Shard *s = shard(key);
+    QSharedPointer<T> result;
+    {
+        QMutexLocker locker(&s->mutex);
+        result = s->cache.object(key);
+    }
+
+    if (result)
+        hitCount_.ref();
+    else
+        missCount_.ref();
+
+    return result;
+}
+
+template <class Key, class T, class EvPolicy>
+bool QConcurrentCache3Q<Key,T,EvPolicy>::contains(const Key &key) const
+{
+    Shard *s = shard(key);
+    QMutexLocker locker(&s->mutex);
+    return s->cache.contains(key);
+}
+
+template <class Key, class T, class EvPolicy>
+void QConcurrentCache3Q<Key,T,EvPolicy>::remove(const Key &key)
+{
+    Shard *s = shard(key);
+    QMutexLocker locker(&s->mutex);
+    s->cache.remove(key);
+}
+
+template <class Key, class T, class EvPolicy>
+void QConcurrentCache3Q<Key,T,EvPolicy>::printStats()
+{
+    int hits = hitCount();
+    int misses = missCount();
+    qDebug("\n=== concurrent cache %p, %d shards ===", this, shards_.size());
+    qDebug("hits: %d (%.2f%%)\tmisses: %d\tfill: %.2f%%", hits,
+           100.0 * float(hits) / (float(hits + misses)),
+           misses,
+           100.0 * float(totalCost()) / float(maxCost()));
+    for (int i = 0; i < shards_.size(); ++i) {
+        QMutexLocker locker(&shards_[i]->mutex);
+        shards_[i]->cache.printStats();
+    }
+}
+
+template <class Key, class T, class EvPolicy>
+void QConcurrentCache3Q<Key,T,EvPolicy>::deserializeQueue(int queueNumber, const QList<Key> &keys,
+                                                          const QList<QSharedPointer<T> > &values,
+                                                          const QList<int> &costs)
+{
+    deserializeQueue(queueNumber, keys, values, costs, QList<quint64>());
+}
+
+template <class Key, class T, class EvPolicy>
+void QConcurrentCache3Q<Key,T,EvPolicy>::deserializeQueue(int queueNumber, const QList<Key> &keys,
+                                                          const QList<QSharedPointer<T> > &values,
+                                                          const QList<int> &costs,
+                                                          const QList<quint64> &pops)
+{
+    // split the lists up by shard, keeping the order within each shard
+    int count = shards_.size();
+    QVector<QList<Key> > shardKeys(count);
+    QVector<QList<QSharedPointer<T> > > shardValues(count);
+    QVector<QList<int> > shardCosts(count);
+    QVector<QList<quint64> > shardPops(count);
+
+    for (int i = 0; i < keys.size(); ++i) {
+        int index = qHash(keys.at(i)) % uint(count);
+        shardKeys[index].append(keys.at(i));
+        shardValues[index].append(values.at(i));
+        shardCosts[index].append(costs.at(i));
+        shardPops[index].append(i < pops.size() ? pops.at(i) : 0);
+    }
+
+    for (int i = 0; i < count; ++i) {
+        QMutexLocker locker(&shards_[i]->mutex);
+        shards_[i]->cache.deserializeQueue(queueNumber, shardKeys.at(i), shardValues.at(i),
+                                           shardCosts.at(i), shardPops.at(i));
+    }
+}
+
+template <class Key, class T, class EvPolicy>
+void QConcurrentCache3Q<Key,T,EvPolicy>::serializeQueue(int queueNumber, QList<QSharedPointer<T> > &buffer)
+{
+    for (int i = 0; i < shards_.size(); ++i) {
+        QMutexLocker locker(&shards_[i]->mutex);
+        shards_[i]->cache.serializeQueue(queueNumber, buffer);
+    }
+}
+
+template <class Key, class T, class EvPolicy>
+void QConcurrentCache3Q<Key,T,EvPolicy>::serializeQueue(int queueNumber, QList<Key> &keys,
+                                                        QList<QSharedPointer<T> > &values,
+                                                        QList<int> &costs, QList<quint64> &pops)
+{
+    for (int i = 0; i < shards_.size(); ++i) {
+        QMutexLocker locker(&shards_[i]->mutex);
+        shards_[i]->cache.serializeQueue(queueNumber, keys, values, costs, pops);
+    }
+}
+
+QT_END_NAMESPACE
+
+#endif // QCONCURRENTCACHE3Q_H
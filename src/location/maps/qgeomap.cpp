@@ -140,6 +140,20 @@ QDoubleVector2D QGeoMap::coordinateToScreenPosition(const QGeoCoordinate &coordi
     return mapData_->coordinateToScreenPosition(coordinate, clipToViewport);
 }
 
+/*!
+    \internal
+
+    Projects all of \a coordinates at once into \a positions, which must have
+    room for coordinates.size() points. Points outside the viewport are set to
+    NaN if \a clipToViewport is true.
+*/
+void QGeoMap::coordinatesToScreenPositions(const QGeoCoordinateArray &coordinates,
+                                           QDoubleVector2D *positions,
+                                           bool clipToViewport) const
+{
+    mapData_->coordinatesToScreenPositions(coordinates, positions, clipToViewport);
+}
+
 void QGeoMap::update()
 {
     emit mapData_->update();
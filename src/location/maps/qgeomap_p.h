@@ -53,6 +53,7 @@
 QT_BEGIN_NAMESPACE
 
 class QGeoCoordinate;
+class QGeoCoordinateArray;
 class QGeoRectangle;
 
 class QGeoMappingManager;
@@ -93,6 +94,9 @@ public:
     QGeoRectangle visibleRegion() const;
     QGeoCoordinate screenPositionToCoordinate(const QDoubleVector2D &pos, bool clipToViewport = true) const;
     QDoubleVector2D coordinateToScreenPosition(const QGeoCoordinate &coordinate, bool clipToViewport = true) const;
+    void coordinatesToScreenPositions(const QGeoCoordinateArray &coordinates,
+                                      QDoubleVector2D *positions,
+                                      bool clipToViewport = true) const;
 
     void setActiveMapType(const QGeoMapType mapType);
     const QGeoMapType activeMapType() const;
@@ -47,6 +47,7 @@
 
 
 #include <QtPositioning/private/qgeoprojection_p.h>
+#include <QtPositioning/private/qgeocoordinatearray_p.h>
 #include <QtPositioning/private/qdoublevector2d_p.h>
 #include <QtPositioning/private/qdoublevector3d_p.h>
 
@@ -130,6 +131,21 @@ const QGeoMapType QGeoMapData::activeMapType() const
     return d->activeMapType();
 }
 
+/*
+    Map types that can project many points faster than one at a time should
+    reimplement this. The default projects each coordinate on its own.
+*/
+void QGeoMapData::coordinatesToScreenPositions(const QGeoCoordinateArray &coordinates,
+                                               QDoubleVector2D *positions,
+                                               bool clipToViewport) const
+{
+    QGeoCoordinate coordinate;
+    for (int i = 0; i < coordinates.size(); ++i) {
+        coordinates.coordinateAt(i, &coordinate);
+        positions[i] = coordinateToScreenPosition(coordinate, clipToViewport);
+    }
+}
+
 QString QGeoMapData::pluginString()
 {
     Q_D(QGeoMapData);
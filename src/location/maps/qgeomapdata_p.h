@@ -52,6 +52,7 @@
 QT_BEGIN_NAMESPACE
 
 class QGeoCoordinate;
+class QGeoCoordinateArray;
 
 class QGeoMappingManagerEngine;
 
@@ -90,6 +91,9 @@ public:
 
     virtual QGeoCoordinate screenPositionToCoordinate(const QDoubleVector2D &pos, bool clipToViewport = true) const = 0;
     virtual QDoubleVector2D coordinateToScreenPosition(const QGeoCoordinate &coordinate, bool clipToViewport = true) const = 0;
+    virtual void coordinatesToScreenPositions(const QGeoCoordinateArray &coordinates,
+                                              QDoubleVector2D *positions,
+                                              bool clipToViewport = true) const;
 
     QString pluginString();
     QGeoCameraCapabilities cameraCapabilities();
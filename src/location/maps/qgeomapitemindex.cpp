@@ -0,0 +1,270 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtLocation module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia. For licensing terms and
+** conditions see http://qt.digia.com/licensing. For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights. These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qgeomapitemindex_p.h"
+
+#include <QtCore/qmath.h>
+
+QT_BEGIN_NAMESPACE
+
+/*
+    QGeoMapItemIndex keeps the bounds of map items in normalized mercator
+    space, where x and y run from 0 to 1 and x wraps around at the dateline.
+
+    It is a hierarchy of sparse grids. An item is stored in exactly one cell,
+    on the finest level whose cells are at least as large as the item, in the
+    cell containing its center. A cell therefore only holds items which lie
+    within half a cell of it, and a query only visits the cells within half a
+    cell of the queried rectangle on each level, or the occupied ones when
+    there are fewer of those.
+
+    Items whose bounds are not known yet are kept unbounded and are part of
+    every query result.
+*/
+
+QGeoMapItemIndex::QGeoMapItemIndex()
+:   levels_(MaximumLevel + 1)
+{
+}
+
+/*
+    Inserts \a item with the given mercator \a bounds, replacing any bounds it
+    had before. The bounds may extend past the dateline on either side.
+*/
+void QGeoMapItemIndex::insert(QObject *item, const QRectF &bounds)
+{
+    remove(item);
+
+    Entry entry;
+    entry.bounds = bounds.normalized();
+
+    // keep the center within [0, 1) so the item has a single home cell
+    const double shift = qFloor(entry.bounds.center().x());
+    entry.bounds.translate(-shift, 0.0);
+
+    entry.level = levelFor(entry.bounds);
+    const int n = 1 << entry.level;
+    const QPointF center = entry.bounds.center();
+    const int x = qBound(0, int(center.x() * n), n - 1);
+    const int y = qBound(0, int(center.y() * n), n - 1);
+    entry.cell = cellKey(x, y);
+
+    levels_[entry.level][entry.cell].append(item);
+    entries_.insert(item, entry);
+}
+
+/*
+    Inserts \a item without bounds, so that every query returns it.
+*/
+void QGeoMapItemIndex::insertUnbounded(QObject *item)
+{
+    remove(item);
+    unbounded_.insert(item);
+}
+
+void QGeoMapItemIndex::remove(QObject *item)
+{
+    if (unbounded_.remove(item))
+        return;
+
+    QHash<QObject *, Entry>::iterator it = entries_.find(item);
+    if (it == entries_.end())
+        return;
+
+    takeFromCell(item, it.value());
+    entries_.erase(it);
+}
+
+void QGeoMapItemIndex::clear()
+{
+    for (int i = 0; i < levels_.size(); ++i)
+        levels_[i].clear();
+    entries_.clear();
+    unbounded_.clear();
+}
+
+bool QGeoMapItemIndex::contains(QObject *item) const
+{
+    return entries_.contains(item) || unbounded_.contains(item);
+}
+
+bool QGeoMapItemIndex::isBounded(QObject *item) const
+{
+    return entries_.contains(item);
+}
+
+/*
+    Returns the bounds \a item was inserted with, moved by a whole number of
+    worlds so that their center lies within [0, 1). Unbounded and unknown
+    items have null bounds.
+*/
+QRectF QGeoMapItemIndex::bounds(QObject *item) const
+{
+    QHash<QObject *, Entry>::const_iterator it = entries_.constFind(item);
+    if (it == entries_.constEnd())
+        return QRectF();
+    return it.value().bounds;
+}
+
+int QGeoMapItemIndex::size() const
+{
+    return entries_.size() + unbounded_.size();
+}
+
+/*
+    Returns the items whose bounds intersect \a rect, followed by the
+    unbounded items. Touching edges count as intersecting, so \a rect may be
+    a single point. Each item is returned once, in no particular order.
+*/
+QVector<QObject *> QGeoMapItemIndex::query(const QRectF &rect) const
+{
+    QRectF r = rect.normalized();
+    r.translate(-qFloor(r.left()), 0.0);
+
+    QVector<QObject *> result;
+    for (int level = 0; level <= MaximumLevel; ++level) {
+        if (!levels_.at(level).isEmpty())
+            queryLevel(level, r, &result);
+    }
+
+    result.reserve(result.size() + unbounded_.size());
+    foreach (QObject *item, unbounded_)
+        result.append(item);
+
+    return result;
+}
+
+/*
+    Returns whether mercator \a bounds and \a rect overlap, taking the
+    wrapping of x into account.
+*/
+bool QGeoMapItemIndex::intersects(const QRectF &bounds, const QRectF &rect)
+{
+    if (bounds.top() > rect.bottom() || rect.top() > bounds.bottom())
+        return false;
+
+    if (bounds.width() >= 1.0 || rect.width() >= 1.0)
+        return true;
+
+    // bring both left edges into [0, 1) and try the neighbouring worlds
+    const double left = bounds.left() - qFloor(bounds.left());
+    const double right = left + bounds.width();
+    const double rectLeft = rect.left() - qFloor(rect.left());
+    const double rectRight = rectLeft + rect.width();
+
+    for (int shift = -1; shift <= 1; ++shift) {
+        if (left + shift <= rectRight && rectLeft <= right + shift)
+            return true;
+    }
+    return false;
+}
+
+int QGeoMapItemIndex::levelFor(const QRectF &bounds)
+{
+    const double extent = qMax(bounds.width(), bounds.height());
+    if (extent <= 0.0)
+        return MaximumLevel;
+    if (extent >= 1.0)
+        return 0;
+
+    const int level = qFloor(-std::log(extent) / std::log(2.0));
+    return qBound(0, level, int(MaximumLevel));
+}
+
+void QGeoMapItemIndex::takeFromCell(QObject *item, const Entry &entry)
+{
+    QHash<quint64, QVector<QObject *> > &cells = levels_[entry.level];
+    QHash<quint64, QVector<QObject *> >::iterator cell = cells.find(entry.cell);
+    if (cell == cells.end())
+        return;
+
+    QVector<QObject *> &items = cell.value();
+    const int i = items.indexOf(item);
+    if (i >= 0) {
+        items[i] = items.last();
+        items.removeLast();
+    }
+    if (items.isEmpty())
+        cells.erase(cell);
+}
+
+void QGeoMapItemIndex::queryLevel(int level, const QRectF &rect, QVector<QObject *> *result) const
+{
+    const QHash<quint64, QVector<QObject *> > &cells = levels_.at(level);
+    const int n = 1 << level;
+    const double size = 1.0 / n;
+
+    // items stick out of their cell by at most half a cell
+    const int x0 = qFloor((rect.left() - size / 2) * n);
+    const int x1 = qFloor((rect.right() + size / 2) * n);
+    const int y0 = qMax(0, qFloor((rect.top() - size / 2) * n));
+    const int y1 = qMin(n - 1, qFloor((rect.bottom() + size / 2) * n));
+    if (y1 < y0)
+        return;
+
+    const bool allColumns = (x1 - x0 + 1) >= n;
+    const int columns = allColumns ? n : x1 - x0 + 1;
+    const qint64 candidates = qint64(columns) * (y1 - y0 + 1);
+
+    if (candidates > cells.size()) {
+        QHash<quint64, QVector<QObject *> >::const_iterator cell;
+        for (cell = cells.constBegin(); cell != cells.constEnd(); ++cell) {
+            const int x = int(quint32(cell.key()));
+            const int y = int(quint32(cell.key() >> 32));
+            if (y < y0 || y > y1)
+                continue;
+            if (!allColumns && (((x - x0) % n) + n) % n >= columns)
+                continue;
+            foreach (QObject *item, cell.value()) {
+                if (intersects(entries_.value(item).bounds, rect))
+                    result->append(item);
+            }
+        }
+        return;
+    }
+
+    for (int y = y0; y <= y1; ++y) {
+        for (int i = 0; i < columns; ++i) {
+            const int x = allColumns ? i : (((x0 + i) % n) + n) % n;
+            QHash<quint64, QVector<QObject *> >::const_iterator cell = cells.constFind(cellKey(x, y));
+            if (cell == cells.constEnd())
+                continue;
+            foreach (QObject *item, cell.value()) {
+                if (intersects(entries_.value(item).bounds, rect))
+                    result->append(item);
+            }
+        }
+    }
+}
+
+QT_END_NAMESPACE
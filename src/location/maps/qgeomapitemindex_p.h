@@ -0,0 +1,101 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtLocation module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia. For licensing terms and
+** conditions see http://qt.digia.com/licensing. For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights. These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QGEOMAPITEMINDEX_P_H
+#define QGEOMAPITEMINDEX_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtLocation/qlocationglobal.h>
+
+#include <QHash>
+#include <QRectF>
+#include <QSet>
+#include <QVector>
+
+QT_BEGIN_NAMESPACE
+
+class QObject;
+
+class Q_LOCATION_EXPORT QGeoMapItemIndex
+{
+public:
+    enum { MaximumLevel = 20 };
+
+    QGeoMapItemIndex();
+
+    void insert(QObject *item, const QRectF &bounds);
+    void insertUnbounded(QObject *item);
+    void remove(QObject *item);
+    void clear();
+
+    bool contains(QObject *item) const;
+    bool isBounded(QObject *item) const;
+    QRectF bounds(QObject *item) const;
+    int size() const;
+
+    QVector<QObject *> query(const QRectF &rect) const;
+
+    static bool intersects(const QRectF &bounds, const QRectF &rect);
+
+private:
+    struct Entry
+    {
+        QRectF bounds;
+        int level;
+        quint64 cell;
+    };
+
+    static int levelFor(const QRectF &bounds);
+    static quint64 cellKey(int x, int y) { return (quint64(quint32(y)) << 32) | quint32(x); }
+    void takeFromCell(QObject *item, const Entry &entry);
+    void queryLevel(int level, const QRectF &rect, QVector<QObject *> *result) const;
+
+    // one sparse grid per level, cells of level n are 2^-n wide
+    QVector<QHash<quint64, QVector<QObject *> > > levels_;
+    QHash<QObject *, Entry> entries_;
+    QSet<QObject *> unbounded_;
+};
+
+QT_END_NAMESPACE
+
+#endif // QGEOMAPITEMINDEX_P_H
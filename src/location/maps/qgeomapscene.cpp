@@ -113,6 +113,8 @@ public:
 
     QDoubleVector2D screenPositionToMercator(const QDoubleVector2D &pos) const;
     QDoubleVector2D mercatorToScreenPosition(const QDoubleVector2D &mercator) const;
+    void mercatorToScreenPositions(const QDoubleVector2D *mercator, int count,
+                                   QDoubleVector2D *positions) const;
 
     void setVisibleTiles(const QSet<QGeoTileSpec> &tiles);
     void removeTiles(const QSet<QGeoTileSpec> &oldTiles);
@@ -186,6 +188,17 @@ QDoubleVector2D QGeoMapScene::mercatorToScreenPosition(const QDoubleVector2D &me
     return d->mercatorToScreenPosition(mercator);
 }
 
+/*
+    Projects \a count points from \a mercator into \a positions, which may
+    be the same array. The camera is only looked at once for all of them.
+*/
+void QGeoMapScene::mercatorToScreenPositions(const QDoubleVector2D *mercator, int count,
+                                             QDoubleVector2D *positions) const
+{
+    Q_D(const QGeoMapScene);
+    d->mercatorToScreenPositions(mercator, count, positions);
+}
+
 bool QGeoMapScene::verticalLock() const
 {
     Q_D(const QGeoMapScene);
@@ -251,8 +264,15 @@ QDoubleVector2D QGeoMapScenePrivate::screenPositionToMercator(const QDoubleVecto
 
 QDoubleVector2D QGeoMapScenePrivate::mercatorToScreenPosition(const QDoubleVector2D &mercator) const
 {
-    double mx = sideLength_ * mercator.x();
+    QDoubleVector2D position;
+    mercatorToScreenPositions(&mercator, 1, &position);
+    return position;
+}
 
+void QGeoMapScenePrivate::mercatorToScreenPositions(const QDoubleVector2D *mercator, int count,
+                                                    QDoubleVector2D *positions) const
+{
+    // everything depending only on the camera is worked out once
     double lb = mercatorCenterX_ - mercatorWidth_ / 2.0;
     if (lb < 0.0)
         lb += sideLength_;
@@ -260,35 +280,37 @@ QDoubleVector2D QGeoMapScenePrivate::mercatorToScreenPosition(const QDoubleVecto
     if (sideLength_ < ub)
         ub -= sideLength_;
 
-    double m = (mx - mercatorCenterX_) / mercatorWidth_;
+    // correct for crossing dateline
+    const bool crossesDateline = qFuzzyCompare(ub - lb + 1.0, 1.0) || (ub < lb);
+    const bool wrapAboveLower = crossesDateline && mercatorCenterX_ < ub;
+    const bool wrapBelowUpper = crossesDateline && !wrapAboveLower && lb < mercatorCenterX_;
 
-    double mWrapLower = (mx - mercatorCenterX_ - sideLength_) / mercatorWidth_;
-    double mWrapUpper = (mx - mercatorCenterX_ + sideLength_) / mercatorWidth_;
+    for (int i = 0; i < count; ++i) {
+        double mx = sideLength_ * mercator[i].x();
+        double my = mercator[i].y();
 
-    // correct for crossing dateline
-    if (qFuzzyCompare(ub - lb + 1.0, 1.0) || (ub < lb) ) {
-        if (mercatorCenterX_ < ub) {
-            if (lb < mx) {
-                 m = mWrapLower;
-            }
-        } else if (lb < mercatorCenterX_) {
-            if (mx <= ub) {
-                m = mWrapUpper;
-            }
-        }
-    }
+        double m = (mx - mercatorCenterX_) / mercatorWidth_;
 
-    // apply wrapping if necessary so we don't return unreasonably large pos/neg screen positions
-    // also allows map items to be drawn properly if some of their coords are out of the screen
-    if ( qAbs(mWrapLower) < qAbs(m) )
-        m = mWrapLower;
-    if ( qAbs(mWrapUpper) < qAbs(m) )
-        m = mWrapUpper;
+        double mWrapLower = (mx - mercatorCenterX_ - sideLength_) / mercatorWidth_;
+        double mWrapUpper = (mx - mercatorCenterX_ + sideLength_) / mercatorWidth_;
 
-    double x = screenWidth_ * (0.5 + m);
-    double y = screenHeight_ * (0.5 + (sideLength_ * mercator.y() - mercatorCenterY_) / mercatorHeight_);
+        if (wrapAboveLower && lb < mx)
+            m = mWrapLower;
+        else if (wrapBelowUpper && mx <= ub)
+            m = mWrapUpper;
 
-    return QDoubleVector2D(x + screenOffsetX_, y + screenOffsetY_);
+        // apply wrapping if necessary so we don't return unreasonably large pos/neg screen positions
+        // also allows map items to be drawn properly if some of their coords are out of the screen
+        if ( qAbs(mWrapLower) < qAbs(m) )
+            m = mWrapLower;
+        if ( qAbs(mWrapUpper) < qAbs(m) )
+            m = mWrapUpper;
+
+        double x = screenWidth_ * (0.5 + m);
+        double y = screenHeight_ * (0.5 + (sideLength_ * my - mercatorCenterY_) / mercatorHeight_);
+
+        positions[i] = QDoubleVector2D(x + screenOffsetX_, y + screenOffsetY_);
+    }
 }
 
 bool QGeoMapScenePrivate::buildGeometry(const QGeoTileSpec &spec, QSGGeometry::TexturedPoint2D *vertices)
@@ -87,6 +87,8 @@ public:
 
     QDoubleVector2D screenPositionToMercator(const QDoubleVector2D &pos) const;
     QDoubleVector2D mercatorToScreenPosition(const QDoubleVector2D &mercator) const;
+    void mercatorToScreenPositions(const QDoubleVector2D *mercator, int count,
+                                   QDoubleVector2D *positions) const;
 
     QSGNode *updateSceneGraph(QSGNode *oldNode, QQuickWindow *window);
 
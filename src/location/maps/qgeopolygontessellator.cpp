@@ -0,0 +1,724 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtLocation module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia. For licensing terms and
+** conditions see http://qt.digia.com/licensing. For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights. These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qgeopolygontessellator_p.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+QT_BEGIN_NAMESPACE
+
+namespace {
+
+enum ClipEdge { LeftEdge, RightEdge, TopEdge, BottomEdge };
+
+inline bool insideEdge(const QPointF &point, ClipEdge edge, double value)
+{
+    switch (edge) {
+    case LeftEdge:
+        return point.x() >= value;
+    case RightEdge:
+        return point.x() <= value;
+    case TopEdge:
+        return point.y() >= value;
+    default:
+        return point.y() <= value;
+    }
+}
+
+inline QPointF edgeIntersection(const QPointF &a, const QPointF &b, ClipEdge edge, double value)
+{
+    if (edge == LeftEdge || edge == RightEdge) {
+        const double t = (value - a.x()) / (b.x() - a.x());
+        return QPointF(value, a.y() + t * (b.y() - a.y()));
+    }
+    const double t = (value - a.y()) / (b.y() - a.y());
+    return QPointF(a.x() + t * (b.x() - a.x()), value);
+}
+
+// one Sutherland-Hodgman pass, appends the part of the ring inside the edge
+void clipToEdge(const QPointF *points, int count, ClipEdge edge, double value,
+                QVector<QPointF> *result)
+{
+    if (count == 0)
+        return;
+
+    QPointF previous = points[count - 1];
+    bool previousInside = insideEdge(previous, edge, value);
+    for (int i = 0; i < count; ++i) {
+        const QPointF &current = points[i];
+        const bool currentInside = insideEdge(current, edge, value);
+        if (currentInside != previousInside)
+            result->append(edgeIntersection(previous, current, edge, value));
+        if (currentInside)
+            result->append(current);
+        previous = current;
+        previousInside = currentInside;
+    }
+}
+
+// twice the signed area of the triangle, positive if a, b, c turn
+// counter-clockwise
+inline double turn(const QPointF &a, const QPointF &b, const QPointF &c)
+{
+    return (b.x() - a.x()) * (c.y() - a.y()) - (b.y() - a.y()) * (c.x() - a.x());
+}
+
+// true also for points on the border, whichever way the triangle turns
+inline bool inTriangle(const QPointF &a, const QPointF &b, const QPointF &c, const QPointF &p)
+{
+    const double ab = turn(a, b, p);
+    const double bc = turn(b, c, p);
+    const double ca = turn(c, a, p);
+    return (ab >= 0.0 && bc >= 0.0 && ca >= 0.0) || (ab <= 0.0 && bc <= 0.0 && ca <= 0.0);
+}
+
+// empties a buffer without giving its memory back
+template <typename T>
+inline void reset(QVector<T> *buffer)
+{
+    buffer->reserve(buffer->capacity());
+    buffer->resize(0);
+}
+
+}
+
+/*
+    QGeoPolygonTessellator turns polygons given in screen coordinates into
+    triangles, for the fill of map polygons.
+
+    A shape is a set of rings with the even-odd fill rule, the rule of
+    QPainterPath::simplified(): a ring inside an odd number of other rings
+    is a hole in the smallest of them, any other ring is the outline of a
+    polygon of its own. Each ring is clipped to the clip rectangle, if one is
+    set, with a linear Sutherland-Hodgman pass per edge. Where a concave ring
+    leaves the rectangle and comes back, the clipped ring runs back and forth
+    along the edge, which adds no area.
+
+    Each polygon is then triangulated by ear clipping. Its holes are joined
+    into the outline by pairs of coincident edges, from the rightmost point
+    of each hole to a point of the outline it can see, which leaves a single
+    ring. An ear is a convex corner whose triangle holds no reflex corner of
+    the ring, and only reflex corners can make that test fail, so they are
+    kept in a grid and each test looks at the cells the triangle covers. A
+    ring that crosses itself runs out of ears before it is done; its convex
+    corners are then cut off regardless.
+
+    The tessellator keeps every buffer between shapes, so once it has seen
+    a shape of a given size it triangulates shapes of that size without
+    allocating.
+*/
+
+QGeoPolygonTessellator::QGeoPolygonTessellator()
+:   gridSide_(1), gridLeft_(0.0), gridTop_(0.0), gridScale_(0.0)
+{
+}
+
+/*
+    Forgets the rings and the result of the last shape, but keeps the memory
+    they used.
+*/
+void QGeoPolygonTessellator::clear()
+{
+    reset(&input_);
+    reset(&inputRings_);
+    reset(&vertices_);
+    reset(&rings_);
+    reset(&indices_);
+    clipRect_ = QRectF();
+}
+
+/*
+    Clips all rings to \a rect. A null rectangle turns clipping off.
+*/
+void QGeoPolygonTessellator::setClipRect(const QRectF &rect)
+{
+    clipRect_ = rect;
+}
+
+/*
+    Adds a ring of \a count \a points to the shape. The ring is closed
+    implicitly; repeating the first point at the end is allowed.
+*/
+void QGeoPolygonTessellator::addRing(const QPointF *points, int count)
+{
+    const int start = input_.size();
+    for (int i = 0; i < count; ++i)
+        input_.append(points[i]);
+    finishRing(start);
+}
+
+void QGeoPolygonTessellator::addRing(const QVector<QPointF> &points)
+{
+    addRing(points.constData(), points.size());
+}
+
+/*
+    Adds every subpath of \a path as a ring. The path may only contain
+    straight lines.
+*/
+void QGeoPolygonTessellator::addPath(const QPainterPath &path)
+{
+    int start = input_.size();
+    for (int i = 0; i < path.elementCount(); ++i) {
+        const QPainterPath::Element e = path.elementAt(i);
+        if (e.isMoveTo()) {
+            finishRing(start);
+            start = input_.size();
+        } else if (!e.isLineTo()) {
+            qWarning("Unhandled element type in polygon painterpath");
+            continue;
+        }
+        input_.append(QPointF(e.x, e.y));
+    }
+    finishRing(start);
+}
+
+/*
+    Turns the points added to the input from \a start on into a ring, or
+    drops them if they do not make one.
+*/
+void QGeoPolygonTessellator::finishRing(int start)
+{
+    int count = input_.size() - start;
+    if (count > 1 && input_.at(input_.size() - 1) == input_.at(start))
+        --count;
+    if (count < 3) {
+        input_.resize(start);
+        return;
+    }
+    input_.resize(start + count);
+
+    Ring ring;
+    ring.start = start;
+    ring.size = count;
+    ring.parent = -1;
+    ring.output = -1;
+
+    const QPointF *points = input_.constData() + start;
+    double minX = points[0].x();
+    double maxX = minX;
+    double minY = points[0].y();
+    double maxY = minY;
+    for (int i = 1; i < count; ++i) {
+        minX = qMin(minX, points[i].x());
+        maxX = qMax(maxX, points[i].x());
+        minY = qMin(minY, points[i].y());
+        maxY = qMax(maxY, points[i].y());
+    }
+    ring.bounds = QRectF(QPointF(minX, minY), QPointF(maxX, maxY));
+    inputRings_.append(ring);
+}
+
+/*
+    Clips and triangulates the rings added since the last clear().
+*/
+void QGeoPolygonTessellator::tessellate()
+{
+    reset(&vertices_);
+    reset(&rings_);
+    reset(&indices_);
+
+    classifyRings();
+
+    for (int r = 0; r < inputRings_.size(); ++r)
+        inputRings_[r].output = clipRing(inputRings_.at(r));
+
+    // holes whose outline was clipped away go with it
+    for (int r = 0; r < inputRings_.size(); ++r) {
+        const Ring &ring = inputRings_.at(r);
+        if (ring.output < 0)
+            continue;
+        if (ring.parent < 0) {
+            rings_[ring.output].parent = -1;
+        } else {
+            const int parent = inputRings_.at(ring.parent).output;
+            rings_[ring.output].parent = parent < 0 ? -2 : parent;
+        }
+    }
+
+    for (int r = 0; r < rings_.size(); ++r) {
+        if (rings_.at(r).parent == -1)
+            tessellatePolygon(r);
+    }
+}
+
+/*
+    Returns the number of rings left after clipping. The points of ring
+    \a ring are the ringSize() vertices starting at ringStart().
+*/
+int QGeoPolygonTessellator::ringCount() const
+{
+    return rings_.size();
+}
+
+int QGeoPolygonTessellator::ringStart(int ring) const
+{
+    return rings_.at(ring).start;
+}
+
+int QGeoPolygonTessellator::ringSize(int ring) const
+{
+    return rings_.at(ring).size;
+}
+
+/*
+    Returns the points of the clipped rings.
+*/
+const QVector<QPointF> &QGeoPolygonTessellator::vertices() const
+{
+    return vertices_;
+}
+
+/*
+    Returns three indices into vertices() for every triangle.
+*/
+const QVector<quint32> &QGeoPolygonTessellator::indices() const
+{
+    return indices_;
+}
+
+void QGeoPolygonTessellator::classifyRings()
+{
+    const int count = inputRings_.size();
+    if (count < 2)
+        return;
+
+    // the nesting depth of a ring is the number of rings around it
+    QVector<int> depth(count, 0);
+    for (int r = 0; r < count; ++r) {
+        const Ring &ring = inputRings_.at(r);
+        const QPointF &point = input_.at(ring.start);
+        for (int o = 0; o < count; ++o) {
+            const Ring &other = inputRings_.at(o);
+            if (o != r && other.bounds.contains(ring.bounds) && ringContains(other, point))
+                ++depth[r];
+        }
+    }
+
+    for (int r = 0; r < count; ++r) {
+        Ring &ring = inputRings_[r];
+        if (depth.at(r) % 2 == 0)
+            continue;
+
+        const QPointF &point = input_.at(ring.start);
+        for (int o = 0; o < count; ++o) {
+            const Ring &other = inputRings_.at(o);
+            if (o != r && depth.at(o) == depth.at(r) - 1
+                    && other.bounds.contains(ring.bounds) && ringContains(other, point)) {
+                ring.parent = o;
+                break;
+            }
+        }
+    }
+}
+
+bool QGeoPolygonTessellator::ringContains(const Ring &ring, const QPointF &point) const
+{
+    const QPointF *points = input_.constData() + ring.start;
+    bool inside = false;
+    for (int i = 0, j = ring.size - 1; i < ring.size; j = i++) {
+        const QPointF &a = points[i];
+        const QPointF &b = points[j];
+        if ((a.y() > point.y()) != (b.y() > point.y())
+                && point.x() < (b.x() - a.x()) * (point.y() - a.y()) / (b.y() - a.y()) + a.x())
+            inside = !inside;
+    }
+    return inside;
+}
+
+/*
+    Appends the part of \a ring inside the clip rectangle to the vertices and
+    returns its index among the clipped rings, or -1 if nothing is left.
+*/
+int QGeoPolygonTessellator::clipRing(const Ring &ring)
+{
+    const QPointF *points = input_.constData() + ring.start;
+
+    Ring clipped;
+    clipped.start = vertices_.size();
+    clipped.parent = -1;
+    clipped.output = -1;
+
+    if (clipRect_.isNull() || clipRect_.contains(ring.bounds)) {
+        for (int i = 0; i < ring.size; ++i)
+            vertices_.append(points[i]);
+        clipped.bounds = ring.bounds;
+    } else {
+        if (!clipRect_.intersects(ring.bounds))
+            return -1;
+
+        reset(&clipBuffer_);
+        clipToEdge(points, ring.size, LeftEdge, clipRect_.left(), &clipBuffer_);
+        reset(&clipBuffer2_);
+        clipToEdge(clipBuffer_.constData(), clipBuffer_.size(), RightEdge, clipRect_.right(), &clipBuffer2_);
+        reset(&clipBuffer_);
+        clipToEdge(clipBuffer2_.constData(), clipBuffer2_.size(), TopEdge, clipRect_.top(), &clipBuffer_);
+        clipToEdge(clipBuffer_.constData(), clipBuffer_.size(), BottomEdge, clipRect_.bottom(), &vertices_);
+        clipped.bounds = ring.bounds & clipRect_;
+    }
+
+    clipped.size = vertices_.size() - clipped.start;
+    if (clipped.size < 3) {
+        vertices_.resize(clipped.start);
+        return -1;
+    }
+
+    rings_.append(clipped);
+    return rings_.size() - 1;
+}
+
+/*
+    Triangulates the clipped ring \a outer together with the clipped rings
+    that are holes in it.
+*/
+void QGeoPolygonTessellator::tessellatePolygon(int outer)
+{
+    reset(&corners_);
+
+    const int loop = appendLoop(rings_.at(outer), true);
+    int count = rings_.at(outer).size;
+
+    // bridge the holes from right to left, so that every bridge ends on the
+    // outline or on a hole that is already part of it
+    reset(&holes_);
+    for (int r = 0; r < rings_.size(); ++r) {
+        if (rings_.at(r).parent == outer)
+            holes_.append(qMakePair(-rings_.at(r).bounds.right(), r));
+    }
+    std::sort(holes_.begin(), holes_.end());
+    for (int h = 0; h < holes_.size(); ++h) {
+        const Ring &hole = rings_.at(holes_.at(h).second);
+        if (bridgeHole(appendLoop(hole, false), loop))
+            count += hole.size + 2;
+    }
+
+    buildGrid(loop, count, rings_.at(outer).bounds);
+    clipEars(loop, count);
+}
+
+/*
+    Appends the points of \a ring to the corners as a closed loop, turning
+    counter-clockwise if \a positive is true and clockwise otherwise, and
+    returns its first corner.
+*/
+int QGeoPolygonTessellator::appendLoop(const Ring &ring, bool positive)
+{
+    const QPointF *points = vertices_.constData() + ring.start;
+    double twiceArea = 0.0;
+    for (int i = 0, j = ring.size - 1; i < ring.size; j = i++)
+        twiceArea += points[j].x() * points[i].y() - points[i].x() * points[j].y();
+    const bool forward = (twiceArea > 0.0) == positive;
+
+    const int first = corners_.size();
+    for (int k = 0; k < ring.size; ++k) {
+        const int i = forward ? k : ring.size - 1 - k;
+        Corner corner;
+        corner.point = points[i];
+        corner.index = ring.start + i;
+        corner.prev = first + (k + ring.size - 1) % ring.size;
+        corner.next = first + (k + 1) % ring.size;
+        corner.nextInCell = -1;
+        corner.reflex = false;
+        corners_.append(corner);
+    }
+    return first;
+}
+
+int QGeoPolygonTessellator::copyCorner(int c)
+{
+    Corner copy = corners_.at(c);
+    copy.nextInCell = -1;
+    corners_.append(copy);
+    return corners_.size() - 1;
+}
+
+/*
+    Joins the loop starting at \a hole into the one at \a loop through two
+    coincident edges, running from the rightmost corner of the hole to a
+    corner of the loop that it can see. Returns false if there is no such
+    corner, and the hole is left out.
+*/
+bool QGeoPolygonTessellator::bridgeHole(int hole, int loop)
+{
+    int m = hole;
+    for (int c = corners_.at(hole).next; c != hole; c = corners_.at(c).next) {
+        if (corners_.at(c).point.x() > corners_.at(m).point.x())
+            m = c;
+    }
+    const QPointF from = corners_.at(m).point;
+
+    // the first edge of the loop hit by a ray from that corner towards +x;
+    // seen from inside, it is an edge running towards +y
+    int edge = -1;
+    double hitX = std::numeric_limits<double>::infinity();
+    int c = loop;
+    do {
+        const QPointF &p = corners_.at(c).point;
+        const QPointF &q = corners_.at(corners_.at(c).next).point;
+        if (p.y() <= from.y() && q.y() >= from.y() && p.y() < q.y()) {
+            const double x = p.x() + (from.y() - p.y()) * (q.x() - p.x()) / (q.y() - p.y());
+            if (x >= from.x() && x < hitX) {
+                hitX = x;
+                edge = c;
+            }
+        }
+        c = corners_.at(c).next;
+    } while (c != loop);
+    if (edge < 0)
+        return false;
+
+    int target = edge;
+    if (corners_.at(corners_.at(edge).next).point.x() > corners_.at(edge).point.x())
+        target = corners_.at(edge).next;
+
+    // reflex corners in the triangle between the hole, the hit and the end
+    // of the edge may hide that end; the one closest in angle to the ray is
+    // visible
+    const QPointF hit(hitX, from.y());
+    const QPointF end = corners_.at(target).point;
+    if (hit != end) {
+        double bestSlope = std::numeric_limits<double>::infinity();
+        double bestDistance = std::numeric_limits<double>::infinity();
+        c = loop;
+        do {
+            const Corner &corner = corners_.at(c);
+            const double dx = corner.point.x() - from.x();
+            const double dy = corner.point.y() - from.y();
+            if (dx > 0.0 && corner.point != end
+                    && turn(corners_.at(corner.prev).point, corner.point,
+                            corners_.at(corner.next).point) < 0.0
+                    && inTriangle(from, hit, end, corner.point)) {
+                const double slope = qAbs(dy) / dx;
+                const double distance = dx * dx + dy * dy;
+                if (slope < bestSlope || (slope == bestSlope && distance < bestDistance)) {
+                    bestSlope = slope;
+                    bestDistance = distance;
+                    target = c;
+                }
+            }
+            c = corner.next;
+        } while (c != loop);
+    }
+
+    // an earlier bridge may have doubled the corner; take the copy whose
+    // inside faces the hole
+    const QPointF targetPoint = corners_.at(target).point;
+    c = loop;
+    do {
+        if (corners_.at(c).point == targetPoint && facesInside(c, from)) {
+            target = c;
+            break;
+        }
+        c = corners_.at(c).next;
+    } while (c != loop);
+
+    const int targetCopy = copyCorner(target);
+    const int holeCopy = copyCorner(m);
+    const int afterTarget = corners_.at(target).next;
+    const int beforeHole = corners_.at(m).prev;
+
+    corners_[target].next = m;
+    corners_[m].prev = target;
+    corners_[beforeHole].next = holeCopy;
+    corners_[holeCopy].prev = beforeHole;
+    corners_[holeCopy].next = targetCopy;
+    corners_[targetCopy].prev = holeCopy;
+    corners_[targetCopy].next = afterTarget;
+    corners_[afterTarget].prev = targetCopy;
+    return true;
+}
+
+/*
+    Returns true if \a point lies within the angle the polygon covers at
+    corner \a c.
+*/
+bool QGeoPolygonTessellator::facesInside(int c, const QPointF &point) const
+{
+    const QPointF &corner = corners_.at(c).point;
+    const QPointF &prev = corners_.at(corners_.at(c).prev).point;
+    const QPointF &next = corners_.at(corners_.at(c).next).point;
+
+    const bool leftOfIncoming = turn(prev, corner, point) >= 0.0;
+    const bool leftOfOutgoing = turn(corner, next, point) >= 0.0;
+    if (turn(prev, corner, next) >= 0.0)
+        return leftOfIncoming && leftOfOutgoing;
+    return leftOfIncoming || leftOfOutgoing;
+}
+
+/*
+    Marks the reflex corners of the loop and sorts them into a grid over
+    \a bounds, so that an ear is only checked against the corners near it.
+*/
+void QGeoPolygonTessellator::buildGrid(int loop, int count, const QRectF &bounds)
+{
+    int reflexCount = 0;
+    int c = loop;
+    do {
+        Corner &corner = corners_[c];
+        corner.reflex = turn(corners_.at(corner.prev).point, corner.point,
+                             corners_.at(corner.next).point) < 0.0;
+        if (corner.reflex)
+            ++reflexCount;
+        c = corner.next;
+    } while (c != loop);
+
+    // about one reflex corner per cell; small loops are not worth a grid
+    gridSide_ = count < 64 ? 1 : qBound(1, int(std::sqrt(double(reflexCount))), 1024);
+    gridLeft_ = bounds.left();
+    gridTop_ = bounds.top();
+    const double extent = qMax(bounds.width(), bounds.height());
+    gridScale_ = extent > 0.0 ? gridSide_ / extent : 0.0;
+
+    reset(&grid_);
+    grid_.fill(-1, gridSide_ * gridSide_);
+
+    c = loop;
+    do {
+        Corner &corner = corners_[c];
+        if (corner.reflex) {
+            int &head = grid_[gridRow(corner.point.y()) * gridSide_ + gridColumn(corner.point.x())];
+            corner.nextInCell = head;
+            head = c;
+        }
+        c = corner.next;
+    } while (c != loop);
+}
+
+int QGeoPolygonTessellator::gridColumn(double x) const
+{
+    return qBound(0, int((x - gridLeft_) * gridScale_), gridSide_ - 1);
+}
+
+int QGeoPolygonTessellator::gridRow(double y) const
+{
+    return qBound(0, int((y - gridTop_) * gridScale_), gridSide_ - 1);
+}
+
+/*
+    Returns true if a reflex corner lies in the triangle of the corners \a a,
+    \a b and \a c or on its border. Corners that coincide with one of the
+    three, such as the two ends of a bridge, do not count.
+*/
+bool QGeoPolygonTessellator::blocked(int a, int b, int c) const
+{
+    const QPointF &pa = corners_.at(a).point;
+    const QPointF &pb = corners_.at(b).point;
+    const QPointF &pc = corners_.at(c).point;
+
+    const int column0 = gridColumn(qMin(pa.x(), qMin(pb.x(), pc.x())));
+    const int column1 = gridColumn(qMax(pa.x(), qMax(pb.x(), pc.x())));
+    const int row0 = gridRow(qMin(pa.y(), qMin(pb.y(), pc.y())));
+    const int row1 = gridRow(qMax(pa.y(), qMax(pb.y(), pc.y())));
+
+    for (int row = row0; row <= row1; ++row) {
+        for (int column = column0; column <= column1; ++column) {
+            int r = grid_.at(row * gridSide_ + column);
+            for (; r >= 0; r = corners_.at(r).nextInCell) {
+                const Corner &corner = corners_.at(r);
+                if (!corner.reflex || corner.point == pa || corner.point == pb || corner.point == pc)
+                    continue;
+                if (inTriangle(pa, pb, pc, corner.point))
+                    return true;
+            }
+        }
+    }
+    return false;
+}
+
+/*
+    Cuts ears off the loop of \a count corners until one triangle is left.
+    Corners on a straight line, and the tips of the zero-width spikes that
+    clipping leaves along the clip rectangle, are dropped without a triangle.
+*/
+void QGeoPolygonTessellator::clipEars(int loop, int count)
+{
+    int current = loop;
+    int misses = 0;
+    while (count > 3) {
+        const int prev = corners_.at(current).prev;
+        const int next = corners_.at(current).next;
+        const double t = turn(corners_.at(prev).point, corners_.at(current).point,
+                              corners_.at(next).point);
+
+        bool cut = t == 0.0 || (t > 0.0 && !blocked(prev, current, next));
+
+        // once a whole round finds no ear the ring crosses itself: cut off
+        // convex corners regardless, and any corner after another round
+        if (!cut && misses >= count)
+            cut = t > 0.0 || misses >= 2 * count;
+
+        if (!cut) {
+            current = next;
+            ++misses;
+            continue;
+        }
+
+        if (t > 0.0) {
+            indices_.append(corners_.at(prev).index);
+            indices_.append(corners_.at(current).index);
+            indices_.append(corners_.at(next).index);
+        }
+        corners_[current].reflex = false;
+        corners_[prev].next = next;
+        corners_[next].prev = prev;
+        --count;
+        updateReflex(prev);
+        updateReflex(next);
+
+        current = next;
+        misses = 0;
+    }
+
+    const Corner &last = corners_.at(current);
+    if (turn(corners_.at(last.prev).point, last.point, corners_.at(last.next).point) != 0.0) {
+        indices_.append(corners_.at(last.prev).index);
+        indices_.append(last.index);
+        indices_.append(corners_.at(last.next).index);
+    }
+}
+
+/*
+    Cutting an ear only narrows the angles at the corners next to it, so a
+    reflex corner can turn convex but never the other way round.
+*/
+void QGeoPolygonTessellator::updateReflex(int c)
+{
+    Corner &corner = corners_[c];
+    if (corner.reflex && turn(corners_.at(corner.prev).point, corner.point,
+                              corners_.at(corner.next).point) >= 0.0)
+        corner.reflex = false;
+}
+
+QT_END_NAMESPACE
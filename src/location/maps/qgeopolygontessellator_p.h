@@ -0,0 +1,138 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtLocation module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia. For licensing terms and
+** conditions see http://qt.digia.com/licensing. For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights. These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QGEOPOLYGONTESSELLATOR_P_H
+#define QGEOPOLYGONTESSELLATOR_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtLocation/qlocationglobal.h>
+
+#include <QPainterPath>
+#include <QPair>
+#include <QPointF>
+#include <QRectF>
+#include <QVector>
+
+QT_BEGIN_NAMESPACE
+
+class Q_LOCATION_EXPORT QGeoPolygonTessellator
+{
+public:
+    QGeoPolygonTessellator();
+
+    void clear();
+    void setClipRect(const QRectF &rect);
+    void addRing(const QPointF *points, int count);
+    void addRing(const QVector<QPointF> &points);
+    void addPath(const QPainterPath &path);
+
+    void tessellate();
+
+    int ringCount() const;
+    int ringStart(int ring) const;
+    int ringSize(int ring) const;
+
+    const QVector<QPointF> &vertices() const;
+    const QVector<quint32> &indices() const;
+
+private:
+    // a point of the ring being triangulated, linked to its neighbours
+    struct Corner
+    {
+        QPointF point;
+        quint32 index;
+        int prev;
+        int next;
+        // the next reflex corner in the same grid cell
+        int nextInCell;
+        bool reflex;
+    };
+
+    struct Ring
+    {
+        int start;
+        int size;
+        QRectF bounds;
+        int parent;
+        int output;
+    };
+
+    void finishRing(int start);
+    void classifyRings();
+    bool ringContains(const Ring &ring, const QPointF &point) const;
+    int clipRing(const Ring &ring);
+    void tessellatePolygon(int outer);
+
+    int appendLoop(const Ring &ring, bool positive);
+    int copyCorner(int c);
+    bool bridgeHole(int hole, int loop);
+    bool facesInside(int c, const QPointF &point) const;
+    void buildGrid(int loop, int count, const QRectF &bounds);
+    int gridColumn(double x) const;
+    int gridRow(double y) const;
+    bool blocked(int a, int b, int c) const;
+    void clipEars(int loop, int count);
+    void updateReflex(int c);
+
+    // all buffers keep their capacity between shapes
+    QVector<QPointF> input_;
+    QVector<Ring> inputRings_;
+    QVector<QPointF> clipBuffer_;
+    QVector<QPointF> clipBuffer2_;
+    QVector<QPointF> vertices_;
+    QVector<Ring> rings_;
+    QVector<quint32> indices_;
+    QVector<Corner> corners_;
+    QVector<QPair<double, int> > holes_;
+    QVector<int> grid_;
+
+    QRectF clipRect_;
+    int gridSide_;
+    double gridLeft_;
+    double gridTop_;
+    double gridScale_;
+};
+
+QT_END_NAMESPACE
+
+#endif // QGEOPOLYGONTESSELLATOR_P_H
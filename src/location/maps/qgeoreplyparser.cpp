@@ -0,0 +1,126 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtLocation module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia. For licensing terms and
+** conditions see http://qt.digia.com/licensing. For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights. These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qgeoreplyparser_p.h"
+
+#include <QtCore/QJsonParseError>
+#include <QtCore/QThreadPool>
+
+QT_BEGIN_NAMESPACE
+
+Q_GLOBAL_STATIC(QThreadPool, replyParserThreadPool)
+
+/*
+    Parses the body of a network reply on a worker thread, so that large
+    responses do not stall the thread the reply lives on.
+
+    Service plugins subclass it for their format: parseData() runs on the
+    worker and, on success, emits the subclass's results signal with
+    everything the reply needs.  The signals reach the reply through queued
+    connections, so the parser never touches the reply or its engine, and
+    a reply destroyed in the meantime simply stops receiving them.
+
+    Unless autoDelete() is turned off, the parser is deleted once it has
+    run.  The pool must not do that itself, since a QObject has to be
+    deleted on the thread it lives on, so the parser schedules its own
+    deletion there, behind the signals it queued.
+*/
+QGeoReplyParser::QGeoReplyParser()
+    : deleteWhenDone_(false)
+{
+}
+
+QGeoReplyParser::~QGeoReplyParser()
+{
+}
+
+/*
+    Starts parsing \a data on the shared parser thread pool.
+*/
+void QGeoReplyParser::parse(const QByteArray &data)
+{
+    data_ = data;
+    deleteWhenDone_ = autoDelete();
+    setAutoDelete(false);
+    threadPool()->start(this);
+}
+
+void QGeoReplyParser::run()
+{
+    const QByteArray data = data_;
+    data_.clear();
+
+    if (!parseData(data))
+        emit error(errorString_);
+
+    if (deleteWhenDone_)
+        deleteLater();
+}
+
+QString QGeoReplyParser::errorString() const
+{
+    return errorString_;
+}
+
+QThreadPool *QGeoReplyParser::threadPool()
+{
+    return replyParserThreadPool();
+}
+
+void QGeoReplyParser::setErrorString(const QString &errorString)
+{
+    errorString_ = errorString;
+}
+
+/*
+    Only builds the document, for replies whose interpretation of it needs
+    state that lives on the reply's thread.
+*/
+QGeoJsonReplyParser::QGeoJsonReplyParser()
+{
+}
+
+bool QGeoJsonReplyParser::parseData(const QByteArray &data)
+{
+    QJsonParseError parseError;
+    QJsonDocument document = QJsonDocument::fromJson(data, &parseError);
+    if (parseError.error != QJsonParseError::NoError) {
+        setErrorString(parseError.errorString());
+        return false;
+    }
+
+    emit results(document);
+    return true;
+}
+
+QT_END_NAMESPACE
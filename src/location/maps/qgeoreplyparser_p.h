@@ -0,0 +1,104 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtLocation module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia. For licensing terms and
+** conditions see http://qt.digia.com/licensing. For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights. These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QGEOREPLYPARSER_P_H
+#define QGEOREPLYPARSER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtLocation/qlocationglobal.h>
+
+#include <QtCore/QByteArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QObject>
+#include <QtCore/QRunnable>
+#include <QtCore/QString>
+
+QT_BEGIN_NAMESPACE
+
+class QThreadPool;
+
+class Q_LOCATION_EXPORT QGeoReplyParser : public QObject, public QRunnable
+{
+    Q_OBJECT
+
+public:
+    QGeoReplyParser();
+    ~QGeoReplyParser();
+
+    void parse(const QByteArray &data);
+    void run();
+
+    QString errorString() const;
+
+    static QThreadPool *threadPool();
+
+Q_SIGNALS:
+    void error(const QString &errorString);
+
+protected:
+    virtual bool parseData(const QByteArray &data) = 0;
+    void setErrorString(const QString &errorString);
+
+private:
+    QByteArray data_;
+    QString errorString_;
+    bool deleteWhenDone_;
+};
+
+class Q_LOCATION_EXPORT QGeoJsonReplyParser : public QGeoReplyParser
+{
+    Q_OBJECT
+
+public:
+    QGeoJsonReplyParser();
+
+Q_SIGNALS:
+    void results(const QJsonDocument &document);
+
+protected:
+    bool parseData(const QByteArray &data);
+};
+
+QT_END_NAMESPACE
+
+#endif // QGEOREPLYPARSER_P_H
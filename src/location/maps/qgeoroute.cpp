@@ -36,8 +36,10 @@
 
 #include "qgeorectangle.h"
 #include "qgeoroutesegment.h"
+#include "qgeoroutesegment_p.h"
 
 #include <QDateTime>
+#include <QtCore/qnumeric.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -176,6 +178,8 @@ QGeoRectangle QGeoRoute::bounds() const
 void QGeoRoute::setFirstRouteSegment(const QGeoRouteSegment &routeSegment)
 {
     d_ptr->firstSegment = routeSegment;
+    d_ptr->segments.clear();
+    d_ptr->segmentsIndexed = false;
 }
 
 /*!
@@ -254,7 +258,7 @@ QGeoRouteRequest::TravelMode QGeoRoute::travelMode() const
 */
 void QGeoRoute::setPath(const QList<QGeoCoordinate> &path)
 {
-    d_ptr->path = path;
+    d_ptr->path = QGeoCoordinateArray(path);
 }
 
 /*!
@@ -265,7 +269,7 @@ void QGeoRoute::setPath(const QList<QGeoCoordinate> &path)
 */
 QList<QGeoCoordinate> QGeoRoute::path() const
 {
-    return d_ptr->path;
+    return d_ptr->path.toList();
 }
 
 /*******************************************************************************
@@ -274,7 +278,8 @@ QList<QGeoCoordinate> QGeoRoute::path() const
 QGeoRoutePrivate::QGeoRoutePrivate()
     : travelTime(0),
       distance(0.0),
-      travelMode(QGeoRouteRequest::CarTravel) {}
+      travelMode(QGeoRouteRequest::CarTravel),
+      segmentsIndexed(false) {}
 
 QGeoRoutePrivate::QGeoRoutePrivate(const QGeoRoutePrivate &other)
     : QSharedData(other),
@@ -285,10 +290,128 @@ QGeoRoutePrivate::QGeoRoutePrivate(const QGeoRoutePrivate &other)
       distance(other.distance),
       travelMode(other.travelMode),
       path(other.path),
-      firstSegment(other.firstSegment) {}
+      firstSegment(other.firstSegment),
+      segments(other.segments),
+      segmentsIndexed(other.segmentsIndexed) {}
 
 QGeoRoutePrivate::~QGeoRoutePrivate() {}
 
+QGeoCoordinateArray QGeoRoutePrivate::compactPath(const QGeoRoute &route)
+{
+    return route.d_ptr->path;
+}
+
+void QGeoRoutePrivate::setCompactPath(QGeoRoute &route, const QGeoCoordinateArray &path)
+{
+    route.d_ptr->path = path;
+}
+
+/*
+    The index reflects the chain as it was when first used; plugins finish
+    linking the segments before handing the route out.
+*/
+void QGeoRoutePrivate::indexSegments() const
+{
+    if (segmentsIndexed)
+        return;
+
+    segments.clear();
+    QGeoRouteSegment segment = firstSegment;
+    while (segment.isValid()) {
+        segments.append(segment);
+        segment = segment.nextRouteSegment();
+    }
+    segmentsIndexed = true;
+}
+
+int QGeoRoutePrivate::segmentCount(const QGeoRoute &route)
+{
+    route.d_ptr->indexSegments();
+    return route.d_ptr->segments.size();
+}
+
+QGeoRouteSegment QGeoRoutePrivate::segmentAt(const QGeoRoute &route, int index)
+{
+    route.d_ptr->indexSegments();
+    return route.d_ptr->segments.at(index);
+}
+
+namespace {
+
+bool samePoint(const QGeoPackedCoordinate &a, const QGeoPackedCoordinate &b)
+{
+    return a.latitude == b.latitude && a.longitude == b.longitude
+            && (a.altitude == b.altitude || (qIsNaN(a.altitude) && qIsNaN(b.altitude)));
+}
+
+}
+
+/*
+    Links \a segments, in order, as the segment chain of \a route and moves
+    their paths into a single buffer, each segment keeping its range of it.
+    A segment that starts where the previous one ended shares that point
+    with it. When the buffer holds the same points as the path of the route,
+    which the route should already have, the route's path is used instead,
+    so every coordinate is stored once. Segments that already are ranges of
+    the route's path are left as they are.
+*/
+void QGeoRoutePrivate::setSegments(QGeoRoute &route, const QList<QGeoRouteSegment> &segments)
+{
+    QGeoRoutePrivate *d = route.d_ptr.data();
+
+    bool shared = true;
+    int points = 0;
+    for (int i = 0; i < segments.size(); ++i) {
+        const QGeoRouteSegment &segment = segments.at(i);
+        points += QGeoRouteSegmentPrivate::pathLength(segment);
+        if (QGeoRouteSegmentPrivate::pathLength(segment) > 0
+                && QGeoRouteSegmentPrivate::pathBuffer(segment).constData() != d->path.constData())
+            shared = false;
+    }
+
+    if (!shared) {
+        QGeoCoordinateArray buffer;
+        buffer.reserve(points);
+
+        QVector<int> offsets(segments.size());
+        for (int i = 0; i < segments.size(); ++i) {
+            const QGeoRouteSegment &segment = segments.at(i);
+            const QGeoCoordinateArray source = QGeoRouteSegmentPrivate::pathBuffer(segment);
+            const QGeoPackedCoordinate *data = source.constData() + QGeoRouteSegmentPrivate::pathOffset(segment);
+            const int length = QGeoRouteSegmentPrivate::pathLength(segment);
+
+            int first = 0;
+            offsets[i] = buffer.size();
+            if (length > 0 && !buffer.isEmpty()
+                    && samePoint(buffer.constData()[buffer.size() - 1], data[0])) {
+                offsets[i] = buffer.size() - 1;
+                first = 1;
+            }
+
+            for (int j = first; j < length; ++j)
+                buffer.append(data[j].latitude, data[j].longitude, data[j].altitude);
+        }
+
+        if (buffer == d->path)
+            buffer = d->path;
+
+        for (int i = 0; i < segments.size(); ++i) {
+            QGeoRouteSegment segment = segments.at(i);
+            QGeoRouteSegmentPrivate::setPathRange(segment, buffer, offsets.at(i),
+                                                  QGeoRouteSegmentPrivate::pathLength(segment));
+        }
+    }
+
+    for (int i = 0; i + 1 < segments.size(); ++i) {
+        QGeoRouteSegment segment = segments.at(i);
+        segment.setNextRouteSegment(segments.at(i + 1));
+    }
+
+    d->firstSegment = segments.isEmpty() ? QGeoRouteSegment() : segments.first();
+    d->segments = segments.toVector();
+    d->segmentsIndexed = true;
+}
+
 bool QGeoRoutePrivate::operator ==(const QGeoRoutePrivate &other) const
 {
     QGeoRouteSegment s1 = firstSegment;
@@ -86,6 +86,8 @@ public:
 
 private:
     QExplicitlySharedDataPointer<QGeoRoutePrivate> d_ptr;
+
+    friend class QGeoRoutePrivate;
 };
 
 QT_END_NAMESPACE
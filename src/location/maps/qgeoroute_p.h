@@ -50,13 +50,17 @@
 #include "qgeorectangle.h"
 #include "qgeoroutesegment.h"
 
+#include <QtPositioning/private/qgeocoordinatearray_p.h>
+
+#include <QList>
 #include <QSharedData>
+#include <QVector>
 
 QT_BEGIN_NAMESPACE
 
 class QGeoCoordinate;
 
-class QGeoRoutePrivate : public QSharedData
+class Q_LOCATION_EXPORT QGeoRoutePrivate : public QSharedData
 {
 public:
     QGeoRoutePrivate();
@@ -65,6 +69,19 @@ public:
 
     bool operator == (const QGeoRoutePrivate &other) const;
 
+    // access to the path without converting it to a QList<QGeoCoordinate>
+    static QGeoCoordinateArray compactPath(const QGeoRoute &route);
+    static void setCompactPath(QGeoRoute &route, const QGeoCoordinateArray &path);
+
+    // random access to the segments of the nextRouteSegment() chain
+    static int segmentCount(const QGeoRoute &route);
+    static QGeoRouteSegment segmentAt(const QGeoRoute &route, int index);
+
+    // chains segments into the route with their paths in one shared buffer
+    static void setSegments(QGeoRoute &route, const QList<QGeoRouteSegment> &segments);
+
+    void indexSegments() const;
+
     QString id;
     QGeoRouteRequest request;
 
@@ -76,9 +93,13 @@ public:
 
     QGeoRouteRequest::TravelMode travelMode;
 
-    QList<QGeoCoordinate> path;
+    QGeoCoordinateArray path;
 
     QGeoRouteSegment firstSegment;
+
+    // the chain starting at firstSegment, built when first needed
+    mutable QVector<QGeoRouteSegment> segments;
+    mutable bool segmentsIndexed;
 };
 
 QT_END_NAMESPACE
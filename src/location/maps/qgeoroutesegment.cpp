@@ -199,7 +199,9 @@ qreal QGeoRouteSegment::distance() const
 void QGeoRouteSegment::setPath(const QList<QGeoCoordinate> &path)
 {
     d_ptr->valid = true;
-    d_ptr->path = path;
+    d_ptr->path = QGeoCoordinateArray(path);
+    d_ptr->pathOffset = 0;
+    d_ptr->pathLength = d_ptr->path.size();
 }
 
 /*!
@@ -211,7 +213,11 @@ void QGeoRouteSegment::setPath(const QList<QGeoCoordinate> &path)
 
 QList<QGeoCoordinate> QGeoRouteSegment::path() const
 {
-    return d_ptr->path;
+    QList<QGeoCoordinate> path;
+    path.reserve(d_ptr->pathLength);
+    for (int i = 0; i < d_ptr->pathLength; ++i)
+        path.append(d_ptr->path.at(d_ptr->pathOffset + i));
+    return path;
 }
 
 /*!
@@ -240,7 +246,9 @@ QGeoManeuver QGeoRouteSegment::maneuver() const
 QGeoRouteSegmentPrivate::QGeoRouteSegmentPrivate()
     : valid(false),
       travelTime(0),
-      distance(0.0) {}
+      distance(0.0),
+      pathOffset(0),
+      pathLength(0) {}
 
 QGeoRouteSegmentPrivate::QGeoRouteSegmentPrivate(const QGeoRouteSegmentPrivate &other)
     : QSharedData(other),
@@ -248,6 +256,8 @@ QGeoRouteSegmentPrivate::QGeoRouteSegmentPrivate(const QGeoRouteSegmentPrivate &
       travelTime(other.travelTime),
       distance(other.distance),
       path(other.path),
+      pathOffset(other.pathOffset),
+      pathLength(other.pathLength),
       maneuver(other.maneuver),
       nextSegment(other.nextSegment) {}
 
@@ -256,12 +266,62 @@ QGeoRouteSegmentPrivate::~QGeoRouteSegmentPrivate()
     nextSegment.reset();
 }
 
+QGeoCoordinateArray QGeoRouteSegmentPrivate::compactPath(const QGeoRouteSegment &segment)
+{
+    const QGeoRouteSegmentPrivate *d = segment.d_ptr.constData();
+    if (d->pathOffset == 0 && d->pathLength == d->path.size())
+        return d->path;
+    return d->path.mid(d->pathOffset, d->pathLength);
+}
+
+void QGeoRouteSegmentPrivate::setCompactPath(QGeoRouteSegment &segment,
+                                             const QGeoCoordinateArray &path)
+{
+    setPathRange(segment, path, 0, path.size());
+}
+
+/*
+    Makes the path of \a segment the \a length points of \a buffer starting
+    at \a offset. The buffer is shared, not copied, so the segments of a route
+    can all keep their paths in one array.
+*/
+void QGeoRouteSegmentPrivate::setPathRange(QGeoRouteSegment &segment,
+                                           const QGeoCoordinateArray &buffer,
+                                           int offset, int length)
+{
+    Q_ASSERT(offset >= 0 && length >= 0 && offset + length <= buffer.size());
+
+    segment.d_ptr->valid = true;
+    segment.d_ptr->path = buffer;
+    segment.d_ptr->pathOffset = offset;
+    segment.d_ptr->pathLength = length;
+}
+
+QGeoCoordinateArray QGeoRouteSegmentPrivate::pathBuffer(const QGeoRouteSegment &segment)
+{
+    return segment.d_ptr->path;
+}
+
+int QGeoRouteSegmentPrivate::pathOffset(const QGeoRouteSegment &segment)
+{
+    return segment.d_ptr->pathOffset;
+}
+
+int QGeoRouteSegmentPrivate::pathLength(const QGeoRouteSegment &segment)
+{
+    return segment.d_ptr->pathLength;
+}
+
 bool QGeoRouteSegmentPrivate::operator ==(const QGeoRouteSegmentPrivate &other) const
 {
+    bool pathEqual = (pathLength == other.pathLength);
+    if (pathEqual && (path.constData() != other.path.constData() || pathOffset != other.pathOffset))
+        pathEqual = (path.mid(pathOffset, pathLength) == other.path.mid(other.pathOffset, other.pathLength));
+
     return ((valid == other.valid)
             && (travelTime == other.travelTime)
             && (distance == other.distance)
-            && (path == other.path)
+            && pathEqual
             && (maneuver == other.maneuver));
 }
 
@@ -79,6 +79,8 @@ protected:
 
 private:
     QExplicitlySharedDataPointer<QGeoRouteSegmentPrivate> d_ptr;
+
+    friend class QGeoRouteSegmentPrivate;
 };
 
 QT_END_NAMESPACE
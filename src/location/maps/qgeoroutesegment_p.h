@@ -47,6 +47,8 @@
 
 #include "qgeomaneuver.h"
 
+#include <QtPositioning/private/qgeocoordinatearray_p.h>
+
 #include <QSharedData>
 #include <QList>
 #include <QString>
@@ -55,7 +57,7 @@ QT_BEGIN_NAMESPACE
 
 class QGeoCoordinate;
 
-class QGeoRouteSegmentPrivate : public QSharedData
+class Q_LOCATION_EXPORT QGeoRouteSegmentPrivate : public QSharedData
 {
 public:
     QGeoRouteSegmentPrivate();
@@ -64,11 +66,26 @@ public:
 
     bool operator ==(const QGeoRouteSegmentPrivate &other) const;
 
+    // access to the path without converting it to a QList<QGeoCoordinate>
+    static QGeoCoordinateArray compactPath(const QGeoRouteSegment &segment);
+    static void setCompactPath(QGeoRouteSegment &segment, const QGeoCoordinateArray &path);
+
+    // the path as a range of a buffer that may be shared with the other
+    // segments and the path of a route
+    static void setPathRange(QGeoRouteSegment &segment, const QGeoCoordinateArray &buffer,
+                             int offset, int length);
+    static QGeoCoordinateArray pathBuffer(const QGeoRouteSegment &segment);
+    static int pathOffset(const QGeoRouteSegment &segment);
+    static int pathLength(const QGeoRouteSegment &segment);
+
     bool valid;
 
     int travelTime;
     qreal distance;
-    QList<QGeoCoordinate> path;
+    // the path is the range [pathOffset, pathOffset + pathLength) of path
+    QGeoCoordinateArray path;
+    int pathOffset;
+    int pathLength;
     QGeoManeuver maneuver;
 
     QExplicitlySharedDataPointer<QGeoRouteSegmentPrivate> nextSegment;
@@ -0,0 +1,552 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtLocation module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia. For licensing terms and
+** conditions see http://qt.digia.com/licensing. For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights. These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include "qgeoroutetracker_p.h"
+#include "qgeoroute_p.h"
+#include "qgeoroutesegment.h"
+
+#include <QtPositioning/QGeoPositionInfo>
+#include <QtPositioning/private/qgeoprojection_p.h>
+
+#include <QtCore/qmath.h>
+#include <QStack>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+QT_BEGIN_NAMESPACE
+
+namespace {
+
+enum {
+    LeafEdges = 8
+};
+
+const double EarthMeanRadius = 6371007.2;
+
+double squaredBoxDistance(const QDoubleVector2D &p,
+                          double minX, double minY, double maxX, double maxY)
+{
+    const double dx = qMax(0.0, qMax(minX - p.x(), p.x() - maxX));
+    const double dy = qMax(0.0, qMax(minY - p.y(), p.y() - maxY));
+    return dx * dx + dy * dy;
+}
+
+double edgeProgress(const QDoubleVector2D &p, const QDoubleVector2D &a, const QDoubleVector2D &b)
+{
+    const QDoubleVector2D ab = b - a;
+    const double lengthSquared = ab.x() * ab.x() + ab.y() * ab.y();
+    if (lengthSquared <= 0.0)
+        return 0.0;
+
+    const QDoubleVector2D ap = p - a;
+    return qBound(0.0, (ap.x() * ab.x() + ap.y() * ab.y()) / lengthSquared, 1.0);
+}
+
+}
+
+/*
+    QGeoRouteTracker follows a stream of positions along a route, as needed
+    for turn by turn navigation.
+
+    Setting the route builds a bounding box hierarchy over the edges of its
+    path, in normalized mercator space. Each node covers a consecutive run of
+    edges, which keeps the boxes tight because the path is continuous. A
+    position update is matched against the hierarchy, visiting only the
+    nodes which could hold an edge nearer than the best one found so far,
+    which takes O(log n) for positions near the route.
+
+    A route may pass the same place twice, out and back along one road or
+    through a loop. An update therefore first looks at the edges just behind
+    and ahead of the last snapped position, where moving back along the
+    route counts against an edge, and searches the whole route only while
+    off route or when no nearby edge is within the off route distance.
+    Maneuvers are placed the same way, each after the one before it.
+
+    The distances along
+    the route are measured once per point, and the travel time and the
+    maneuvers are looked up with a binary search, so an update does not
+    depend on the length of the route.
+
+    The tracker leaves the route only after OffRouteUpdates consecutive
+    positions further than the off route distance, widened by the horizontal
+    accuracy when the position has one, and returns to it once a position is
+    within half that distance. This keeps a noisy fix from flipping the
+    state back and forth.
+*/
+
+QGeoRouteTracker::QGeoRouteTracker(QObject *parent)
+:   QObject(parent),
+    offRouteDistance_(50.0)
+{
+    reset();
+}
+
+QGeoRouteTracker::~QGeoRouteTracker()
+{
+}
+
+void QGeoRouteTracker::reset()
+{
+    snapped_ = QGeoCoordinate();
+    deviation_ = 0.0;
+    distanceTraveled_ = 0.0;
+    nextManeuver_ = 0;
+    offRoute_ = false;
+    offRouteUpdates_ = 0;
+}
+
+void QGeoRouteTracker::setRoute(const QGeoRoute &route)
+{
+    route_ = route;
+
+    points_ = QGeoCoordinateArray();
+    mercator_.clear();
+    distances_.clear();
+    nodes_.clear();
+    timeDistances_.clear();
+    times_.clear();
+    maneuvers_.clear();
+    maneuverDistances_.clear();
+    reset();
+
+    const QGeoCoordinateArray path = QGeoRoutePrivate::compactPath(route);
+    QVector<QDoubleVector2D> mercator(path.size());
+    QGeoProjection::coordToMercator(path, mercator.data());
+
+    points_.reserve(path.size());
+    mercator_.reserve(path.size());
+    distances_.reserve(path.size());
+    for (int i = 0; i < path.size(); ++i) {
+        if (!path.isValid(i))
+            continue;
+
+        const QGeoCoordinate coordinate = path.at(i);
+        QDoubleVector2D point = mercator.at(i);
+        qreal distance = 0.0;
+        if (!mercator_.isEmpty()) {
+            const double dx = point.x() - mercator_.last().x();
+            point.setX(point.x() - qRound(dx));
+            distance = distances_.last() + points_.at(points_.size() - 1).distanceTo(coordinate);
+        }
+        points_.append(coordinate.latitude(), coordinate.longitude(), coordinate.altitude());
+        mercator_.append(point);
+        distances_.append(distance);
+    }
+
+    if (mercator_.size() >= 2)
+        build(0, mercator_.size() - 1);
+
+    const qreal length = distances_.isEmpty() ? 0.0 : distances_.last();
+
+    // the segment distances come from the routing service and need not add up
+    // to the length of the path, so they are scaled to it
+    const int segmentCount = QGeoRoutePrivate::segmentCount(route);
+    qreal segmentDistance = 0.0;
+    for (int i = 0; i < segmentCount; ++i)
+        segmentDistance += QGeoRoutePrivate::segmentAt(route, i).distance();
+
+    timeDistances_.append(0.0);
+    times_.append(0.0);
+    if (segmentDistance > 0.0) {
+        const qreal scale = length / segmentDistance;
+        qreal distance = 0.0;
+        qreal time = 0.0;
+        for (int i = 0; i < segmentCount; ++i) {
+            const QGeoRouteSegment segment = QGeoRoutePrivate::segmentAt(route, i);
+            distance += segment.distance() * scale;
+            time += segment.travelTime();
+            timeDistances_.append(distance);
+            times_.append(time);
+        }
+    } else {
+        timeDistances_.append(length);
+        times_.append(route.travelTime());
+    }
+
+    // maneuvers are placed where their position snaps to, kept in route order
+    for (int i = 0; i < segmentCount; ++i) {
+        const QGeoManeuver maneuver = QGeoRoutePrivate::segmentAt(route, i).maneuver();
+        if (!maneuver.isValid())
+            continue;
+
+        // without a position, the maneuver is at the end of its segment
+        const qreal end = timeDistances_.at(qMin(i + 1, timeDistances_.size() - 1));
+        qreal distance = end;
+        QGeoCoordinate snapped;
+        const qreal from = maneuverDistances_.isEmpty() ? 0.0 : maneuverDistances_.last();
+        int edge = 0;
+        double progress = 0.0;
+        if (maneuver.position().isValid() && mercator_.size() >= 2
+                && nearbyEdge(maneuver.position(), from, qMax(end - from, qreal(0.0)) + offRouteDistance_,
+                              offRouteDistance_, &edge, &progress)) {
+            edgePoint(edge, progress, &snapped, &distance);
+        } else {
+            snap(maneuver.position(), &snapped, &distance);
+        }
+        if (!maneuverDistances_.isEmpty())
+            distance = qMax(distance, maneuverDistances_.last());
+        maneuvers_.append(maneuver);
+        maneuverDistances_.append(distance);
+    }
+}
+
+QGeoRoute QGeoRouteTracker::route() const
+{
+    return route_;
+}
+
+void QGeoRouteTracker::setOffRouteDistance(qreal distance)
+{
+    offRouteDistance_ = distance;
+}
+
+qreal QGeoRouteTracker::offRouteDistance() const
+{
+    return offRouteDistance_;
+}
+
+/*
+    Returns the point of the route nearest to the last position.
+*/
+QGeoCoordinate QGeoRouteTracker::snappedCoordinate() const
+{
+    return snapped_;
+}
+
+/*
+    Returns the distance in meters between the last position and the route.
+*/
+qreal QGeoRouteTracker::deviation() const
+{
+    return deviation_;
+}
+
+qreal QGeoRouteTracker::distanceTraveled() const
+{
+    return distanceTraveled_;
+}
+
+qreal QGeoRouteTracker::remainingDistance() const
+{
+    if (distances_.isEmpty())
+        return 0.0;
+    return distances_.last() - distanceTraveled_;
+}
+
+/*
+    Returns the travel time in seconds from the snapped position to the end
+    of the route, as estimated by the routing service.
+*/
+int QGeoRouteTracker::remainingTime() const
+{
+    if (times_.isEmpty())
+        return 0;
+    return qRound(times_.last()) - elapsedTime(distanceTraveled_);
+}
+
+/*
+    Returns the first maneuver ahead of the snapped position, or an invalid
+    maneuver when all of them have been passed.
+*/
+QGeoManeuver QGeoRouteTracker::nextManeuver() const
+{
+    if (nextManeuver_ >= maneuvers_.size())
+        return QGeoManeuver();
+    return maneuvers_.at(nextManeuver_);
+}
+
+qreal QGeoRouteTracker::distanceToNextManeuver() const
+{
+    if (nextManeuver_ >= maneuvers_.size())
+        return remainingDistance();
+    return maneuverDistances_.at(nextManeuver_) - distanceTraveled_;
+}
+
+bool QGeoRouteTracker::isOffRoute() const
+{
+    return offRoute_;
+}
+
+/*
+    Finds the point of the route nearest to \a coordinate, and stores it in
+    \a snapped and its distance along the route in \a distance. Returns false,
+    leaving both untouched, if the route or the coordinate is empty.
+*/
+bool QGeoRouteTracker::snap(const QGeoCoordinate &coordinate, QGeoCoordinate *snapped,
+                            qreal *distance) const
+{
+    if (!coordinate.isValid() || points_.size() == 0)
+        return false;
+
+    if (points_.size() == 1) {
+        *snapped = points_.at(0);
+        *distance = 0.0;
+        return true;
+    }
+
+    int edge = 0;
+    double progress = 0.0;
+    if (!nearestEdge(QGeoProjection::coordToMercator(coordinate), &edge, &progress))
+        return false;
+
+    edgePoint(edge, progress, snapped, distance);
+    return true;
+}
+
+void QGeoRouteTracker::updatePosition(const QGeoPositionInfo &info)
+{
+    const QGeoCoordinate coordinate = info.coordinate();
+
+    qreal limit = offRouteDistance_;
+    if (info.hasAttribute(QGeoPositionInfo::HorizontalAccuracy))
+        limit += info.attribute(QGeoPositionInfo::HorizontalAccuracy);
+
+    QGeoCoordinate snapped;
+    qreal distance = 0.0;
+    int edge = 0;
+    double progress = 0.0;
+    if (coordinate.isValid() && snapped_.isValid() && !offRoute_ && mercator_.size() >= 2
+            && nearbyEdge(coordinate, distanceTraveled_, LocalSearchDistance, limit, &edge, &progress)) {
+        edgePoint(edge, progress, &snapped, &distance);
+    } else if (!snap(coordinate, &snapped, &distance)) {
+        return;
+    }
+
+    snapped_ = snapped;
+    distanceTraveled_ = distance;
+    deviation_ = coordinate.distanceTo(snapped);
+    nextManeuver_ = std::upper_bound(maneuverDistances_.constBegin(), maneuverDistances_.constEnd(),
+                                     distance) - maneuverDistances_.constBegin();
+
+    bool offRoute = offRoute_;
+    if (!offRoute_) {
+        if (deviation_ > limit)
+            offRoute = ++offRouteUpdates_ >= OffRouteUpdates;
+        else
+            offRouteUpdates_ = 0;
+    } else if (deviation_ < limit / 2) {
+        offRoute = false;
+        offRouteUpdates_ = 0;
+    }
+
+    emit progressChanged();
+
+    if (offRoute != offRoute_) {
+        offRoute_ = offRoute;
+        emit offRouteChanged(offRoute_);
+    }
+}
+
+/*
+    Builds the node covering the edges [first, last) and returns its index.
+    Edge i runs from point i to point i + 1.
+*/
+int QGeoRouteTracker::build(int first, int last)
+{
+    const int index = nodes_.size();
+    nodes_.append(Node());
+
+    Node node;
+    node.first = first;
+    node.last = last;
+    node.left = -1;
+    node.right = -1;
+
+    if (last - first <= LeafEdges) {
+        node.minX = node.maxX = mercator_.at(first).x();
+        node.minY = node.maxY = mercator_.at(first).y();
+        for (int i = first + 1; i <= last; ++i) {
+            const QDoubleVector2D &p = mercator_.at(i);
+            node.minX = qMin(node.minX, p.x());
+            node.minY = qMin(node.minY, p.y());
+            node.maxX = qMax(node.maxX, p.x());
+            node.maxY = qMax(node.maxY, p.y());
+        }
+    } else {
+        const int middle = first + (last - first) / 2;
+        node.left = build(first, middle);
+        node.right = build(middle, last);
+
+        const Node &left = nodes_.at(node.left);
+        const Node &right = nodes_.at(node.right);
+        node.minX = qMin(left.minX, right.minX);
+        node.minY = qMin(left.minY, right.minY);
+        node.maxX = qMax(left.maxX, right.maxX);
+        node.maxY = qMax(left.maxY, right.maxY);
+    }
+
+    nodes_[index] = node;
+    return index;
+}
+
+bool QGeoRouteTracker::nearestEdge(const QDoubleVector2D &point, int *edge, double *progress) const
+{
+    if (nodes_.isEmpty())
+        return false;
+
+    // the unwrapped path may leave [0, 1), so the point is also tried a
+    // world to either side
+    QVector<QDoubleVector2D> queries;
+    queries.append(point);
+    if (nodes_.first().minX < 0.0)
+        queries.append(point - QDoubleVector2D(1.0, 0.0));
+    if (nodes_.first().maxX >= 1.0)
+        queries.append(point + QDoubleVector2D(1.0, 0.0));
+
+    double best = std::numeric_limits<double>::infinity();
+    QStack<int> stack;
+    for (int q = 0; q < queries.size(); ++q) {
+        const QDoubleVector2D &p = queries.at(q);
+        stack.push(0);
+        while (!stack.isEmpty()) {
+            const Node &node = nodes_.at(stack.pop());
+            if (squaredBoxDistance(p, node.minX, node.minY, node.maxX, node.maxY) >= best)
+                continue;
+
+            if (node.left < 0) {
+                for (int i = node.first; i < node.last; ++i) {
+                    const QDoubleVector2D &a = mercator_.at(i);
+                    const QDoubleVector2D &b = mercator_.at(i + 1);
+                    const double t = edgeProgress(p, a, b);
+                    const QDoubleVector2D d = p - (a + (b - a) * t);
+                    const double distance = d.x() * d.x() + d.y() * d.y();
+                    if (distance < best) {
+                        best = distance;
+                        *edge = i;
+                        *progress = t;
+                    }
+                }
+                continue;
+            }
+
+            // the nearer child goes on top, to tighten the bound early; on a
+            // tie the earlier edges do, so a place the route passes twice
+            // snaps to its first pass
+            const Node &left = nodes_.at(node.left);
+            const Node &right = nodes_.at(node.right);
+            const double leftDistance = squaredBoxDistance(p, left.minX, left.minY, left.maxX, left.maxY);
+            const double rightDistance = squaredBoxDistance(p, right.minX, right.minY, right.maxX, right.maxY);
+            if (leftDistance <= rightDistance) {
+                stack.push(node.right);
+                stack.push(node.left);
+            } else {
+                stack.push(node.left);
+                stack.push(node.right);
+            }
+        }
+    }
+
+    return best < std::numeric_limits<double>::infinity();
+}
+
+/*
+    Finds the edge nearest to \a coordinate among those from \a limit meters
+    behind the distance \a from along the route to \a ahead meters past it.
+    Every meter the match lies behind \a from counts as a meter further away,
+    so where the route passes the same place twice, the pass continuing from
+    \a from wins. Returns false if the match is further than \a limit from
+    \a coordinate.
+*/
+bool QGeoRouteTracker::nearbyEdge(const QGeoCoordinate &coordinate, qreal from, qreal ahead,
+                                  qreal limit, int *edge, double *progress) const
+{
+    const int edges = mercator_.size() - 1;
+    int first = std::upper_bound(distances_.constBegin(), distances_.constEnd(), from)
+            - distances_.constBegin() - 1;
+    first = qBound(0, first, edges - 1);
+    while (first > 0 && distances_.at(first) > from - limit)
+        --first;
+
+    // meters per unit of normalized mercator at the latitude of the coordinate
+    const double scale = 2.0 * M_PI * EarthMeanRadius * std::cos(qDegreesToRadians(coordinate.latitude()));
+
+    // the path near the match decides which world the point is taken from
+    QDoubleVector2D p = QGeoProjection::coordToMercator(coordinate);
+    p.setX(p.x() + qRound(mercator_.at(first).x() - p.x()));
+
+    double best = std::numeric_limits<double>::infinity();
+    double bestDeviation = best;
+    for (int i = first; i < edges && distances_.at(i) <= from + ahead; ++i) {
+        const QDoubleVector2D &a = mercator_.at(i);
+        const QDoubleVector2D &b = mercator_.at(i + 1);
+        const double t = edgeProgress(p, a, b);
+        const QDoubleVector2D d = p - (a + (b - a) * t);
+        const double deviation = std::sqrt(d.x() * d.x() + d.y() * d.y()) * scale;
+        const double along = distances_.at(i) + (distances_.at(i + 1) - distances_.at(i)) * t;
+        const double cost = deviation + qMax(0.0, from - along);
+        if (cost < best) {
+            best = cost;
+            bestDeviation = deviation;
+            *edge = i;
+            *progress = t;
+        }
+    }
+
+    return bestDeviation <= limit;
+}
+
+/*
+    Stores the point at \a progress along \a edge in \a snapped, and its
+    distance along the route in \a distance.
+*/
+void QGeoRouteTracker::edgePoint(int edge, double progress, QGeoCoordinate *snapped,
+                                 qreal *distance) const
+{
+    const QDoubleVector2D &a = mercator_.at(edge);
+    const QDoubleVector2D &b = mercator_.at(edge + 1);
+    QDoubleVector2D point = a + (b - a) * progress;
+    point.setX(point.x() - std::floor(point.x()));
+
+    *snapped = QGeoProjection::mercatorToCoord(point);
+    *distance = distances_.at(edge) + (distances_.at(edge + 1) - distances_.at(edge)) * progress;
+}
+
+int QGeoRouteTracker::elapsedTime(qreal distance) const
+{
+    const int step = std::upper_bound(timeDistances_.constBegin(), timeDistances_.constEnd(), distance)
+            - timeDistances_.constBegin();
+    if (step <= 0)
+        return 0;
+    if (step >= timeDistances_.size())
+        return qRound(times_.last());
+
+    const qreal from = timeDistances_.at(step - 1);
+    const qreal to = timeDistances_.at(step);
+    const qreal progress = to > from ? (distance - from) / (to - from) : 0.0;
+    return qRound(times_.at(step - 1) + (times_.at(step) - times_.at(step - 1)) * progress);
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,151 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtLocation module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia. For licensing terms and
+** conditions see http://qt.digia.com/licensing. For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights. These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#ifndef QGEOROUTETRACKER_P_H
+#define QGEOROUTETRACKER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtLocation/qlocationglobal.h>
+#include "qgeomaneuver.h"
+#include "qgeoroute.h"
+#include <QtPositioning/QGeoCoordinate>
+#include <QtPositioning/private/qgeocoordinatearray_p.h>
+#include <QtPositioning/private/qdoublevector2d_p.h>
+
+#include <QtCore/QList>
+#include <QtCore/QObject>
+#include <QtCore/QVector>
+
+QT_BEGIN_NAMESPACE
+
+class QGeoPositionInfo;
+
+class Q_LOCATION_EXPORT QGeoRouteTracker : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum {
+        /* Consecutive updates beyond the off route distance before leaving the route */
+        OffRouteUpdates = 3,
+        /* Meters ahead of the last snapped position searched before the whole route */
+        LocalSearchDistance = 2000
+    };
+
+    explicit QGeoRouteTracker(QObject *parent = 0);
+    ~QGeoRouteTracker();
+
+    void setRoute(const QGeoRoute &route);
+    QGeoRoute route() const;
+
+    void setOffRouteDistance(qreal distance);
+    qreal offRouteDistance() const;
+
+    QGeoCoordinate snappedCoordinate() const;
+    qreal deviation() const;
+    qreal distanceTraveled() const;
+    qreal remainingDistance() const;
+    int remainingTime() const;
+    QGeoManeuver nextManeuver() const;
+    qreal distanceToNextManeuver() const;
+    bool isOffRoute() const;
+
+    bool snap(const QGeoCoordinate &coordinate, QGeoCoordinate *snapped, qreal *distance) const;
+
+public Q_SLOTS:
+    void updatePosition(const QGeoPositionInfo &info);
+
+Q_SIGNALS:
+    void progressChanged();
+    void offRouteChanged(bool offRoute);
+
+private:
+    struct Node
+    {
+        double minX;
+        double minY;
+        double maxX;
+        double maxY;
+        // the edges [first, last), or the children of an inner node
+        int first;
+        int last;
+        int left;
+        int right;
+    };
+
+    int build(int first, int last);
+    bool nearestEdge(const QDoubleVector2D &point, int *edge, double *progress) const;
+    bool nearbyEdge(const QGeoCoordinate &coordinate, qreal from, qreal ahead, qreal limit,
+                    int *edge, double *progress) const;
+    void edgePoint(int edge, double progress, QGeoCoordinate *snapped, qreal *distance) const;
+    int elapsedTime(qreal distance) const;
+    void reset();
+
+    QGeoRoute route_;
+    qreal offRouteDistance_;
+
+    // valid points of the route path, x unwrapped across the dateline
+    QGeoCoordinateArray points_;
+    QVector<QDoubleVector2D> mercator_;
+    QVector<qreal> distances_;
+    QVector<Node> nodes_;
+
+    // piecewise linear travel time along the route, one step per segment
+    QVector<qreal> timeDistances_;
+    QVector<qreal> times_;
+
+    QList<QGeoManeuver> maneuvers_;
+    QVector<qreal> maneuverDistances_;
+
+    QGeoCoordinate snapped_;
+    qreal deviation_;
+    qreal distanceTraveled_;
+    int nextManeuver_;
+    bool offRoute_;
+    int offRouteUpdates_;
+};
+
+QT_END_NAMESPACE
+
+#endif // QGEOROUTETRACKER_P_H
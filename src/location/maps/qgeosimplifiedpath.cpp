@@ -0,0 +1,259 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtLocation module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia. For licensing terms and
+** conditions see http://qt.digia.com/licensing. For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights. These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qgeosimplifiedpath_p.h"
+
+#include <QtPositioning/private/qgeoprojection_p.h>
+#include <QtPositioning/private/qdoublevector2d_p.h>
+
+#include <QtCore/qmath.h>
+#include <QStack>
+
+#include <cmath>
+#include <limits>
+
+QT_BEGIN_NAMESPACE
+
+namespace {
+
+struct Range
+{
+    int first;
+    int last;
+    double limit;
+};
+
+double squaredSegmentDistance(const QDoubleVector2D &p,
+                              const QDoubleVector2D &a, const QDoubleVector2D &b)
+{
+    const QDoubleVector2D ab = b - a;
+    const double lengthSquared = ab.x() * ab.x() + ab.y() * ab.y();
+
+    QDoubleVector2D closest = a;
+    if (lengthSquared > 0.0) {
+        const QDoubleVector2D ap = p - a;
+        const double t = qBound(0.0, (ap.x() * ab.x() + ap.y() * ab.y()) / lengthSquared, 1.0);
+        closest = a + ab * t;
+    }
+
+    const QDoubleVector2D d = p - closest;
+    return d.x() * d.x() + d.y() * d.y();
+}
+
+}
+
+/*
+    QGeoSimplifiedPath holds a path at several levels of detail, so that a
+    long path can be drawn with only as many points as the current zoom level
+    resolves.
+
+    The points are ranked once, with the Douglas-Peucker algorithm in
+    normalized mercator space: the importance of a point is the distance at
+    which the algorithm would keep it. Level n keeps the points more important
+    than 2^-(n + 8), which is a pixel at zoom level n with 256 pixel tiles, so
+    the simplified path is never more than a pixel away from the original.
+    Every level is stored as a list of indices, so taking the path of a level
+    costs time in proportion to the points it keeps.
+
+    Invalid coordinates are left out of all levels. Building is linear in the
+    number of levels and, for typical paths, O(n log n) in the number of
+    points, so it is meant to be done once per path on a worker thread.
+*/
+
+QGeoSimplifiedPath::QGeoSimplifiedPath()
+{
+}
+
+QGeoSimplifiedPath::QGeoSimplifiedPath(const QGeoCoordinateArray &path)
+:   path_(path)
+{
+    QVector<QDoubleVector2D> mercator(path.size());
+    QGeoProjection::coordToMercator(path, mercator.data());
+
+    // gather the valid points, unwrapping x so that segments which cross the
+    // dateline are measured the short way around
+    QVector<QDoubleVector2D> points;
+    QVector<int> sourceIndices;
+    points.reserve(path.size());
+    sourceIndices.reserve(path.size());
+    for (int i = 0; i < path.size(); ++i) {
+        if (!path.isValid(i))
+            continue;
+
+        QDoubleVector2D point = mercator.at(i);
+        if (!points.isEmpty()) {
+            const double dx = point.x() - points.last().x();
+            point.setX(point.x() - qRound(dx));
+        }
+        points.append(point);
+        sourceIndices.append(i);
+    }
+
+    const int count = points.size();
+    if (count == 0)
+        return;
+
+    const double infinity = std::numeric_limits<double>::infinity();
+    QVector<double> importance(count, 0.0);
+    importance[0] = infinity;
+    importance[count - 1] = infinity;
+
+    // A point is never ranked above the split it was found in, so every
+    // level is exactly what Douglas-Peucker gives for its tolerance.
+    QStack<Range> ranges;
+    Range whole = { 0, count - 1, infinity };
+    ranges.push(whole);
+    while (!ranges.isEmpty()) {
+        const Range range = ranges.pop();
+        if (range.last - range.first < 2)
+            continue;
+
+        const QDoubleVector2D &a = points.at(range.first);
+        const QDoubleVector2D &b = points.at(range.last);
+        int split = range.first + 1;
+        double maxDistance = -1.0;
+        for (int i = range.first + 1; i < range.last; ++i) {
+            const double distance = squaredSegmentDistance(points.at(i), a, b);
+            if (distance > maxDistance) {
+                maxDistance = distance;
+                split = i;
+            }
+        }
+
+        const double limit = qMin(std::sqrt(maxDistance), range.limit);
+        importance[split] = limit;
+
+        Range left = { range.first, split, limit };
+        Range right = { split, range.last, limit };
+        ranges.push(left);
+        ranges.push(right);
+    }
+
+    for (int level = 0; level <= MaximumLevel; ++level) {
+        const double levelTolerance = tolerance(level);
+        QVector<int> indices;
+        for (int i = 0; i < count; ++i) {
+            if (importance.at(i) > levelTolerance)
+                indices.append(sourceIndices.at(i));
+        }
+
+        // equal levels share their data
+        if (!levels_.isEmpty() && levels_.last().size() == indices.size())
+            levels_.append(levels_.last());
+        else
+            levels_.append(indices);
+
+        if (indices.size() == count)
+            return;
+    }
+
+    levels_.append(sourceIndices);
+}
+
+/*
+    Returns true if the path has no valid points.
+*/
+bool QGeoSimplifiedPath::isEmpty() const
+{
+    return levels_.isEmpty();
+}
+
+/*
+    Returns the number of levels. The last level keeps all valid points, and
+    asking for any level beyond it gives the last level.
+*/
+int QGeoSimplifiedPath::levelCount() const
+{
+    return levels_.size();
+}
+
+/*
+    Returns the number of points kept on \a level.
+*/
+int QGeoSimplifiedPath::size(int level) const
+{
+    return indices(level).size();
+}
+
+/*
+    Returns the indices into the original path of the points kept on
+    \a level, in path order.
+*/
+const QVector<int> &QGeoSimplifiedPath::indices(int level) const
+{
+    static const QVector<int> none;
+    if (levels_.isEmpty())
+        return none;
+    return levels_.at(qBound(0, level, levels_.size() - 1));
+}
+
+/*
+    Returns the points kept on \a level.
+*/
+QGeoCoordinateArray QGeoSimplifiedPath::path(int level) const
+{
+    const QVector<int> &kept = indices(level);
+    const QGeoPackedCoordinate *points = path_.constData();
+
+    QGeoCoordinateArray result;
+    result.reserve(kept.size());
+    for (int i = 0; i < kept.size(); ++i) {
+        const QGeoPackedCoordinate &p = points[kept.at(i)];
+        result.append(p.latitude, p.longitude, p.altitude);
+    }
+    return result;
+}
+
+/*
+    Returns the coarsest level which is accurate to a pixel on a map whose
+    whole world is \a worldSize pixels wide.
+*/
+int QGeoSimplifiedPath::levelForWorldSize(double worldSize)
+{
+    if (!(worldSize > 256.0))
+        return 0;
+
+    const double level = std::log(worldSize / 256.0) / std::log(2.0);
+    return qMin(qCeil(level - 1e-9), int(MaximumLevel) + 1);
+}
+
+/*
+    Returns the largest distance, in normalized mercator units, between the
+    points dropped on \a level and the simplified path.
+*/
+double QGeoSimplifiedPath::tolerance(int level)
+{
+    return std::ldexp(1.0, -(level + 8));
+}
+
+QT_END_NAMESPACE
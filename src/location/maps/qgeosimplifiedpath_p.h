@@ -0,0 +1,84 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtLocation module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia. For licensing terms and
+** conditions see http://qt.digia.com/licensing. For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights. These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QGEOSIMPLIFIEDPATH_P_H
+#define QGEOSIMPLIFIEDPATH_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtLocation/qlocationglobal.h>
+#include <QtPositioning/private/qgeocoordinatearray_p.h>
+
+#include <QVector>
+
+QT_BEGIN_NAMESPACE
+
+class Q_LOCATION_EXPORT QGeoSimplifiedPath
+{
+public:
+    enum {
+        /* Paths shorter than this are cheaper to project in full */
+        MinimumPoints = 1000,
+        MaximumLevel = 24
+    };
+
+    QGeoSimplifiedPath();
+    explicit QGeoSimplifiedPath(const QGeoCoordinateArray &path);
+
+    bool isEmpty() const;
+    int levelCount() const;
+    int size(int level) const;
+    const QVector<int> &indices(int level) const;
+    QGeoCoordinateArray path(int level) const;
+
+    static int levelForWorldSize(double worldSize);
+    static double tolerance(int level);
+
+private:
+    QGeoCoordinateArray path_;
+    // indices of the points kept on each level, the last level keeps all
+    QVector<QVector<int> > levels_;
+};
+
+QT_END_NAMESPACE
+
+#endif // QGEOSIMPLIFIEDPATH_P_H
@@ -33,6 +33,7 @@
 #include "qgeotilecache_p.h"
 
 #include "qgeotilespec_p.h"
+#include "qgeotilepackstore_p.h"
 
 #include "qgeomappingmanager_p.h"
 
@@ -40,6 +41,11 @@
 #include <QStandardPaths>
 #include <QMetaType>
 #include <QPixmap>
+#include <QImage>
+#include <QRunnable>
+#include <QThread>
+#include <QDataStream>
+#include <QSaveFile>
 #include <QDebug>
 
 Q_DECLARE_METATYPE(QList<QGeoTileSpec>)
@@ -47,6 +53,12 @@ Q_DECLARE_METATYPE(QSet<QGeoTileSpec>)
 
 QT_BEGIN_NAMESPACE
 
+static const quint32 IndexMagic = 0x49544751; // "QGTI"
+static const quint32 IndexVersion = 1;
+
+// how often the disk cache index is written while the cache is in use
+static const int IndexCheckpointInterval = 60 * 1000;
+
 class QGeoCachedTileMemory
 {
 public:
@@ -65,6 +77,100 @@ public:
 QGeoTileTexture::QGeoTileTexture()
     : textureBound(false) {}
 
+/* Reads (if necessary) and decodes the bytes of a single cached tile on one of
+ * the cache's worker threads. Only QImage is used here, QPixmap must not be
+ * touched outside of the GUI thread. */
+class QGeoTileDecodeJob : public QRunnable
+{
+public:
+    QGeoTileDecodeJob(QGeoTileCache *cache, const QGeoTileSpec &spec,
+                      const QByteArray &bytes, const QString &filename,
+                      const QString &format, bool fromDisk)
+        : cache_(cache), spec_(spec), bytes_(bytes), filename_(filename), format_(format),
+          fromDisk_(fromDisk)
+    {
+        cache_->queuedDecodes_.ref();
+    }
+
+    void run()
+    {
+        cache_->queuedDecodes_.deref();
+        cache_->runningDecodes_.ref();
+
+        // bytes coming from the disk cache are handed back so that they can
+        // be promoted to the memory cache
+        if (!filename_.isEmpty()) {
+            QFile file(filename_);
+            if (file.open(QIODevice::ReadOnly))
+                bytes_ = file.readAll();
+        }
+        QByteArray diskBytes = fromDisk_ ? bytes_ : QByteArray();
+
+        QImage image;
+        QByteArray format = format_.toLocal8Bit();
+        image.loadFromData(bytes_, format.isEmpty() ? 0 : format.constData());
+
+        // the texture upload takes this format without converting, which
+        // would otherwise happen on the GUI or render thread
+        if (!image.isNull() && image.format() != QImage::Format_ARGB32_Premultiplied)
+            image = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+
+        cache_->runningDecodes_.deref();
+        cache_->finishedDecodes_.ref();
+
+        QMetaObject::invokeMethod(cache_, "decodeFinished", Qt::QueuedConnection,
+                                  Q_ARG(QGeoTileSpec, spec_),
+                                  Q_ARG(QByteArray, diskBytes),
+                                  Q_ARG(QString, format_),
+                                  Q_ARG(QImage, image));
+    }
+
+private:
+    // the cache waits for all jobs in its destructor, so this can't dangle
+    QGeoTileCache *cache_;
+    QGeoTileSpec spec_;
+    QByteArray bytes_;
+    QString filename_;
+    QString format_;
+    bool fromDisk_;
+};
+
+/* Looks for tile files which are not in the index. This can only happen if
+ * the application was not shut down properly after the last index checkpoint,
+ * so it runs in the background rather than delaying startup. */
+class QGeoTileOrphanScanJob : public QRunnable
+{
+public:
+    QGeoTileOrphanScanJob(QGeoTileCache *cache, const QString &directory,
+                          const QSet<QString> &knownFiles)
+        : cache_(cache), directory_(directory), knownFiles_(knownFiles) {}
+
+    void run()
+    {
+        QDir dir(directory_);
+        QStringList files = dir.entryList(QStringList(QLatin1String("*.*")), QDir::Files);
+
+        QStringList orphans;
+        QList<int> sizes;
+        foreach (const QString &file, files) {
+            if (knownFiles_.contains(file)
+                    || QGeoTileCache::filenameToTileSpec(file).zoom() == -1)
+                continue;
+            orphans.append(file);
+            sizes.append(QFileInfo(dir.filePath(file)).size());
+        }
+
+        QMetaObject::invokeMethod(cache_, "addOrphanedTiles", Qt::QueuedConnection,
+                                  Q_ARG(QStringList, orphans),
+                                  Q_ARG(QList<int>, sizes));
+    }
+
+private:
+    QGeoTileCache *cache_;
+    QString directory_;
+    QSet<QString> knownFiles_;
+};
+
 void QCache3QTileEvictionPolicy::aboutToBeRemoved(const QGeoTileSpec &key, QSharedPointer<QGeoCachedTileDisk> obj)
 {
     Q_UNUSED(key);
@@ -89,13 +195,15 @@ QGeoTileTexture::~QGeoTileTexture()
 {
 }
 
-QGeoTileCache::QGeoTileCache(const QString &directory, QObject *parent)
-    : QObject(parent), directory_(directory),
-      minTextureUsage_(0), extraTextureUsage_(0)
+QGeoTileCache::QGeoTileCache(const QString &directory, QObject *parent,
+                             QGeoTiledMappingManagerEngine::DiskCacheLayout layout)
+    : QObject(parent), directory_(directory), packStore_(0),
+      minTextureUsage_(0), extraTextureUsage_(0), indexDirty_(0), checkpointRunning_(0)
 {
     qRegisterMetaType<QGeoTileSpec>();
     qRegisterMetaType<QList<QGeoTileSpec> >();
     qRegisterMetaType<QSet<QGeoTileSpec> >();
+    qRegisterMetaType<QList<int> >();
 
     // We keep default values here so that they are in one place
     // rather than in each individual plugin (the plugins can
@@ -112,11 +220,34 @@ QGeoTileCache::QGeoTileCache(const QString &directory, QObject *parent)
     setMaxMemoryUsage(3 * 1024 * 1024);
     setExtraTextureUsage(6 * 1024 * 1024);
 
+    // leave one core for the GUI and render threads
+    decodePool_.setMaxThreadCount(qBound(1, QThread::idealThreadCount() - 1, 4));
+
+    checkpointTimer_.setInterval(IndexCheckpointInterval);
+    connect(&checkpointTimer_, SIGNAL(timeout()), this, SLOT(checkpoint()));
+    checkpointTimer_.start();
+
+    if (layout == QGeoTiledMappingManagerEngine::PackedFileLayout) {
+        packStore_ = new QGeoTilePackStore(QDir(directory_).filePath(QLatin1String("tiles.pack")), this);
+        if (packStore_->open()) {
+            loadPackedTiles();
+            return;
+        }
+        qWarning() << "Falling back to one file per tile in " << directory_;
+        delete packStore_;
+        packStore_ = 0;
+    }
+
     loadTiles();
 }
 
 void QGeoTileCache::loadTiles()
 {
+    // the index knows all tiles, their costs and where they were queued
+    if (loadIndex())
+        return;
+
+    // otherwise fall back to the queue manifests and the directory contents
     QStringList formats;
     formats << QLatin1String("*.*");
 
@@ -169,29 +300,356 @@ void QGeoTileCache::loadTiles()
     }
 }
 
-QGeoTileCache::~QGeoTileCache()
+void QGeoTileCache::loadPackedTiles()
 {
-    // write disk cache queues to disk
+    QStringList formats;
+    formats << QLatin1String("*.*");
+
     QDir dir(directory_);
-    for (int i = 1; i<=4; i++) {
+
+    // tiles left over from the one file per tile layout are moved into the
+    // pack the first time it is used
+    QStringList files = dir.entryList(formats, QDir::Files);
+    importTilesToPack(files);
+
+    // same index and manifest files as for the per-file layout, but the tiles
+    // are looked up in the pack rather than on the file system
+    bool indexed = loadIndex();
+    for (int i = 1; !indexed && i<=4; i++) {
         QString filename = dir.filePath(QString::fromLatin1("queue") + QString::number(i));
         QFile file(filename);
-        if (!file.open(QIODevice::WriteOnly)){
-            qWarning() << "Unable to write tile cache file " << filename;
+        if (!file.open(QIODevice::ReadOnly))
             continue;
-        }
         QList<QSharedPointer<QGeoCachedTileDisk> > queue;
-        diskCache_.serializeQueue(i, queue);
-        foreach (const QSharedPointer<QGeoCachedTileDisk> &tile, queue) {
-            if (tile.isNull())
+        QList<QGeoTileSpec> specs;
+        QList<int> costs;
+        while (!file.atEnd()) {
+            QByteArray line = file.readLine().trimmed();
+            QGeoTileSpec spec = filenameToTileSpec(QString::fromLatin1(line.constData(), line.length()));
+            if (spec.zoom() == -1 || !packStore_->contains(spec))
                 continue;
-
-            // we just want the filename here, not the full path
-            int index = tile->filename.lastIndexOf(QLatin1Char('/'));
-            QByteArray filename = tile->filename.mid(index + 1).toLatin1() + '\n';
-            file.write(filename);
+            QSharedPointer<QGeoCachedTileDisk> tileDisk(new QGeoCachedTileDisk);
+            tileDisk->cache = this;
+            tileDisk->spec = spec;
+            specs.append(spec);
+            queue.append(tileDisk);
+            costs.append(packStore_->size(spec));
         }
+
+        diskCache_.deserializeQueue(i, specs, queue, costs);
+        file.close();
+    }
+
+    // tiles written after the last index checkpoint or manifest
+    foreach (const QGeoTileSpec &spec, packStore_->tiles()) {
+        if (!diskCache_.contains(spec))
+            addToDiskCache(spec, QString(), packStore_->size(spec));
+    }
+}
+
+void QGeoTileCache::importTilesToPack(const QStringList &files)
+{
+    QDir dir(directory_);
+    int imported = 0;
+
+    for (int i = 0; i < files.size(); ++i) {
+        QGeoTileSpec spec = filenameToTileSpec(files.at(i));
+        if (spec.zoom() == -1)
+            continue;
+
+        QString filename = dir.filePath(files.at(i));
+        QFile file(filename);
+        if (!file.open(QIODevice::ReadOnly))
+            continue;
+        QByteArray bytes = file.readAll();
         file.close();
+
+        QStringList parts = files.at(i).split('.');
+        packStore_->write(spec, bytes, parts.at(1));
+        QFile::remove(filename);
+        ++imported;
+    }
+
+    if (imported > 0)
+        packStore_->flush();
+}
+
+QGeoTileCache::~QGeoTileCache()
+{
+    // jobs still waiting in the queue are dropped, running ones have to finish
+    // before the cache goes away
+    decodePool_.clear();
+    decodePool_.waitForDone();
+
+    // write the disk cache index, marked as written on a clean shutdown
+    saveIndex(true);
+
+    if (packStore_)
+        packStore_->close();
+}
+
+static quint16 indexStringId(QStringList &strings, QHash<QString, int> &ids, const QString &string)
+{
+    QHash<QString, int>::const_iterator it = ids.constFind(string);
+    if (it != ids.constEnd())
+        return it.value();
+    int id = strings.size();
+    strings.append(string);
+    ids.insert(string, id);
+    return id;
+}
+
+/*
+    What the index is written from: the spec, format, cost and popularity of
+    every tile in the disk cache, in queue order.
+*/
+class QGeoTileIndexSnapshot
+{
+public:
+    QString directory;
+    quint8 layout;
+    bool clean;
+    QList<QGeoTileSpec> keys[4];
+    QStringList formats[4];
+    QList<int> costs[4];
+    QList<quint64> pops[4];
+};
+
+/* Writes a checkpoint of the index, so that serializing a large cache does
+ * not stall the thread the cache lives in. */
+class QGeoTileIndexJob : public QRunnable
+{
+public:
+    QGeoTileIndexJob(QGeoTileCache *cache, const QGeoTileIndexSnapshot &snapshot)
+        : cache_(cache), snapshot_(snapshot) {}
+
+    void run()
+    {
+        // tiles added or evicted meanwhile have marked the index dirty again
+        if (!QGeoTileCache::writeIndex(snapshot_))
+            cache_->indexDirty_.store(1);
+        cache_->checkpointRunning_.store(0);
+    }
+
+private:
+    QGeoTileCache *cache_;
+    QGeoTileIndexSnapshot snapshot_;
+};
+
+/*
+    Copies what writeIndex() needs out of the disk cache queues. Only keys,
+    formats and numbers are copied, so the snapshot can be written from any
+    thread.
+*/
+void QGeoTileCache::snapshotIndex(QGeoTileIndexSnapshot *snapshot, bool clean)
+{
+    snapshot->directory = directory_;
+    snapshot->layout = quint8(diskLayout());
+    snapshot->clean = clean;
+
+    for (int i = 0; i < 4; i++) {
+        QList<QSharedPointer<QGeoCachedTileDisk> > values;
+        diskCache_.serializeQueue(i + 1, snapshot->keys[i], values, snapshot->costs[i],
+                                  snapshot->pops[i]);
+
+        QStringList &formats = snapshot->formats[i];
+        formats.reserve(values.size());
+        for (int j = 0; j < values.size(); ++j) {
+            // ghosts of evicted tiles have no format
+            const QSharedPointer<QGeoCachedTileDisk> &tile = values.at(j);
+            if (packStore_)
+                formats.append(packStore_->format(snapshot->keys[i].at(j)));
+            else if (!tile.isNull())
+                formats.append(tile->filename.mid(tile->filename.lastIndexOf(QLatin1Char('.')) + 1));
+            else
+                formats.append(QString());
+        }
+    }
+}
+
+/*
+    Writes the index of the disk cache. The index holds the spec, cost and
+    popularity of every tile in the disk cache, in queue order, so that the
+    queues can be rebuilt on startup without looking at the tiles themselves.
+
+    The index is written on shutdown with \a clean set, and periodically in
+    the background by checkpoint() while the cache is in use.
+*/
+void QGeoTileCache::saveIndex(bool clean)
+{
+    QGeoTileIndexSnapshot snapshot;
+    snapshotIndex(&snapshot, clean);
+    indexDirty_.store(0);
+    if (!writeIndex(snapshot))
+        indexDirty_.store(1);
+}
+
+bool QGeoTileCache::writeIndex(const QGeoTileIndexSnapshot &snapshot)
+{
+    // plugin names and formats are shared by most tiles, so they are stored
+    // once in a string table
+    QStringList strings;
+    QHash<QString, int> stringIds;
+
+    QByteArray entries;
+    QDataStream entryStream(&entries, QIODevice::WriteOnly);
+    entryStream.setVersion(QDataStream::Qt_5_0);
+
+    for (int i = 0; i < 4; i++) {
+        const QList<QGeoTileSpec> &keys = snapshot.keys[i];
+
+        entryStream << quint32(keys.size());
+        for (int j = 0; j < keys.size(); ++j) {
+            const QGeoTileSpec &spec = keys.at(j);
+            entryStream << indexStringId(strings, stringIds, spec.plugin())
+                        << indexStringId(strings, stringIds, snapshot.formats[i].at(j))
+                        << qint32(spec.mapId())
+                        << qint32(spec.zoom())
+                        << qint32(spec.x())
+                        << qint32(spec.y())
+                        << qint32(spec.version())
+                        << qint32(snapshot.costs[i].at(j))
+                        << snapshot.pops[i].at(j);
+        }
+    }
+
+    QDir dir(snapshot.directory);
+    QSaveFile file(dir.filePath(QLatin1String("index")));
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Unable to write tile cache index " << file.fileName();
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream << IndexMagic << IndexVersion << snapshot.layout << quint8(snapshot.clean) << strings;
+    stream.writeRawData(entries.constData(), entries.size());
+
+    if (!file.commit()) {
+        qWarning() << "Unable to write tile cache index " << file.fileName();
+        return false;
+    }
+
+    // the manifests of older versions are superseded by the index
+    for (int i = 1; i <= 4; i++)
+        QFile::remove(dir.filePath(QString::fromLatin1("queue") + QString::number(i)));
+    return true;
+}
+
+/*
+    Rebuilds the disk cache queues from the index written by saveIndex().
+    Returns false if there is no usable index, in which case nothing is changed.
+*/
+bool QGeoTileCache::loadIndex()
+{
+    QDir dir(directory_);
+    QFile file(dir.filePath(QLatin1String("index")));
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QByteArray data = file.readAll();
+    file.close();
+
+    QDataStream stream(data);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    quint8 layout = 0;
+    quint8 clean = 0;
+    QStringList strings;
+    stream >> magic >> version >> layout >> clean >> strings;
+    if (stream.status() != QDataStream::Ok || magic != IndexMagic || version != IndexVersion
+            || layout != quint8(diskLayout()))
+        return false;
+
+    // parse everything before creating any tiles, tiles which are dropped
+    // again would delete their files
+    QList<QGeoTileSpec> specs[4];
+    QList<QString> formats[4];
+    QList<int> costs[4];
+    QList<quint64> pops[4];
+
+    for (int i = 0; i < 4; i++) {
+        quint32 count = 0;
+        stream >> count;
+        for (quint32 j = 0; j < count && stream.status() == QDataStream::Ok; ++j) {
+            quint16 pluginId, formatId;
+            qint32 mapId, zoom, x, y, tileVersion, cost;
+            quint64 pop;
+            stream >> pluginId >> formatId >> mapId >> zoom >> x >> y >> tileVersion >> cost >> pop;
+            if (pluginId >= strings.size() || formatId >= strings.size())
+                return false;
+            specs[i].append(QGeoTileSpec(strings.at(pluginId), mapId, zoom, x, y, tileVersion));
+            formats[i].append(strings.at(formatId));
+            costs[i].append(cost);
+            pops[i].append(pop);
+        }
+        if (stream.status() != QDataStream::Ok)
+            return false;
+    }
+
+    QSet<QString> knownFiles;
+
+    for (int i = 0; i < 4; i++) {
+        QList<QGeoTileSpec> queueSpecs;
+        QList<QSharedPointer<QGeoCachedTileDisk> > queue;
+        QList<int> queueCosts;
+        QList<quint64> queuePops;
+
+        for (int j = 0; j < specs[i].size(); ++j) {
+            const QGeoTileSpec &spec = specs[i].at(j);
+            QSharedPointer<QGeoCachedTileDisk> tileDisk;
+
+            // the last queue only holds the ghosts of evicted tiles
+            if (i < 3) {
+                if (packStore_ && !packStore_->contains(spec))
+                    continue;
+                tileDisk = QSharedPointer<QGeoCachedTileDisk>(new QGeoCachedTileDisk);
+                tileDisk->cache = this;
+                tileDisk->spec = spec;
+                if (!packStore_) {
+                    tileDisk->filename = tileSpecToFilename(spec, formats[i].at(j), directory_);
+                    knownFiles.insert(tileDisk->filename.mid(tileDisk->filename.lastIndexOf(QLatin1Char('/')) + 1));
+                }
+            }
+
+            queueSpecs.append(spec);
+            queue.append(tileDisk);
+            queueCosts.append(i < 3 ? costs[i].at(j) : 0);
+            queuePops.append(pops[i].at(j));
+        }
+
+        diskCache_.deserializeQueue(i + 1, queueSpecs, queue, queueCosts, queuePops);
+    }
+
+    // tiles written after the last checkpoint are not in the index
+    if (!clean && !packStore_)
+        decodePool_.start(new QGeoTileOrphanScanJob(this, directory_, knownFiles));
+
+    return true;
+}
+
+void QGeoTileCache::checkpoint()
+{
+    // one checkpoint at a time, the next timeout picks up what is left
+    if (!indexDirty_.load() || checkpointRunning_.load())
+        return;
+
+    QGeoTileIndexSnapshot snapshot;
+    snapshotIndex(&snapshot, false);
+    indexDirty_.store(0);
+    checkpointRunning_.store(1);
+    decodePool_.start(new QGeoTileIndexJob(this, snapshot));
+}
+
+void QGeoTileCache::addOrphanedTiles(const QStringList &files, const QList<int> &sizes)
+{
+    QDir dir(directory_);
+    for (int i = 0; i < files.size(); ++i) {
+        QGeoTileSpec spec = filenameToTileSpec(files.at(i));
+        if (!diskCache_.contains(spec))
+            addToDiskCache(spec, dir.filePath(files.at(i)), sizes.at(i));
     }
 }
 
@@ -200,6 +658,8 @@ void QGeoTileCache::printStats()
     textureCache_.printStats();
     memoryCache_.printStats();
     diskCache_.printStats();
+    qDebug("decodes: %d queued, %d running, %d finished",
+           queuedDecodeCount(), runningDecodeCount(), finishedDecodeCount());
 }
 
 void QGeoTileCache::setMaxDiskUsage(int diskUsage)
@@ -260,6 +720,21 @@ int QGeoTileCache::textureUsage() const
     return textureCache_.totalCost();
 }
 
+int QGeoTileCache::queuedDecodeCount() const
+{
+    return queuedDecodes_.load();
+}
+
+int QGeoTileCache::runningDecodeCount() const
+{
+    return runningDecodes_.load();
+}
+
+int QGeoTileCache::finishedDecodeCount() const
+{
+    return finishedDecodes_.load();
+}
+
 QSharedPointer<QGeoTileTexture> QGeoTileCache::get(const QGeoTileSpec &spec)
 {
     QSharedPointer<QGeoTileTexture> tt = textureCache_.object(spec);
@@ -273,18 +748,25 @@ QSharedPointer<QGeoTileTexture> QGeoTileCache::get(const QGeoTileSpec &spec)
             handleError(spec, QLatin1String("Problem with tile image"));
             return QSharedPointer<QGeoTileTexture>(0);
         }
-        QSharedPointer<QGeoTileTexture> tt = addToTextureCache(spec, pixmap);
+        QSharedPointer<QGeoTileTexture> tt = addToTextureCache(spec, pixmap.toImage());
         if (tt)
             return tt;
     }
 
     QSharedPointer<QGeoCachedTileDisk> td = diskCache_.object(spec);
     if (td) {
-        QStringList parts = td->filename.split('.');
-        QFile file(td->filename);
-        file.open(QIODevice::ReadOnly);
-        QByteArray bytes = file.readAll();
-        file.close();
+        QStringList parts;
+        QByteArray bytes;
+        if (packStore_) {
+            parts << QString() << packStore_->format(spec);
+            bytes = packStore_->read(spec);
+        } else {
+            parts = td->filename.split('.');
+            QFile file(td->filename);
+            file.open(QIODevice::ReadOnly);
+            bytes = file.readAll();
+            file.close();
+        }
 
         QPixmap pixmap;
         if (!pixmap.loadFromData(bytes, (parts.size() == 2 ? parts.at(1).toLocal8Bit().constData() : 0))) {
@@ -298,7 +780,7 @@ QSharedPointer<QGeoTileTexture> QGeoTileCache::get(const QGeoTileSpec &spec)
         }
 
         addToMemoryCache(spec, bytes, (parts.size() == 2 ? parts.at(1) : QLatin1String("")));
-        QSharedPointer<QGeoTileTexture> tt = addToTextureCache(td->spec, pixmap);
+        QSharedPointer<QGeoTileTexture> tt = addToTextureCache(td->spec, pixmap.toImage());
         if (tt)
             return tt;
     }
@@ -306,17 +788,118 @@ QSharedPointer<QGeoTileTexture> QGeoTileCache::get(const QGeoTileSpec &spec)
     return QSharedPointer<QGeoTileTexture>();
 }
 
+/*
+    Returns true if the tile is stored on disk or in memory, without touching
+    its position in the caches.
+*/
+bool QGeoTileCache::contains(const QGeoTileSpec &spec) const
+{
+    return diskCache_.contains(spec) || memoryCache_.contains(spec);
+}
+
+/*
+    Returns the texture for \a spec if it has already been decoded, without
+    touching the memory or disk caches.
+*/
+QSharedPointer<QGeoTileTexture> QGeoTileCache::getDecoded(const QGeoTileSpec &spec)
+{
+    return textureCache_.object(spec);
+}
+
+/*
+    Schedules decoding of the tile \a spec from the memory or disk cache on a
+    worker thread. Returns false if the tile is in neither of them, in which
+    case it has to be fetched. Once the texture is available tileDecoded() is
+    emitted, if the cached data turns out to be unusable tileDecodeFailed() is
+    emitted instead.
+*/
+bool QGeoTileCache::requestDecode(const QGeoTileSpec &spec)
+{
+    if (pendingDecodes_.contains(spec))
+        return true;
+
+    QSharedPointer<QGeoCachedTileMemory> tm = memoryCache_.object(spec);
+    if (tm) {
+        pendingDecodes_.insert(spec);
+        decodePool_.start(new QGeoTileDecodeJob(this, spec, tm->bytes, QString(), tm->format, false));
+        return true;
+    }
+
+    QSharedPointer<QGeoCachedTileDisk> td = diskCache_.object(spec);
+    if (td) {
+        pendingDecodes_.insert(spec);
+        if (packStore_) {
+            // copying out of the mapped pack is cheap, only the decoding
+            // needs to go to the worker
+            decodePool_.start(new QGeoTileDecodeJob(this, spec, packStore_->read(spec), QString(),
+                                                    packStore_->format(spec), true));
+        } else {
+            QStringList parts = td->filename.split('.');
+            QString format = (parts.size() == 2 ? parts.at(1) : QString());
+            decodePool_.start(new QGeoTileDecodeJob(this, spec, QByteArray(), td->filename, format, true));
+        }
+        return true;
+    }
+
+    return false;
+}
+
+void QGeoTileCache::decodeFinished(const QGeoTileSpec &spec, const QByteArray &diskBytes,
+                                   const QString &format, const QImage &image)
+{
+    pendingDecodes_.remove(spec);
+
+    if (image.isNull()) {
+        handleError(spec, QLatin1String("Problem with tile image"));
+        emit tileDecodeFailed(spec);
+        return;
+    }
+
+    if (!diskBytes.isEmpty()) {
+        if (image.size() != tileSize_) {
+            QSharedPointer<QGeoCachedTileDisk> td = diskCache_.object(spec);
+            if (td)
+                evictFromDiskCache(td.data());
+            emit tileDecodeFailed(spec);
+            return;
+        }
+        addToMemoryCache(spec, diskBytes, format);
+    }
+
+    addToTextureCache(spec, image);
+    emit tileDecoded(spec);
+}
+
 QString QGeoTileCache::directory() const
 {
     return directory_;
 }
 
+QGeoTiledMappingManagerEngine::DiskCacheLayout QGeoTileCache::diskLayout() const
+{
+    return packStore_ ? QGeoTiledMappingManagerEngine::PackedFileLayout
+                      : QGeoTiledMappingManagerEngine::FilePerTileLayout;
+}
+
+/*
+ * The disk and memory caches are sharded and locked internally, so insert()
+ * may be called from the tile fetcher's thread while the maps keep reading
+ * from the GUI thread.
+ */
 void QGeoTileCache::insert(const QGeoTileSpec &spec,
                            const QByteArray &bytes,
                            const QString &format,
                            QGeoTiledMappingManagerEngine::CacheAreas areas)
 {
-    if (areas & QGeoTiledMappingManagerEngine::DiskCache) {
+    if ((areas & QGeoTiledMappingManagerEngine::DiskCache) && packStore_) {
+        // Drop the old entry before writing the new record. remove() passes
+        // it to aboutToBeRemoved(), which clears its cache pointer, so its
+        // destructor neither deletes the record nor writes a tombstone; the
+        // record written below supersedes the old one in the pack.
+        diskCache_.remove(spec);
+        packStore_->write(spec, bytes, format);
+        addToDiskCache(spec, QString(), bytes.size());
+    } else if (areas & QGeoTiledMappingManagerEngine::DiskCache) {
         QString filename = tileSpecToFilename(spec, format, directory_);
         QFile file(filename);
         file.open(QIODevice::WriteOnly);
@@ -337,7 +920,13 @@ void QGeoTileCache::insert(const QGeoTileSpec &spec,
 
 void QGeoTileCache::evictFromDiskCache(QGeoCachedTileDisk *td)
 {
-    QFile::remove(td->filename);
+    if (td->cache)
+        td->cache->indexDirty_.store(1);
+
+    if (td->cache && td->cache->packStore_)
+        td->cache->packStore_->remove(td->spec);
+    else
+        QFile::remove(td->filename);
 }
 
 void QGeoTileCache::evictFromMemoryCache(QGeoCachedTileMemory * /* tm  */)
@@ -345,15 +934,20 @@ void QGeoTileCache::evictFromMemoryCache(QGeoCachedTileMemory * /* tm  */)
 }
 
 QSharedPointer<QGeoCachedTileDisk> QGeoTileCache::addToDiskCache(const QGeoTileSpec &spec, const QString &filename)
+{
+    QFileInfo fi(filename);
+    return addToDiskCache(spec, filename, fi.size());
+}
+
+QSharedPointer<QGeoCachedTileDisk> QGeoTileCache::addToDiskCache(const QGeoTileSpec &spec, const QString &filename, int cost)
 {
     QSharedPointer<QGeoCachedTileDisk> td(new QGeoCachedTileDisk);
     td->spec = spec;
     td->filename = filename;
     td->cache = this;
 
-    QFileInfo fi(filename);
-    int diskCost = fi.size();
-    diskCache_.insert(spec, td, diskCost);
+    diskCache_.insert(spec, td, cost);
+    indexDirty_.store(1);
     return td;
 }
 
@@ -371,11 +965,11 @@ QSharedPointer<QGeoCachedTileMemory> QGeoTileCache::addToMemoryCache(const QGeoT
     return tm;
 }
 
-QSharedPointer<QGeoTileTexture> QGeoTileCache::addToTextureCache(const QGeoTileSpec &spec, const QPixmap &pixmap)
+QSharedPointer<QGeoTileTexture> QGeoTileCache::addToTextureCache(const QGeoTileSpec &spec, const QImage &image)
 {
     QSharedPointer<QGeoTileTexture> tt(new QGeoTileTexture);
     tt->spec = spec;
-    tt->image = pixmap.toImage();
+    tt->image = image;
 
     int textureCost = tt->image.width() * tt->image.height() * tt->image.depth() / 8;
     textureCache_.insert(spec, tt, textureCost);
@@ -49,9 +49,12 @@
 #include <QObject>
 #include <QCache>
 #include "qcache3q_p.h"
+#include "qconcurrentcache3q_p.h"
 #include <QSet>
 #include <QMutex>
 #include <QTimer>
+#include <QThreadPool>
+#include <QAtomicInt>
 
 #include "qgeotilespec_p.h"
 #include "qgeotiledmappingmanagerengine_p.h"
@@ -65,6 +68,11 @@ class QGeoMappingManager;
 class QGeoTile;
 class QGeoCachedTileMemory;
 class QGeoTileCache;
+class QGeoTileDecodeJob;
+class QGeoTileOrphanScanJob;
+class QGeoTileIndexJob;
+class QGeoTileIndexSnapshot;
+class QGeoTilePackStore;
 
 class QPixmap;
 class QThread;
@@ -108,7 +116,9 @@ class Q_LOCATION_EXPORT QGeoTileCache : public QObject
 {
     Q_OBJECT
 public:
-    QGeoTileCache(const QString &directory = QString(), QObject *parent = 0);
+    QGeoTileCache(const QString &directory = QString(), QObject *parent = 0,
+                  QGeoTiledMappingManagerEngine::DiskCacheLayout layout
+                      = QGeoTiledMappingManagerEngine::FilePerTileLayout);
     ~QGeoTileCache();
 
     void setMaxDiskUsage(int diskUsage);
@@ -126,7 +136,15 @@ public:
     int textureUsage() const;
 
     QSharedPointer<QGeoTileTexture> get(const QGeoTileSpec &spec);
+    QSharedPointer<QGeoTileTexture> getDecoded(const QGeoTileSpec &spec);
+    bool requestDecode(const QGeoTileSpec &spec);
+    bool contains(const QGeoTileSpec &spec) const;
     QString directory() const;
+    QGeoTiledMappingManagerEngine::DiskCacheLayout diskLayout() const;
+
+    int queuedDecodeCount() const;
+    int runningDecodeCount() const;
+    int finishedDecodeCount() const;
 
     void setTileSize(const QSize &size) { tileSize_ = size; }
 
@@ -143,25 +161,62 @@ public:
 public Q_SLOTS:
     void printStats();
 
+Q_SIGNALS:
+    void tileDecoded(const QGeoTileSpec &spec);
+    void tileDecodeFailed(const QGeoTileSpec &spec);
+
+private Q_SLOTS:
+    void decodeFinished(const QGeoTileSpec &spec, const QByteArray &diskBytes,
+                        const QString &format, const QImage &image);
+    void checkpoint();
+    void addOrphanedTiles(const QStringList &files, const QList<int> &sizes);
+
 private:
     void loadTiles();
+    void loadPackedTiles();
+    void importTilesToPack(const QStringList &files);
+    bool loadIndex();
+    void saveIndex(bool clean);
+    void snapshotIndex(QGeoTileIndexSnapshot *snapshot, bool clean);
+    static bool writeIndex(const QGeoTileIndexSnapshot &snapshot);
 
     QSharedPointer<QGeoCachedTileDisk> addToDiskCache(const QGeoTileSpec &spec, const QString &filename);
+    QSharedPointer<QGeoCachedTileDisk> addToDiskCache(const QGeoTileSpec &spec, const QString &filename, int cost);
     QSharedPointer<QGeoCachedTileMemory> addToMemoryCache(const QGeoTileSpec &spec, const QByteArray &bytes, const QString &format);
-    QSharedPointer<QGeoTileTexture> addToTextureCache(const QGeoTileSpec &spec, const QPixmap &pixmap);
+    QSharedPointer<QGeoTileTexture> addToTextureCache(const QGeoTileSpec &spec, const QImage &image);
 
     static QString tileSpecToFilename(const QGeoTileSpec &spec, const QString &format, const QString &directory);
     static QGeoTileSpec filenameToTileSpec(const QString &filename);
 
     QString directory_;
-    QCache3Q<QGeoTileSpec, QGeoCachedTileDisk, QCache3QTileEvictionPolicy > diskCache_;
-    QCache3Q<QGeoTileSpec, QGeoCachedTileMemory > memoryCache_;
+    // only set for QGeoTiledMappingManagerEngine::PackedFileLayout
+    QGeoTilePackStore *packStore_;
+    // the disk and memory caches may be filled from the tile fetcher's thread
+    QConcurrentCache3Q<QGeoTileSpec, QGeoCachedTileDisk, QCache3QTileEvictionPolicy > diskCache_;
+    QConcurrentCache3Q<QGeoTileSpec, QGeoCachedTileMemory > memoryCache_;
     QCache3Q<QGeoTileSpec, QGeoTileTexture > textureCache_;
 
     int minTextureUsage_;
     int extraTextureUsage_;
 
     QSize tileSize_;
+
+    // decoding of cached bytes into textures happens on decodePool_, results
+    // are delivered back to this object's thread through decodeFinished()
+    QThreadPool decodePool_;
+    QSet<QGeoTileSpec> pendingDecodes_;
+    QAtomicInt queuedDecodes_;
+    QAtomicInt runningDecodes_;
+    QAtomicInt finishedDecodes_;
+
+    // checkpoints of the index are written on decodePool_ as well
+    QTimer checkpointTimer_;
+    QAtomicInt indexDirty_;
+    QAtomicInt checkpointRunning_;
+
+    friend class QGeoTileDecodeJob;
+    friend class QGeoTileOrphanScanJob;
+    friend class QGeoTileIndexJob;
 };
 
 QT_END_NAMESPACE
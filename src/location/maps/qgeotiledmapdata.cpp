@@ -38,6 +38,7 @@
 #include "qgeotilespec_p.h"
 
 #include "qgeocameratiles_p.h"
+#include "qgeotileprefetcher_p.h"
 #include "qgeotilerequestmanager_p.h"
 #include "qgeomapscene_p.h"
 #include "qgeocameracapabilities_p.h"
@@ -48,6 +49,7 @@
 #include <qnumeric.h>
 
 #include <QtPositioning/private/qgeoprojection_p.h>
+#include <QtPositioning/private/qgeocoordinatearray_p.h>
 #include <QtPositioning/private/qdoublevector2d_p.h>
 
 #include <cmath>
@@ -66,6 +68,16 @@ QGeoTiledMapData::QGeoTiledMapData(QGeoTiledMappingManagerEngine *engine, QObjec
             this,
             SLOT(updateMapVersion()));
     QMetaObject::invokeMethod(this, "updateMapVersion", Qt::QueuedConnection);
+
+    QGeoTileCache *cache = engine->tileCache();
+    connect(cache,
+            SIGNAL(tileDecoded(QGeoTileSpec)),
+            this,
+            SLOT(tileDecoded(QGeoTileSpec)));
+    connect(cache,
+            SIGNAL(tileDecodeFailed(QGeoTileSpec)),
+            this,
+            SLOT(tileDecodeFailed(QGeoTileSpec)));
 }
 
 QGeoTiledMapData::~QGeoTiledMapData()
@@ -86,6 +98,18 @@ void QGeoTiledMapData::newTileFetched(const QGeoTileSpec &spec)
     d->newTileFetched(spec);
 }
 
+void QGeoTiledMapData::tileDecoded(const QGeoTileSpec &spec)
+{
+    Q_D(QGeoTiledMapData);
+    d->tileRequests_->tileDecoded(spec);
+}
+
+void QGeoTiledMapData::tileDecodeFailed(const QGeoTileSpec &spec)
+{
+    Q_D(QGeoTiledMapData);
+    d->tileRequests_->tileDecodeFailed(spec);
+}
+
 QGeoTileCache *QGeoTiledMapData::tileCache()
 {
     Q_D(QGeoTiledMapData);
@@ -117,6 +141,41 @@ void QGeoTiledMapData::prefetchData()
     d->prefetchTiles();
 }
 
+/*
+ * In predictive mode the map follows the camera motion, or the route set with
+ * setPrefetchRoute(), and prefetches the tiles ahead of the viewport into the
+ * cache. These requests never hold up the tiles that are visible.
+ */
+void QGeoTiledMapData::setPredictivePrefetch(bool enabled)
+{
+    Q_D(QGeoTiledMapData);
+    d->setPredictivePrefetch(enabled);
+}
+
+bool QGeoTiledMapData::predictivePrefetch() const
+{
+    Q_D(const QGeoTiledMapData);
+    return d->predictivePrefetch_;
+}
+
+void QGeoTiledMapData::setPrefetchRoute(const QList<QGeoCoordinate> &path)
+{
+    Q_D(QGeoTiledMapData);
+    d->setPrefetchRoute(path);
+}
+
+void QGeoTiledMapData::setPrefetchBudget(int bytesPerSecond)
+{
+    Q_D(QGeoTiledMapData);
+    d->prefetcher_->setBandwidthBudget(bytesPerSecond);
+}
+
+int QGeoTiledMapData::prefetchBudget() const
+{
+    Q_D(const QGeoTiledMapData);
+    return d->prefetcher_->bandwidthBudget();
+}
+
 void QGeoTiledMapData::changeActiveMapType(const QGeoMapType mapType)
 {
     Q_D(QGeoTiledMapData);
@@ -169,19 +228,50 @@ QDoubleVector2D QGeoTiledMapData::coordinateToScreenPosition(const QGeoCoordinat
     return pos;
 }
 
+void QGeoTiledMapData::coordinatesToScreenPositions(const QGeoCoordinateArray &coordinates,
+                                                    QDoubleVector2D *positions,
+                                                    bool clipToViewport) const
+{
+    Q_D(const QGeoTiledMapData);
+
+    // the mercator positions are projected to the screen in place
+    const int count = coordinates.size();
+    QGeoProjection::coordToMercator(coordinates, positions);
+    d->mapScene_->mercatorToScreenPositions(positions, count, positions);
+
+    if (clipToViewport) {
+        int w = width();
+        int h = height();
+
+        for (int i = 0; i < count; ++i) {
+            const QDoubleVector2D &pos = positions[i];
+            if ((pos.x() < 0) || (w < pos.x()) || (pos.y() < 0) || (h < pos.y()))
+                positions[i] = QDoubleVector2D(qQNaN(), qQNaN());
+        }
+    }
+}
+
 QGeoTiledMapDataPrivate::QGeoTiledMapDataPrivate(QGeoTiledMapData *parent, QGeoTiledMappingManagerEngine *engine)
     : map_(parent),
       cache_(engine->tileCache()),
       engine_(engine),
       cameraTiles_(new QGeoCameraTiles()),
       mapScene_(new QGeoMapScene()),
-      tileRequests_(new QGeoTileRequestManager(parent))
+      tileRequests_(new QGeoTileRequestManager(parent)),
+      prefetcher_(new QGeoTilePrefetcher()),
+      predictivePrefetch_(false),
+      lastPrediction_(0)
 {
     cameraTiles_->setMinimumZoomLevel(static_cast<int>(std::floor(engine->cameraCapabilities().minimumZoomLevel())));
     cameraTiles_->setMaximumZoomLevel(static_cast<int>(std::ceil(engine->cameraCapabilities().maximumZoomLevel())));
     cameraTiles_->setTileSize(engine->tileSize().width());
     cameraTiles_->setPluginString(map_->pluginString());
 
+    prefetcher_->setMinimumZoomLevel(static_cast<int>(std::floor(engine->cameraCapabilities().minimumZoomLevel())));
+    prefetcher_->setMaximumZoomLevel(static_cast<int>(std::ceil(engine->cameraCapabilities().maximumZoomLevel())));
+    prefetcher_->setTileSize(engine->tileSize().width());
+    prefetcher_->setPluginString(map_->pluginString());
+
     mapScene_->setTileSize(engine->tileSize().width());
 
     QObject::connect(mapScene_,
@@ -194,6 +284,7 @@ QGeoTiledMapDataPrivate::~QGeoTiledMapDataPrivate()
 {
     // controller_ is a child of map_, don't need to delete it here
 
+    delete prefetcher_;
     delete tileRequests_;
     delete mapScene_;
     delete cameraTiles_;
@@ -221,6 +312,48 @@ void QGeoTiledMapDataPrivate::prefetchTiles()
     tileRequests_->requestTiles(tiles - mapScene_->texturedTiles());
 }
 
+void QGeoTiledMapDataPrivate::setPredictivePrefetch(bool enabled)
+{
+    if (predictivePrefetch_ == enabled)
+        return;
+
+    predictivePrefetch_ = enabled;
+    prefetcher_->clearCameraSamples();
+
+    if (enabled) {
+        motionClock_.start();
+        lastPrediction_ = 0;
+        prefetcher_->addCameraSample(map_->cameraData(), 0);
+    } else if (engine_) {
+        engine_->updatePrefetchRequests(map_, QSet<QGeoTileSpec>());
+    }
+}
+
+void QGeoTiledMapDataPrivate::setPrefetchRoute(const QList<QGeoCoordinate> &path)
+{
+    prefetcher_->setRoute(path);
+    if (predictivePrefetch_)
+        predictTiles();
+}
+
+void QGeoTiledMapDataPrivate::predictTiles()
+{
+    if (!engine_)
+        return;
+
+    lastPrediction_ = motionClock_.elapsed();
+
+    QSet<QGeoTileSpec> visible = cameraTiles_->tiles();
+    QSet<QGeoTileSpec> tiles;
+    foreach (const QGeoTileSpec &spec, prefetcher_->predictedTiles()) {
+        if (visible.contains(spec) || (cache_ && cache_->contains(spec)))
+            continue;
+        tiles.insert(spec);
+    }
+
+    engine_->updatePrefetchRequests(map_, tiles);
+}
+
 void QGeoTiledMapDataPrivate::changeCameraData(const QGeoCameraData &oldCameraData)
 {
     double lat = oldCameraData.center().latitude();
@@ -262,22 +395,37 @@ void QGeoTiledMapDataPrivate::changeCameraData(const QGeoCameraData &oldCameraDa
         if (!cachedTiles.isEmpty())
             map_->update();
     }
+
+    if (predictivePrefetch_) {
+        qint64 now = motionClock_.elapsed();
+        prefetcher_->addCameraSample(cam, now);
+
+        // camera changes come once per frame, predicting a few times per
+        // second is plenty
+        static const qint64 PredictionInterval = 250;
+        if (now - lastPrediction_ >= PredictionInterval)
+            predictTiles();
+    }
 }
 
 void QGeoTiledMapDataPrivate::changeActiveMapType(const QGeoMapType mapType)
 {
     cameraTiles_->setMapType(mapType);
+    prefetcher_->setMapType(mapType);
 }
 
 void QGeoTiledMapDataPrivate::changeMapVersion(int mapVersion)
 {
     cameraTiles_->setMapVersion(mapVersion);
+    prefetcher_->setMapVersion(mapVersion);
 }
 
 void QGeoTiledMapDataPrivate::resized(int width, int height)
 {
     if (cameraTiles_)
         cameraTiles_->setScreenSize(QSize(width, height));
+    if (prefetcher_)
+        prefetcher_->setScreenSize(QSize(width, height));
     if (mapScene_)
         mapScene_->setScreenSize(QSize(width, height));
     if (map_)
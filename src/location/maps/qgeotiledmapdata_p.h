@@ -82,8 +82,17 @@ public:
 
     QGeoCoordinate screenPositionToCoordinate(const QDoubleVector2D &pos, bool clipToViewport = true) const;
     QDoubleVector2D coordinateToScreenPosition(const QGeoCoordinate &coordinate, bool clipToViewport = true) const;
+    void coordinatesToScreenPositions(const QGeoCoordinateArray &coordinates,
+                                      QDoubleVector2D *positions,
+                                      bool clipToViewport = true) const;
     void prefetchTiles();
 
+    void setPredictivePrefetch(bool enabled);
+    bool predictivePrefetch() const;
+    void setPrefetchRoute(const QList<QGeoCoordinate> &path);
+    void setPrefetchBudget(int bytesPerSecond);
+    int prefetchBudget() const;
+
     // Alternative to exposing this is to make tileFetched a slot, but then requestManager would
     // need to be a QObject
     QGeoTileRequestManager *getRequestManager();
@@ -100,6 +109,10 @@ protected Q_SLOTS:
     virtual void evaluateCopyrights(const QSet<QGeoTileSpec> &visibleTiles);
     void updateMapVersion();
 
+private Q_SLOTS:
+    void tileDecoded(const QGeoTileSpec &spec);
+    void tileDecodeFailed(const QGeoTileSpec &spec);
+
 private:
     QGeoTiledMapDataPrivate *d_ptr;
     Q_DECLARE_PRIVATE(QGeoTiledMapData)
@@ -53,6 +53,7 @@
 #include <QMatrix4x4>
 #include <QString>
 #include <QPointer>
+#include <QElapsedTimer>
 
 #include <QtPositioning/private/qdoublevector3d_p.h>
 #include <QtPositioning/private/qdoublevector2d_p.h>
@@ -69,6 +70,7 @@ class QGeoMapController;
 class QGeoProjection;
 
 class QGeoCameraTiles;
+class QGeoTilePrefetcher;
 class QGeoTileRequestManager;
 class QGeoMapScene;
 class QGeoTiledMapData;
@@ -96,6 +98,9 @@ public:
     QSet<QGeoTileSpec> visibleTiles();
 
     void prefetchTiles();
+    void setPredictivePrefetch(bool enabled);
+    void setPrefetchRoute(const QList<QGeoCoordinate> &path);
+    void predictTiles();
     QPointer<QGeoTiledMappingManagerEngine> engine() const;
 
 private:
@@ -108,6 +113,10 @@ private:
     Q_DISABLE_COPY(QGeoTiledMapDataPrivate)
 public:
     QGeoTileRequestManager *tileRequests_;
+    QGeoTilePrefetcher *prefetcher_;
+    bool predictivePrefetch_;
+    QElapsedTimer motionClock_;
+    qint64 lastPrediction_;
 };
 
 QT_END_NAMESPACE
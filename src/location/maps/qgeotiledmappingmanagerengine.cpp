@@ -40,20 +40,40 @@
 #include "qgeotilerequestmanager_p.h"
 #include "qgeotilecache_p.h"
 #include "qgeotilespec_p.h"
+#include "qgeotileregiondownload_p.h"
+#include "qgeocameradata_p.h"
+
+#include <QtPositioning/private/qgeoprojection_p.h>
+#include <QtPositioning/private/qdoublevector2d_p.h>
 
 #include <QTimer>
 #include <QLocale>
 
+#include <cmath>
+
 QT_BEGIN_NAMESPACE
 
-void QGeoTiledMappingManagerEnginePrivate::ensureTileCacheCreated(const QString &cacheDir)
+void QGeoTiledMappingManagerEnginePrivate::ensureTileCacheCreated(const QString &cacheDir,
+                                                                  QGeoTiledMappingManagerEngine::DiskCacheLayout layout)
 {
     if (!tileCache_) {
-        tileCache_ = new QGeoTileCache(cacheDir);
+        tileCache_ = new QGeoTileCache(cacheDir, 0, layout);
         tileCache_->setTileSize(tileSize_);
+        if (fetcher_)
+            fetcher_->setTileCache(tileCache_, cacheHint_);
     }
 }
 
+void QGeoTiledMappingManagerEnginePrivate::prefetchDone(const QGeoTileSpec &spec)
+{
+    if (!prefetchRefs_.remove(spec))
+        return;
+
+    QHash<QGeoTiledMapData *, QSet<QGeoTileSpec> >::iterator it = prefetchHash_.begin();
+    for (; it != prefetchHash_.end(); ++it)
+        it->remove(spec);
+}
+
 
 QGeoTiledMappingManagerEngine::QGeoTiledMappingManagerEngine(QObject *parent)
     : QGeoMappingManagerEngine(parent),
@@ -75,6 +95,8 @@ void QGeoTiledMappingManagerEngine::setTileFetcher(QGeoTileFetcher *fetcher)
     Q_D(QGeoTiledMappingManagerEngine);
 
     d->fetcher_ = fetcher;
+    if (d->tileCache_)
+        d->fetcher_->setTileCache(d->tileCache_, d->cacheHint_);
 
     qRegisterMetaType<QGeoTileSpec>();
 
@@ -111,6 +133,10 @@ void QGeoTiledMappingManagerEngine::registerMap(QGeoTiledMapData *map)
 
 void QGeoTiledMappingManagerEngine::deregisterMap(QGeoTiledMapData *map)
 {
+    if (d_ptr->prefetchHash_.contains(map))
+        updatePrefetchRequests(map, QSet<QGeoTileSpec>());
+    d_ptr->prefetchHash_.remove(map);
+
     d_ptr->tileMaps_.remove(map);
     d_ptr->mapHash_.remove(map);
 
@@ -186,16 +212,69 @@ void QGeoTiledMappingManagerEngine::updateTileRequests(QGeoTiledMapData *map,
 
     cancelTiles -= reqTiles;
 
+    // fetch the tiles closest to the camera of the map that asked first
+    QGeoCameraData camera = map->cameraData();
+    QDoubleVector2D center = QGeoProjection::coordToMercator(camera.center());
+    QMetaObject::invokeMethod(d->fetcher_, "setPriorityCenter",
+                              Qt::QueuedConnection,
+                              Q_ARG(double, center.x()),
+                              Q_ARG(double, center.y()),
+                              Q_ARG(int, static_cast<int>(std::floor(camera.zoomLevel()))));
+
     QMetaObject::invokeMethod(d->fetcher_, "updateTileRequests",
                               Qt::QueuedConnection,
                               Q_ARG(QSet<QGeoTileSpec>, reqTiles),
                               Q_ARG(QSet<QGeoTileSpec>, cancelTiles));
 }
 
+/*
+ * Replaces the set of tiles \a map wants to have prefetched into the cache.
+ * The fetcher serves them after all tiles requested by updateTileRequests().
+ */
+void QGeoTiledMappingManagerEngine::updatePrefetchRequests(QGeoTiledMapData *map,
+                                                           const QSet<QGeoTileSpec> &tiles)
+{
+    Q_D(QGeoTiledMappingManagerEngine);
+
+    QSet<QGeoTileSpec> &oldTiles = d->prefetchHash_[map];
+
+    QSet<QGeoTileSpec> reqTiles;
+    QSet<QGeoTileSpec> cancelTiles;
+
+    foreach (const QGeoTileSpec &tile, oldTiles) {
+        if (tiles.contains(tile))
+            continue;
+        int &refs = d->prefetchRefs_[tile];
+        if (--refs <= 0) {
+            d->prefetchRefs_.remove(tile);
+            cancelTiles.insert(tile);
+        }
+    }
+
+    foreach (const QGeoTileSpec &tile, tiles) {
+        if (oldTiles.contains(tile))
+            continue;
+        if (++d->prefetchRefs_[tile] == 1)
+            reqTiles.insert(tile);
+    }
+
+    oldTiles = tiles;
+
+    if (!d->fetcher_ || (reqTiles.isEmpty() && cancelTiles.isEmpty()))
+        return;
+
+    QMetaObject::invokeMethod(d->fetcher_, "updatePrefetchRequests",
+                              Qt::QueuedConnection,
+                              Q_ARG(QSet<QGeoTileSpec>, reqTiles),
+                              Q_ARG(QSet<QGeoTileSpec>, cancelTiles));
+}
+
 void QGeoTiledMappingManagerEngine::engineTileFinished(const QGeoTileSpec &spec, const QByteArray &bytes, const QString &format)
 {
     Q_D(QGeoTiledMappingManagerEngine);
 
+    d->prefetchDone(spec);
+
     QSet<QGeoTiledMapData *> maps = d->tileHash_.value(spec);
 
     typedef QSet<QGeoTiledMapData *>::const_iterator map_iter;
@@ -213,7 +292,9 @@ void QGeoTiledMappingManagerEngine::engineTileFinished(const QGeoTileSpec &spec,
 
     d->tileHash_.remove(spec);
 
-    tileCache()->insert(spec, bytes, format, d->cacheHint_);
+    // the fetcher normally stores the tile itself before emitting
+    if (!d->fetcher_->insertsIntoCache())
+        tileCache()->insert(spec, bytes, format, d->cacheHint_);
 
     map = maps.constBegin();
     mapEnd = maps.constEnd();
@@ -226,6 +307,8 @@ void QGeoTiledMappingManagerEngine::engineTileError(const QGeoTileSpec &spec, co
 {
     Q_D(QGeoTiledMappingManagerEngine);
 
+    d->prefetchDone(spec);
+
     QSet<QGeoTiledMapData *> maps = d->tileHash_.value(spec);
     typedef QSet<QGeoTiledMapData *>::const_iterator map_iter;
     map_iter map = maps.constBegin();
@@ -270,13 +353,16 @@ void QGeoTiledMappingManagerEngine::setCacheHint(QGeoTiledMappingManagerEngine::
 {
     Q_D(QGeoTiledMappingManagerEngine);
     d->cacheHint_ = cacheHint;
+    if (d->fetcher_ && d->tileCache_)
+        d->fetcher_->setTileCache(d->tileCache_, cacheHint);
 }
 
-QGeoTileCache *QGeoTiledMappingManagerEngine::createTileCacheWithDir(const QString &cacheDirectory)
+QGeoTileCache *QGeoTiledMappingManagerEngine::createTileCacheWithDir(const QString &cacheDirectory,
+                                                                     DiskCacheLayout layout)
 {
     Q_D(QGeoTiledMappingManagerEngine);
     Q_ASSERT_X(!d->tileCache_, Q_FUNC_INFO, "This should be called only once");
-    d->ensureTileCacheCreated(cacheDirectory);
+    d->ensureTileCacheCreated(cacheDirectory, layout);
     return d->tileCache_;
 }
 
@@ -287,6 +373,18 @@ QGeoTileCache *QGeoTiledMappingManagerEngine::tileCache()
     return d->tileCache_;
 }
 
+/*
+ * Creates a download of tiles from this engine into its disk cache. The
+ * region, zoom range and map id still have to be set on it.
+ */
+QGeoTileRegionDownload *QGeoTiledMappingManagerEngine::createRegionDownload(QObject *parent)
+{
+    Q_D(QGeoTiledMappingManagerEngine);
+    QGeoTileRegionDownload *download = new QGeoTileRegionDownload(d->fetcher_, tileCache(), parent);
+    download->setPluginString(managerName() + QLatin1Char('_') + QString::number(managerVersion()));
+    return download;
+}
+
 QSharedPointer<QGeoTileTexture> QGeoTiledMappingManagerEngine::getTileTexture(const QGeoTileSpec &spec)
 {
     return d_ptr->tileCache_->get(spec);
@@ -47,6 +47,7 @@ class QGeoTiledMappingManagerEnginePrivate;
 class QGeoMapRequestOptions;
 class QGeoTileFetcher;
 class QGeoTileTexture;
+class QGeoTileRegionDownload;
 
 class QGeoTileSpec;
 class QGeoTiledMapData;
@@ -64,6 +65,11 @@ public:
     };
     Q_DECLARE_FLAGS(CacheAreas, CacheArea)
 
+    enum DiskCacheLayout {
+        FilePerTileLayout,
+        PackedFileLayout
+    };
+
     explicit QGeoTiledMappingManagerEngine(QObject *parent = 0);
     virtual ~QGeoTiledMappingManagerEngine();
 
@@ -79,6 +85,8 @@ public:
     void updateTileRequests(QGeoTiledMapData *map,
                             const QSet<QGeoTileSpec> &tilesAdded,
                             const QSet<QGeoTileSpec> &tilesRemoved);
+    void updatePrefetchRequests(QGeoTiledMapData *map,
+                                const QSet<QGeoTileSpec> &tiles);
 
     QGeoTileCache *tileCache(); // TODO: check this is still used
     QSharedPointer<QGeoTileTexture> getTileTexture(const QGeoTileSpec &spec);
@@ -86,6 +94,8 @@ public:
 
     QGeoTiledMappingManagerEngine::CacheAreas cacheHint() const;
 
+    QGeoTileRegionDownload *createRegionDownload(QObject *parent = 0);
+
 private Q_SLOTS:
     void engineTileFinished(const QGeoTileSpec &spec, const QByteArray &bytes, const QString &format);
     void engineTileError(const QGeoTileSpec &spec, const QString &errorString);
@@ -99,7 +109,8 @@ protected:
     void setTileSize(const QSize &tileSize);
     void setCacheHint(QGeoTiledMappingManagerEngine::CacheAreas cacheHint);
 
-    QGeoTileCache *createTileCacheWithDir(const QString &cacheDirectory);
+    QGeoTileCache *createTileCacheWithDir(const QString &cacheDirectory,
+                                          DiskCacheLayout layout = FilePerTileLayout);
 
 private:
     QGeoTiledMappingManagerEnginePrivate *d_ptr;
@@ -68,11 +68,17 @@ public:
     QSet<QGeoTiledMapData *> tileMaps_;
     QHash<QGeoTiledMapData *, QSet<QGeoTileSpec> > mapHash_;
     QHash<QGeoTileSpec, QSet<QGeoTiledMapData *> > tileHash_;
+    // tiles the maps expect to need soon, with the number of maps wanting each
+    QHash<QGeoTiledMapData *, QSet<QGeoTileSpec> > prefetchHash_;
+    QHash<QGeoTileSpec, int> prefetchRefs_;
     QGeoTiledMappingManagerEngine::CacheAreas cacheHint_;
     QGeoTileCache *tileCache_;
     QGeoTileFetcher *fetcher_;
 
-    void ensureTileCacheCreated(const QString &cacheDir = QString());
+    void prefetchDone(const QGeoTileSpec &spec);
+    void ensureTileCacheCreated(const QString &cacheDir = QString(),
+                                QGeoTiledMappingManagerEngine::DiskCacheLayout layout
+                                    = QGeoTiledMappingManagerEngine::FilePerTileLayout);
 
 private:
     Q_DISABLE_COPY(QGeoTiledMappingManagerEnginePrivate)
@@ -85,6 +85,7 @@ public:
 
 Q_SIGNALS:
     void finished();
+    void firstByteReceived();
     void error(QGeoTiledMapReply::Error error, const QString &errorString = QString());
 
 protected:
@@ -33,12 +33,16 @@
 
 #include <QtCore/QTimerEvent>
 
+#include <algorithm>
+#include <cmath>
+
 #include "qgeomappingmanagerengine_p.h"
 #include "qgeotilefetcher_p.h"
 #include "qgeotilefetcher_p_p.h"
 #include "qgeotiledmapreply_p.h"
 #include "qgeotilespec_p.h"
 #include "qgeotiledmapdata_p.h"
+#include "qgeotilecache_p.h"
 
 QT_BEGIN_NAMESPACE
 
@@ -48,9 +52,6 @@ QGeoTileFetcher::QGeoTileFetcher(QObject *parent)
     Q_D(QGeoTileFetcher);
 
     d->enabled_ = true;
-
-    if (!d->queue_.isEmpty())
-        d->timer_.start(0, this);
 }
 
 QGeoTileFetcher::~QGeoTileFetcher()
@@ -59,6 +60,58 @@ QGeoTileFetcher::~QGeoTileFetcher()
     delete d_ptr;
 }
 
+void QGeoTileFetcher::setMaxRequestsPerHost(int requests)
+{
+    Q_D(QGeoTileFetcher);
+
+    QMutexLocker ml(&d->queueMutex_);
+    d->maxRequestsPerHost_ = qMax(1, requests);
+
+    if (d->enabled_ && !d->queued_.isEmpty() && !d->timer_.isActive())
+        d->timer_.start(0, this);
+}
+
+int QGeoTileFetcher::maxRequestsPerHost() const
+{
+    Q_D(const QGeoTileFetcher);
+    QMutexLocker ml(&d->queueMutex_);
+    return d->maxRequestsPerHost_;
+}
+
+/*
+ * Number of tiles waiting to be requested.
+ */
+int QGeoTileFetcher::queueDepth() const
+{
+    Q_D(const QGeoTileFetcher);
+    QMutexLocker ml(&d->queueMutex_);
+    return d->queued_.size();
+}
+
+/*
+ * Number of requests that have been sent and not finished yet.
+ */
+int QGeoTileFetcher::inFlightCount() const
+{
+    Q_D(const QGeoTileFetcher);
+    QMutexLocker ml(&d->queueMutex_);
+    return d->inFlightCount_;
+}
+
+/*
+ * Average time in milliseconds between sending a request and the first
+ * response data arriving. Replies that never report their first byte are
+ * counted as taking until they finished.
+ */
+double QGeoTileFetcher::averageTimeToFirstByte() const
+{
+    Q_D(const QGeoTileFetcher);
+    QMutexLocker ml(&d->queueMutex_);
+    if (d->firstByteSamples_ == 0)
+        return 0.0;
+    return double(d->firstByteTotal_) / d->firstByteSamples_;
+}
+
 void QGeoTileFetcher::updateTileRequests(const QSet<QGeoTileSpec> &tilesAdded,
                                                   const QSet<QGeoTileSpec> &tilesRemoved)
 {
@@ -68,61 +121,217 @@ void QGeoTileFetcher::updateTileRequests(const QSet<QGeoTileSpec> &tilesAdded,
 
     cancelTileRequests(tilesRemoved);
 
-    d->queue_ += tilesAdded.toList();
+    typedef QSet<QGeoTileSpec>::const_iterator tile_iter;
+    tile_iter tile = tilesAdded.constBegin();
+    tile_iter end = tilesAdded.constEnd();
+    for (; tile != end; ++tile) {
+        // a prefetched tile that is needed now moves ahead of the prefetches
+        bool wasLowPriority = d->lowPriority_.remove(*tile);
+        if (d->invmap_.contains(*tile))
+            continue;
+        if (d->queued_.contains(*tile) && !wasLowPriority)
+            continue;
+        d->enqueue(hostForTile(*tile), *tile);
+    }
 
-    if (d->enabled_ && !d->queue_.isEmpty() && !d->timer_.isActive())
+    if (d->enabled_ && !d->queued_.isEmpty() && !d->timer_.isActive())
         d->timer_.start(0, this);
 }
 
-void QGeoTileFetcher::cancelTileRequests(const QSet<QGeoTileSpec> &tiles)
+/*
+ * Prefetched tiles are only fetched when no tile requested through
+ * updateTileRequests() is waiting for the same host, and they never take more
+ * than half of the requests per host. Removing a tile only cancels it if it
+ * has not been requested through updateTileRequests() or
+ * updateDownloadRequests() since.
+ */
+void QGeoTileFetcher::updatePrefetchRequests(const QSet<QGeoTileSpec> &tilesAdded,
+                                             const QSet<QGeoTileSpec> &tilesRemoved)
 {
     Q_D(QGeoTileFetcher);
 
-    typedef QSet<QGeoTileSpec>::const_iterator tile_iter;
-    tile_iter tile = tiles.constBegin();
-    tile_iter end = tiles.constEnd();
-    for (; tile != end; ++tile) {
-        QGeoTiledMapReply *reply = d->invmap_.value(*tile, 0);
-        if (reply) {
-            d->invmap_.remove(*tile);
-            reply->abort();
-            if (reply->isFinished())
-                reply->deleteLater();
+    QMutexLocker ml(&d->queueMutex_);
+    updateLowPriorityRequests(tilesAdded, tilesRemoved, QGeoTileFetcherPrivate::Prefetch);
+}
+
+/*
+ * Downloaded tiles are scheduled like prefetched ones, but they are only
+ * stored in the disk cache, so that bulk downloads do not push the tiles in
+ * use out of memory.
+ */
+void QGeoTileFetcher::updateDownloadRequests(const QSet<QGeoTileSpec> &tilesAdded,
+                                             const QSet<QGeoTileSpec> &tilesRemoved)
+{
+    Q_D(QGeoTileFetcher);
+
+    QMutexLocker ml(&d->queueMutex_);
+    updateLowPriorityRequests(tilesAdded, tilesRemoved, QGeoTileFetcherPrivate::Download);
+}
+
+void QGeoTileFetcher::updateLowPriorityRequests(const QSet<QGeoTileSpec> &tilesAdded,
+                                                const QSet<QGeoTileSpec> &tilesRemoved,
+                                                int reason)
+{
+    Q_D(QGeoTileFetcher);
+
+    QSet<QGeoTileSpec> cancelled;
+    foreach (const QGeoTileSpec &tile, tilesRemoved) {
+        QHash<QGeoTileSpec, int>::iterator it = d->lowPriority_.find(tile);
+        if (it == d->lowPriority_.end() || !(it.value() & reason))
+            continue;
+        it.value() &= ~reason;
+        if (it.value() == 0)
+            cancelled.insert(tile);
+    }
+    cancelTileRequests(cancelled);
+
+    foreach (const QGeoTileSpec &tile, tilesAdded) {
+        if (d->queued_.contains(tile) || d->invmap_.contains(tile)) {
+            // tiles requested with full priority stay that way
+            QHash<QGeoTileSpec, int>::iterator it = d->lowPriority_.find(tile);
+            if (it != d->lowPriority_.end())
+                it.value() |= reason;
+            continue;
         }
-        d->queue_.removeAll(*tile);
+        d->enqueue(hostForTile(tile), tile, true);
+        d->lowPriority_.insert(tile, reason);
     }
+
+    if (d->enabled_ && !d->queued_.isEmpty() && !d->timer_.isActive())
+        d->timer_.start(0, this);
 }
 
-void QGeoTileFetcher::requestNextTile()
+QGeoTileCache *QGeoTileFetcher::tileCache() const
+{
+    Q_D(const QGeoTileFetcher);
+    QMutexLocker ml(&d->queueMutex_);
+    return d->tileCache_;
+}
+
+/*
+ * Tiles are requested in order of their distance from this point, given in
+ * normalized mercator coordinates, with tiles from the zoom level \a zoom
+ * coming before those of other levels.
+ */
+void QGeoTileFetcher::setPriorityCenter(double mercatorX, double mercatorY, int zoom)
 {
     Q_D(QGeoTileFetcher);
 
     QMutexLocker ml(&d->queueMutex_);
 
-    if (!d->enabled_)
+    if (d->hasCenter_ && d->centerX_ == mercatorX && d->centerY_ == mercatorY
+            && d->centerZoom_ == zoom)
         return;
 
-    if (d->queue_.isEmpty())
-        return;
+    d->hasCenter_ = true;
+    d->centerX_ = mercatorX;
+    d->centerY_ = mercatorY;
+    d->centerZoom_ = zoom;
+
+    d->rebuildQueues();
+}
+
+void QGeoTileFetcher::cancelTileRequests(const QSet<QGeoTileSpec> &tiles)
+{
+    Q_D(QGeoTileFetcher);
 
-    QGeoTileSpec ts = d->queue_.takeFirst();
+    typedef QSet<QGeoTileSpec>::const_iterator tile_iter;
+    tile_iter tile = tiles.constBegin();
+    tile_iter end = tiles.constEnd();
+    for (; tile != end; ++tile) {
+        d->lowPriority_.remove(*tile);
 
-    QGeoTiledMapReply *reply = getTileImage(ts);
+        // the heap entry stays behind and is skipped when it comes up
+        if (d->queued_.remove(*tile))
+            continue;
 
-    if (reply->isFinished()) {
-        handleReply(reply, ts);
-    } else {
-        connect(reply,
-                SIGNAL(finished()),
-                this,
-                SLOT(finished()),
-                Qt::QueuedConnection);
+        QHash<QGeoTileSpec, QGeoTileFetchInFlight>::iterator it = d->invmap_.find(*tile);
+        if (it == d->invmap_.end())
+            continue;
 
-        d->invmap_.insert(ts, reply);
+        QGeoTiledMapReply *reply = it->reply;
+        d->releaseSlot(*it);
+        d->invmap_.erase(it);
+
+        reply->abort();
+        if (reply->isFinished())
+            reply->deleteLater();
     }
 
-    if (d->queue_.isEmpty())
-        d->timer_.stop();
+    if (d->enabled_ && !d->queued_.isEmpty() && !d->timer_.isActive())
+        d->timer_.start(0, this);
+}
+
+/*
+ * Sends as many queued requests as the per host limit allows, best priority
+ * first. Must be called with the queue lock held.
+ */
+void QGeoTileFetcher::requestTiles()
+{
+    Q_D(QGeoTileFetcher);
+
+    if (!d->enabled_)
+        return;
+
+    if (d->heapEntries_ > 2 * d->queued_.size() + 64)
+        d->rebuildQueues();
+
+    int prefetchSlots = qMax(1, d->maxRequestsPerHost_ / 2);
+
+    QHash<QString, QGeoTileFetchHost>::iterator host = d->hosts_.begin();
+    for (; host != d->hosts_.end(); ++host) {
+        QVector<QGeoTileFetchRequest> &heap = host->heap;
+
+        while (!heap.isEmpty() && host->inFlight < d->maxRequestsPerHost_) {
+            std::pop_heap(heap.begin(), heap.end());
+            QGeoTileFetchRequest request = heap.takeLast();
+            --d->heapEntries_;
+
+            QHash<QGeoTileSpec, quint64>::iterator queued = d->queued_.find(request.spec);
+            if (queued == d->queued_.end() || queued.value() != request.serial)
+                continue;
+
+            // everything behind a prefetched tile is prefetched as well
+            if (request.prefetch && host->prefetchInFlight >= prefetchSlots) {
+                heap.append(request);
+                std::push_heap(heap.begin(), heap.end());
+                ++d->heapEntries_;
+                break;
+            }
+
+            d->queued_.erase(queued);
+
+            QGeoTileFetchInFlight inFlight;
+            inFlight.host = host.key();
+            inFlight.prefetch = request.prefetch;
+            inFlight.started.start();
+
+            QGeoTiledMapReply *reply = getTileImage(request.spec);
+
+            if (reply->isFinished()) {
+                handleReply(reply, request.spec);
+                continue;
+            }
+
+            connect(reply,
+                    SIGNAL(finished()),
+                    this,
+                    SLOT(finished()),
+                    Qt::QueuedConnection);
+            connect(reply,
+                    SIGNAL(firstByteReceived()),
+                    this,
+                    SLOT(firstByteReceived()),
+                    Qt::QueuedConnection);
+
+            inFlight.reply = reply;
+            d->invmap_.insert(request.spec, inFlight);
+            ++host->inFlight;
+            if (request.prefetch)
+                ++host->prefetchInFlight;
+            ++d->inFlightCount_;
+        }
+    }
 }
 
 void QGeoTileFetcher::finished()
@@ -137,14 +346,34 @@ void QGeoTileFetcher::finished()
 
     QGeoTileSpec spec = reply->tileSpec();
 
-    if (!d->invmap_.contains(spec)) {
+    QHash<QGeoTileSpec, QGeoTileFetchInFlight>::iterator it = d->invmap_.find(spec);
+    if (it == d->invmap_.end() || it->reply != reply) {
         reply->deleteLater();
         return;
     }
 
-    d->invmap_.remove(spec);
+    d->recordFirstByte(*it);
+    d->releaseSlot(*it);
+    d->invmap_.erase(it);
 
     handleReply(reply, spec);
+
+    requestTiles();
+}
+
+void QGeoTileFetcher::firstByteReceived()
+{
+    Q_D(QGeoTileFetcher);
+
+    QMutexLocker ml(&d->queueMutex_);
+
+    QGeoTiledMapReply *reply = qobject_cast<QGeoTiledMapReply *>(sender());
+    if (!reply)
+        return;
+
+    QHash<QGeoTileSpec, QGeoTileFetchInFlight>::iterator it = d->invmap_.find(reply->tileSpec());
+    if (it != d->invmap_.end() && it->reply == reply)
+        d->recordFirstByte(*it);
 }
 
 void QGeoTileFetcher::timerEvent(QTimerEvent *event)
@@ -155,24 +384,44 @@ void QGeoTileFetcher::timerEvent(QTimerEvent *event)
         return;
     }
 
-    if (d->queue_.isEmpty()) {
-        d->timer_.stop();
-        return;
-    }
+    QMutexLocker ml(&d->queueMutex_);
+
+    d->timer_.stop();
+    requestTiles();
+}
 
-    requestNextTile();
+/*
+ * Returns the name of the connection pool \a spec is fetched through. Each
+ * pool gets at most maxRequestsPerHost() requests in flight. The default puts
+ * every tile into the same pool.
+ */
+QString QGeoTileFetcher::hostForTile(const QGeoTileSpec &spec) const
+{
+    Q_UNUSED(spec);
+    return QString();
 }
 
 void QGeoTileFetcher::handleReply(QGeoTiledMapReply *reply, const QGeoTileSpec &spec)
 {
     Q_D(QGeoTileFetcher);
 
+    int reason = d->lowPriority_.take(spec);
+
     if (!d->enabled_) {
         reply->deleteLater();
         return;
     }
 
     if (reply->error() == QGeoTiledMapReply::NoError) {
+        // store the tile straight from this thread, so the engine's thread
+        // only has to notify the maps
+        if (d->tileCache_) {
+            // region downloads go to disk whatever the maps keep cached
+            QGeoTiledMappingManagerEngine::CacheAreas areas = d->cacheHint_;
+            if (reason == QGeoTileFetcherPrivate::Download)
+                areas = QGeoTiledMappingManagerEngine::DiskCache;
+            d->tileCache_->insert(spec, reply->mapImageData(), reply->mapImageFormat(), areas);
+        }
         emit tileFinished(spec, reply->mapImageData(), reply->mapImageFormat());
     } else {
         emit tileError(spec, reply->errorString());
@@ -181,11 +430,46 @@ void QGeoTileFetcher::handleReply(QGeoTiledMapReply *reply, const QGeoTileSpec &
     reply->deleteLater();
 }
 
+QGeoTiledMappingManagerEngine::CacheAreas QGeoTileFetcher::cacheHint() const
+{
+    // only called from getTileImage(), which already runs under the queue lock
+    Q_D(const QGeoTileFetcher);
+    return d->cacheHint_;
+}
+
+void QGeoTileFetcher::setTileCache(QGeoTileCache *cache,
+                                   QGeoTiledMappingManagerEngine::CacheAreas cacheHint)
+{
+    Q_D(QGeoTileFetcher);
+    QMutexLocker ml(&d->queueMutex_);
+    d->tileCache_ = cache;
+    d->cacheHint_ = cacheHint;
+}
+
+bool QGeoTileFetcher::insertsIntoCache() const
+{
+    Q_D(const QGeoTileFetcher);
+    QMutexLocker ml(&d->queueMutex_);
+    return d->tileCache_ != 0;
+}
+
 /*******************************************************************************
 *******************************************************************************/
 
 QGeoTileFetcherPrivate::QGeoTileFetcherPrivate()
-:   enabled_(false)
+:   enabled_(false),
+    heapEntries_(0),
+    nextSerial_(0),
+    maxRequestsPerHost_(6),
+    hasCenter_(false),
+    centerX_(0.0),
+    centerY_(0.0),
+    centerZoom_(0),
+    inFlightCount_(0),
+    firstByteTotal_(0),
+    firstByteSamples_(0),
+    tileCache_(0),
+    cacheHint_(QGeoTiledMappingManagerEngine::AllCaches)
 {
 }
 
@@ -193,4 +477,91 @@ QGeoTileFetcherPrivate::~QGeoTileFetcherPrivate()
 {
 }
 
+/*
+ * Without a center tiles keep the order in which they were requested.
+ * Otherwise tiles of the center zoom level come first, followed by each
+ * further level, and within a level the squared distance in tiles from the
+ * center decides.
+ */
+void QGeoTileFetcherPrivate::prioritize(QGeoTileFetchRequest &request) const
+{
+    if (!hasCenter_) {
+        request.level = 0;
+        request.distance = 0.0;
+        return;
+    }
+
+    const QGeoTileSpec &spec = request.spec;
+    double side = std::pow(2.0, spec.zoom());
+    double dx = std::fabs(spec.x() + 0.5 - centerX_ * side);
+    double dy = spec.y() + 0.5 - centerY_ * side;
+
+    // the map wraps around horizontally
+    dx = qMin(dx, side - dx);
+
+    request.level = qAbs(spec.zoom() - centerZoom_);
+    request.distance = dx * dx + dy * dy;
+}
+
+void QGeoTileFetcherPrivate::enqueue(const QString &host, const QGeoTileSpec &spec, bool prefetch)
+{
+    QGeoTileFetchRequest request;
+    request.spec = spec;
+    request.prefetch = prefetch;
+    request.serial = nextSerial_++;
+
+    prioritize(request);
+    queued_.insert(spec, request.serial);
+
+    QVector<QGeoTileFetchRequest> &heap = hosts_[host].heap;
+    heap.append(request);
+    std::push_heap(heap.begin(), heap.end());
+    ++heapEntries_;
+}
+
+/*
+ * Drops the stale entries of cancelled tiles and recomputes the priorities of
+ * the remaining ones.
+ */
+void QGeoTileFetcherPrivate::rebuildQueues()
+{
+    heapEntries_ = 0;
+
+    QHash<QString, QGeoTileFetchHost>::iterator host = hosts_.begin();
+    for (; host != hosts_.end(); ++host) {
+        QVector<QGeoTileFetchRequest> &heap = host->heap;
+
+        int live = 0;
+        for (int i = 0; i < heap.size(); ++i) {
+            QHash<QGeoTileSpec, quint64>::const_iterator queued = queued_.constFind(heap.at(i).spec);
+            if (queued == queued_.constEnd() || queued.value() != heap.at(i).serial)
+                continue;
+            heap[live] = heap.at(i);
+            prioritize(heap[live]);
+            ++live;
+        }
+        heap.resize(live);
+        std::make_heap(heap.begin(), heap.end());
+        heapEntries_ += live;
+    }
+}
+
+void QGeoTileFetcherPrivate::releaseSlot(const QGeoTileFetchInFlight &request)
+{
+    QGeoTileFetchHost &host = hosts_[request.host];
+    --host.inFlight;
+    if (request.prefetch)
+        --host.prefetchInFlight;
+    --inFlightCount_;
+}
+
+void QGeoTileFetcherPrivate::recordFirstByte(QGeoTileFetchInFlight &request)
+{
+    if (request.firstByte)
+        return;
+    request.firstByte = true;
+    firstByteTotal_ += request.started.elapsed();
+    ++firstByteSamples_;
+}
+
 QT_END_NAMESPACE
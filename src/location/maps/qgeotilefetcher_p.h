@@ -58,6 +58,7 @@ class QGeoTileFetcherPrivate;
 class QGeoTiledMappingManagerEngine;
 class QGeoTiledMapReply;
 class QGeoTileSpec;
+class QGeoTileCache;
 
 class Q_LOCATION_EXPORT QGeoTileFetcher : public QObject
 {
@@ -67,13 +68,25 @@ public:
     QGeoTileFetcher(QObject *parent = 0);
     virtual ~QGeoTileFetcher();
 
+    QGeoTileCache *tileCache() const;
+
+    void setMaxRequestsPerHost(int requests);
+    int maxRequestsPerHost() const;
+
+    int queueDepth() const;
+    int inFlightCount() const;
+    double averageTimeToFirstByte() const;
+
 public Q_SLOTS:
     void updateTileRequests(const QSet<QGeoTileSpec> &tilesAdded, const QSet<QGeoTileSpec> &tilesRemoved);
+    void setPriorityCenter(double mercatorX, double mercatorY, int zoom);
+    void updatePrefetchRequests(const QSet<QGeoTileSpec> &tilesAdded, const QSet<QGeoTileSpec> &tilesRemoved);
+    void updateDownloadRequests(const QSet<QGeoTileSpec> &tilesAdded, const QSet<QGeoTileSpec> &tilesRemoved);
 
 private Q_SLOTS:
     void cancelTileRequests(const QSet<QGeoTileSpec> &tiles);
-    void requestNextTile();
     void finished();
+    void firstByteReceived();
 
 Q_SIGNALS:
     void tileFinished(const QGeoTileSpec &spec, const QByteArray &bytes, const QString &format);
@@ -83,11 +96,18 @@ protected:
     void timerEvent(QTimerEvent *event);
     QGeoTiledMappingManagerEngine::CacheAreas cacheHint() const;
 
+    virtual QString hostForTile(const QGeoTileSpec &spec) const;
+
 private:
     QGeoTileFetcherPrivate *d_ptr;
 
     virtual QGeoTiledMapReply *getTileImage(const QGeoTileSpec &spec) = 0;
     void handleReply(QGeoTiledMapReply *reply, const QGeoTileSpec &spec);
+    void requestTiles();
+    void updateLowPriorityRequests(const QSet<QGeoTileSpec> &tilesAdded,
+                                   const QSet<QGeoTileSpec> &tilesRemoved, int reason);
+    void setTileCache(QGeoTileCache *cache, QGeoTiledMappingManagerEngine::CacheAreas cacheHint);
+    bool insertsIntoCache() const;
 
     Q_DECLARE_PRIVATE(QGeoTileFetcher)
     Q_DISABLE_COPY(QGeoTileFetcher)
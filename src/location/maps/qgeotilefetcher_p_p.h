@@ -53,26 +53,103 @@
 #include <QMutex>
 #include <QMutexLocker>
 #include <QHash>
+#include <QVector>
+#include <QElapsedTimer>
 #include "qgeomaptype_p.h"
+#include "qgeotilespec_p.h"
+#include "qgeotiledmappingmanagerengine_p.h"
 
 QT_BEGIN_NAMESPACE
 
-class QGeoTileSpec;
 class QGeoTiledMapReply;
 class QGeoTileCache;
 class QGeoTiledMappingManagerEngine;
 
+struct QGeoTileFetchRequest
+{
+    QGeoTileSpec spec;
+    bool prefetch;
+    int level;
+    double distance;
+    quint64 serial;
+};
+
+// orders the heap so that its front holds tiles needed now before prefetched
+// ones, then the closest zoom level and then the closest tile, ties are served
+// in the order they were queued
+inline bool operator<(const QGeoTileFetchRequest &lhs, const QGeoTileFetchRequest &rhs)
+{
+    if (lhs.prefetch != rhs.prefetch)
+        return lhs.prefetch;
+    if (lhs.level != rhs.level)
+        return lhs.level > rhs.level;
+    if (lhs.distance != rhs.distance)
+        return lhs.distance > rhs.distance;
+    return lhs.serial > rhs.serial;
+}
+
+struct QGeoTileFetchHost
+{
+    QGeoTileFetchHost() : inFlight(0), prefetchInFlight(0) {}
+
+    QVector<QGeoTileFetchRequest> heap;
+    int inFlight;
+    int prefetchInFlight;
+};
+
+struct QGeoTileFetchInFlight
+{
+    QGeoTileFetchInFlight() : reply(0), prefetch(false), firstByte(false) {}
+
+    QGeoTiledMapReply *reply;
+    QString host;
+    QElapsedTimer started;
+    bool prefetch;
+    bool firstByte;
+};
+
 class QGeoTileFetcherPrivate
 {
 public:
     QGeoTileFetcherPrivate();
     virtual ~QGeoTileFetcherPrivate();
 
+    void prioritize(QGeoTileFetchRequest &request) const;
+    void enqueue(const QString &host, const QGeoTileSpec &spec, bool prefetch = false);
+    void releaseSlot(const QGeoTileFetchInFlight &request);
+    void rebuildQueues();
+    void recordFirstByte(QGeoTileFetchInFlight &request);
+
     bool enabled_;
     QBasicTimer timer_;
-    QMutex queueMutex_;
-    QList<QGeoTileSpec> queue_;
-    QHash<QGeoTileSpec, QGeoTiledMapReply *> invmap_;
+    mutable QMutex queueMutex_;
+
+    // the per host heaps may hold stale entries for cancelled tiles, only the
+    // entry whose serial matches queued_ is live
+    QHash<QGeoTileSpec, quint64> queued_;
+    QHash<QString, QGeoTileFetchHost> hosts_;
+    // tiles queued or in flight only with low priority, with the reasons
+    enum LowPriorityReason {
+        Prefetch = 0x1,
+        Download = 0x2
+    };
+    QHash<QGeoTileSpec, int> lowPriority_;
+    int heapEntries_;
+    quint64 nextSerial_;
+    int maxRequestsPerHost_;
+
+    bool hasCenter_;
+    double centerX_;
+    double centerY_;
+    int centerZoom_;
+
+    QHash<QGeoTileSpec, QGeoTileFetchInFlight> invmap_;
+    int inFlightCount_;
+    qint64 firstByteTotal_;
+    int firstByteSamples_;
+
+    QGeoTileCache *tileCache_;
+    QGeoTiledMappingManagerEngine::CacheAreas cacheHint_;
 
 private:
     Q_DISABLE_COPY(QGeoTileFetcherPrivate)
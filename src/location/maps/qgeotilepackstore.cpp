@@ -0,0 +1,651 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtLocation module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia. For licensing terms and
+** conditions see http://qt.digia.com/licensing. For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights. These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+#include "qgeotilepackstore_p.h"
+
+#include <QDataStream>
+#include <QRunnable>
+#include <QThread>
+#include <QDebug>
+
+#include <algorithm>
+
+QT_BEGIN_NAMESPACE
+
+static const quint32 PackMagic = 0x50544751; // "QGTP"
+static const quint32 PackVersion = 1;
+static const qint64 PackHeaderSize = 8;
+
+static const quint8 TileRecord = 1;
+static const quint8 TombstoneRecord = 2;
+
+// Compaction only starts once there is a fair amount of dead data and it
+// outweighs the live data, so the pack never grows beyond roughly twice the
+// size of the tiles it holds.
+static const qint64 MinCompactionBytes = 4 * 1024 * 1024;
+
+static QByteArray packHeader()
+{
+    QByteArray header;
+    QDataStream stream(&header, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream << PackMagic << PackVersion;
+    return header;
+}
+
+static QByteArray recordHeader(const QGeoTileSpec &spec, const QString &format,
+                               int length, bool tombstone)
+{
+    QByteArray header;
+    QDataStream stream(&header, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream << (tombstone ? TombstoneRecord : TileRecord)
+           << spec.plugin()
+           << qint32(spec.mapId())
+           << qint32(spec.zoom())
+           << qint32(spec.x())
+           << qint32(spec.y())
+           << qint32(spec.version());
+    if (!tombstone)
+        stream << format << quint32(length);
+    return header;
+}
+
+/* A compaction swaps in the new pack by moving the old one aside first, so
+ * that one of the two is complete at any point. If the pack is missing,
+ * a crash interrupted the swap after the new pack had been written, so the
+ * new pack is moved in, or failing that the old one is moved back. */
+static void recoverPack(const QString &fileName)
+{
+    const QString compactName = fileName + QLatin1String(".compact");
+    const QString oldName = fileName + QLatin1String(".old");
+
+    if (!QFile::exists(fileName)) {
+        if (!(QFile::exists(compactName) && QFile::rename(compactName, fileName))
+                && QFile::exists(oldName)) {
+            QFile::rename(oldName, fileName);
+        }
+    }
+
+    // left over from a compaction which didn't finish, or from a swap
+    // which finished up to removing the old pack
+    QFile::remove(compactName);
+    QFile::remove(oldName);
+}
+
+struct QGeoTilePackCompactItem
+{
+    QGeoTileSpec spec;
+    qint64 offset;
+    int length;
+    QString format;
+};
+
+static bool compactItemLessThan(const QGeoTilePackCompactItem &a, const QGeoTilePackCompactItem &b)
+{
+    return a.offset < b.offset;
+}
+
+/* Copies the live tiles of a pack, as they were when the compaction started,
+ * into a new pack file. Everything below snapshotEnd is never modified again
+ * since the pack is append-only, so this can run without any locking. */
+class QGeoTilePackCompactJob : public QRunnable
+{
+public:
+    QGeoTilePackCompactJob(QGeoTilePackStore *store, const QString &fileName,
+                           const QString &packName, qint64 snapshotEnd,
+                           const QList<QGeoTilePackCompactItem> &items)
+        : store_(store), fileName_(fileName), packName_(packName),
+          snapshotEnd_(snapshotEnd), items_(items) {}
+
+    void run()
+    {
+        // read the source sequentially
+        std::sort(items_.begin(), items_.end(), compactItemLessThan);
+
+        QFile source(fileName_);
+        QFile target(packName_);
+        bool ok = source.open(QIODevice::ReadOnly)
+                && target.open(QIODevice::WriteOnly | QIODevice::Truncate);
+
+        if (ok) {
+            QByteArray header = packHeader();
+            ok = (target.write(header) == header.size());
+        }
+
+        for (int i = 0; ok && i < items_.size(); ++i) {
+            const QGeoTilePackCompactItem &item = items_.at(i);
+            if (!source.seek(item.offset)) {
+                ok = false;
+                break;
+            }
+            QByteArray bytes = source.read(item.length);
+            QByteArray header = recordHeader(item.spec, item.format, item.length, false);
+            ok = (bytes.size() == item.length)
+                    && (target.write(header) == header.size())
+                    && (target.write(bytes) == bytes.size());
+        }
+
+        target.close();
+        if (!ok)
+            target.remove();
+
+        QMetaObject::invokeMethod(store_, "compactionFinished", Qt::QueuedConnection,
+                                  Q_ARG(QString, packName_),
+                                  Q_ARG(qint64, snapshotEnd_),
+                                  Q_ARG(bool, ok));
+    }
+
+private:
+    // the store waits for this job in its destructor
+    QGeoTilePackStore *store_;
+    QString fileName_;
+    QString packName_;
+    qint64 snapshotEnd_;
+    QList<QGeoTilePackCompactItem> items_;
+};
+
+QGeoTilePackStore::QGeoTilePackStore(const QString &fileName, QObject *parent)
+    : QObject(parent),
+      mutex_(QMutex::Recursive),
+      fileName_(fileName),
+      maxPendingBytes_(256 * 1024),
+      fileSize_(0),
+      mapped_(0),
+      mappedSize_(0),
+      liveBytes_(0),
+      deadBytes_(0),
+      compacting_(false),
+      compactQueued_(false)
+{
+    flushTimer_.setSingleShot(true);
+    flushTimer_.setInterval(1000);
+    connect(&flushTimer_, SIGNAL(timeout()), this, SLOT(flush()));
+
+    compactPool_.setMaxThreadCount(1);
+}
+
+QGeoTilePackStore::~QGeoTilePackStore()
+{
+    close();
+    compactPool_.waitForDone();
+    QFile::remove(fileName_ + QLatin1String(".compact"));
+}
+
+QString QGeoTilePackStore::fileName() const
+{
+    return fileName_;
+}
+
+bool QGeoTilePackStore::open()
+{
+    QMutexLocker locker(&mutex_);
+
+    if (file_.isOpen())
+        return true;
+
+    recoverPack(fileName_);
+
+    file_.setFileName(fileName_);
+    if (!file_.open(QIODevice::ReadWrite)) {
+        qWarning() << "Unable to open tile pack " << fileName_;
+        return false;
+    }
+
+    if (!scan()) {
+        unmap();
+        file_.close();
+        return false;
+    }
+
+    return true;
+}
+
+void QGeoTilePackStore::close()
+{
+    QMutexLocker locker(&mutex_);
+
+    if (!file_.isOpen())
+        return;
+
+    flush();
+    unmap();
+    file_.close();
+
+    index_.clear();
+    liveBytes_ = 0;
+    deadBytes_ = 0;
+    fileSize_ = 0;
+}
+
+bool QGeoTilePackStore::isOpen() const
+{
+    QMutexLocker locker(&mutex_);
+    return file_.isOpen();
+}
+
+bool QGeoTilePackStore::scan()
+{
+    index_.clear();
+    liveBytes_ = 0;
+    deadBytes_ = 0;
+    fileSize_ = file_.size();
+
+    if (fileSize_ == 0) {
+        QByteArray header = packHeader();
+        if (file_.write(header) != header.size())
+            return false;
+        file_.flush();
+        fileSize_ = header.size();
+        return true;
+    }
+
+    if (!map(fileSize_))
+        return false;
+
+    QByteArray data = QByteArray::fromRawData(reinterpret_cast<const char *>(mapped_), fileSize_);
+    QDataStream stream(data);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    stream >> magic >> version;
+    if (stream.status() != QDataStream::Ok || magic != PackMagic || version != PackVersion) {
+        qWarning() << "Unsupported tile pack " << fileName_;
+        return false;
+    }
+
+    qint64 pos = PackHeaderSize;
+    while (pos < fileSize_) {
+        quint8 type = 0;
+        QString plugin;
+        qint32 mapId, zoom, x, y, tileVersion;
+        QString format;
+        quint32 length = 0;
+
+        stream >> type >> plugin >> mapId >> zoom >> x >> y >> tileVersion;
+        if (type == TileRecord)
+            stream >> format >> length;
+
+        if (stream.status() != QDataStream::Ok
+                || (type != TileRecord && type != TombstoneRecord))
+            break;
+
+        qint64 dataOffset = stream.device()->pos();
+        if (dataOffset + length > fileSize_)
+            break;
+        if (length > 0 && stream.skipRawData(length) != int(length))
+            break;
+
+        int recordLength = int(dataOffset + length - pos);
+        QGeoTileSpec spec(plugin, mapId, zoom, x, y, tileVersion);
+
+        // later records supersede earlier ones for the same tile
+        QHash<QGeoTileSpec, Entry>::iterator it = index_.find(spec);
+        if (it != index_.end()) {
+            liveBytes_ -= it->recordLength;
+            deadBytes_ += it->recordLength;
+            index_.erase(it);
+        }
+
+        if (type == TileRecord) {
+            Entry entry;
+            entry.offset = dataOffset;
+            entry.length = length;
+            entry.recordLength = recordLength;
+            entry.format = format;
+            index_.insert(spec, entry);
+            liveBytes_ += recordLength;
+        } else {
+            deadBytes_ += recordLength;
+        }
+
+        pos = dataOffset + length;
+    }
+
+    if (pos < fileSize_) {
+        // the last record was cut short, most likely by a crash during a write
+        qWarning() << "Truncating damaged tile pack " << fileName_ << " at " << pos;
+        unmap();
+        file_.resize(pos);
+        fileSize_ = pos;
+    }
+
+    return true;
+}
+
+bool QGeoTilePackStore::map(qint64 end)
+{
+    if (mapped_ && end <= mappedSize_)
+        return true;
+
+    unmap();
+    mapped_ = file_.map(0, fileSize_);
+    if (!mapped_)
+        return false;
+    mappedSize_ = fileSize_;
+    return end <= mappedSize_;
+}
+
+void QGeoTilePackStore::unmap()
+{
+    if (mapped_)
+        file_.unmap(mapped_);
+    mapped_ = 0;
+    mappedSize_ = 0;
+}
+
+QList<QGeoTileSpec> QGeoTilePackStore::tiles() const
+{
+    QMutexLocker locker(&mutex_);
+    return index_.keys();
+}
+
+bool QGeoTilePackStore::contains(const QGeoTileSpec &spec) const
+{
+    QMutexLocker locker(&mutex_);
+    return index_.contains(spec);
+}
+
+int QGeoTilePackStore::size(const QGeoTileSpec &spec) const
+{
+    QMutexLocker locker(&mutex_);
+    QHash<QGeoTileSpec, Entry>::const_iterator it = index_.constFind(spec);
+    if (it == index_.constEnd())
+        return -1;
+    return it->length;
+}
+
+QString QGeoTilePackStore::format(const QGeoTileSpec &spec) const
+{
+    QMutexLocker locker(&mutex_);
+    QHash<QGeoTileSpec, Entry>::const_iterator it = index_.constFind(spec);
+    if (it == index_.constEnd())
+        return QString();
+    return it->format;
+}
+
+QByteArray QGeoTilePackStore::read(const QGeoTileSpec &spec)
+{
+    QMutexLocker locker(&mutex_);
+    QHash<QGeoTileSpec, Entry>::const_iterator it = index_.constFind(spec);
+    if (it == index_.constEnd())
+        return QByteArray();
+
+    const Entry &entry = it.value();
+
+    // not flushed yet
+    if (entry.offset >= fileSize_)
+        return pending_.mid(int(entry.offset - fileSize_), entry.length);
+
+    if (!map(entry.offset + entry.length))
+        return QByteArray();
+
+    return QByteArray(reinterpret_cast<const char *>(mapped_ + entry.offset), entry.length);
+}
+
+void QGeoTilePackStore::appendRecord(const QGeoTileSpec &spec, const QByteArray &bytes,
+                                     const QString &format, bool tombstone)
+{
+    QByteArray header = recordHeader(spec, format, bytes.size(), tombstone);
+    qint64 recordOffset = fileSize_ + pending_.size();
+
+    pending_ += header;
+
+    if (tombstone) {
+        deadBytes_ += header.size();
+    } else {
+        pending_ += bytes;
+
+        Entry entry;
+        entry.offset = recordOffset + header.size();
+        entry.length = bytes.size();
+        entry.recordLength = header.size() + bytes.size();
+        entry.format = format;
+        index_.insert(spec, entry);
+        liveBytes_ += entry.recordLength;
+    }
+
+    if (pending_.size() >= maxPendingBytes_)
+        flush();
+    else if (!flushTimer_.isActive())
+        scheduleFlush();
+}
+
+void QGeoTilePackStore::scheduleFlush()
+{
+    // the timer can only be started from the thread it lives in
+    if (QThread::currentThread() == thread())
+        flushTimer_.start();
+    else
+        QMetaObject::invokeMethod(&flushTimer_, "start", Qt::QueuedConnection);
+}
+
+void QGeoTilePackStore::write(const QGeoTileSpec &spec, const QByteArray &bytes, const QString &format)
+{
+    QMutexLocker locker(&mutex_);
+
+    if (!file_.isOpen())
+        return;
+
+    // the new record supersedes the old one, no tombstone needed
+    QHash<QGeoTileSpec, Entry>::iterator it = index_.find(spec);
+    if (it != index_.end()) {
+        liveBytes_ -= it->recordLength;
+        deadBytes_ += it->recordLength;
+        index_.erase(it);
+    }
+
+    appendRecord(spec, bytes, format, false);
+    maybeCompact();
+}
+
+void QGeoTilePackStore::remove(const QGeoTileSpec &spec)
+{
+    QMutexLocker locker(&mutex_);
+
+    if (!file_.isOpen())
+        return;
+
+    QHash<QGeoTileSpec, Entry>::iterator it = index_.find(spec);
+    if (it == index_.end())
+        return;
+
+    liveBytes_ -= it->recordLength;
+    deadBytes_ += it->recordLength;
+    index_.erase(it);
+
+    appendRecord(spec, QByteArray(), QString(), true);
+    maybeCompact();
+}
+
+void QGeoTilePackStore::flush()
+{
+    QMutexLocker locker(&mutex_);
+
+    // if called from another thread the timer simply fires with nothing to do
+    if (QThread::currentThread() == thread())
+        flushTimer_.stop();
+
+    if (pending_.isEmpty() || !file_.isOpen())
+        return;
+
+    if (!file_.seek(fileSize_) || file_.write(pending_) != pending_.size()) {
+        qWarning() << "Unable to write tile pack " << fileName_;
+        // don't leave a partial record behind, the index still points into
+        // pending_ for these tiles, so they are dropped
+        file_.resize(fileSize_);
+        QHash<QGeoTileSpec, Entry>::iterator it = index_.begin();
+        while (it != index_.end()) {
+            if (it->offset >= fileSize_) {
+                liveBytes_ -= it->recordLength;
+                it = index_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        pending_.clear();
+        return;
+    }
+
+    file_.flush();
+    fileSize_ += pending_.size();
+    pending_.clear();
+}
+
+void QGeoTilePackStore::setMaxPendingBytes(int bytes)
+{
+    QMutexLocker locker(&mutex_);
+    maxPendingBytes_ = bytes;
+}
+
+int QGeoTilePackStore::maxPendingBytes() const
+{
+    return maxPendingBytes_;
+}
+
+qint64 QGeoTilePackStore::liveBytes() const
+{
+    QMutexLocker locker(&mutex_);
+    return liveBytes_;
+}
+
+qint64 QGeoTilePackStore::deadBytes() const
+{
+    QMutexLocker locker(&mutex_);
+    return deadBytes_;
+}
+
+bool QGeoTilePackStore::isCompacting() const
+{
+    QMutexLocker locker(&mutex_);
+    return compacting_;
+}
+
+void QGeoTilePackStore::maybeCompact()
+{
+    if (compacting_ || compactQueued_
+            || deadBytes_ < MinCompactionBytes || deadBytes_ < liveBytes_)
+        return;
+
+    // don't start it from within a cache eviction
+    compactQueued_ = true;
+    QMetaObject::invokeMethod(this, "compact", Qt::QueuedConnection);
+}
+
+void QGeoTilePackStore::compact()
+{
+    QMutexLocker locker(&mutex_);
+
+    compactQueued_ = false;
+
+    if (!file_.isOpen() || compacting_)
+        return;
+
+    flush();
+
+    QList<QGeoTilePackCompactItem> items;
+    items.reserve(index_.size());
+    QHash<QGeoTileSpec, Entry>::const_iterator it = index_.constBegin();
+    for (; it != index_.constEnd(); ++it) {
+        QGeoTilePackCompactItem item;
+        item.spec = it.key();
+        item.offset = it->offset;
+        item.length = it->length;
+        item.format = it->format;
+        items.append(item);
+    }
+
+    compacting_ = true;
+    compactPool_.start(new QGeoTilePackCompactJob(this, fileName_,
+                                                  fileName_ + QLatin1String(".compact"),
+                                                  fileSize_, items));
+}
+
+void QGeoTilePackStore::compactionFinished(const QString &packName, qint64 snapshotEnd, bool ok)
+{
+    QMutexLocker locker(&mutex_);
+
+    compacting_ = false;
+
+    if (!ok || !file_.isOpen()) {
+        if (!ok)
+            qWarning() << "Compaction of tile pack " << fileName_ << " failed";
+        QFile::remove(packName);
+        return;
+    }
+
+    flush();
+
+    // carry over whatever was appended while the copy was running. This
+    // includes tombstones for tiles which were removed in the meantime.
+    QFile target(packName);
+    if (!target.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        QFile::remove(packName);
+        return;
+    }
+    if (fileSize_ > snapshotEnd) {
+        if (!map(fileSize_)
+                || target.write(reinterpret_cast<const char *>(mapped_ + snapshotEnd),
+                                fileSize_ - snapshotEnd) != fileSize_ - snapshotEnd) {
+            target.close();
+            target.remove();
+            return;
+        }
+    }
+    target.close();
+
+    // move the old pack aside rather than removing it, so that a crash in
+    // between leaves a complete pack for open() to recover
+    const QString oldName = fileName_ + QLatin1String(".old");
+    close();
+    QFile::remove(oldName);
+    if (!QFile::rename(fileName_, oldName)) {
+        qWarning() << "Unable to replace tile pack " << fileName_;
+        QFile::remove(packName);
+        open();
+        return;
+    }
+    if (!QFile::rename(packName, fileName_)) {
+        qWarning() << "Unable to replace tile pack " << fileName_;
+        QFile::remove(packName);
+        QFile::rename(oldName, fileName_);
+        open();
+        return;
+    }
+    QFile::remove(oldName);
+    open();
+
+    emit compacted();
+}
+
+QT_END_NAMESPACE
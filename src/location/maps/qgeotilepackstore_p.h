@@ -0,0 +1,161 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtLocation module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia. For licensing terms and
+** conditions see http://qt.digia.com/licensing. For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights. These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+#ifndef QGEOTILEPACKSTORE_P_H
+#define QGEOTILEPACKSTORE_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtLocation/qlocationglobal.h>
+
+#include <QObject>
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QTimer>
+#include <QThreadPool>
+#include <QMutex>
+
+#include "qgeotilespec_p.h"
+
+QT_BEGIN_NAMESPACE
+
+/*
+ * QGeoTilePackStore
+ *
+ * Disk storage for map tiles which keeps all tiles of a cache in a single,
+ * append-only pack file instead of one file per tile.
+ *
+ * The pack file is a header followed by a sequence of records. A record is
+ * either a tile (spec, format and image bytes) or a tombstone (spec only)
+ * marking an earlier tile record as deleted. Opening the store scans the
+ * record headers of the memory-mapped file once to build an in-memory index,
+ * after which lookups are a single hash access.
+ *
+ * Writes are collected in a buffer and appended to the file in batches.
+ * Removed tiles leave dead records behind; once they make up a large enough
+ * part of the file the live records are copied into a new pack on a worker
+ * thread, and the file is swapped when the copy is done.
+ *
+ * All functions may be called from any thread.
+ */
+class Q_LOCATION_EXPORT QGeoTilePackStore : public QObject
+{
+    Q_OBJECT
+public:
+    explicit QGeoTilePackStore(const QString &fileName, QObject *parent = 0);
+    ~QGeoTilePackStore();
+
+    bool open();
+    void close();
+    bool isOpen() const;
+    QString fileName() const;
+
+    QList<QGeoTileSpec> tiles() const;
+    bool contains(const QGeoTileSpec &spec) const;
+    int size(const QGeoTileSpec &spec) const;
+    QString format(const QGeoTileSpec &spec) const;
+
+    QByteArray read(const QGeoTileSpec &spec);
+    void write(const QGeoTileSpec &spec, const QByteArray &bytes, const QString &format);
+    void remove(const QGeoTileSpec &spec);
+
+    void setMaxPendingBytes(int bytes);
+    int maxPendingBytes() const;
+
+    qint64 liveBytes() const;
+    qint64 deadBytes() const;
+    bool isCompacting() const;
+
+public Q_SLOTS:
+    void flush();
+    void compact();
+
+Q_SIGNALS:
+    void compacted();
+
+private Q_SLOTS:
+    void compactionFinished(const QString &packName, qint64 snapshotEnd, bool ok);
+
+private:
+    struct Entry
+    {
+        qint64 offset;
+        int length;
+        int recordLength;
+        QString format;
+    };
+
+    bool scan();
+    bool map(qint64 end);
+    void unmap();
+    void appendRecord(const QGeoTileSpec &spec, const QByteArray &bytes,
+                      const QString &format, bool tombstone);
+    void maybeCompact();
+    void scheduleFlush();
+
+    mutable QMutex mutex_;
+    QString fileName_;
+    QFile file_;
+    QHash<QGeoTileSpec, Entry> index_;
+
+    // records appended since the last flush(), starting at fileSize_
+    QByteArray pending_;
+    int maxPendingBytes_;
+    QTimer flushTimer_;
+    qint64 fileSize_;
+
+    uchar *mapped_;
+    qint64 mappedSize_;
+
+    qint64 liveBytes_;
+    qint64 deadBytes_;
+
+    QThreadPool compactPool_;
+    bool compacting_;
+    bool compactQueued_;
+
+    Q_DISABLE_COPY(QGeoTilePackStore)
+};
+
+QT_END_NAMESPACE
+
+#endif // QGEOTILEPACKSTORE_P_H
@@ -0,0 +1,466 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtLocation module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia. For licensing terms and
+** conditions see http://qt.digia.com/licensing. For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights. These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+#include "qgeotileprefetcher_p.h"
+#include "qgeocameradata_p.h"
+#include "qgeotilespec_p.h"
+#include "qgeomaptype_p.h"
+
+#include <QtPositioning/QGeoCoordinate>
+#include <QtPositioning/private/qgeoprojection_p.h>
+#include <QtPositioning/private/qdoublevector2d_p.h>
+
+#include <QVector>
+#include <QSet>
+
+#include <cmath>
+
+QT_BEGIN_NAMESPACE
+
+// only this much camera history is used to estimate the motion
+static const qint64 SampleWindow = 1000;
+static const int MaxSamples = 16;
+// samples closer together than this give a too noisy velocity
+static const qint64 MinSampleSpan = 50;
+// the path ahead is sampled once per tile, up to this many times
+static const int MaxPathPoints = 256;
+
+struct QGeoCameraSample
+{
+    QDoubleVector2D center;
+    double zoom;
+    qint64 msecs;
+};
+
+class QGeoTilePrefetcherPrivate {
+public:
+    QGeoTilePrefetcherPrivate();
+    ~QGeoTilePrefetcherPrivate();
+
+    QSize screenSize_;
+    int tileSize_;
+    int minZoom_;
+    int maxZoom_;
+
+    QString pluginString_;
+    QGeoMapType mapType_;
+    int mapVersion_;
+
+    int budget_;
+    int tileBytes_;
+    int lookAhead_;
+
+    QList<QGeoCoordinate> route_;
+    // mercator positions of the route, unwrapped so that consecutive points
+    // never cross the date line
+    QVector<QDoubleVector2D> routePoints_;
+
+    QList<QGeoCameraSample> samples_;
+
+    bool motion(QDoubleVector2D *velocity, double *zoomRate) const;
+    QVector<QDoubleVector2D> pathFromMotion(const QDoubleVector2D &center,
+                                            const QDoubleVector2D &velocity,
+                                            double distance, double step) const;
+    QVector<QDoubleVector2D> pathAlongRoute(const QDoubleVector2D &center,
+                                            const QDoubleVector2D &velocity,
+                                            double distance, double step) const;
+    QGeoTileSpec tileAt(int zoom, int x, int y) const;
+};
+
+static double wrappedDelta(double delta, double side)
+{
+    if (delta > side / 2)
+        return delta - side;
+    if (delta < -side / 2)
+        return delta + side;
+    return delta;
+}
+
+QGeoTilePrefetcher::QGeoTilePrefetcher()
+    : d_ptr(new QGeoTilePrefetcherPrivate()) {}
+
+QGeoTilePrefetcher::~QGeoTilePrefetcher()
+{
+    delete d_ptr;
+}
+
+void QGeoTilePrefetcher::setScreenSize(const QSize &size)
+{
+    Q_D(QGeoTilePrefetcher);
+    d->screenSize_ = size;
+}
+
+void QGeoTilePrefetcher::setTileSize(int tileSize)
+{
+    Q_D(QGeoTilePrefetcher);
+    d->tileSize_ = tileSize;
+}
+
+void QGeoTilePrefetcher::setMinimumZoomLevel(int minZoom)
+{
+    Q_D(QGeoTilePrefetcher);
+    d->minZoom_ = minZoom;
+}
+
+void QGeoTilePrefetcher::setMaximumZoomLevel(int maxZoom)
+{
+    Q_D(QGeoTilePrefetcher);
+    d->maxZoom_ = maxZoom;
+}
+
+void QGeoTilePrefetcher::setPluginString(const QString &pluginString)
+{
+    Q_D(QGeoTilePrefetcher);
+    d->pluginString_ = pluginString;
+}
+
+void QGeoTilePrefetcher::setMapType(const QGeoMapType &mapType)
+{
+    Q_D(QGeoTilePrefetcher);
+    d->mapType_ = mapType;
+}
+
+void QGeoTilePrefetcher::setMapVersion(int mapVersion)
+{
+    Q_D(QGeoTilePrefetcher);
+    d->mapVersion_ = mapVersion;
+}
+
+void QGeoTilePrefetcher::setBandwidthBudget(int bytesPerSecond)
+{
+    Q_D(QGeoTilePrefetcher);
+    d->budget_ = qMax(0, bytesPerSecond);
+}
+
+int QGeoTilePrefetcher::bandwidthBudget() const
+{
+    Q_D(const QGeoTilePrefetcher);
+    return d->budget_;
+}
+
+void QGeoTilePrefetcher::setEstimatedTileBytes(int bytes)
+{
+    Q_D(QGeoTilePrefetcher);
+    d->tileBytes_ = qMax(1, bytes);
+}
+
+int QGeoTilePrefetcher::estimatedTileBytes() const
+{
+    Q_D(const QGeoTilePrefetcher);
+    return d->tileBytes_;
+}
+
+void QGeoTilePrefetcher::setLookAhead(int msecs)
+{
+    Q_D(QGeoTilePrefetcher);
+    d->lookAhead_ = qMax(0, msecs);
+}
+
+int QGeoTilePrefetcher::lookAhead() const
+{
+    Q_D(const QGeoTilePrefetcher);
+    return d->lookAhead_;
+}
+
+void QGeoTilePrefetcher::setRoute(const QList<QGeoCoordinate> &path)
+{
+    Q_D(QGeoTilePrefetcher);
+
+    d->route_ = path;
+    d->routePoints_.clear();
+    d->routePoints_.reserve(path.size());
+
+    foreach (const QGeoCoordinate &coord, path) {
+        if (!coord.isValid())
+            continue;
+        QDoubleVector2D p = QGeoProjection::coordToMercator(coord);
+        if (!d->routePoints_.isEmpty()) {
+            const QDoubleVector2D &last = d->routePoints_.last();
+            p.setX(last.x() + wrappedDelta(p.x() - last.x(), 1.0));
+        }
+        d->routePoints_.append(p);
+    }
+}
+
+QList<QGeoCoordinate> QGeoTilePrefetcher::route() const
+{
+    Q_D(const QGeoTilePrefetcher);
+    return d->route_;
+}
+
+void QGeoTilePrefetcher::addCameraSample(const QGeoCameraData &camera, qint64 msecs)
+{
+    Q_D(QGeoTilePrefetcher);
+
+    QGeoCameraSample sample;
+    sample.center = QGeoProjection::coordToMercator(camera.center());
+    sample.zoom = camera.zoomLevel();
+    sample.msecs = msecs;
+
+    d->samples_.append(sample);
+    while (d->samples_.size() > MaxSamples
+           || (d->samples_.size() > 2 && msecs - d->samples_.first().msecs > SampleWindow))
+        d->samples_.removeFirst();
+}
+
+void QGeoTilePrefetcher::clearCameraSamples()
+{
+    Q_D(QGeoTilePrefetcher);
+    d->samples_.clear();
+}
+
+/*
+ * Returns the tiles ahead of the camera, most urgent first. Tiles covered by
+ * the viewport at the last camera position are left out.
+ */
+QList<QGeoTileSpec> QGeoTilePrefetcher::predictedTiles() const
+{
+    Q_D(const QGeoTilePrefetcher);
+
+    QList<QGeoTileSpec> result;
+
+    if (d->samples_.isEmpty() || d->tileSize_ <= 0 || d->screenSize_.isEmpty())
+        return result;
+
+    qint64 maxTiles = qint64(d->budget_) * d->lookAhead_ / 1000 / d->tileBytes_;
+    if (maxTiles <= 0)
+        return result;
+
+    const QGeoCameraSample &now = d->samples_.last();
+    int zoom = qBound(d->minZoom_, static_cast<int>(std::floor(now.zoom)), d->maxZoom_);
+    double side = std::pow(2.0, zoom);
+    double step = 1.0 / side;
+
+    QDoubleVector2D velocity;
+    double zoomRate = 0.0;
+    bool moving = d->motion(&velocity, &zoomRate);
+
+    // half the viewport in tiles of the current level
+    double scale = std::pow(2.0, now.zoom - zoom);
+    int radiusX = static_cast<int>(std::ceil(d->screenSize_.width() / (d->tileSize_ * scale) / 2.0));
+    int radiusY = static_cast<int>(std::ceil(d->screenSize_.height() / (d->tileSize_ * scale) / 2.0));
+
+    double distance = moving ? velocity.length() * d->lookAhead_ : 0.0;
+
+    QVector<QDoubleVector2D> path;
+    if (d->routePoints_.size() >= 2) {
+        // along a route look at least one screen ahead, even when stopped
+        distance = qMax(distance, qMax(radiusX, radiusY) * 2 * step);
+        path = d->pathAlongRoute(now.center, velocity, distance, step);
+    } else if (moving && distance >= step / 2) {
+        path = d->pathFromMotion(now.center, velocity, distance, step);
+    }
+
+    if (path.isEmpty())
+        return result;
+
+    int nextZoom = zoomRate < 0.0 ? zoom - 1 : zoom + 1;
+    if (nextZoom < d->minZoom_ || nextZoom > d->maxZoom_)
+        nextZoom = zoom;
+    double nextSide = std::pow(2.0, nextZoom);
+
+    int centerX = static_cast<int>(std::floor(now.center.x() * side));
+    int centerY = static_cast<int>(std::floor(now.center.y() * side));
+    int sideLength = static_cast<int>(side);
+    int nextSideLength = static_cast<int>(nextSide);
+
+    QSet<QGeoTileSpec> seen;
+
+    foreach (const QDoubleVector2D &point, path) {
+        int px = static_cast<int>(std::floor(point.x() * side));
+        int py = static_cast<int>(std::floor(point.y() * side));
+
+        // the viewport as it will be around this point
+        for (int y = py - radiusY; y <= py + radiusY; ++y) {
+            if (y < 0 || y >= sideLength)
+                continue;
+            for (int x = px - radiusX; x <= px + radiusX; ++x) {
+                if (qAbs(wrappedDelta(x - centerX, side)) <= radiusX
+                        && qAbs(y - centerY) <= radiusY)
+                    continue;
+
+                int wx = ((x % sideLength) + sideLength) % sideLength;
+                QGeoTileSpec spec = d->tileAt(zoom, wx, y);
+                if (seen.contains(spec))
+                    continue;
+                seen.insert(spec);
+                result.append(spec);
+                if (result.size() >= maxTiles)
+                    return result;
+            }
+        }
+
+        if (nextZoom == zoom)
+            continue;
+
+        // and the middle of it one level further in
+        int nx = static_cast<int>(std::floor(point.x() * nextSide));
+        int ny = static_cast<int>(std::floor(point.y() * nextSide));
+        for (int y = ny - 1; y <= ny + 1; ++y) {
+            if (y < 0 || y >= nextSideLength)
+                continue;
+            for (int x = nx - 1; x <= nx + 1; ++x) {
+                int wx = ((x % nextSideLength) + nextSideLength) % nextSideLength;
+                QGeoTileSpec spec = d->tileAt(nextZoom, wx, y);
+                if (seen.contains(spec))
+                    continue;
+                seen.insert(spec);
+                result.append(spec);
+                if (result.size() >= maxTiles)
+                    return result;
+            }
+        }
+    }
+
+    return result;
+}
+
+QGeoTilePrefetcherPrivate::QGeoTilePrefetcherPrivate()
+    : tileSize_(0),
+      minZoom_(0),
+      maxZoom_(0),
+      mapVersion_(-1),
+      budget_(256 * 1024),
+      tileBytes_(16 * 1024),
+      lookAhead_(5000) {}
+
+QGeoTilePrefetcherPrivate::~QGeoTilePrefetcherPrivate() {}
+
+/*
+ * Estimates the camera velocity in mercator units per millisecond and the
+ * zoom rate in levels per millisecond from the oldest and newest sample.
+ */
+bool QGeoTilePrefetcherPrivate::motion(QDoubleVector2D *velocity, double *zoomRate) const
+{
+    if (samples_.size() < 2)
+        return false;
+
+    const QGeoCameraSample &first = samples_.first();
+    const QGeoCameraSample &last = samples_.last();
+    qint64 span = last.msecs - first.msecs;
+    if (span < MinSampleSpan)
+        return false;
+
+    QDoubleVector2D delta(wrappedDelta(last.center.x() - first.center.x(), 1.0),
+                          last.center.y() - first.center.y());
+    *velocity = delta / span;
+    *zoomRate = (last.zoom - first.zoom) / span;
+    return true;
+}
+
+QVector<QDoubleVector2D> QGeoTilePrefetcherPrivate::pathFromMotion(const QDoubleVector2D &center,
+                                                                   const QDoubleVector2D &velocity,
+                                                                   double distance, double step) const
+{
+    QVector<QDoubleVector2D> path;
+    QDoubleVector2D direction = velocity.normalized();
+
+    for (double travelled = step; travelled <= distance && path.size() < MaxPathPoints; travelled += step)
+        path.append(center + direction * travelled);
+
+    // always look at where the camera ends up
+    if (path.isEmpty())
+        path.append(center + direction * distance);
+
+    return path;
+}
+
+QVector<QDoubleVector2D> QGeoTilePrefetcherPrivate::pathAlongRoute(const QDoubleVector2D &center,
+                                                                   const QDoubleVector2D &velocity,
+                                                                   double distance, double step) const
+{
+    QVector<QDoubleVector2D> path;
+
+    // find the point of the route closest to the camera
+    int segment = -1;
+    double bestDistance = 0.0;
+    QDoubleVector2D start;
+    QDoubleVector2D shift;
+    for (int i = 0; i + 1 < routePoints_.size(); ++i) {
+        const QDoubleVector2D &a = routePoints_.at(i);
+        const QDoubleVector2D &b = routePoints_.at(i + 1);
+
+        // compare against the copy of the camera nearest to this segment
+        QDoubleVector2D c(a.x() + wrappedDelta(center.x() - a.x(), 1.0), center.y());
+
+        QDoubleVector2D ab = b - a;
+        double lengthSquared = ab.lengthSquared();
+        double t = lengthSquared > 0.0 ? QDoubleVector2D::dotProduct(c - a, ab) / lengthSquared : 0.0;
+        t = qBound(0.0, t, 1.0);
+        QDoubleVector2D p = a + ab * t;
+        double d = (c - p).lengthSquared();
+
+        if (segment < 0 || d < bestDistance) {
+            segment = i;
+            bestDistance = d;
+            start = p;
+            shift = QDoubleVector2D(center.x() - c.x(), 0.0);
+        }
+    }
+
+    if (segment < 0)
+        return path;
+
+    // follow the route in the direction the camera moves, or forward
+    QDoubleVector2D segmentDirection = routePoints_.at(segment + 1) - routePoints_.at(segment);
+    bool forward = QDoubleVector2D::dotProduct(velocity, segmentDirection) >= 0.0;
+    int next = forward ? segment + 1 : segment;
+
+    QDoubleVector2D pos = start;
+    double toNextPoint = step;
+    double travelled = 0.0;
+    while (travelled < distance && next >= 0 && next < routePoints_.size()
+           && path.size() < MaxPathPoints) {
+        QDoubleVector2D delta = routePoints_.at(next) - pos;
+        double length = delta.length();
+        if (length >= toNextPoint) {
+            pos += delta * (toNextPoint / length);
+            travelled += toNextPoint;
+            path.append(pos + shift);
+            toNextPoint = step;
+        } else {
+            pos = routePoints_.at(next);
+            travelled += length;
+            toNextPoint -= length;
+            next += forward ? 1 : -1;
+        }
+    }
+
+    return path;
+}
+
+QGeoTileSpec QGeoTilePrefetcherPrivate::tileAt(int zoom, int x, int y) const
+{
+    return QGeoTileSpec(pluginString_, mapType_.mapId(), zoom, x, y, mapVersion_);
+}
+
+QT_END_NAMESPACE
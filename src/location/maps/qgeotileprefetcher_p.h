@@ -0,0 +1,106 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtLocation module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia. For licensing terms and
+** conditions see http://qt.digia.com/licensing. For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights. These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+#ifndef QGEOTILEPREFETCHER_P_H
+#define QGEOTILEPREFETCHER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtLocation/qlocationglobal.h>
+#include <QList>
+#include <QSize>
+
+QT_BEGIN_NAMESPACE
+
+class QGeoCameraData;
+class QGeoCoordinate;
+class QGeoTileSpec;
+class QGeoMapType;
+
+class QGeoTilePrefetcherPrivate;
+
+/*
+ * Predicts the tiles a moving camera is about to need.
+ *
+ * Camera positions are fed in as they change. The recent motion, or the route
+ * if one is set, is extrapolated for lookAhead() milliseconds and the tiles
+ * around that path are returned, at the current zoom level and at the level
+ * the camera is zooming towards. The number of tiles is capped so that
+ * fetching them over the look ahead period stays within bandwidthBudget().
+ */
+class Q_LOCATION_EXPORT QGeoTilePrefetcher {
+public:
+    QGeoTilePrefetcher();
+    ~QGeoTilePrefetcher();
+
+    void setScreenSize(const QSize &size);
+    void setTileSize(int tileSize);
+    void setMinimumZoomLevel(int minZoom);
+    void setMaximumZoomLevel(int maxZoom);
+
+    void setPluginString(const QString &pluginString);
+    void setMapType(const QGeoMapType &mapType);
+    void setMapVersion(int mapVersion);
+
+    void setBandwidthBudget(int bytesPerSecond);
+    int bandwidthBudget() const;
+    void setEstimatedTileBytes(int bytes);
+    int estimatedTileBytes() const;
+    void setLookAhead(int msecs);
+    int lookAhead() const;
+
+    void setRoute(const QList<QGeoCoordinate> &path);
+    QList<QGeoCoordinate> route() const;
+
+    void addCameraSample(const QGeoCameraData &camera, qint64 msecs);
+    void clearCameraSamples();
+
+    QList<QGeoTileSpec> predictedTiles() const;
+
+private:
+    QGeoTilePrefetcherPrivate *d_ptr;
+    Q_DECLARE_PRIVATE(QGeoTilePrefetcher)
+    Q_DISABLE_COPY(QGeoTilePrefetcher)
+};
+
+QT_END_NAMESPACE
+
+#endif // QGEOTILEPREFETCHER_P_H
@@ -0,0 +1,753 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtLocation module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia. For licensing terms and
+** conditions see http://qt.digia.com/licensing. For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights. These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+#include "qgeotileregiondownload_p.h"
+#include "qgeotilefetcher_p.h"
+#include "qgeotilecache_p.h"
+
+#include <QtPositioning/private/qgeoprojection_p.h>
+#include <QtPositioning/private/qdoublevector2d_p.h>
+
+#include <QDataStream>
+#include <QFile>
+#include <QSaveFile>
+#include <QSet>
+
+#include <algorithm>
+#include <cmath>
+
+Q_DECLARE_METATYPE(QSet<QGeoTileSpec>)
+
+QT_BEGIN_NAMESPACE
+
+static const quint32 JournalMagic = 0x5147524a; // "QGRJ"
+static const quint32 JournalVersion = 2;
+static const int JournalInterval = 2000;
+// outstanding tiles are handed to the fetcher again this often, in case a
+// map cancelled the same tile in the meantime
+static const int ResubmitInterval = 30000;
+// at most this many tiles are looked up in the cache before dispatch()
+// returns to the event loop
+static const int MaxChecksPerDispatch = 256;
+
+QGeoTileRegionDownload::QGeoTileRegionDownload(QGeoTileFetcher *fetcher, QGeoTileCache *cache,
+                                               QObject *parent)
+    : QObject(parent),
+      fetcher_(fetcher),
+      cache_(cache),
+      isRectangle_(true),
+      minZoom_(0),
+      maxZoom_(0),
+      mapId_(0),
+      mapVersion_(-1),
+      state_(Idle),
+      total_(-1),
+      rowSpansZoom_(-1),
+      rowSpansRow_(-1),
+      failed_(0),
+      skipped_(0),
+      journalDirty_(false)
+{
+    qRegisterMetaType<QGeoTileSpec>();
+    qRegisterMetaType<QSet<QGeoTileSpec> >();
+
+    cursor_.zoom = 0;
+    cursor_.row = 0;
+    cursor_.column = 0;
+    cursor_.position = 0;
+
+    journalTimer_.setInterval(JournalInterval);
+    connect(&journalTimer_, SIGNAL(timeout()), this, SLOT(writeJournal()));
+    resubmitTimer_.setInterval(ResubmitInterval);
+    connect(&resubmitTimer_, SIGNAL(timeout()), this, SLOT(resubmit()));
+
+    // the fetcher emits with its queue locked, so the replies have to be
+    // queued even if it lives in this thread
+    if (fetcher_) {
+        connect(fetcher_,
+                SIGNAL(tileFinished(QGeoTileSpec,QByteArray,QString)),
+                this,
+                SLOT(tileFinished(QGeoTileSpec,QByteArray,QString)),
+                Qt::QueuedConnection);
+        connect(fetcher_,
+                SIGNAL(tileError(QGeoTileSpec,QString)),
+                this,
+                SLOT(tileError(QGeoTileSpec,QString)),
+                Qt::QueuedConnection);
+    }
+}
+
+QGeoTileRegionDownload::~QGeoTileRegionDownload()
+{
+    if (state_ == Running) {
+        withdrawOutstanding();
+        writeJournal();
+    }
+}
+
+/*
+ * Creates a download from the journal written by an earlier one. The download
+ * is returned paused, and continues where the journal was last written once
+ * start() is called. Returns 0 if the journal cannot be read.
+ */
+QGeoTileRegionDownload *QGeoTileRegionDownload::resume(const QString &journal,
+                                                       QGeoTileFetcher *fetcher,
+                                                       QGeoTileCache *cache,
+                                                       QObject *parent)
+{
+    QGeoTileRegionDownload *download = new QGeoTileRegionDownload(fetcher, cache, parent);
+    download->setJournal(journal);
+    if (!download->readJournal()) {
+        delete download;
+        return 0;
+    }
+    download->state_ = Paused;
+    return download;
+}
+
+/*
+ * The region can only be changed while the download is not running. A
+ * rectangle crossing the dateline is downloaded on both sides of it.
+ */
+void QGeoTileRegionDownload::setRegion(const QGeoRectangle &area)
+{
+    if (state_ == Running)
+        return;
+
+    region_.clear();
+    region_ << area.topLeft() << area.bottomRight();
+    isRectangle_ = true;
+    rectangle_ = area;
+    polygon_.clear();
+    total_ = -1;
+    rowSpansZoom_ = -1;
+}
+
+/*
+ * Downloads the tiles touching the \a polygon. Consecutive points are taken to
+ * be less than half way round the world apart, so that polygons can cross the
+ * dateline.
+ */
+void QGeoTileRegionDownload::setRegion(const QList<QGeoCoordinate> &polygon)
+{
+    if (state_ == Running)
+        return;
+
+    region_ = polygon;
+    isRectangle_ = false;
+    rectangle_ = QGeoRectangle();
+    polygon_.clear();
+    polygon_.reserve(polygon.size());
+
+    double offset = 0.0;
+    double lastX = 0.0;
+    for (int i = 0; i < polygon.size(); ++i) {
+        QDoubleVector2D p = QGeoProjection::coordToMercator(polygon.at(i));
+        double x = p.x() + offset;
+        if (i > 0) {
+            if (x - lastX > 0.5) {
+                offset -= 1.0;
+                x -= 1.0;
+            } else if (x - lastX < -0.5) {
+                offset += 1.0;
+                x += 1.0;
+            }
+        }
+        polygon_.append(QPointF(x, p.y()));
+        lastX = x;
+    }
+    total_ = -1;
+    rowSpansZoom_ = -1;
+}
+
+void QGeoTileRegionDownload::setZoomRange(int minZoom, int maxZoom)
+{
+    if (state_ == Running)
+        return;
+
+    minZoom_ = qMax(0, minZoom);
+    maxZoom_ = qMin(maxZoom, 30);
+    total_ = -1;
+}
+
+void QGeoTileRegionDownload::setPluginString(const QString &pluginString)
+{
+    if (state_ != Running)
+        pluginString_ = pluginString;
+}
+
+void QGeoTileRegionDownload::setMapId(int mapId)
+{
+    if (state_ != Running)
+        mapId_ = mapId;
+}
+
+void QGeoTileRegionDownload::setMapVersion(int mapVersion)
+{
+    if (state_ != Running)
+        mapVersion_ = mapVersion;
+}
+
+void QGeoTileRegionDownload::setJournal(const QString &fileName)
+{
+    journal_ = fileName;
+}
+
+QString QGeoTileRegionDownload::journal() const
+{
+    return journal_;
+}
+
+QGeoTileRegionDownload::State QGeoTileRegionDownload::state() const
+{
+    return state_;
+}
+
+qint64 QGeoTileRegionDownload::totalTiles() const
+{
+    if (total_ < 0)
+        const_cast<QGeoTileRegionDownload *>(this)->total_ = countTiles();
+    return total_;
+}
+
+/*
+ * Returns the number of tiles that were downloaded, failed or skipped.
+ */
+qint64 QGeoTileRegionDownload::finishedTiles() const
+{
+    return cursor_.position - outstanding_.size() - withdrawn_.size();
+}
+
+qint64 QGeoTileRegionDownload::failedTiles() const
+{
+    return failed_;
+}
+
+/*
+ * Returns the number of tiles that were already in the cache.
+ */
+qint64 QGeoTileRegionDownload::skippedTiles() const
+{
+    return skipped_;
+}
+
+void QGeoTileRegionDownload::start()
+{
+    if (state_ == Running || state_ == Finished || !fetcher_)
+        return;
+
+    if (state_ == Idle || state_ == Cancelled) {
+        cursor_.zoom = minZoom_;
+        cursor_.row = 0;
+        cursor_.column = 0;
+        cursor_.position = 0;
+        failed_ = 0;
+        skipped_ = 0;
+        withdrawn_.clear();
+    }
+    totalTiles();
+
+    journalDirty_ = true;
+    journalTimer_.start();
+    resubmitTimer_.start();
+    setState(Running);
+    dispatch();
+}
+
+/*
+ * Stops downloading and writes the journal. Tiles already handed to the
+ * fetcher are cancelled and requested again by start(), before any tile
+ * after them.
+ */
+void QGeoTileRegionDownload::pause()
+{
+    if (state_ != Running)
+        return;
+
+    withdrawOutstanding();
+    journalTimer_.stop();
+    resubmitTimer_.stop();
+    journalDirty_ = true;
+    writeJournal();
+    setState(Paused);
+}
+
+/*
+ * Stops downloading and removes the journal. The tiles downloaded so far stay
+ * in the cache.
+ */
+void QGeoTileRegionDownload::cancel()
+{
+    if (state_ != Running && state_ != Paused)
+        return;
+
+    withdrawOutstanding();
+    journalTimer_.stop();
+    resubmitTimer_.stop();
+    if (!journal_.isEmpty())
+        QFile::remove(journal_);
+    journalDirty_ = false;
+    setState(Cancelled);
+}
+
+void QGeoTileRegionDownload::tileFinished(const QGeoTileSpec &spec, const QByteArray &bytes,
+                                          const QString &format)
+{
+    if (!outstanding_.remove(spec))
+        return;
+
+    // a fetcher without the cache does not store the tile itself, one with
+    // the cache stores downloads on disk whatever its cache hint
+    if (cache_ && (!fetcher_ || fetcher_->tileCache() != cache_))
+        cache_->insert(spec, bytes, format, QGeoTiledMappingManagerEngine::DiskCache);
+
+    journalDirty_ = true;
+    emit progress(finishedTiles(), total_);
+    dispatch();
+}
+
+void QGeoTileRegionDownload::tileError(const QGeoTileSpec &spec, const QString &errorString)
+{
+    Q_UNUSED(errorString)
+
+    if (!outstanding_.remove(spec))
+        return;
+
+    ++failed_;
+    journalDirty_ = true;
+    emit progress(finishedTiles(), total_);
+    dispatch();
+}
+
+/*
+ * Hands the next tiles to the fetcher, keeping twice as many tiles outstanding
+ * as it requests from one host at a time, so that it always has the next
+ * request at hand without the whole region being queued.
+ */
+void QGeoTileRegionDownload::dispatch()
+{
+    if (state_ != Running || !fetcher_)
+        return;
+
+    int window = 2 * qMax(1, fetcher_->maxRequestsPerHost());
+    int checks = 0;
+    bool exhausted = false;
+    qint64 skippedBefore = skipped_;
+
+    QSet<QGeoTileSpec> added;
+    while (outstanding_.size() < window && checks < MaxChecksPerDispatch) {
+        QGeoTileSpec spec;
+        if (!withdrawn_.isEmpty()) {
+            // already counted by the cursor, but not finished yet
+            QSet<QGeoTileSpec>::iterator it = withdrawn_.begin();
+            spec = *it;
+            withdrawn_.erase(it);
+        } else if (!nextTile(&spec)) {
+            exhausted = true;
+            break;
+        }
+        ++checks;
+
+        if (cache_ && cache_->contains(spec)) {
+            ++skipped_;
+            continue;
+        }
+
+        outstanding_.insert(spec);
+        added.insert(spec);
+    }
+
+    if (!added.isEmpty()) {
+        QMetaObject::invokeMethod(fetcher_, "updateDownloadRequests",
+                                  Qt::QueuedConnection,
+                                  Q_ARG(QSet<QGeoTileSpec>, added),
+                                  Q_ARG(QSet<QGeoTileSpec>, QSet<QGeoTileSpec>()));
+    }
+
+    if (skipped_ != skippedBefore) {
+        journalDirty_ = true;
+        emit progress(finishedTiles(), total_);
+    }
+
+    if (exhausted && outstanding_.isEmpty()) {
+        journalTimer_.stop();
+        resubmitTimer_.stop();
+        if (!journal_.isEmpty())
+            QFile::remove(journal_);
+        journalDirty_ = false;
+        setState(Finished);
+        emit finished();
+        return;
+    }
+
+    // a long run of cached tiles continues from the event loop
+    if (!exhausted && outstanding_.size() < window)
+        QTimer::singleShot(0, this, SLOT(dispatch()));
+}
+
+void QGeoTileRegionDownload::resubmit()
+{
+    if (state_ != Running || !fetcher_ || outstanding_.isEmpty())
+        return;
+
+    QMetaObject::invokeMethod(fetcher_, "updateDownloadRequests",
+                              Qt::QueuedConnection,
+                              Q_ARG(QSet<QGeoTileSpec>, outstanding_),
+                              Q_ARG(QSet<QGeoTileSpec>, QSet<QGeoTileSpec>()));
+}
+
+/*
+ * The journal records the cursor together with the tiles before it that are
+ * still pending, so that resuming neither loses a tile nor counts one twice.
+ */
+void QGeoTileRegionDownload::writeJournal()
+{
+    if (journal_.isEmpty() || !journalDirty_)
+        return;
+
+    QSaveFile file(journal_);
+    if (!file.open(QIODevice::WriteOnly))
+        return;
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << JournalMagic << JournalVersion;
+    out << pluginString_ << qint32(mapId_) << qint32(mapVersion_);
+    out << qint32(minZoom_) << qint32(maxZoom_);
+    out << isRectangle_ << qint32(region_.size());
+    foreach (const QGeoCoordinate &coord, region_)
+        out << coord.latitude() << coord.longitude();
+    out << qint32(cursor_.zoom) << qint32(cursor_.row) << qint32(cursor_.column)
+        << cursor_.position;
+    out << failed_ << skipped_;
+    out << qint32(outstanding_.size() + withdrawn_.size());
+    foreach (const QGeoTileSpec &spec, outstanding_ + withdrawn_)
+        out << qint32(spec.zoom()) << qint32(spec.x()) << qint32(spec.y());
+
+    if (out.status() == QDataStream::Ok && file.commit())
+        journalDirty_ = false;
+}
+
+bool QGeoTileRegionDownload::readJournal()
+{
+    QFile file(journal_);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    in >> magic >> version;
+    if (magic != JournalMagic || version != JournalVersion)
+        return false;
+
+    QString pluginString;
+    qint32 mapId, mapVersion, minZoom, maxZoom;
+    bool isRectangle;
+    qint32 count;
+    in >> pluginString >> mapId >> mapVersion >> minZoom >> maxZoom;
+    in >> isRectangle >> count;
+    if (in.status() != QDataStream::Ok || count < 0)
+        return false;
+
+    QList<QGeoCoordinate> region;
+    for (qint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        double latitude, longitude;
+        in >> latitude >> longitude;
+        region.append(QGeoCoordinate(latitude, longitude));
+    }
+
+    qint32 zoom, row, column;
+    qint64 position, failed, skipped;
+    in >> zoom >> row >> column >> position >> failed >> skipped;
+    in >> count;
+    if (in.status() != QDataStream::Ok || count < 0)
+        return false;
+
+    QList<QGeoTileSpec> pending;
+    for (qint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        qint32 tileZoom, x, y;
+        in >> tileZoom >> x >> y;
+        pending.append(QGeoTileSpec(pluginString, mapId, tileZoom, x, y, mapVersion));
+    }
+    if (in.status() != QDataStream::Ok)
+        return false;
+    if (isRectangle && region.size() != 2)
+        return false;
+
+    setPluginString(pluginString);
+    setMapId(mapId);
+    setMapVersion(mapVersion);
+    setZoomRange(minZoom, maxZoom);
+    if (isRectangle)
+        setRegion(QGeoRectangle(region.at(0), region.at(1)));
+    else
+        setRegion(region);
+
+    cursor_.zoom = zoom;
+    cursor_.row = row;
+    cursor_.column = column;
+    cursor_.position = position;
+    failed_ = failed;
+    skipped_ = skipped;
+    withdrawn_ = QSet<QGeoTileSpec>::fromList(pending);
+    return true;
+}
+
+/*
+ * Returns the tiles covering the bounding box of the region at \a zoom.
+ * Columns are not wrapped, so the box of a region crossing the dateline
+ * extends past the last column.
+ */
+QGeoTileRegionDownload::Bounds QGeoTileRegionDownload::bounds(int zoom) const
+{
+    Bounds b;
+    b.side = 1 << zoom;
+    b.x = 0;
+    b.y = 0;
+    b.columns = 0;
+    b.rows = 0;
+
+    double x0, y0, x1, y1;
+    if (isRectangle_) {
+        if (!rectangle_.isValid())
+            return b;
+        QDoubleVector2D tl = QGeoProjection::coordToMercator(rectangle_.topLeft());
+        QDoubleVector2D br = QGeoProjection::coordToMercator(rectangle_.bottomRight());
+        x0 = tl.x();
+        x1 = br.x();
+        if (x1 < x0)
+            x1 += 1.0;
+        y0 = tl.y();
+        y1 = br.y();
+    } else {
+        if (region_.size() < 3)
+            return b;
+        QRectF r = polygon_.boundingRect();
+        x0 = r.left();
+        x1 = r.right();
+        y0 = r.top();
+        y1 = r.bottom();
+    }
+
+    int ix0 = static_cast<int>(std::floor(x0 * b.side));
+    int ix1 = qMax(ix0, static_cast<int>(std::ceil(x1 * b.side)) - 1);
+    int iy0 = qBound(0, static_cast<int>(std::floor(y0 * b.side)), b.side - 1);
+    int iy1 = qBound(iy0, static_cast<int>(std::ceil(y1 * b.side)) - 1, b.side - 1);
+
+    b.x = ix0;
+    b.y = iy0;
+    b.columns = qMin(ix1 - ix0 + 1, b.side);
+    b.rows = iy1 - iy0 + 1;
+    return b;
+}
+
+/*
+ * Returns the columns of row \a y that the region touches, as sorted and
+ * disjoint ranges of first and last column within the bounds \a b.
+ *
+ * The part of the polygon inside the row is bounded by the edges clipped to
+ * the row and by the stretches of the row's top and bottom lines that lie
+ * inside the polygon, so the columns it touches are the ones covered by
+ * either of them.
+ */
+QVector<QPair<int, int> > QGeoTileRegionDownload::columnSpans(const Bounds &b, int y) const
+{
+    QVector<QPair<int, int> > spans;
+    if (b.columns <= 0)
+        return spans;
+
+    int lastColumn = b.x + b.columns - 1;
+    if (isRectangle_) {
+        spans.append(qMakePair(b.x, lastColumn));
+        return spans;
+    }
+
+    double top = double(y) / b.side;
+    double bottom = double(y + 1) / b.side;
+    QVector<QPair<double, double> > ranges;
+
+    int n = polygon_.size();
+    for (int i = 0; i < n; ++i) {
+        QPointF p = polygon_.at(i);
+        QPointF q = polygon_.at((i + 1) % n);
+        if (qMax(p.y(), q.y()) < top || qMin(p.y(), q.y()) > bottom)
+            continue;
+        if (p.y() == q.y()) {
+            ranges.append(qMakePair(qMin(p.x(), q.x()), qMax(p.x(), q.x())));
+            continue;
+        }
+        double ta = (top - p.y()) / (q.y() - p.y());
+        double tb = (bottom - p.y()) / (q.y() - p.y());
+        double t0 = qMax(0.0, qMin(ta, tb));
+        double t1 = qMin(1.0, qMax(ta, tb));
+        double x0 = p.x() + t0 * (q.x() - p.x());
+        double x1 = p.x() + t1 * (q.x() - p.x());
+        ranges.append(qMakePair(qMin(x0, x1), qMax(x0, x1)));
+    }
+
+    // the stretches of the top and bottom lines with a non-zero winding number
+    for (int line = 0; line < 2; ++line) {
+        double ly = line == 0 ? top : bottom;
+        QVector<QPair<double, int> > crossings;
+        for (int i = 0; i < n; ++i) {
+            QPointF p = polygon_.at(i);
+            QPointF q = polygon_.at((i + 1) % n);
+            if ((p.y() <= ly) == (q.y() <= ly))
+                continue;
+            double x = p.x() + (ly - p.y()) / (q.y() - p.y()) * (q.x() - p.x());
+            crossings.append(qMakePair(x, q.y() > p.y() ? 1 : -1));
+        }
+        std::sort(crossings.begin(), crossings.end());
+        int winding = 0;
+        for (int i = 0; i < crossings.size(); ++i) {
+            int next = winding + crossings.at(i).second;
+            if (next != 0 && i + 1 < crossings.size())
+                ranges.append(qMakePair(crossings.at(i).first, crossings.at(i + 1).first));
+            winding = next;
+        }
+    }
+
+    QVector<QPair<int, int> > columns;
+    columns.reserve(ranges.size());
+    for (int i = 0; i < ranges.size(); ++i) {
+        int first = static_cast<int>(std::floor(ranges.at(i).first * b.side));
+        int last = qMax(first, static_cast<int>(std::ceil(ranges.at(i).second * b.side)) - 1);
+        first = qMax(first, b.x);
+        last = qMin(last, lastColumn);
+        if (first <= last)
+            columns.append(qMakePair(first, last));
+    }
+    std::sort(columns.begin(), columns.end());
+
+    for (int i = 0; i < columns.size(); ++i) {
+        if (!spans.isEmpty() && columns.at(i).first <= spans.last().second + 1)
+            spans.last().second = qMax(spans.last().second, columns.at(i).second);
+        else
+            spans.append(columns.at(i));
+    }
+    return spans;
+}
+
+bool QGeoTileRegionDownload::nextTile(QGeoTileSpec *spec)
+{
+    while (cursor_.zoom <= maxZoom_) {
+        Bounds b = bounds(cursor_.zoom);
+        if (cursor_.row >= b.rows) {
+            ++cursor_.zoom;
+            cursor_.row = 0;
+            cursor_.column = 0;
+            continue;
+        }
+        if (rowSpansZoom_ != cursor_.zoom || rowSpansRow_ != cursor_.row) {
+            rowSpans_ = columnSpans(b, b.y + cursor_.row);
+            rowSpansZoom_ = cursor_.zoom;
+            rowSpansRow_ = cursor_.row;
+        }
+
+        // skip ahead to the next column the region touches
+        int x = b.x + cursor_.column;
+        int span = 0;
+        while (span < rowSpans_.size() && rowSpans_.at(span).second < x)
+            ++span;
+        if (span == rowSpans_.size()) {
+            ++cursor_.row;
+            cursor_.column = 0;
+            continue;
+        }
+        x = qMax(x, rowSpans_.at(span).first);
+        cursor_.column = x - b.x + 1;
+
+        int y = b.y + cursor_.row;
+        ++cursor_.position;
+        int wrapped = ((x % b.side) + b.side) % b.side;
+        *spec = QGeoTileSpec(pluginString_, mapId_, cursor_.zoom, wrapped, y, mapVersion_);
+        return true;
+    }
+    return false;
+}
+
+/*
+ * Counts the tiles row by row from the column spans, so the cost grows with
+ * the number of rows and polygon edges rather than with the number of tiles.
+ */
+qint64 QGeoTileRegionDownload::countTiles() const
+{
+    qint64 count = 0;
+    for (int zoom = minZoom_; zoom <= maxZoom_; ++zoom) {
+        Bounds b = bounds(zoom);
+        if (isRectangle_) {
+            count += qint64(b.columns) * b.rows;
+            continue;
+        }
+        for (int row = 0; row < b.rows; ++row) {
+            QVector<QPair<int, int> > spans = columnSpans(b, b.y + row);
+            for (int i = 0; i < spans.size(); ++i)
+                count += spans.at(i).second - spans.at(i).first + 1;
+        }
+    }
+    return count;
+}
+
+/*
+ * Cancels the tiles handed to the fetcher and keeps them aside, so that they
+ * are requested again when the download continues. The cursor stays where it
+ * is, the tiles after them have been counted already.
+ */
+void QGeoTileRegionDownload::withdrawOutstanding()
+{
+    if (outstanding_.isEmpty())
+        return;
+
+    if (fetcher_) {
+        QMetaObject::invokeMethod(fetcher_, "updateDownloadRequests",
+                                  Qt::QueuedConnection,
+                                  Q_ARG(QSet<QGeoTileSpec>, QSet<QGeoTileSpec>()),
+                                  Q_ARG(QSet<QGeoTileSpec>, outstanding_));
+    }
+
+    withdrawn_.unite(outstanding_);
+    outstanding_.clear();
+    journalDirty_ = true;
+}
+
+void QGeoTileRegionDownload::setState(State state)
+{
+    if (state_ == state)
+        return;
+    state_ = state;
+    emit stateChanged(state);
+}
+
+QT_END_NAMESPACE
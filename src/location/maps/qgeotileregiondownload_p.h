@@ -0,0 +1,200 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtLocation module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia. For licensing terms and
+** conditions see http://qt.digia.com/licensing. For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights. These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+#ifndef QGEOTILEREGIONDOWNLOAD_P_H
+#define QGEOTILEREGIONDOWNLOAD_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtLocation/qlocationglobal.h>
+
+#include <QObject>
+#include <QList>
+#include <QPair>
+#include <QPointer>
+#include <QPolygonF>
+#include <QSet>
+#include <QTimer>
+#include <QVector>
+
+#include <QtPositioning/QGeoCoordinate>
+#include <QtPositioning/QGeoRectangle>
+
+#include "qgeotilespec_p.h"
+
+QT_BEGIN_NAMESPACE
+
+class QGeoTileFetcher;
+class QGeoTileCache;
+
+/*
+ * Downloads every tile of a region over a range of zoom levels into the disk
+ * cache.
+ *
+ * The tiles go through the fetcher as low priority requests, so maps using
+ * the same fetcher are served first, and only a small window of them is
+ * handed to the fetcher at any time. Tiles that are already cached are
+ * skipped.
+ *
+ * If a journal file is set the position of the download and the tiles still
+ * pending are saved there every few seconds and when pausing, and resume()
+ * continues from it after a crash.
+ * The journal is removed once the download finishes.
+ *
+ * Nothing here depends on a map being shown, so a download can run headless
+ * with any fetcher, including one serving tiles from a local stand-in.
+ */
+class Q_LOCATION_EXPORT QGeoTileRegionDownload : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum State {
+        Idle,
+        Running,
+        Paused,
+        Finished,
+        Cancelled
+    };
+
+    QGeoTileRegionDownload(QGeoTileFetcher *fetcher, QGeoTileCache *cache, QObject *parent = 0);
+    ~QGeoTileRegionDownload();
+
+    static QGeoTileRegionDownload *resume(const QString &journal, QGeoTileFetcher *fetcher,
+                                          QGeoTileCache *cache, QObject *parent = 0);
+
+    void setRegion(const QGeoRectangle &area);
+    void setRegion(const QList<QGeoCoordinate> &polygon);
+    void setZoomRange(int minZoom, int maxZoom);
+    void setPluginString(const QString &pluginString);
+    void setMapId(int mapId);
+    void setMapVersion(int mapVersion);
+    void setJournal(const QString &fileName);
+    QString journal() const;
+
+    State state() const;
+    qint64 totalTiles() const;
+    qint64 finishedTiles() const;
+    qint64 failedTiles() const;
+    qint64 skippedTiles() const;
+
+public Q_SLOTS:
+    void start();
+    void pause();
+    void cancel();
+
+Q_SIGNALS:
+    void progress(qint64 finished, qint64 total);
+    void stateChanged(QGeoTileRegionDownload::State state);
+    void finished();
+
+private Q_SLOTS:
+    void tileFinished(const QGeoTileSpec &spec, const QByteArray &bytes, const QString &format);
+    void tileError(const QGeoTileSpec &spec, const QString &errorString);
+    void dispatch();
+    void resubmit();
+    void writeJournal();
+
+private:
+    struct Cursor
+    {
+        int zoom;
+        int row;
+        int column;
+        qint64 position;
+    };
+
+    struct Bounds
+    {
+        int side;
+        int x;
+        int y;
+        int columns;
+        int rows;
+    };
+
+    Bounds bounds(int zoom) const;
+    QVector<QPair<int, int> > columnSpans(const Bounds &b, int y) const;
+    bool nextTile(QGeoTileSpec *spec);
+    qint64 countTiles() const;
+    void withdrawOutstanding();
+    void setState(State state);
+    bool readJournal();
+
+    QPointer<QGeoTileFetcher> fetcher_;
+    QGeoTileCache *cache_;
+
+    QList<QGeoCoordinate> region_;
+    bool isRectangle_;
+    QGeoRectangle rectangle_;
+    // the polygon in mercator coordinates, x unwrapped across the dateline
+    QPolygonF polygon_;
+    int minZoom_;
+    int maxZoom_;
+    QString pluginString_;
+    int mapId_;
+    int mapVersion_;
+
+    State state_;
+    Cursor cursor_;
+    // tiles handed to the fetcher
+    QSet<QGeoTileSpec> outstanding_;
+    // tiles taken back from the fetcher by pause(), requested first by start()
+    QSet<QGeoTileSpec> withdrawn_;
+    qint64 total_;
+    // columnSpans() of the row the cursor is on
+    QVector<QPair<int, int> > rowSpans_;
+    int rowSpansZoom_;
+    int rowSpansRow_;
+    qint64 failed_;
+    qint64 skipped_;
+
+    QString journal_;
+    bool journalDirty_;
+    QTimer journalTimer_;
+    QTimer resubmitTimer_;
+
+    Q_DISABLE_COPY(QGeoTileRegionDownload)
+};
+
+QT_END_NAMESPACE
+
+#endif // QGEOTILEREGIONDOWNLOAD_P_H
@@ -57,8 +57,13 @@ public:
     QHash<QGeoTileSpec, int> retries_;
     QHash<QGeoTileSpec, QSharedPointer<RetryFuture> > futures_;
     QSet<QGeoTileSpec> requested_;
+    // tiles waiting for their texture to be decoded, the value says whether
+    // the tile should be fetched again if the cached copy turns out to be bad
+    QHash<QGeoTileSpec, bool> decoding_;
 
     void tileFetched(const QGeoTileSpec &spec);
+    void tileDecoded(const QGeoTileSpec &spec);
+    void tileDecodeFailed(const QGeoTileSpec &spec);
 };
 
 QGeoTileRequestManager::QGeoTileRequestManager(QGeoTiledMapData *map)
@@ -83,6 +88,18 @@ void QGeoTileRequestManager::tileFetched(const QGeoTileSpec &spec)
     d->tileFetched(spec);
 }
 
+void QGeoTileRequestManager::tileDecoded(const QGeoTileSpec &spec)
+{
+    Q_D(QGeoTileRequestManager);
+    d->tileDecoded(spec);
+}
+
+void QGeoTileRequestManager::tileDecodeFailed(const QGeoTileSpec &spec)
+{
+    Q_D(QGeoTileRequestManager);
+    d->tileDecodeFailed(spec);
+}
+
 void QGeoTileRequestManager::tileError(const QGeoTileSpec &tile, const QString &errorString)
 {
     Q_D(QGeoTileRequestManager);
@@ -103,6 +120,18 @@ QList<QSharedPointer<QGeoTileTexture> > QGeoTileRequestManagerPrivate::requestTi
     QSet<QGeoTileSpec> cancelTiles = requested_ - tiles;
     QSet<QGeoTileSpec> requestTiles = tiles - requested_;
     QSet<QGeoTileSpec> cached;
+
+    // decodes that are no longer wanted still complete into the texture
+    // cache, we just stop waiting for them
+    QHash<QGeoTileSpec, bool>::iterator pending = decoding_.begin();
+    while (pending != decoding_.end()) {
+        if (tiles.contains(pending.key())) {
+            requestTiles.remove(pending.key());
+            ++pending;
+        } else {
+            pending = decoding_.erase(pending);
+        }
+    }
 //    int tileSize = tiles.size();
 //    int newTiles = requestTiles.size();
 
@@ -113,16 +142,22 @@ QList<QSharedPointer<QGeoTileTexture> > QGeoTileRequestManagerPrivate::requestTi
     QGeoTiledMappingManagerEngine *engine = map_ ?
                 static_cast<QGeoTiledMappingManagerEngine *>(map_->engine()) : 0;
 
-    // remove tiles in cache from request tiles
-    if (engine) {
+    // remove tiles in cache from request tiles. Tiles which are cached but
+    // not decoded yet are decoded off the GUI thread and handed to the map
+    // through tileDecoded()
+    QGeoTileCache *cache = engine ? engine->tileCache() : 0;
+    if (cache) {
         iter i = requestTiles.constBegin();
         iter end = requestTiles.constEnd();
         for (; i != end; ++i) {
             QGeoTileSpec tile = *i;
-            QSharedPointer<QGeoTileTexture> tex = engine->getTileTexture(tile);
+            QSharedPointer<QGeoTileTexture> tex = cache->getDecoded(tile);
             if (tex) {
                 cachedTex << tex;
                 cached.insert(tile);
+            } else if (cache->requestDecode(tile)) {
+                decoding_.insert(tile, true);
+                cached.insert(tile);
             }
         }
     }
@@ -155,10 +190,49 @@ QList<QSharedPointer<QGeoTileTexture> > QGeoTileRequestManagerPrivate::requestTi
 
 void QGeoTileRequestManagerPrivate::tileFetched(const QGeoTileSpec &spec)
 {
-    map_->newTileFetched(spec);
     requested_.remove(spec);
     retries_.remove(spec);
     futures_.remove(spec);
+
+    QGeoTiledMappingManagerEngine *engine = map_ ?
+                static_cast<QGeoTiledMappingManagerEngine *>(map_->engine()) : 0;
+    QGeoTileCache *cache = engine ? engine->tileCache() : 0;
+
+    // the fetched bytes were put into the memory cache, decode them there
+    // rather than on the GUI thread
+    if (cache && !cache->getDecoded(spec) && cache->requestDecode(spec)) {
+        decoding_.insert(spec, false);
+        return;
+    }
+
+    map_->newTileFetched(spec);
+}
+
+void QGeoTileRequestManagerPrivate::tileDecoded(const QGeoTileSpec &spec)
+{
+    if (!decoding_.contains(spec))
+        return;
+
+    decoding_.remove(spec);
+    map_->newTileFetched(spec);
+}
+
+void QGeoTileRequestManagerPrivate::tileDecodeFailed(const QGeoTileSpec &spec)
+{
+    if (!decoding_.contains(spec))
+        return;
+
+    bool refetch = decoding_.take(spec);
+
+    // the cached copy is unusable, fall back to fetching the tile
+    QGeoTiledMappingManagerEngine *engine = map_ ?
+                static_cast<QGeoTiledMappingManagerEngine *>(map_->engine()) : 0;
+    if (refetch && engine && !requested_.contains(spec)) {
+        QSet<QGeoTileSpec> requestTiles;
+        requestTiles.insert(spec);
+        requested_.insert(spec);
+        engine->updateTileRequests(map_, requestTiles, QSet<QGeoTileSpec>());
+    }
 }
 
 // Represents a tile that needs to be retried after a certain period of time
@@ -69,6 +69,8 @@ public:
 
     void tileError(const QGeoTileSpec &tile, const QString &errorString);
     void tileFetched(const QGeoTileSpec &spec);
+    void tileDecoded(const QGeoTileSpec &spec);
+    void tileDecodeFailed(const QGeoTileSpec &spec);
 private:
     QGeoTileRequestManagerPrivate *d_ptr;
     Q_DECLARE_PRIVATE(QGeoTileRequestManager)
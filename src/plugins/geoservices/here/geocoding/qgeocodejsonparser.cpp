@@ -59,7 +59,7 @@
 #include <QtCore/QJsonArray>
 #include <QtCore/QJsonParseError>
 #include <QtCore/QVariantMap>
-#include <QtCore/QIODevice>
+#include <QtCore/QJsonDocument>
 
 #include <QtDebug>
 
@@ -399,34 +399,30 @@ QGeoCodeJsonParser::~QGeoCodeJsonParser()
 {
 }
 
-bool QGeoCodeJsonParser::parse(QIODevice *source)
+bool QGeoCodeJsonParser::parseData(const QByteArray &data)
 {
     // parse the document.
     QJsonParseError error;
-    QByteArray data = source->readAll();
-    m_document = QJsonDocument::fromJson(data, &error);
+    QJsonDocument document = QJsonDocument::fromJson(data, &error);
     if (error.error != QJsonParseError::NoError) {
-        m_errorString = error.errorString();
+        setErrorString(error.errorString());
         return false;
     }
 
     // ensure that the response is valid and contains the information we need.
-    if (!checkDocument(m_document, &m_errorString)) {
+    QString errorString;
+    if (!checkDocument(document, &errorString)) {
+        setErrorString(errorString);
         return false;
     }
 
     // extract the location results from the response.
-    return parseDocument(m_document, &m_results);
-}
-
-QList<QGeoLocation> QGeoCodeJsonParser::results() const
-{
-    return m_results;
-}
+    QList<QGeoLocation> locations;
+    if (!parseDocument(document, &locations))
+        return false;
 
-QString QGeoCodeJsonParser::errorString() const
-{
-    return m_errorString;
+    emit results(locations);
+    return true;
 }
 
 QT_END_NAMESPACE
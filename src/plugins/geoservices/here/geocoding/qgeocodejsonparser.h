@@ -49,33 +49,31 @@
 #ifndef QGEOCODEJSONPARSER_H
 #define QGEOCODEJSONPARSER_H
 
-#include <QtCore/QJsonDocument>
+#include <QtLocation/private/qgeoreplyparser_p.h>
+#include <QtPositioning/QGeoLocation>
+
 #include <QtCore/QString>
 #include <QtCore/QList>
 
 QT_BEGIN_NAMESPACE
 
-class QIODevice;
-class QGeoLocation;
 class QGeoAddress;
 class QGeoRectangle;
 class QGeoCoordinate;
 
-class QGeoCodeJsonParser
+class QGeoCodeJsonParser : public QGeoReplyParser
 {
+    Q_OBJECT
+
 public:
     QGeoCodeJsonParser();
     ~QGeoCodeJsonParser();
 
-    bool parse(QIODevice *source);
-
-    QList<QGeoLocation> results() const;
-    QString errorString() const;
+Q_SIGNALS:
+    void results(const QList<QGeoLocation> &locations);
 
-private:
-    QJsonDocument m_document;
-    QList<QGeoLocation> m_results;
-    QString m_errorString;
+protected:
+    bool parseData(const QByteArray &data);
 };
 
 QT_END_NAMESPACE
@@ -51,7 +51,6 @@
 
 #include <QtPositioning/QGeoShape>
 
-#include <QtCore/QBuffer>
 #include <QtCore/QByteArray>
 #include <QtDebug>
 
@@ -63,7 +62,10 @@ QGeoCodeReplyHere::QGeoCodeReplyHere(QNetworkReply *reply, int limit, int offset
         : QGeoCodeReply(parent)
         , m_reply(reply)
         , m_manualBoundsRequired(manualBoundsRequired)
+        , m_parsing(false)
 {
+    qRegisterMetaType<QList<QGeoLocation> >();
+
     connect(m_reply, &QNetworkReply::finished,
             this, &QGeoCodeReplyHere::networkFinished);
 
@@ -80,6 +82,9 @@ QGeoCodeReplyHere::~QGeoCodeReplyHere()
 
 void QGeoCodeReplyHere::abort()
 {
+    // the results of a running parser are dropped
+    m_parsing = false;
+
     if (!m_reply)
         return;
 
@@ -101,25 +106,47 @@ void QGeoCodeReplyHere::networkFinished()
         return;
     }
 
-    QGeoCodeJsonParser parser;
-    if (parser.parse(m_reply)) {
-        QList<QGeoLocation> locations = parser.results();
-        QGeoShape bounds = viewport();
-        if (m_manualBoundsRequired && bounds.isValid()) {
-            for (int i = locations.size() - 1; i >= 0; --i) {
-                if (!bounds.contains(locations[i].coordinate())) {
-                    locations.removeAt(i);
-                }
+    QGeoCodeJsonParser *parser = new QGeoCodeJsonParser;
+    connect(parser, &QGeoCodeJsonParser::results,
+            this, &QGeoCodeReplyHere::appendResults);
+    connect(parser, &QGeoCodeJsonParser::error,
+            this, &QGeoCodeReplyHere::parserError);
+
+    m_parsing = true;
+    parser->parse(m_reply->readAll());
+
+    m_reply->deleteLater();
+    m_reply = 0;
+}
+
+void QGeoCodeReplyHere::appendResults(const QList<QGeoLocation> &locations)
+{
+    if (!m_parsing)
+        return;
+
+    m_parsing = false;
+
+    QList<QGeoLocation> filteredLocations = locations;
+    QGeoShape bounds = viewport();
+    if (m_manualBoundsRequired && bounds.isValid()) {
+        for (int i = filteredLocations.size() - 1; i >= 0; --i) {
+            if (!bounds.contains(filteredLocations[i].coordinate())) {
+                filteredLocations.removeAt(i);
             }
         }
-        setLocations(locations);
-        setFinished(true);
-    } else {
-        setError(QGeoCodeReply::ParseError, parser.errorString());
     }
+    setLocations(filteredLocations);
+    setFinished(true);
+}
 
-    m_reply->deleteLater();
-    m_reply = 0;
+void QGeoCodeReplyHere::parserError(const QString &errorString)
+{
+    if (!m_parsing)
+        return;
+
+    m_parsing = false;
+
+    setError(QGeoCodeReply::ParseError, errorString);
 }
 
 QT_END_NAMESPACE
@@ -66,10 +66,13 @@ public:
 
 private Q_SLOTS:
     void networkFinished();
+    void appendResults(const QList<QGeoLocation> &locations);
+    void parserError(const QString &errorString);
 
 private:
     QNetworkReply *m_reply;
     bool m_manualBoundsRequired;
+    bool m_parsing;
 };
 
 QT_END_NAMESPACE
@@ -63,6 +63,9 @@ QGeoMapReplyHere::QGeoMapReplyHere(QNetworkReply *reply, const QGeoTileSpec &spe
     connect(m_reply, &QNetworkReply::finished,
             this, &QGeoMapReplyHere::networkFinished);
 
+    connect(m_reply, &QNetworkReply::metaDataChanged,
+            this, &QGeoTiledMapReply::firstByteReceived);
+
     connect(m_reply, &QObject::destroyed,
             this, &QGeoMapReplyHere::replyDestroyed);
 }
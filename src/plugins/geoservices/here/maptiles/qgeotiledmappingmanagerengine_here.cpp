@@ -114,7 +114,11 @@ QGeoTiledMappingManagerEngineHere::QGeoTiledMappingManagerEngineHere(
     if (parameters.contains(QLatin1String("mapping.cache.directory")))
         cacheDir = parameters.value(QLatin1String("mapping.cache.directory")).toString();
 
-    QGeoTileCache *tileCache = createTileCacheWithDir(cacheDir);
+    QGeoTiledMappingManagerEngine::DiskCacheLayout cacheLayout = FilePerTileLayout;
+    if (parameters.value(QLatin1String("mapping.cache.disk.layout")).toString() == QLatin1String("packed"))
+        cacheLayout = PackedFileLayout;
+
+    QGeoTileCache *tileCache = createTileCacheWithDir(cacheDir, cacheLayout);
 
     if (parameters.contains(QLatin1String("mapping.cache.disk.size"))) {
       bool ok = false;
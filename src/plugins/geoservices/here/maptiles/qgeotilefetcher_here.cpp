@@ -122,6 +122,13 @@ QGeoTiledMapReply *QGeoTileFetcherHere::getTileImage(const QGeoTileSpec &spec)
     return mapReply;
 }
 
+QString QGeoTileFetcherHere::hostForTile(const QGeoTileSpec &spec) const
+{
+    if (m_engineHere && isAerialType(m_engineHere->getScheme(spec.mapId())))
+        return QStringLiteral("aerial");
+    return QStringLiteral("base");
+}
+
 QString QGeoTileFetcherHere::getRequestString(const QGeoTileSpec &spec)
 {
     static const QString http("http://");
@@ -92,6 +92,9 @@ public Q_SLOTS:
     void versionFetched();
     void fetchVersionData();
 
+protected:
+    QString hostForTile(const QGeoTileSpec &spec) const;
+
 private:
     Q_DISABLE_COPY(QGeoTileFetcherHere)
 
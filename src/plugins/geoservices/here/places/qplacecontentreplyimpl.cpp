@@ -55,6 +55,7 @@
 #include <QtCore/QCoreApplication>
 #include <QtCore/QJsonDocument>
 #include <QtCore/QJsonObject>
+#include <QtLocation/private/qgeoreplyparser_p.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -96,28 +97,42 @@ void QPlaceContentReplyImpl::setError(QPlaceReply::Error error_, const QString &
 void QPlaceContentReplyImpl::replyFinished()
 {
     if (m_reply->isOpen()) {
-        QJsonDocument document = QJsonDocument::fromJson(m_reply->readAll());
-        if (!document.isObject()) {
-            setError(ParseError, QCoreApplication::translate(HERE_PLUGIN_CONTEXT_NAME, PARSE_ERROR));
-            return;
-        }
-
-        QJsonObject object = document.object();
-
-        QPlaceContent::Collection collection;
-        int totalCount;
-        QPlaceContentRequest previous;
-        QPlaceContentRequest next;
-
-        parseCollection(request().contentType(), object, &collection, &totalCount,
-                        &previous, &next, m_engine);
-
-        setTotalCount(totalCount);
-        setContent(collection);
-        setPreviousPageRequest(previous);
-        setNextPageRequest(next);
+        QGeoJsonReplyParser *parser = new QGeoJsonReplyParser;
+        connect(parser, SIGNAL(results(QJsonDocument)), this, SLOT(documentParsed(QJsonDocument)));
+        connect(parser, SIGNAL(error(QString)), this, SLOT(parserError(QString)));
+        parser->parse(m_reply->readAll());
+        return;
+    }
+
+    m_reply->deleteLater();
+    m_reply = 0;
+
+    setFinished(true);
+    emit finished();
+}
+
+void QPlaceContentReplyImpl::documentParsed(const QJsonDocument &document)
+{
+    if (!document.isObject()) {
+        setError(ParseError, QCoreApplication::translate(HERE_PLUGIN_CONTEXT_NAME, PARSE_ERROR));
+        return;
     }
 
+    QJsonObject object = document.object();
+
+    QPlaceContent::Collection collection;
+    int totalCount;
+    QPlaceContentRequest previous;
+    QPlaceContentRequest next;
+
+    parseCollection(request().contentType(), object, &collection, &totalCount,
+                    &previous, &next, m_engine);
+
+    setTotalCount(totalCount);
+    setContent(collection);
+    setPreviousPageRequest(previous);
+    setNextPageRequest(next);
+
     m_reply->deleteLater();
     m_reply = 0;
 
@@ -125,6 +140,13 @@ void QPlaceContentReplyImpl::replyFinished()
     emit finished();
 }
 
+void QPlaceContentReplyImpl::parserError(const QString &parseErrorString)
+{
+    Q_UNUSED(parseErrorString)
+
+    setError(ParseError, QCoreApplication::translate(HERE_PLUGIN_CONTEXT_NAME, PARSE_ERROR));
+}
+
 void QPlaceContentReplyImpl::replyError(QNetworkReply::NetworkError error)
 {
     switch (error) {
@@ -65,6 +65,7 @@
 #include <QtCore/QJsonDocument>
 #include <QtCore/QJsonObject>
 #include <QtCore/QJsonArray>
+#include <QtLocation/private/qgeoreplyparser_p.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -150,7 +151,14 @@ void QPlaceDetailsReplyImpl::replyFinished()
         return;
     }
 
-    QJsonDocument document = QJsonDocument::fromJson(m_reply->readAll());
+    QGeoJsonReplyParser *parser = new QGeoJsonReplyParser;
+    connect(parser, SIGNAL(results(QJsonDocument)), this, SLOT(documentParsed(QJsonDocument)));
+    connect(parser, SIGNAL(error(QString)), this, SLOT(parserError(QString)));
+    parser->parse(m_reply->readAll());
+}
+
+void QPlaceDetailsReplyImpl::documentParsed(const QJsonDocument &document)
+{
     if (!document.isObject()) {
         setError(ParseError, QCoreApplication::translate(HERE_PLUGIN_CONTEXT_NAME, PARSE_ERROR));
         return;
@@ -358,4 +366,11 @@ void QPlaceDetailsReplyImpl::replyFinished()
     emit finished();
 }
 
+void QPlaceDetailsReplyImpl::parserError(const QString &parseErrorString)
+{
+    Q_UNUSED(parseErrorString)
+
+    setError(ParseError, QCoreApplication::translate(HERE_PLUGIN_CONTEXT_NAME, PARSE_ERROR));
+}
+
 QT_END_NAMESPACE
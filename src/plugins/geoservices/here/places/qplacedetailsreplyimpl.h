@@ -50,6 +50,7 @@
 #define QPLACEDETAILSREPLYIMPL_H
 
 #include <QtLocation/QPlaceDetailsReply>
+#include <QtCore/QJsonDocument>
 #include <QtNetwork/QNetworkReply>
 
 QT_BEGIN_NAMESPACE
@@ -71,6 +72,8 @@ public:
 private slots:
     void setError(QPlaceReply::Error error_, const QString &errorString);
     void replyFinished();
+    void documentParsed(const QJsonDocument &document);
+    void parserError(const QString &parseErrorString);
 
 private:
     QNetworkReply *m_reply;
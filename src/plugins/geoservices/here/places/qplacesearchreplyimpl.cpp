@@ -60,6 +60,7 @@
 #include <QtCore/QJsonDocument>
 #include <QtCore/QJsonObject>
 #include <QtCore/QJsonArray>
+#include <QtLocation/private/qgeoreplyparser_p.h>
 
 #include <QtCore/QDebug>
 
@@ -117,7 +118,14 @@ void QPlaceSearchReplyImpl::replyFinished()
         return;
     }
 
-    QJsonDocument document = QJsonDocument::fromJson(m_reply->readAll());
+    QGeoJsonReplyParser *parser = new QGeoJsonReplyParser;
+    connect(parser, SIGNAL(results(QJsonDocument)), this, SLOT(documentParsed(QJsonDocument)));
+    connect(parser, SIGNAL(error(QString)), this, SLOT(parserError(QString)));
+    parser->parse(m_reply->readAll());
+}
+
+void QPlaceSearchReplyImpl::documentParsed(const QJsonDocument &document)
+{
     if (!document.isObject()) {
         setError(ParseError, QCoreApplication::translate(HERE_PLUGIN_CONTEXT_NAME, PARSE_ERROR));
         return;
@@ -150,6 +158,13 @@ void QPlaceSearchReplyImpl::replyFinished()
     emit finished();
 }
 
+void QPlaceSearchReplyImpl::parserError(const QString &parseErrorString)
+{
+    Q_UNUSED(parseErrorString)
+
+    setError(ParseError, QCoreApplication::translate(HERE_PLUGIN_CONTEXT_NAME, PARSE_ERROR));
+}
+
 QPlaceResult QPlaceSearchReplyImpl::parsePlaceResult(const QJsonObject &item) const
 {
     QPlaceResult result;
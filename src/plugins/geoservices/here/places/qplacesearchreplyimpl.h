@@ -50,6 +50,7 @@
 #define QPLACESEARCHREPLYIMPL_H
 
 #include <QtLocation/QPlaceSearchReply>
+#include <QtCore/QJsonDocument>
 #include <QtNetwork/QNetworkReply>
 
 QT_BEGIN_NAMESPACE
@@ -73,6 +74,8 @@ public:
 private slots:
     void setError(QPlaceReply::Error error_, const QString &errorString);
     void replyFinished();
+    void documentParsed(const QJsonDocument &document);
+    void parserError(const QString &parseErrorString);
 
 private:
     QPlaceResult parsePlaceResult(const QJsonObject &item) const;
@@ -54,6 +54,7 @@
 #include <QtCore/QJsonDocument>
 #include <QtCore/QJsonObject>
 #include <QtCore/QJsonArray>
+#include <QtLocation/private/qgeoreplyparser_p.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -100,7 +101,14 @@ void QPlaceSearchSuggestionReplyImpl::replyFinished()
         return;
     }
 
-    QJsonDocument document = QJsonDocument::fromJson(m_reply->readAll());
+    QGeoJsonReplyParser *parser = new QGeoJsonReplyParser;
+    connect(parser, SIGNAL(results(QJsonDocument)), this, SLOT(documentParsed(QJsonDocument)));
+    connect(parser, SIGNAL(error(QString)), this, SLOT(parserError(QString)));
+    parser->parse(m_reply->readAll());
+}
+
+void QPlaceSearchSuggestionReplyImpl::documentParsed(const QJsonDocument &document)
+{
     if (!document.isObject()) {
         setError(ParseError, QCoreApplication::translate(HERE_PLUGIN_CONTEXT_NAME, PARSE_ERROR));
         emit error(error(), errorString());
@@ -127,4 +135,12 @@ void QPlaceSearchSuggestionReplyImpl::replyFinished()
     emit finished();
 }
 
+void QPlaceSearchSuggestionReplyImpl::parserError(const QString &parseErrorString)
+{
+    Q_UNUSED(parseErrorString)
+
+    setError(ParseError, QCoreApplication::translate(HERE_PLUGIN_CONTEXT_NAME, PARSE_ERROR));
+    emit error(error(), errorString());
+}
+
 QT_END_NAMESPACE
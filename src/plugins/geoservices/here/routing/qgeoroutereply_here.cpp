@@ -51,12 +51,17 @@
 
 #include <QtLocation/QGeoRouteRequest>
 
+Q_DECLARE_METATYPE(QList<QGeoRoute>)
+
 QT_BEGIN_NAMESPACE
 
 QGeoRouteReplyHere::QGeoRouteReplyHere(const QGeoRouteRequest &request, const QList<QNetworkReply*> &replies, QObject *parent)
         : QGeoRouteReply(request, parent)
         , m_replies(replies)
+        , m_parsers(0)
 {
+    qRegisterMetaType<QList<QGeoRoute> >();
+
     foreach (QNetworkReply *reply, m_replies) {
         connect(reply,
                 SIGNAL(finished()),
@@ -77,6 +82,9 @@ QGeoRouteReplyHere::~QGeoRouteReplyHere()
 
 void QGeoRouteReplyHere::abort()
 {
+    // results of parsers still running are dropped
+    m_parsers = 0;
+
     if (m_replies.isEmpty())
         return;
 
@@ -101,18 +109,7 @@ void QGeoRouteReplyHere::networkFinished()
         return;
     }
 
-    QGeoRouteXmlParser parser(request());
-    if (parser.parse(reply)) {
-        addRoutes(parser.results());
-        reply->deleteLater();
-        m_replies.removeOne(reply);
-        if (m_replies.isEmpty())
-            setFinished(true);
-    } else {
-        // add a qWarning with the actual parser.errorString()
-        setError(QGeoRouteReply::ParseError, "The response from the service was not in a recognisable format.");
-        abort();
-    }
+    parse(reply);
 }
 
 void QGeoRouteReplyHere::networkError(QNetworkReply::NetworkError error)
@@ -123,23 +120,58 @@ void QGeoRouteReplyHere::networkError(QNetworkReply::NetworkError error)
     if (!reply)
         return;
 
-    bool resolvedError = false;
     if (QNetworkReply::UnknownContentError == error) {
-        QGeoRouteXmlParser parser(request());
-        if (parser.parse(reply)) {
-            addRoutes(parser.results());
-            reply->deleteLater();
-            m_replies.removeOne(reply);
-            resolvedError = true;
-            if (m_replies.isEmpty())
-                setFinished(true);
-        }
+        // the body may still hold a route, a parse error is reported if not
+        parse(reply);
+        return;
     }
 
-    if (!resolvedError) {
-        setError(QGeoRouteReply::CommunicationError, reply->errorString());
-        abort();
-    }
+    setError(QGeoRouteReply::CommunicationError, reply->errorString());
+    abort();
+}
+
+void QGeoRouteReplyHere::appendResults(const QList<QGeoRoute> &routes)
+{
+    if (m_parsers == 0)
+        return;
+
+    addRoutes(routes);
+    --m_parsers;
+    if (m_parsers == 0 && m_replies.isEmpty())
+        setFinished(true);
+}
+
+void QGeoRouteReplyHere::parserError(const QString &errorString)
+{
+    Q_UNUSED(errorString)
+
+    if (m_parsers == 0)
+        return;
+
+    // add a qWarning with the actual errorString
+    setError(QGeoRouteReply::ParseError, "The response from the service was not in a recognisable format.");
+    abort();
+}
+
+/*!
+    \internal
+
+    Hands the body of \a reply to a parser running off this thread; the
+    reply is done with once its data has been read.
+*/
+void QGeoRouteReplyHere::parse(QNetworkReply *reply)
+{
+    QGeoRouteXmlParser *parser = new QGeoRouteXmlParser(request());
+    connect(parser, SIGNAL(results(QList<QGeoRoute>)),
+            this, SLOT(appendResults(QList<QGeoRoute>)));
+    connect(parser, SIGNAL(error(QString)),
+            this, SLOT(parserError(QString)));
+
+    ++m_parsers;
+    parser->parse(reply->readAll());
+
+    reply->deleteLater();
+    m_replies.removeOne(reply);
 }
 
 QT_END_NAMESPACE
@@ -67,9 +67,14 @@ public:
 private Q_SLOTS:
     void networkFinished();
     void networkError(QNetworkReply::NetworkError error);
+    void appendResults(const QList<QGeoRoute> &routes);
+    void parserError(const QString &errorString);
 
 private:
+    void parse(QNetworkReply *reply);
+
     QList<QNetworkReply*> m_replies;
+    int m_parsers;
 };
 
 QT_END_NAMESPACE
@@ -49,10 +49,11 @@
 #include "routing/qgeoroutexmlparser.h"
 
 #include <QtLocation/QGeoRoute>
+#include <QtLocation/private/qgeoroute_p.h>
+#include <QtLocation/private/qgeoroutesegment_p.h>
 #include <QtPositioning/QGeoRectangle>
 
 #include <QXmlStreamReader>
-#include <QIODevice>
 #include <QStringList>
 #include <QString>
 
@@ -74,30 +75,20 @@ QGeoRouteXmlParser::~QGeoRouteXmlParser()
 {
 }
 
-bool QGeoRouteXmlParser::parse(QIODevice *source)
+bool QGeoRouteXmlParser::parseData(const QByteArray &data)
 {
-    m_reader.reset(new QXmlStreamReader(source));
+    m_reader.reset(new QXmlStreamReader(data));
 
     if (!parseRootElement()) {
-        m_errorString = m_reader->errorString();
+        setErrorString(m_reader->errorString());
         return false;
     }
 
-    m_errorString = "";
+    emit results(m_results);
 
     return true;
 }
 
-QList<QGeoRoute> QGeoRouteXmlParser::results() const
-{
-    return m_results;
-}
-
-QString QGeoRouteXmlParser::errorString() const
-{
-    return m_errorString;
-}
-
 bool QGeoRouteXmlParser::parseRootElement()
 {
     if (!m_reader->readNextStartElement()) {
@@ -167,9 +158,8 @@ bool QGeoRouteXmlParser::parseRoute(QGeoRoute *route)
                 if (!parseMode(route))
                     return false;
             } else if (m_reader->name() == "Shape") {
-                QString elementName = m_reader->name().toString();
                 QList<QGeoCoordinate> path;
-                if (!parseGeoPoints(m_reader->readElementText(), &path, elementName))
+                if (!parseGeoPoints(m_reader->readElementText(), &path, QStringLiteral("Shape")))
                     return false;
                 route->setPath(path);
             } else if (m_reader->name() == "BoundingBox") {
@@ -260,36 +250,39 @@ bool QGeoRouteXmlParser::postProcessRoute(QGeoRoute *route)
         ++maneuverIndex;
     }
 
+    // merge segments without a maneuver into the following one in a single
+    // pass, growing the merged path in place until the segment is complete
     QList<QGeoRouteSegment> compactedRouteSegments;
-    compactedRouteSegments.append(routeSegments.first());
-    routeSegments.removeFirst();
+    if (!routeSegments.isEmpty()) {
+        compactedRouteSegments.reserve(routeSegments.size());
 
-    while (routeSegments.size() > 0) {
-        QGeoRouteSegment segment = routeSegments.first();
-        routeSegments.removeFirst();
+        QGeoRouteSegment lastSegment = routeSegments.first();
+        QGeoCoordinateArray lastPath = QGeoRouteSegmentPrivate::compactPath(lastSegment);
 
-        QGeoRouteSegment lastSegment = compactedRouteSegments.last();
+        for (int i = 1; i < routeSegments.size(); ++i) {
+            const QGeoRouteSegment &segment = routeSegments.at(i);
 
-        if (lastSegment.maneuver().isValid()) {
-            compactedRouteSegments.append(segment);
-        } else {
-            compactedRouteSegments.removeLast();
-            lastSegment.setDistance(lastSegment.distance() + segment.distance());
-            lastSegment.setTravelTime(lastSegment.travelTime() + segment.travelTime());
-            QList<QGeoCoordinate> path = lastSegment.path();
-            path.append(segment.path());
-            lastSegment.setPath(path);
-            lastSegment.setManeuver(segment.maneuver());
-            compactedRouteSegments.append(lastSegment);
+            if (lastSegment.maneuver().isValid()) {
+                QGeoRouteSegmentPrivate::setCompactPath(lastSegment, lastPath);
+                compactedRouteSegments.append(lastSegment);
+                lastSegment = segment;
+                lastPath = QGeoRouteSegmentPrivate::compactPath(segment);
+            } else {
+                lastSegment.setDistance(lastSegment.distance() + segment.distance());
+                lastSegment.setTravelTime(lastSegment.travelTime() + segment.travelTime());
+                lastPath.append(QGeoRouteSegmentPrivate::compactPath(segment));
+                lastSegment.setManeuver(segment.maneuver());
+            }
         }
-    }
 
-    if (compactedRouteSegments.size() > 0) {
-        route->setFirstRouteSegment(compactedRouteSegments.at(0));
-        for (int i = 0; i < compactedRouteSegments.size() - 1; ++i)
-            compactedRouteSegments[i].setNextRouteSegment(compactedRouteSegments.at(i + 1));
+        QGeoRouteSegmentPrivate::setCompactPath(lastSegment, lastPath);
+        compactedRouteSegments.append(lastSegment);
     }
 
+    // keep the segment paths as ranges of one buffer, shared with the route
+    // path where they match it
+    QGeoRoutePrivate::setSegments(*route, compactedRouteSegments);
+
     m_maneuvers.clear();
     m_segments.clear();
     return true;
@@ -491,9 +484,8 @@ bool QGeoRouteXmlParser::parseLink()
             if (m_reader->name() == QStringLiteral("LinkId")) {
                 segmentContainer.id = m_reader->readElementText();
             } else if (m_reader->name() == QStringLiteral("Shape")) {
-                QString elementName = m_reader->name().toString();
                 QList<QGeoCoordinate> path;
-                parseGeoPoints(m_reader->readElementText(), &path, elementName);
+                parseGeoPoints(m_reader->readElementText(), &path, QStringLiteral("Shape"));
                 segmentContainer.segment.setPath(path);
             } else if (m_reader->name() == QStringLiteral("Length")) {
                 segmentContainer.segment.setDistance(m_reader->readElementText().toDouble());
@@ -522,35 +514,56 @@ bool QGeoRouteXmlParser::parseLink()
 
 bool QGeoRouteXmlParser::parseGeoPoints(const QString &strPoints, QList<QGeoCoordinate> *geoPoints, const QString &elementName)
 {
-    QStringList rawPoints = strPoints.split(' ');
-
-    for (int i = 0; i < rawPoints.length(); ++i) {
-        QStringList coords = rawPoints[i].split(',');
+    // tokenize the "lat,lng" pairs in place, the numbers are converted
+    // straight from the character data without intermediate strings
+    const QChar *data = strPoints.constData();
+    const int length = strPoints.length();
+
+    geoPoints->reserve(geoPoints->size() + strPoints.count(QLatin1Char(',')));
+
+    int i = 0;
+    while (i < length) {
+        while (i < length && data[i].isSpace())
+            ++i;
+        if (i == length)
+            break;
+
+        const int start = i;
+        int comma = -1;
+        while (i < length && !data[i].isSpace()) {
+            if (data[i] == QLatin1Char(',')) {
+                if (comma != -1)
+                    break;
+                comma = i;
+            }
+            ++i;
+        }
 
-        if (coords.length() != 2) {
-            m_reader->raiseError(QString("Each of the space separated values of \"%1\" is expected to be a comma separated pair of coordinates (value was \"%2\")").arg(elementName).arg(rawPoints[i]));
+        if (comma == -1 || (i < length && !data[i].isSpace())) {
+            while (i < length && !data[i].isSpace())
+                ++i;
+            m_reader->raiseError(QString("Each of the space separated values of \"%1\" is expected to be a comma separated pair of coordinates (value was \"%2\")").arg(elementName).arg(strPoints.mid(start, i - start)));
             return false;
         }
 
         bool ok = false;
-        QString latString = coords[0];
+        const QStringRef latString(&strPoints, start, comma - start);
         double lat = latString.toDouble(&ok);
 
         if (!ok) {
-            m_reader->raiseError(QString("The latitude portions of \"%1\" are expected to have a value convertable to a double (value was \"%2\")").arg(elementName).arg(latString));
+            m_reader->raiseError(QString("The latitude portions of \"%1\" are expected to have a value convertable to a double (value was \"%2\")").arg(elementName).arg(latString.toString()));
             return false;
         }
 
-        QString lngString = coords[1];
+        const QStringRef lngString(&strPoints, comma + 1, i - comma - 1);
         double lng = lngString.toDouble(&ok);
 
         if (!ok) {
-            m_reader->raiseError(QString("The longitude portions of \"%1\" are expected to have a value convertable to a double (value was \"%2\")").arg(elementName).arg(lngString));
+            m_reader->raiseError(QString("The longitude portions of \"%1\" are expected to have a value convertable to a double (value was \"%2\")").arg(elementName).arg(lngString.toString()));
             return false;
         }
 
-        QGeoCoordinate geoPoint(lat, lng);
-        geoPoints->append(geoPoint);
+        geoPoints->append(QGeoCoordinate(lat, lng));
     }
 
     return true;
@@ -50,17 +50,17 @@
 #define QROUTEXMLPARSER_H
 
 #include <QtLocation/QGeoManeuver>
+#include <QtLocation/QGeoRoute>
 #include <QtLocation/QGeoRouteSegment>
 #include <QtLocation/QGeoRouteRequest>
+#include <QtLocation/private/qgeoreplyparser_p.h>
 
 #include <QtCore/QList>
 #include <QtCore/QString>
 #include <QtCore/QScopedPointer>
 
 QT_BEGIN_NAMESPACE
-class QIODevice;
 class QXmlStreamReader;
-class QGeoRoute;
 class QGeoCoordinate;
 class QGeoRectangle;
 
@@ -92,15 +92,19 @@ public:
     int baseTime;
 };
 
-class QGeoRouteXmlParser
+class QGeoRouteXmlParser : public QGeoReplyParser
 {
+    Q_OBJECT
+
 public:
     QGeoRouteXmlParser(const QGeoRouteRequest &request);
     ~QGeoRouteXmlParser();
 
-    bool parse(QIODevice *source);
-    QList<QGeoRoute> results() const;
-    QString errorString() const;
+Q_SIGNALS:
+    void results(const QList<QGeoRoute> &routes);
+
+protected:
+    bool parseData(const QByteArray &data);
 
 private:
     bool parseRootElement();
@@ -121,7 +125,6 @@ private:
     QGeoRouteRequest m_request;
     QScopedPointer<QXmlStreamReader> m_reader;
     QList<QGeoRoute> m_results;
-    QString m_errorString;
     QList<QGeoManeuverContainer> m_maneuvers;
     QList<QGeoRouteSegmentContainer> m_segments;
 };
@@ -36,6 +36,7 @@
 #include <QtCore/QJsonDocument>
 #include <QtCore/QJsonObject>
 #include <QtCore/QJsonArray>
+#include <QtLocation/private/qgeoreplyparser_p.h>
 #include <QtPositioning/QGeoCoordinate>
 #include <QtPositioning/QGeoAddress>
 #include <QtPositioning/QGeoLocation>
@@ -44,7 +45,7 @@
 QT_BEGIN_NAMESPACE
 
 QGeoCodeReplyOsm::QGeoCodeReplyOsm(QNetworkReply *reply, QObject *parent)
-:   QGeoCodeReply(parent), m_reply(reply)
+:   QGeoCodeReply(parent), m_reply(reply), m_parsing(false)
 {
     connect(m_reply, SIGNAL(finished()), this, SLOT(networkReplyFinished()));
     connect(m_reply, SIGNAL(error(QNetworkReply::NetworkError)),
@@ -62,6 +63,9 @@ QGeoCodeReplyOsm::~QGeoCodeReplyOsm()
 
 void QGeoCodeReplyOsm::abort()
 {
+    // the document of a running parser is dropped
+    m_parsing = false;
+
     if (!m_reply)
         return;
 
@@ -79,8 +83,25 @@ void QGeoCodeReplyOsm::networkReplyFinished()
     if (m_reply->error() != QNetworkReply::NoError)
         return;
 
+    QGeoJsonReplyParser *parser = new QGeoJsonReplyParser;
+    connect(parser, SIGNAL(results(QJsonDocument)), this, SLOT(documentParsed(QJsonDocument)));
+    connect(parser, SIGNAL(error(QString)), this, SLOT(parserError(QString)));
+
+    m_parsing = true;
+    parser->parse(m_reply->readAll());
+
+    m_reply->deleteLater();
+    m_reply = 0;
+}
+
+void QGeoCodeReplyOsm::documentParsed(const QJsonDocument &document)
+{
+    if (!m_parsing)
+        return;
+
+    m_parsing = false;
+
     QList<QGeoLocation> locations;
-    QJsonDocument document = QJsonDocument::fromJson(m_reply->readAll());
 
     if (document.isObject()) {
         QJsonObject object = document.object();
@@ -158,9 +179,16 @@ void QGeoCodeReplyOsm::networkReplyFinished()
 
     setLocations(locations);
     setFinished(true);
+}
 
-    m_reply->deleteLater();
-    m_reply = 0;
+void QGeoCodeReplyOsm::parserError(const QString &errorString)
+{
+    if (!m_parsing)
+        return;
+
+    m_parsing = false;
+
+    setError(QGeoCodeReply::ParseError, errorString);
 }
 
 void QGeoCodeReplyOsm::networkReplyError(QNetworkReply::NetworkError error)
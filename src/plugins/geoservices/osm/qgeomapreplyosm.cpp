@@ -39,6 +39,7 @@ QGeoMapReplyOsm::QGeoMapReplyOsm(QNetworkReply *reply, const QGeoTileSpec &spec,
 :   QGeoTiledMapReply(spec, parent), m_reply(reply)
 {
     connect(m_reply, SIGNAL(finished()), this, SLOT(networkReplyFinished()));
+    connect(m_reply, SIGNAL(metaDataChanged()), this, SIGNAL(firstByteReceived()));
     connect(m_reply, SIGNAL(error(QNetworkReply::NetworkError)),
             this, SLOT(networkReplyError(QNetworkReply::NetworkError)));
     connect(m_reply, SIGNAL(destroyed()), this, SLOT(replyDestroyed()));
@@ -36,21 +36,25 @@
 #include <QtCore/QJsonDocument>
 #include <QtCore/QJsonObject>
 #include <QtCore/QJsonArray>
+#include <QtLocation/private/qgeoreplyparser_p.h>
 #include <QtLocation/QGeoRouteSegment>
 #include <QtLocation/QGeoManeuver>
+#include <QtLocation/private/qgeoroute_p.h>
+#include <QtLocation/private/qgeoroutesegment_p.h>
 
 QT_BEGIN_NAMESPACE
 
-static QList<QGeoCoordinate> parsePolyline(const QByteArray &data)
+static QGeoCoordinateArray parsePolyline(const QByteArray &data)
 {
-    QList<QGeoCoordinate> path;
+    QGeoCoordinateArray path;
 
     bool parsingLatitude = true;
 
     int shift = 0;
     int value = 0;
 
-    QGeoCoordinate coord(0, 0);
+    double latitude = 0.0;
+    double longitude = 0.0;
 
     for (int i = 0; i < data.length(); ++i) {
         unsigned char c = data.at(i) - 63;
@@ -65,10 +69,10 @@ static QList<QGeoCoordinate> parsePolyline(const QByteArray &data)
         int diff = (value & 1) ? ~(value >> 1) : (value >> 1);
 
         if (parsingLatitude) {
-            coord.setLatitude(coord.latitude() + (double)diff/1e6);
+            latitude += (double)diff/1e6;
         } else {
-            coord.setLongitude(coord.longitude() + (double)diff/1e6);
-            path.append(coord);
+            longitude += (double)diff/1e6;
+            path.append(latitude, longitude);
         }
 
         parsingLatitude = !parsingLatitude;
@@ -235,7 +239,7 @@ const QString osrmInstructionText(const QString &instructionCode, const QString
 
 QGeoRouteReplyOsm::QGeoRouteReplyOsm(QNetworkReply *reply, const QGeoRouteRequest &request,
                                      QObject *parent)
-:   QGeoRouteReply(request, parent), m_reply(reply)
+:   QGeoRouteReply(request, parent), m_reply(reply), m_parsing(false)
 {
     connect(m_reply, SIGNAL(finished()), this, SLOT(networkReplyFinished()));
     connect(m_reply, SIGNAL(error(QNetworkReply::NetworkError)),
@@ -250,6 +254,9 @@ QGeoRouteReplyOsm::~QGeoRouteReplyOsm()
 
 void QGeoRouteReplyOsm::abort()
 {
+    // the document of a running parser is dropped
+    m_parsing = false;
+
     if (!m_reply)
         return;
 
@@ -264,13 +271,12 @@ static QGeoRoute constructRoute(const QByteArray &geometry, const QJsonArray &in
 {
     QGeoRoute route;
 
-    QList<QGeoCoordinate> path = parsePolyline(geometry);
+    QGeoCoordinateArray path = parsePolyline(geometry);
+    QGeoRoutePrivate::setCompactPath(route, path);
 
-    QGeoRouteSegment firstSegment;
+    QList<QGeoRouteSegment> segments;
     int firstPosition = -1;
 
-    int segmentPathLengthCount = 0;
-
     for (int i = instructions.count() - 1; i >= 0; --i) {
         QJsonArray instruction = instructions.at(i).toArray();
 
@@ -300,25 +306,20 @@ static QGeoRoute constructRoute(const QByteArray &geometry, const QJsonArray &in
 
         segment.setManeuver(maneuver);
 
-        if (firstPosition == -1)
-            segment.setPath(path.mid(position));
-        else
-            segment.setPath(path.mid(position, firstPosition - position));
-
-        segmentPathLengthCount += segment.path().length();
+        // the segments are ranges of the route path, not copies of it
+        const int end = (firstPosition == -1) ? path.size() : qMin(firstPosition, path.size());
+        const int offset = qBound(0, position, end);
+        QGeoRouteSegmentPrivate::setPathRange(segment, path, offset, end - offset);
 
         segment.setTravelTime(time);
 
-        segment.setNextRouteSegment(firstSegment);
-
-        firstSegment = segment;
+        segments.prepend(segment);
         firstPosition = position;
     }
 
     route.setDistance(summary.value(QStringLiteral("total_distance")).toDouble());
     route.setTravelTime(summary.value(QStringLiteral("total_time")).toDouble());
-    route.setFirstRouteSegment(firstSegment);
-    route.setPath(path);
+    QGeoRoutePrivate::setSegments(route, segments);
 
     return route;
 }
@@ -335,7 +336,23 @@ void QGeoRouteReplyOsm::networkReplyFinished()
         return;
     }
 
-    QJsonDocument document = QJsonDocument::fromJson(m_reply->readAll());
+    QGeoJsonReplyParser *parser = new QGeoJsonReplyParser;
+    connect(parser, SIGNAL(results(QJsonDocument)), this, SLOT(documentParsed(QJsonDocument)));
+    connect(parser, SIGNAL(error(QString)), this, SLOT(parserError(QString)));
+
+    m_parsing = true;
+    parser->parse(m_reply->readAll());
+
+    m_reply->deleteLater();
+    m_reply = 0;
+}
+
+void QGeoRouteReplyOsm::documentParsed(const QJsonDocument &document)
+{
+    if (!m_parsing)
+        return;
+
+    m_parsing = false;
 
     if (document.isObject()) {
         QJsonObject object = document.object();
@@ -349,8 +366,6 @@ void QGeoRouteReplyOsm::networkReplyFinished()
         // an error occurred when trying to find a route
         if (0 != status) {
             setError(QGeoRouteReply::UnknownError, statusMessage);
-            m_reply->deleteLater();
-            m_reply = 0;
             return;
         }
 
@@ -389,9 +404,18 @@ void QGeoRouteReplyOsm::networkReplyFinished()
     } else {
         setError(QGeoRouteReply::ParseError, QStringLiteral("Couldn't parse json."));
     }
+}
 
-    m_reply->deleteLater();
-    m_reply = 0;
+void QGeoRouteReplyOsm::parserError(const QString &errorString)
+{
+    Q_UNUSED(errorString)
+
+    if (!m_parsing)
+        return;
+
+    m_parsing = false;
+
+    setError(QGeoRouteReply::ParseError, QStringLiteral("Couldn't parse json."));
 }
 
 void QGeoRouteReplyOsm::networkReplyError(QNetworkReply::NetworkError error)
@@ -34,6 +34,7 @@
 #ifndef QGEOROUTEREPLYOSM_H
 #define QGEOROUTEREPLYOSM_H
 
+#include <QtCore/QJsonDocument>
 #include <QtNetwork/QNetworkReply>
 #include <QtLocation/QGeoRouteReply>
 
@@ -53,9 +54,12 @@ public:
 private Q_SLOTS:
     void networkReplyFinished();
     void networkReplyError(QNetworkReply::NetworkError error);
+    void documentParsed(const QJsonDocument &document);
+    void parserError(const QString &errorString);
 
 private:
     QNetworkReply *m_reply;
+    bool m_parsing;
 };
 
 QT_END_NAMESPACE
@@ -60,6 +60,8 @@ QGeoTiledMappingManagerEngineOsm::QGeoTiledMappingManagerEngineOsm(const QVarian
         const QByteArray ua = parameters.value(QStringLiteral("useragent")).toString().toLatin1();
         tileFetcher->setUserAgent(ua);
     }
+    if (parameters.contains(QStringLiteral("mapping.host")))
+        tileFetcher->setMappingHost(parameters.value(QStringLiteral("mapping.host")).toString());
 
     setTileFetcher(tileFetcher);
 
@@ -51,11 +51,27 @@ void QGeoTileFetcherOsm::setUserAgent(const QByteArray &userAgent)
     m_userAgent = userAgent;
 }
 
+void QGeoTileFetcherOsm::setMappingHost(const QString &host)
+{
+    m_mappingHost = host;
+    if (!m_mappingHost.isEmpty() && !m_mappingHost.endsWith(QLatin1Char('/')))
+        m_mappingHost += QLatin1Char('/');
+}
+
 QGeoTiledMapReply *QGeoTileFetcherOsm::getTileImage(const QGeoTileSpec &spec)
 {
     QNetworkRequest request;
     request.setRawHeader("User-Agent", m_userAgent);
 
+    if (!m_mappingHost.isEmpty()) {
+        request.setUrl(QUrl(m_mappingHost +
+                            QString::number(spec.mapId()) + QLatin1Char('/') +
+                            QString::number(spec.zoom()) + QLatin1Char('/') +
+                            QString::number(spec.x()) + QLatin1Char('/') +
+                            QString::number(spec.y()) + QStringLiteral(".png")));
+        return new QGeoMapReplyOsm(m_networkManager->get(request), spec);
+    }
+
     switch (spec.mapId()) {
         case 1:
             // opensteetmap.org street map
@@ -80,4 +96,10 @@ QGeoTiledMapReply *QGeoTileFetcherOsm::getTileImage(const QGeoTileSpec &spec)
     return new QGeoMapReplyOsm(reply, spec);
 }
 
+QString QGeoTileFetcherOsm::hostForTile(const QGeoTileSpec &spec) const
+{
+    // each map type is served by its own tile server
+    return QString::number(spec.mapId());
+}
+
 QT_END_NAMESPACE
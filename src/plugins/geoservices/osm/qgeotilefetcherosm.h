@@ -49,12 +49,17 @@ public:
     QGeoTileFetcherOsm(QObject *parent = 0);
 
     void setUserAgent(const QByteArray &userAgent);
+    void setMappingHost(const QString &host);
+
+protected:
+    QString hostForTile(const QGeoTileSpec &spec) const;
 
 private:
     QGeoTiledMapReply *getTileImage(const QGeoTileSpec &spec);
 
     QNetworkAccessManager *m_networkManager;
     QByteArray m_userAgent;
+    QString m_mappingHost;
 };
 
 QT_END_NAMESPACE
@@ -40,11 +40,250 @@
 #include <QtCore/qtimer.h>
 #include <QtCore/qdebug.h>
 #include <QtCore/qmutex.h>
+#include <QtCore/qmath.h>
+
+#include <algorithm>
+#include <limits>
 
 #define UPDATE_INTERVAL_5S  5000
 
+// limits of the adaptive update interval, see adaptUpdateInterval()
+#define ADAPTIVE_MAXIMUM_INTERVAL   600000
+#define ADAPTIVE_SEARCH_RINGS       32
+// speeds in m/s assumed for fixes without GroundSpeed and at the least
+#define ADAPTIVE_DEFAULT_SPEED      30.0
+#define ADAPTIVE_MINIMUM_SPEED      1.5
+
+#define METERS_PER_DEGREE           111195.08
+
 typedef QHash<QString, QGeoAreaMonitorInfo> MonitorTable;
 
+/*
+ * Grid over latitude and longitude which maps each cell to the monitors
+ * whose area overlaps it, so that a position update only tests the
+ * monitors of its own cell. Areas covering more than MaximumCells cells,
+ * or a pole, are not put into the grid and are tested on every update.
+ **/
+class MonitorIndex
+{
+public:
+    void insert(const QGeoAreaMonitorInfo &monitor)
+    {
+        const QString identifier = monitor.identifier();
+        remove(identifier);
+
+        QVector<quint64> keys;
+        if (!cellsForArea(monitor.area(), &keys)) {
+            unindexed.insert(identifier);
+            return;
+        }
+
+        foreach (quint64 key, keys)
+            cells[key].append(identifier);
+        cellsOfMonitor.insert(identifier, keys);
+    }
+
+    void remove(const QString &identifier)
+    {
+        if (unindexed.remove(identifier))
+            return;
+
+        const QVector<quint64> keys = cellsOfMonitor.take(identifier);
+        foreach (quint64 key, keys) {
+            QHash<quint64, QStringList>::iterator cell = cells.find(key);
+            if (cell == cells.end())
+                continue;
+            cell->removeOne(identifier);
+            if (cell->isEmpty())
+                cells.erase(cell);
+        }
+    }
+
+    // the monitors whose area may contain coordinate
+    QStringList candidates(const QGeoCoordinate &coordinate) const
+    {
+        QStringList result = unindexed.toList();
+        if (coordinate.isValid())
+            result += ring(coordinate, 0);
+        return result;
+    }
+
+    // the indexed monitors in the cells distance cells away from coordinate
+    QStringList ring(const QGeoCoordinate &coordinate, int distance) const
+    {
+        const int centerRow = row(coordinate.latitude());
+        const int centerColumn = column(coordinate.longitude());
+
+        QStringList result;
+        for (int r = centerRow - distance; r <= centerRow + distance; ++r) {
+            if (r < 0 || r >= Rows)
+                continue;
+            const bool edgeRow = qAbs(r - centerRow) == distance;
+            const int step = edgeRow ? 1 : 2 * distance;
+            for (int c = centerColumn - distance; c <= centerColumn + distance; c += step) {
+                QHash<quint64, QStringList>::const_iterator cell = cells.constFind(cellKey(r, c));
+                if (cell != cells.constEnd())
+                    result += *cell;
+            }
+        }
+        return result;
+    }
+
+    // the narrowest width in meters of the cells within rings of latitude
+    static double cellWidth(double latitude, int rings)
+    {
+        const double edge = qMin(qAbs(latitude) + (rings + 1) * CellSize, 89.0);
+        return CellSize * METERS_PER_DEGREE * qCos(qDegreesToRadians(edge));
+    }
+
+    const QSet<QString> &unindexedMonitors() const
+    {
+        return unindexed;
+    }
+
+private:
+    enum {
+        Rows = 18000,
+        Columns = 36000,
+        MaximumCells = 4096
+    };
+
+    static int row(double latitude)
+    {
+        return qBound(0, int((latitude + 90.0) / CellSize), Rows - 1);
+    }
+
+    // unbounded, cellKey() wraps it around the dateline
+    static int column(double longitude)
+    {
+        return int(qFloor((longitude + 180.0) / CellSize));
+    }
+
+    static quint64 cellKey(int row, int column)
+    {
+        return quint64(row) * Columns + ((column % Columns) + Columns) % Columns;
+    }
+
+    static bool cellsForArea(const QGeoShape &area, QVector<quint64> *keys)
+    {
+        double north;
+        double south;
+        double west;
+        double east;
+
+        switch (area.type()) {
+        case QGeoShape::CircleType:
+        {
+            const QGeoCircle circle(area);
+            const double latitude = circle.center().latitude();
+            // a little larger than the radius QGeoCoordinate::distanceTo() uses
+            const double angle = circle.radius() / 6371000.0;
+            const double latitudeSpan = qRadiansToDegrees(angle);
+            north = latitude + latitudeSpan;
+            south = latitude - latitudeSpan;
+            if (north >= 90.0 || south <= -90.0)
+                return false;
+            const double longitudeSpan =
+                    qRadiansToDegrees(qAsin(qSin(angle) / qCos(qDegreesToRadians(latitude))));
+            west = circle.center().longitude() - longitudeSpan;
+            east = circle.center().longitude() + longitudeSpan;
+            break;
+        }
+        case QGeoShape::RectangleType:
+        {
+            const QGeoRectangle rectangle(area);
+            north = rectangle.topLeft().latitude();
+            south = rectangle.bottomRight().latitude();
+            west = rectangle.topLeft().longitude();
+            east = rectangle.bottomRight().longitude();
+            if (east < west)
+                east += 360.0;
+            break;
+        }
+        default:
+            return false;
+        }
+
+        const int firstRow = row(south);
+        const int lastRow = row(north);
+        const int firstColumn = column(west);
+        const int lastColumn = column(east);
+        if (qint64(lastRow - firstRow + 1) * (lastColumn - firstColumn + 1) > MaximumCells)
+            return false;
+
+        for (int r = firstRow; r <= lastRow; ++r) {
+            for (int c = firstColumn; c <= lastColumn; ++c)
+                keys->append(cellKey(r, c));
+        }
+        return true;
+    }
+
+    static const double CellSize;
+
+    QHash<quint64, QStringList> cells;
+    QHash<QString, QVector<quint64> > cellsOfMonitor;
+    QSet<QString> unindexed;
+};
+
+// about a kilometer, the size of a typical geofence
+const double MonitorIndex::CellSize = 0.01;
+
+/*
+ * Distance in meters from coordinate to the border of area. Rectangles
+ * are measured on a local flat approximation, which is plenty for
+ * choosing when to take the next fix.
+ **/
+static double boundaryDistance(const QGeoShape &area, const QGeoCoordinate &coordinate)
+{
+    switch (area.type()) {
+    case QGeoShape::CircleType:
+    {
+        const QGeoCircle circle(area);
+        return qAbs(circle.center().distanceTo(coordinate) - circle.radius());
+    }
+    case QGeoShape::RectangleType:
+    {
+        const QGeoRectangle rectangle(area);
+        const double west = rectangle.topLeft().longitude();
+        double width = rectangle.bottomRight().longitude() - west;
+        if (width < 0.0)
+            width += 360.0;
+        double x = coordinate.longitude() - west;
+        if (x < 0.0)
+            x += 360.0;
+
+        const double north = rectangle.topLeft().latitude();
+        const double south = rectangle.bottomRight().latitude();
+        const double y = coordinate.latitude();
+        const double xScale = qCos(qDegreesToRadians(y));
+
+        if (x <= width && y >= south && y <= north) {
+            const double dx = qMin(x, width - x) * xScale;
+            const double dy = qMin(north - y, y - south);
+            return qMin(dx, dy) * METERS_PER_DEGREE;
+        }
+
+        const double dx = x <= width ? 0.0 : qMin(x - width, 360.0 - x) * xScale;
+        const double dy = qMax(0.0, qMax(y - north, south - y));
+        return qSqrt(dx * dx + dy * dy) * METERS_PER_DEGREE;
+    }
+    default:
+        return 0.0;
+    }
+}
+
+struct MonitorExpiry
+{
+    QDateTime expiration;
+    QString identifier;
+};
+
+// orders the expiry heap so that the earliest expiration is on top
+static bool laterExpiry(const MonitorExpiry &a, const MonitorExpiry &b)
+{
+    return b.expiration < a.expiration;
+}
+
 
 static QMetaMethod areaEnteredSignal()
 {
@@ -68,7 +307,8 @@ class QGeoAreaMonitorPollingPrivate : public QObject
 {
     Q_OBJECT
 public:
-    QGeoAreaMonitorPollingPrivate() : source(0), mutex(QMutex::Recursive)
+    QGeoAreaMonitorPollingPrivate()
+        : source(0), baseInterval(0), adaptive(false), mutex(QMutex::Recursive)
     {
         nextExpiryTimer = new QTimer(this);
         nextExpiryTimer->setSingleShot(true);
@@ -80,7 +320,7 @@ public:
     {
         QMutexLocker locker(&mutex);
 
-        activeMonitorAreas.insert(monitor.identifier(), monitor);
+        insertMonitor(monitor);
         singleShotTrigger.remove(monitor.identifier());
 
         checkStartStop();
@@ -91,7 +331,7 @@ public:
     {
         QMutexLocker locker(&mutex);
 
-        activeMonitorAreas.insert(monitor.identifier(), monitor);
+        insertMonitor(monitor);
         singleShotTrigger.insert(monitor.identifier(), signalId);
 
         checkStartStop();
@@ -102,7 +342,7 @@ public:
     {
         QMutexLocker locker(&mutex);
 
-        QGeoAreaMonitorInfo mon = activeMonitorAreas.take(monitor.identifier());
+        QGeoAreaMonitorInfo mon = takeMonitor(monitor.identifier());
 
         checkStartStop();
         setupNextExpiryTimeout();
@@ -152,6 +392,8 @@ public:
             source->moveToThread(this->thread());
             if (source->updateInterval() == 0)
                 source->setUpdateInterval(UPDATE_INTERVAL_5S);
+            baseInterval = source->updateInterval();
+            adaptive = false;
             disconnect(source, 0, 0, 0); //disconnect all
             connect(source, SIGNAL(positionUpdated(QGeoPositionInfo)),
                     this, SLOT(positionUpdated(QGeoPositionInfo)));
@@ -174,6 +416,28 @@ public:
         return activeMonitorAreas;
     }
 
+    /*
+     * The monitors which may change state at coordinate: those whose area
+     * may contain it and those it may have left. The others are outside
+     * before and after, so they would emit nothing.
+     **/
+    QList<QGeoAreaMonitorInfo> candidateMonitors(const QGeoCoordinate &coordinate) const
+    {
+        QMutexLocker locker(&mutex);
+
+        QSet<QString> identifiers = insideArea;
+        foreach (const QString &identifier, monitorIndex.candidates(coordinate))
+            identifiers.insert(identifier);
+
+        QList<QGeoAreaMonitorInfo> result;
+        foreach (const QString &identifier, identifiers) {
+            MonitorTable::const_iterator it = activeMonitorAreas.constFind(identifier);
+            if (it != activeMonitorAreas.constEnd())
+                result.append(*it);
+        }
+        return result;
+    }
+
     void checkStartStop()
     {
         QMutexLocker locker(&mutex);
@@ -196,27 +460,106 @@ public:
             if (source)
                 source->stopUpdates();
         }
+
+        resetUpdateInterval();
+    }
+
+    /*
+     * The tightest detection latency asked for by the clients listening
+     * for area events, or 0 if any of them wants the fixed interval.
+     **/
+    int detectionLatency() const
+    {
+        QMutexLocker locker(&mutex);
+
+        int latency = 0;
+        foreach (const QGeoAreaMonitorPolling *client, registeredClients) {
+            if (!client->signalsAreConnected)
+                continue;
+            if (client->maximumDetectionLatency() <= 0)
+                return 0;
+            latency = latency ? qMin(latency, client->maximumDetectionLatency())
+                              : client->maximumDetectionLatency();
+        }
+        return latency;
+    }
+
+    /*
+     * Restarts adaptive sampling from the detection latency, as a new
+     * monitor may be nearer than the current interval allows for, or
+     * goes back to the fixed interval when adaptive sampling is off.
+     **/
+    void resetUpdateInterval()
+    {
+        QMutexLocker locker(&mutex);
+
+        if (!source)
+            return;
+
+        const int latency = detectionLatency();
+        if (latency > 0) {
+            if (!adaptive || source->updateInterval() > latency)
+                source->setUpdateInterval(latency);
+            adaptive = true;
+        } else if (adaptive) {
+            source->setUpdateInterval(baseInterval);
+            adaptive = false;
+        }
     }
 
 private:
+    void insertMonitor(const QGeoAreaMonitorInfo &monitor)
+    {
+        activeMonitorAreas.insert(monitor.identifier(), monitor);
+        monitorIndex.insert(monitor);
+
+        if (monitor.expiration().isValid()) {
+            MonitorExpiry expiry = { monitor.expiration(), monitor.identifier() };
+            expiryHeap.append(expiry);
+            std::push_heap(expiryHeap.begin(), expiryHeap.end(), laterExpiry);
+        }
+    }
+
+    QGeoAreaMonitorInfo takeMonitor(const QString &identifier)
+    {
+        // the expiry heap is cleaned up lazily in setupNextExpiryTimeout()
+        monitorIndex.remove(identifier);
+        return activeMonitorAreas.take(identifier);
+    }
+
+    // true if the expiry no longer belongs to an active monitor
+    bool isStale(const MonitorExpiry &expiry) const
+    {
+        MonitorTable::const_iterator it = activeMonitorAreas.constFind(expiry.identifier);
+        return it == activeMonitorAreas.constEnd() || it->expiration() != expiry.expiration;
+    }
+
     void setupNextExpiryTimeout()
     {
         nextExpiryTimer->stop();
         activeExpiry.first = QDateTime();
         activeExpiry.second = QString();
 
-        foreach (const QGeoAreaMonitorInfo &info, activeMonitors()) {
-            if (info.expiration().isValid()) {
-                if (!activeExpiry.first.isValid()) {
-                    activeExpiry.first = info.expiration();
-                    activeExpiry.second = info.identifier();
-                    continue;
-                }
-                if (info.expiration() < activeExpiry.first) {
-                    activeExpiry.first = info.expiration();
-                    activeExpiry.second = info.identifier();
-                }
+        // stopped and updated monitors leave entries behind, rebuild the
+        // heap once they are the majority so that it stays bounded
+        if (expiryHeap.size() > 2 * activeMonitorAreas.size() + 16) {
+            QVector<MonitorExpiry> live;
+            foreach (const MonitorExpiry &expiry, expiryHeap) {
+                if (!isStale(expiry))
+                    live.append(expiry);
             }
+            expiryHeap = live;
+            std::make_heap(expiryHeap.begin(), expiryHeap.end(), laterExpiry);
+        }
+
+        while (!expiryHeap.isEmpty() && isStale(expiryHeap.first())) {
+            std::pop_heap(expiryHeap.begin(), expiryHeap.end(), laterExpiry);
+            expiryHeap.removeLast();
+        }
+
+        if (!expiryHeap.isEmpty()) {
+            activeExpiry.first = expiryHeap.first().expiration;
+            activeExpiry.second = expiryHeap.first().identifier;
         }
 
         if (activeExpiry.first.isValid())
@@ -231,7 +574,7 @@ private:
             if (singleShotTrigger.value(monitorIdent, -1) == areaEnteredSignal().methodIndex()) {
                 //this is the finishing singleshot event
                 singleShotTrigger.remove(monitorIdent);
-                activeMonitorAreas.remove(monitorIdent);
+                takeMonitor(monitorIdent);
                 setupNextExpiryTimeout();
             } else {
                 insideArea.insert(monitorIdent);
@@ -249,7 +592,7 @@ private:
             if (singleShotTrigger.value(monitorIdent, -1) == areaExitedSignal().methodIndex()) {
                 //this is the finishing singleShot event
                 singleShotTrigger.remove(monitorIdent);
-                activeMonitorAreas.remove(monitorIdent);
+                takeMonitor(monitorIdent);
                 setupNextExpiryTimeout();
             } else {
                 insideArea.remove(monitorIdent);
@@ -273,7 +616,7 @@ private Q_SLOTS:
          * Don't block timer firing even if monitorExpiredSignal is not connected.
          * This allows us to continue to remove the existing monitors as they expire.
          **/
-        const QGeoAreaMonitorInfo info = activeMonitorAreas.take(activeExpiry.second);
+        const QGeoAreaMonitorInfo info = takeMonitor(activeExpiry.second);
         setupNextExpiryTimeout();
         emit timeout(info);
 
@@ -281,7 +624,7 @@ private Q_SLOTS:
 
     void positionUpdated(const QGeoPositionInfo &info)
     {
-        foreach (const QGeoAreaMonitorInfo &monInfo, activeMonitors()) {
+        foreach (const QGeoAreaMonitorInfo &monInfo, candidateMonitors(info.coordinate())) {
             const QString identifier = monInfo.identifier();
             if (monInfo.area().contains(info.coordinate())) {
                 if (processInsideArea(identifier))
@@ -291,6 +634,78 @@ private Q_SLOTS:
                     emit areaEventDetected(monInfo, info, false);
             }
         }
+
+        adaptUpdateInterval(info);
+    }
+
+private:
+    /*
+     * Distance in meters to the nearest border of any monitored area,
+     * searching the index ring by ring until no closer area can be found.
+     * Areas further than ADAPTIVE_SEARCH_RINGS cells count as that far.
+     **/
+    double nearestBoundary(const QGeoCoordinate &coordinate) const
+    {
+        QMutexLocker locker(&mutex);
+
+        if (!coordinate.isValid())
+            return 0.0;
+
+        double nearest = std::numeric_limits<double>::infinity();
+        QSet<QString> identifiers = insideArea;
+        identifiers += monitorIndex.unindexedMonitors();
+        foreach (const QString &identifier, identifiers) {
+            MonitorTable::const_iterator it = activeMonitorAreas.constFind(identifier);
+            if (it != activeMonitorAreas.constEnd())
+                nearest = qMin(nearest, boundaryDistance(it->area(), coordinate));
+        }
+
+        // areas not in rings below n are at least n - 1 cells away
+        const double width = MonitorIndex::cellWidth(coordinate.latitude(), ADAPTIVE_SEARCH_RINGS);
+        for (int ring = 0; ring <= ADAPTIVE_SEARCH_RINGS; ++ring) {
+            if ((ring - 1) * width >= nearest)
+                return nearest;
+
+            foreach (const QString &identifier, monitorIndex.ring(coordinate, ring)) {
+                MonitorTable::const_iterator it = activeMonitorAreas.constFind(identifier);
+                if (it != activeMonitorAreas.constEnd())
+                    nearest = qMin(nearest, boundaryDistance(it->area(), coordinate));
+            }
+        }
+
+        return qMin(nearest, ADAPTIVE_SEARCH_RINGS * width);
+    }
+
+    /*
+     * No area border can be crossed before the device covers the distance
+     * to the nearest one, so the next fix is due that long plus the allowed
+     * detection latency from now. Without a ground speed the device is
+     * assumed to drive, and a slow one may speed up, so the speed has a
+     * floor.
+     **/
+    void adaptUpdateInterval(const QGeoPositionInfo &info)
+    {
+        QMutexLocker locker(&mutex);
+
+        if (!source || !adaptive)
+            return;
+
+        const int latency = detectionLatency();
+        if (latency <= 0)
+            return;
+
+        qreal speed = ADAPTIVE_DEFAULT_SPEED;
+        if (info.hasAttribute(QGeoPositionInfo::GroundSpeed))
+            speed = qMax(qreal(info.attribute(QGeoPositionInfo::GroundSpeed)), qreal(ADAPTIVE_MINIMUM_SPEED));
+
+        const double interval = latency + 1000.0 * nearestBoundary(info.coordinate()) / speed;
+        const int next = qMax(source->minimumUpdateInterval(),
+                              int(qMin(interval, double(ADAPTIVE_MAXIMUM_INTERVAL))));
+
+        // small changes are not worth restarting the source for
+        const int current = source->updateInterval();
+        if (qAbs(next - current) > current / 10)
+            source->setUpdateInterval(next);
     }
 
 private:
@@ -300,8 +715,12 @@ private:
     QSet<QString> insideArea;
 
     MonitorTable activeMonitorAreas;
+    MonitorIndex monitorIndex;
+    QVector<MonitorExpiry> expiryHeap;
 
     QGeoPositionInfoSource* source;
+    int baseInterval;
+    bool adaptive;
     QList<QGeoAreaMonitorPolling*> registeredClients;
     mutable QMutex mutex;
 };
@@ -310,7 +729,7 @@ Q_GLOBAL_STATIC(QGeoAreaMonitorPollingPrivate, pollingPrivate)
 
 
 QGeoAreaMonitorPolling::QGeoAreaMonitorPolling(QObject *parent)
-    : QGeoAreaMonitorSource(parent), signalsAreConnected(false)
+    : QGeoAreaMonitorSource(parent), signalsAreConnected(false), detectionLatency(0)
 {
     d = pollingPrivate();
     lastError = QGeoAreaMonitorSource::NoError;
@@ -335,6 +754,23 @@ void QGeoAreaMonitorPolling::setPositionInfoSource(QGeoPositionInfoSource *sourc
     d->setPositionSource(source);
 }
 
+/*
+ * Maximum time in milliseconds between crossing the border of a monitored
+ * area and the event for it. When set, the update interval of the position
+ * source follows the distance to the nearest area instead of staying fixed.
+ * 0, the default, keeps the fixed interval.
+ **/
+int QGeoAreaMonitorPolling::maximumDetectionLatency() const
+{
+    return detectionLatency;
+}
+
+void QGeoAreaMonitorPolling::setMaximumDetectionLatency(int msec)
+{
+    detectionLatency = qMax(0, msec);
+    d->resetUpdateInterval();
+}
+
 QGeoAreaMonitorSource::Error QGeoAreaMonitorPolling::error() const
 {
     return lastError;
@@ -47,6 +47,7 @@ class QGeoAreaMonitorPollingPrivate;
 class QGeoAreaMonitorPolling : public QGeoAreaMonitorSource
 {
     Q_OBJECT
+    Q_PROPERTY(int maximumDetectionLatency READ maximumDetectionLatency WRITE setMaximumDetectionLatency)
 public :
     explicit QGeoAreaMonitorPolling(QObject *parent = 0);
     ~QGeoAreaMonitorPolling();
@@ -68,6 +69,9 @@ public :
 
     inline bool isValid() { return positionInfoSource(); }
 
+    int maximumDetectionLatency() const;
+    void setMaximumDetectionLatency(int msec);
+
     bool signalsAreConnected;
 
 private Q_SLOTS:
@@ -78,6 +82,7 @@ private Q_SLOTS:
 private:
     QGeoAreaMonitorPollingPrivate* d;
     QGeoAreaMonitorSource::Error lastError;
+    int detectionLatency;
 
     void connectNotify(const QMetaMethod &signal);
     void disconnectNotify(const QMetaMethod &signal);
@@ -44,6 +44,7 @@ PRIVATE_HEADERS += \
                     qlocationutils_p.h \
                     qnmeapositioninfosource_p.h \
                     qgeocoordinate_p.h \
+                    qgeocoordinatearray_p.h \
                     qgeopositioninfosource_p.h \
                     qdeclarativegeoaddress_p.h \
                     qdeclarativegeolocation_p.h \
@@ -59,6 +60,7 @@ SOURCES += \
             qgeorectangle.cpp \
             qgeocircle.cpp \
             qgeocoordinate.cpp \
+            qgeocoordinatearray.cpp \
             qgeolocation.cpp \
             qgeopositioninfo.cpp \
             qgeopositioninfosource.cpp \
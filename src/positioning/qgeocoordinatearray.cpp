@@ -0,0 +1,163 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtLocation module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia. For licensing terms and
+** conditions see http://qt.digia.com/licensing. For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights. These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+#include "qgeocoordinatearray_p.h"
+
+QT_BEGIN_NAMESPACE
+
+// the same comparison as QGeoCoordinate::operator==()
+static bool fuzzyEqual(const QGeoPackedCoordinate &a, const QGeoPackedCoordinate &b)
+{
+    bool latEqual = (qIsNaN(a.latitude) && qIsNaN(b.latitude))
+                        || qFuzzyCompare(a.latitude, b.latitude);
+    bool lngEqual = (qIsNaN(a.longitude) && qIsNaN(b.longitude))
+                        || qFuzzyCompare(a.longitude, b.longitude);
+    bool altEqual = (qIsNaN(a.altitude) && qIsNaN(b.altitude))
+                        || qFuzzyCompare(a.altitude, b.altitude);
+
+    if (!qIsNaN(a.latitude) && ((a.latitude == 90.0) || (a.latitude == -90.0)))
+        lngEqual = true;
+
+    return (latEqual && lngEqual && altEqual);
+}
+
+static inline QGeoPackedCoordinate pack(const QGeoCoordinate &coordinate)
+{
+    QGeoPackedCoordinate p = { coordinate.latitude(), coordinate.longitude(), coordinate.altitude() };
+    return p;
+}
+
+QGeoCoordinateArray::QGeoCoordinateArray()
+{
+}
+
+QGeoCoordinateArray::QGeoCoordinateArray(const QList<QGeoCoordinate> &coordinates)
+{
+    points_.reserve(coordinates.size());
+    for (int i = 0; i < coordinates.size(); ++i)
+        points_.append(pack(coordinates.at(i)));
+}
+
+QGeoCoordinateArray QGeoCoordinateArray::fromList(const QList<QGeoCoordinate> &coordinates)
+{
+    return QGeoCoordinateArray(coordinates);
+}
+
+QList<QGeoCoordinate> QGeoCoordinateArray::toList() const
+{
+    QList<QGeoCoordinate> coordinates;
+    coordinates.reserve(points_.size());
+    for (int i = 0; i < points_.size(); ++i)
+        coordinates.append(at(i));
+    return coordinates;
+}
+
+/*
+ * Returns the coordinate at \a i. This allocates, so loops over many points
+ * should read latitude(), longitude() and altitude() instead.
+ */
+QGeoCoordinate QGeoCoordinateArray::at(int i) const
+{
+    const QGeoPackedCoordinate &p = points_.at(i);
+
+    // the setters keep invalid values, the constructors would drop them
+    QGeoCoordinate coordinate;
+    coordinate.setLatitude(p.latitude);
+    coordinate.setLongitude(p.longitude);
+    coordinate.setAltitude(p.altitude);
+    return coordinate;
+}
+
+/*
+ * Sets \a coordinate to the coordinate at \a i. A coordinate that is not
+ * shared is updated in place, so reusing one for every point of a loop does
+ * not allocate.
+ */
+void QGeoCoordinateArray::coordinateAt(int i, QGeoCoordinate *coordinate) const
+{
+    const QGeoPackedCoordinate &p = points_.at(i);
+    coordinate->setLatitude(p.latitude);
+    coordinate->setLongitude(p.longitude);
+    coordinate->setAltitude(p.altitude);
+}
+
+void QGeoCoordinateArray::append(const QGeoCoordinate &coordinate)
+{
+    points_.append(pack(coordinate));
+}
+
+void QGeoCoordinateArray::append(const QGeoCoordinateArray &other)
+{
+    points_ += other.points_;
+}
+
+void QGeoCoordinateArray::replace(int i, const QGeoCoordinate &coordinate)
+{
+    points_.replace(i, pack(coordinate));
+}
+
+void QGeoCoordinateArray::removeAt(int i)
+{
+    points_.remove(i);
+}
+
+int QGeoCoordinateArray::lastIndexOf(const QGeoCoordinate &coordinate) const
+{
+    QGeoPackedCoordinate p = pack(coordinate);
+    for (int i = points_.size() - 1; i >= 0; --i) {
+        if (fuzzyEqual(points_.at(i), p))
+            return i;
+    }
+    return -1;
+}
+
+QGeoCoordinateArray QGeoCoordinateArray::mid(int pos, int length) const
+{
+    QGeoCoordinateArray result;
+    result.points_ = points_.mid(pos, length);
+    return result;
+}
+
+bool QGeoCoordinateArray::operator==(const QGeoCoordinateArray &other) const
+{
+    if (points_.size() != other.points_.size())
+        return false;
+    if (points_.constData() == other.points_.constData())
+        return true;
+    for (int i = 0; i < points_.size(); ++i) {
+        if (!fuzzyEqual(points_.at(i), other.points_.at(i)))
+            return false;
+    }
+    return true;
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,142 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the QtLocation module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia. For licensing terms and
+** conditions see http://qt.digia.com/licensing. For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights. These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+#ifndef QGEOCOORDINATEARRAY_P_H
+#define QGEOCOORDINATEARRAY_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qpositioningglobal.h"
+#include "qgeocoordinate.h"
+
+#include <QtCore/qlist.h>
+#include <QtCore/qvector.h>
+#include <QtCore/qmetatype.h>
+
+QT_BEGIN_NAMESPACE
+
+struct QGeoPackedCoordinate
+{
+    double latitude;
+    double longitude;
+    double altitude;
+};
+
+Q_DECLARE_TYPEINFO(QGeoPackedCoordinate, Q_PRIMITIVE_TYPE);
+
+/*
+ * An implicitly shared array of coordinates stored as plain doubles in one
+ * contiguous block, for paths with many points. Unlike QList<QGeoCoordinate>
+ * it needs no allocation per point, and loops over it do not chase pointers.
+ *
+ * Coordinates are stored as they are given, invalid ones included, so
+ * converting a list to an array and back gives an equal list.
+ */
+class Q_POSITIONING_EXPORT QGeoCoordinateArray
+{
+public:
+    QGeoCoordinateArray();
+    explicit QGeoCoordinateArray(const QList<QGeoCoordinate> &coordinates);
+
+    static QGeoCoordinateArray fromList(const QList<QGeoCoordinate> &coordinates);
+    QList<QGeoCoordinate> toList() const;
+
+    inline int size() const { return points_.size(); }
+    inline bool isEmpty() const { return points_.isEmpty(); }
+    inline void reserve(int size) { points_.reserve(size); }
+    inline void clear() { points_.clear(); }
+
+    inline double latitude(int i) const { return points_.at(i).latitude; }
+    inline double longitude(int i) const { return points_.at(i).longitude; }
+    inline double altitude(int i) const { return points_.at(i).altitude; }
+    inline bool isValid(int i) const;
+
+    QGeoCoordinate at(int i) const;
+    void coordinateAt(int i, QGeoCoordinate *coordinate) const;
+    inline QGeoCoordinate first() const { return at(0); }
+    inline QGeoCoordinate last() const { return at(size() - 1); }
+
+    inline void append(double latitude, double longitude, double altitude = qQNaN());
+    void append(const QGeoCoordinate &coordinate);
+    void append(const QGeoCoordinateArray &other);
+    void replace(int i, const QGeoCoordinate &coordinate);
+    inline void replace(int i, double latitude, double longitude, double altitude);
+    void removeAt(int i);
+    int lastIndexOf(const QGeoCoordinate &coordinate) const;
+    QGeoCoordinateArray mid(int pos, int length = -1) const;
+
+    inline const QGeoPackedCoordinate *constData() const { return points_.constData(); }
+
+    bool operator==(const QGeoCoordinateArray &other) const;
+    inline bool operator!=(const QGeoCoordinateArray &other) const { return !operator==(other); }
+
+private:
+    QVector<QGeoPackedCoordinate> points_;
+};
+
+Q_DECLARE_TYPEINFO(QGeoCoordinateArray, Q_MOVABLE_TYPE);
+
+inline bool QGeoCoordinateArray::isValid(int i) const
+{
+    const QGeoPackedCoordinate &p = points_.at(i);
+    return p.latitude >= -90 && p.latitude <= 90
+            && p.longitude >= -180 && p.longitude <= 180;
+}
+
+inline void QGeoCoordinateArray::append(double latitude, double longitude, double altitude)
+{
+    QGeoPackedCoordinate p = { latitude, longitude, altitude };
+    points_.append(p);
+}
+
+inline void QGeoCoordinateArray::replace(int i, double latitude, double longitude, double altitude)
+{
+    QGeoPackedCoordinate &p = points_[i];
+    p.latitude = latitude;
+    p.longitude = longitude;
+    p.altitude = altitude;
+}
+
+QT_END_NAMESPACE
+
+Q_DECLARE_METATYPE(QGeoCoordinateArray)
+
+#endif // QGEOCOORDINATEARRAY_P_H
@@ -33,6 +33,7 @@
 #include "qgeoprojection_p.h"
 
 #include "qgeocoordinate.h"
+#include "qgeocoordinatearray_p.h"
 
 #include <qnumeric.h>
 
@@ -95,6 +96,72 @@ QGeoCoordinate QGeoProjection::mercatorToCoord(const QDoubleVector2D &mercator)
     return QGeoCoordinate(lat, lng, 0.0);
 }
 
+/*
+    Projects all of \a coords into \a mercator, which must have room for
+    coords.size() points. The results are identical to those of projecting
+    each coordinate on its own, but the loop reads the packed doubles directly
+    and has no calls the compiler cannot see through apart from the math.
+*/
+void QGeoProjection::coordToMercator(const QGeoCoordinateArray &coords, QDoubleVector2D *mercator)
+{
+    const double pi = M_PI;
+    const QGeoPackedCoordinate *p = coords.constData();
+    const int count = coords.size();
+
+    for (int i = 0; i < count; ++i) {
+        double lon = p[i].longitude / 360.0 + 0.5;
+
+        double lat = p[i].latitude;
+        lat = 0.5 - (std::log(std::tan((pi / 4.0) + (pi / 2.0) * lat / 180.0)) / pi) / 2.0;
+        lat = qBound(0.0, lat, 1.0);
+
+        mercator[i] = QDoubleVector2D(lon, lat);
+    }
+}
+
+/*
+    Appends the coordinates of the \a count points in \a mercator to
+    \a coords.
+*/
+void QGeoProjection::mercatorToCoord(const QDoubleVector2D *mercator, int count,
+                                     QGeoCoordinateArray *coords)
+{
+    const double pi = M_PI;
+    coords->reserve(coords->size() + count);
+
+    for (int i = 0; i < count; ++i) {
+        double fy = mercator[i].y();
+        if (fy < 0.0)
+            fy = 0.0;
+        else if (fy > 1.0)
+            fy = 1.0;
+
+        double lat;
+        if (fy == 0.0)
+            lat = 90.0;
+        else if (fy == 1.0)
+            lat = -90.0;
+        else
+            lat = (180.0 / pi) * (2.0 * std::atan(std::exp(pi * (1.0 - 2.0 * fy))) - (pi / 2.0));
+
+        double fx = mercator[i].x();
+        double lng;
+        if (fx >= 0)
+            lng = realmod(fx, 1.0);
+        else
+            lng = realmod(1.0 - realmod(-1.0 * fx, 1.0), 1.0);
+
+        lng = lng * 360.0 - 180.0;
+
+        // like QGeoCoordinate(lat, lng, 0.0), which drops all values of an
+        // invalid coordinate
+        if (qIsNaN(lat) || qIsNaN(lng))
+            coords->append(qQNaN(), qQNaN(), qQNaN());
+        else
+            coords->append(lat, lng, 0.0);
+    }
+}
+
 QGeoCoordinate QGeoProjection::coordinateInterpolation(const QGeoCoordinate &from, const QGeoCoordinate &to, qreal progress)
 {
     QDoubleVector2D s = QGeoProjection::coordToMercator(from);
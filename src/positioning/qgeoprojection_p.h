@@ -54,6 +54,7 @@
 QT_BEGIN_NAMESPACE
 
 class QGeoCoordinate;
+class QGeoCoordinateArray;
 class QDoubleVector2D;
 
 class Q_POSITIONING_EXPORT QGeoProjection
@@ -61,6 +62,11 @@ class Q_POSITIONING_EXPORT QGeoProjection
 public:
     static QDoubleVector2D coordToMercator(const QGeoCoordinate &coord);
     static QGeoCoordinate mercatorToCoord(const QDoubleVector2D &mercator);
+
+    // the same projections for many points at once
+    static void coordToMercator(const QGeoCoordinateArray &coords, QDoubleVector2D *mercator);
+    static void mercatorToCoord(const QDoubleVector2D *mercator, int count, QGeoCoordinateArray *coords);
+
     static QGeoCoordinate coordinateInterpolation(const QGeoCoordinate &from, const QGeoCoordinate &to, qreal progress);
 
 private:
@@ -36,11 +36,11 @@
 #include "qgeopositioninfo.h"
 
 #include <QTime>
-#include <QList>
 #include <QByteArray>
 #include <QDebug>
 
 #include <math.h>
+#include <string.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -52,42 +52,246 @@ static double qlocationutils_nmeaDegreesToDecimal(double nmeaDegrees)
     return deg + (min / 60.0);
 }
 
+namespace {
+
+/*
+    A field of an NMEA sentence, pointing into the sentence itself.
+*/
+struct NmeaField
+{
+    const char *data;
+    int size;
+
+    bool isEmpty() const { return size == 0; }
+    char first() const { return data[0]; }
+};
+
+/*
+    Splits a sentence at its commas without copying it. Fields beyond
+    MaximumFields are dropped, no sentence read here has that many.
+*/
+class NmeaFields
+{
+public:
+    enum { MaximumFields = 32 };
+
+    NmeaFields(const char *data, int size)
+        : fieldCount(0)
+    {
+        const char *end = data + size;
+        const char *begin = data;
+        while (fieldCount < MaximumFields) {
+            const char *comma = static_cast<const char *>(memchr(begin, ',', end - begin));
+            const char *fieldEnd = comma ? comma : end;
+            fields[fieldCount].data = begin;
+            fields[fieldCount].size = fieldEnd - begin;
+            ++fieldCount;
+            if (!comma)
+                break;
+            begin = comma + 1;
+        }
+    }
+
+    int count() const { return fieldCount; }
+    const NmeaField &operator[](int i) const { return fields[i]; }
+
+private:
+    NmeaField fields[MaximumFields];
+    int fieldCount;
+};
+
+}
+
+static inline bool qlocationutils_isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+/*
+    Parses an unsigned decimal integer made of digits only.
+*/
+static bool qlocationutils_toUInt(const char *data, int size, uint *value)
+{
+    if (size <= 0 || size > 9)
+        return false;
+
+    uint result = 0;
+    for (int i = 0; i < size; ++i) {
+        if (!qlocationutils_isDigit(data[i]))
+            return false;
+        result = result * 10 + (data[i] - '0');
+    }
+    *value = result;
+    return true;
+}
+
+static int qlocationutils_toInt(const NmeaField &field)
+{
+    if (field.isEmpty())
+        return 0;
+
+    const bool negative = field.first() == '-';
+    const int sign = (negative || field.first() == '+') ? 1 : 0;
+    uint value = 0;
+    if (!qlocationutils_toUInt(field.data + sign, field.size - sign, &value))
+        return QByteArray(field.data, field.size).toInt();
+    return negative ? -int(value) : int(value);
+}
+
+/*
+    Parses [sign]digits[.digits], the only form of number in NMEA sentences.
+    While the digits fit in the 53 bits of a double the result is one
+    correctly rounded division, as exact as strtod(). Anything else,
+    including exponents, is left to QByteArray::toDouble().
+*/
+static bool qlocationutils_toDouble(const NmeaField &field, double *value)
+{
+    static const double powersOfTen[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    const char *p = field.data;
+    const char *end = field.data + field.size;
+    bool negative = false;
+    if (p != end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        ++p;
+    }
+
+    quint64 mantissa = 0;
+    int digits = 0;
+    int fractionDigits = 0;
+    bool fraction = false;
+    bool simple = true;
+    for (; p != end; ++p) {
+        if (qlocationutils_isDigit(*p)) {
+            if (mantissa >= (Q_UINT64_C(1) << 53) / 10) {
+                simple = false;
+                break;
+            }
+            mantissa = mantissa * 10 + (*p - '0');
+            ++digits;
+            if (fraction)
+                ++fractionDigits;
+        } else if (*p == '.' && !fraction) {
+            fraction = true;
+        } else {
+            simple = false;
+            break;
+        }
+    }
+
+    if (!simple || digits == 0 || fractionDigits > 22) {
+        bool ok = false;
+        const double result = QByteArray(field.data, field.size).toDouble(&ok);
+        if (ok)
+            *value = result;
+        return ok;
+    }
+
+    const double result = double(mantissa) / powersOfTen[fractionDigits];
+    *value = negative ? -result : result;
+    return true;
+}
+
+static bool qlocationutils_getNmeaTime(const char *data, int size, QTime *time)
+{
+    const char *dot = static_cast<const char *>(memchr(data, '.', size));
+    const int wholeSize = dot ? dot - data : size;
+
+    uint hour = 0;
+    uint minute = 0;
+    uint second = 0;
+    if (wholeSize != 6
+            || !qlocationutils_toUInt(data, 2, &hour)
+            || !qlocationutils_toUInt(data + 2, 2, &minute)
+            || !qlocationutils_toUInt(data + 4, 2, &second)) {
+        return false;
+    }
+
+    QTime tempTime(hour, minute, second);
+    if (!tempTime.isValid())
+        return false;
+
+    if (dot) {
+        // as before, up to three digits are taken as a count of milliseconds
+        const int msecsSize = qMin(3, size - wholeSize - 1);
+        uint msecs = 0;
+        if (qlocationutils_toUInt(dot + 1, msecsSize, &msecs))
+            tempTime = tempTime.addMSecs(msecs);
+    }
+
+    *time = tempTime;
+    return true;
+}
+
+static bool qlocationutils_getNmeaLatLong(const NmeaField &latField, char latDirection,
+                                          const NmeaField &lngField, char lngDirection,
+                                          double *lat, double *lng)
+{
+    if ((latDirection != 'N' && latDirection != 'S')
+            || (lngDirection != 'E' && lngDirection != 'W')) {
+        return false;
+    }
+
+    double tempLat;
+    double tempLng;
+    if (qlocationutils_toDouble(latField, &tempLat) && qlocationutils_toDouble(lngField, &tempLng)) {
+        tempLat = qlocationutils_nmeaDegreesToDecimal(tempLat);
+        if (latDirection == 'S')
+            tempLat *= -1;
+        tempLng = qlocationutils_nmeaDegreesToDecimal(tempLng);
+        if (lngDirection == 'W')
+            tempLng *= -1;
+
+        if (QLocationUtils::isValidLat(tempLat) && QLocationUtils::isValidLong(tempLng)) {
+            *lat = tempLat;
+            *lng = tempLng;
+            return true;
+        }
+    }
+    return false;
+}
+
+static inline bool qlocationutils_getNmeaTime(const NmeaField &field, QTime *time)
+{
+    return qlocationutils_getNmeaTime(field.data, field.size, time);
+}
+
 static void qlocationutils_readGga(const char *data, int size, QGeoPositionInfo *info, double uere,
                                    bool *hasFix)
 {
-    QByteArray sentence(data, size);
-    QList<QByteArray> parts = sentence.split(',');
+    const NmeaFields parts(data, size);
     QGeoCoordinate coord;
 
-    if (hasFix && parts.count() > 6 && parts[6].count() > 0)
-        *hasFix = parts[6].toInt() > 0;
+    if (hasFix && parts.count() > 6 && !parts[6].isEmpty())
+        *hasFix = qlocationutils_toInt(parts[6]) > 0;
 
-    if (parts.count() > 1 && parts[1].count() > 0) {
+    if (parts.count() > 1 && !parts[1].isEmpty()) {
         QTime time;
-        if (QLocationUtils::getNmeaTime(parts[1], &time))
+        if (qlocationutils_getNmeaTime(parts[1], &time))
             info->setTimestamp(QDateTime(QDate(), time, Qt::UTC));
     }
 
-    if (parts.count() > 5 && parts[3].count() == 1 && parts[5].count() == 1) {
+    if (parts.count() > 5 && parts[3].size == 1 && parts[5].size == 1) {
         double lat;
         double lng;
-        if (QLocationUtils::getNmeaLatLong(parts[2], parts[3][0], parts[4], parts[5][0], &lat, &lng)) {
+        if (qlocationutils_getNmeaLatLong(parts[2], parts[3].first(), parts[4], parts[5].first(), &lat, &lng)) {
             coord.setLatitude(lat);
             coord.setLongitude(lng);
         }
     }
 
     if (parts.count() > 8 && !parts[8].isEmpty()) {
-        bool hasHdop = false;
-        double hdop = parts[8].toDouble(&hasHdop);
-        if (hasHdop)
+        double hdop;
+        if (qlocationutils_toDouble(parts[8], &hdop))
             info->setAttribute(QGeoPositionInfo::HorizontalAccuracy, 2 * hdop * uere);
     }
 
-    if (parts.count() > 9 && parts[9].count() > 0) {
-        bool hasAlt = false;
-        double alt = parts[9].toDouble(&hasAlt);
-        if (hasAlt)
+    if (parts.count() > 9 && !parts[9].isEmpty()) {
+        double alt;
+        if (qlocationutils_toDouble(parts[9], &alt))
             coord.setAltitude(alt);
     }
 
@@ -98,45 +302,42 @@ static void qlocationutils_readGga(const char *data, int size, QGeoPositionInfo
 static void qlocationutils_readGsa(const char *data, int size, QGeoPositionInfo *info, double uere,
                                    bool *hasFix)
 {
-    QList<QByteArray> parts = QByteArray::fromRawData(data, size).split(',');
+    const NmeaFields parts(data, size);
 
     if (hasFix && parts.count() > 2 && !parts[2].isEmpty())
-        *hasFix = parts[2].toInt() > 0;
+        *hasFix = qlocationutils_toInt(parts[2]) > 0;
 
     if (parts.count() > 16 && !parts[16].isEmpty()) {
-        bool hasHdop = false;
-        double hdop = parts[16].toDouble(&hasHdop);
-        if (hasHdop)
+        double hdop;
+        if (qlocationutils_toDouble(parts[16], &hdop))
             info->setAttribute(QGeoPositionInfo::HorizontalAccuracy, 2 * hdop * uere);
     }
 
     if (parts.count() > 17 && !parts[17].isEmpty()) {
-        bool hasVdop = false;
-        double vdop = parts[17].toDouble(&hasVdop);
-        if (hasVdop)
+        double vdop;
+        if (qlocationutils_toDouble(parts[17], &vdop))
             info->setAttribute(QGeoPositionInfo::VerticalAccuracy, 2 * vdop * uere);
     }
 }
 
 static void qlocationutils_readGll(const char *data, int size, QGeoPositionInfo *info, bool *hasFix)
 {
-    QByteArray sentence(data, size);
-    QList<QByteArray> parts = sentence.split(',');
+    const NmeaFields parts(data, size);
     QGeoCoordinate coord;
 
-    if (hasFix && parts.count() > 6 && parts[6].count() > 0)
-        *hasFix = (parts[6][0] == 'A');
+    if (hasFix && parts.count() > 6 && !parts[6].isEmpty())
+        *hasFix = (parts[6].first() == 'A');
 
-    if (parts.count() > 5 && parts[5].count() > 0) {
+    if (parts.count() > 5 && !parts[5].isEmpty()) {
         QTime time;
-        if (QLocationUtils::getNmeaTime(parts[5], &time))
+        if (qlocationutils_getNmeaTime(parts[5], &time))
             info->setTimestamp(QDateTime(QDate(), time, Qt::UTC));
     }
 
-    if (parts.count() > 4 && parts[2].count() == 1 && parts[4].count() == 1) {
+    if (parts.count() > 4 && parts[2].size == 1 && parts[4].size == 1) {
         double lat;
         double lng;
-        if (QLocationUtils::getNmeaLatLong(parts[1], parts[2][0], parts[3], parts[4][0], &lat, &lng)) {
+        if (qlocationutils_getNmeaLatLong(parts[1], parts[2].first(), parts[3], parts[4].first(), &lat, &lng)) {
             coord.setLatitude(lat);
             coord.setLongitude(lng);
         }
@@ -148,52 +349,55 @@ static void qlocationutils_readGll(const char *data, int size, QGeoPositionInfo
 
 static void qlocationutils_readRmc(const char *data, int size, QGeoPositionInfo *info, bool *hasFix)
 {
-    QByteArray sentence(data, size);
-    QList<QByteArray> parts = sentence.split(',');
+    const NmeaFields parts(data, size);
     QGeoCoordinate coord;
     QDate date;
     QTime time;
 
-    if (hasFix && parts.count() > 2 && parts[2].count() > 0)
-        *hasFix = (parts[2][0] == 'A');
-
-    if (parts.count() > 9 && parts[9].count() == 6) {
-        date = QDate::fromString(QString::fromLatin1(parts[9]), QStringLiteral("ddMMyy"));
+    if (hasFix && parts.count() > 2 && !parts[2].isEmpty())
+        *hasFix = (parts[2].first() == 'A');
+
+    if (parts.count() > 9 && parts[9].size == 6) {
+        // ddMMyy, read as 19yy like QDate::fromString() and moved to 20yy
+        uint day = 0;
+        uint month = 0;
+        uint year = 0;
+        if (qlocationutils_toUInt(parts[9].data, 2, &day)
+                && qlocationutils_toUInt(parts[9].data + 2, 2, &month)
+                && qlocationutils_toUInt(parts[9].data + 4, 2, &year)) {
+            date = QDate(1900 + year, month, day);
+        }
         if (date.isValid())
             date = date.addYears(100);     // otherwise starts from 1900
         else
             date = QDate();
     }
 
-    if (parts.count() > 1 && parts[1].count() > 0)
-        QLocationUtils::getNmeaTime(parts[1], &time);
+    if (parts.count() > 1 && !parts[1].isEmpty())
+        qlocationutils_getNmeaTime(parts[1], &time);
 
-    if (parts.count() > 6 && parts[4].count() == 1 && parts[6].count() == 1) {
+    if (parts.count() > 6 && parts[4].size == 1 && parts[6].size == 1) {
         double lat;
         double lng;
-        if (QLocationUtils::getNmeaLatLong(parts[3], parts[4][0], parts[5], parts[6][0], &lat, &lng)) {
+        if (qlocationutils_getNmeaLatLong(parts[3], parts[4].first(), parts[5], parts[6].first(), &lat, &lng)) {
             coord.setLatitude(lat);
             coord.setLongitude(lng);
         }
     }
 
-    bool parsed = false;
     double value = 0.0;
-    if (parts.count() > 7 && parts[7].count() > 0) {
-        value = parts[7].toDouble(&parsed);
-        if (parsed)
+    if (parts.count() > 7 && !parts[7].isEmpty()) {
+        if (qlocationutils_toDouble(parts[7], &value))
             info->setAttribute(QGeoPositionInfo::GroundSpeed, qreal(value * 1.852 / 3.6));    // knots -> m/s
     }
-    if (parts.count() > 8 && parts[8].count() > 0) {
-        value = parts[8].toDouble(&parsed);
-        if (parsed)
+    if (parts.count() > 8 && !parts[8].isEmpty()) {
+        if (qlocationutils_toDouble(parts[8], &value))
             info->setAttribute(QGeoPositionInfo::Direction, qreal(value));
     }
-    if (parts.count() > 11 && parts[11].count() == 1
-            && (parts[11][0] == 'E' || parts[11][0] == 'W')) {
-        value = parts[10].toDouble(&parsed);
-        if (parsed) {
-            if (parts[11][0] == 'W')
+    if (parts.count() > 11 && parts[11].size == 1
+            && (parts[11].first() == 'E' || parts[11].first() == 'W')) {
+        if (qlocationutils_toDouble(parts[10], &value)) {
+            if (parts[11].first() == 'W')
                 value *= -1;
             info->setAttribute(QGeoPositionInfo::MagneticVariation, qreal(value));
         }
@@ -210,19 +414,15 @@ static void qlocationutils_readVtg(const char *data, int size, QGeoPositionInfo
     if (hasFix)
         *hasFix = false;
 
-    QByteArray sentence(data, size);
-    QList<QByteArray> parts = sentence.split(',');
+    const NmeaFields parts(data, size);
 
-    bool parsed = false;
     double value = 0.0;
-    if (parts.count() > 1 && parts[1].count() > 0) {
-        value = parts[1].toDouble(&parsed);
-        if (parsed)
+    if (parts.count() > 1 && !parts[1].isEmpty()) {
+        if (qlocationutils_toDouble(parts[1], &value))
             info->setAttribute(QGeoPositionInfo::Direction, qreal(value));
     }
-    if (parts.count() > 7 && parts[7].count() > 0) {
-        value = parts[7].toDouble(&parsed);
-        if (parsed)
+    if (parts.count() > 7 && !parts[7].isEmpty()) {
+        if (qlocationutils_toDouble(parts[7], &value))
             info->setAttribute(QGeoPositionInfo::GroundSpeed, qreal(value / 3.6));    // km/h -> m/s
     }
 }
@@ -232,19 +432,21 @@ static void qlocationutils_readZda(const char *data, int size, QGeoPositionInfo
     if (hasFix)
         *hasFix = false;
 
-    QByteArray sentence(data, size);
-    QList<QByteArray> parts = sentence.split(',');
+    const NmeaFields parts(data, size);
     QDate date;
     QTime time;
 
-    if (parts.count() > 1 && parts[1].count() > 0)
-        QLocationUtils::getNmeaTime(parts[1], &time);
-
-    if (parts.count() > 4 && parts[2].count() > 0 && parts[3].count() > 0
-            && parts[4].count() == 4) {     // must be full 4-digit year
-        int day = parts[2].toUInt();
-        int month = parts[3].toUInt();
-        int year = parts[4].toUInt();
+    if (parts.count() > 1 && !parts[1].isEmpty())
+        qlocationutils_getNmeaTime(parts[1], &time);
+
+    if (parts.count() > 4 && !parts[2].isEmpty() && !parts[3].isEmpty()
+            && parts[4].size == 4) {     // must be full 4-digit year
+        uint day = 0;
+        uint month = 0;
+        uint year = 0;
+        qlocationutils_toUInt(parts[2].data, parts[2].size, &day);
+        qlocationutils_toUInt(parts[3].data, parts[3].size, &month);
+        qlocationutils_toUInt(parts[4].data, parts[4].size, &year);
         if (day > 0 && month > 0 && year > 0)
             date.setDate(year, month, day);
     }
@@ -252,6 +454,17 @@ static void qlocationutils_readZda(const char *data, int size, QGeoPositionInfo
     info->setTimestamp(QDateTime(date, time, Qt::UTC));
 }
 
+static int qlocationutils_hexDigit(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
 bool QLocationUtils::getPosInfoFromNmea(const char *data, int size, QGeoPositionInfo *info,
                                         double uere, bool *hasFix)
 {
@@ -264,12 +477,7 @@ bool QLocationUtils::getPosInfoFromNmea(const char *data, int size, QGeoPosition
         return false;
 
     // Adjust size so that * and following characters are not parsed by the following functions.
-    for (int i = 0; i < size; ++i) {
-        if (data[i] == '*') {
-            size = i;
-            break;
-        }
-    }
+    size = static_cast<const char *>(memchr(data, '*', size)) - data;
 
     if (data[3] == 'G' && data[4] == 'G' && data[5] == 'A') {
         // "$--GGA" sentence.
@@ -312,86 +520,32 @@ bool QLocationUtils::getPosInfoFromNmea(const char *data, int size, QGeoPosition
 
 bool QLocationUtils::hasValidNmeaChecksum(const char *data, int size)
 {
-    int asteriskIndex = -1;
-    for (int i = 0; i < size; ++i) {
-        if (data[i] == '*') {
-            asteriskIndex = i;
-            break;
-        }
-    }
+    const char *asterisk = static_cast<const char *>(memchr(data, '*', size));
 
     const int CSUM_LEN = 2;
-    if (asteriskIndex < 0 || asteriskIndex + CSUM_LEN >= size)
+    if (!asterisk || (asterisk - data) + CSUM_LEN >= size)
         return false;
 
     // XOR byte value of all characters between '$' and '*'
     int result = 0;
-    for (int i = 1; i < asteriskIndex; ++i)
-        result ^= data[i];
-    /*
-        char calc[CSUM_LEN + 1];
-        ::snprintf(calc, CSUM_LEN + 1, "%02x", result);
-        return ::strncmp(calc, &data[asteriskIndex+1], 2) == 0;
-        */
-
-    QByteArray checkSumBytes(&data[asteriskIndex + 1], 2);
-    bool ok = false;
-    int checksum = checkSumBytes.toInt(&ok,16);
-    return ok && checksum == result;
+    for (const char *p = data + 1; p < asterisk; ++p)
+        result ^= *p;
+
+    const int high = qlocationutils_hexDigit(asterisk[1]);
+    const int low = qlocationutils_hexDigit(asterisk[2]);
+    return high >= 0 && low >= 0 && (high << 4 | low) == result;
 }
 
 bool QLocationUtils::getNmeaTime(const QByteArray &bytes, QTime *time)
 {
-    int dotIndex = bytes.indexOf('.');
-    QTime tempTime;
-
-    if (dotIndex < 0) {
-        tempTime = QTime::fromString(QString::fromLatin1(bytes.constData()),
-                                     QStringLiteral("hhmmss"));
-    } else {
-        tempTime = QTime::fromString(QString::fromLatin1(bytes.mid(0, dotIndex)),
-                                     QStringLiteral("hhmmss"));
-        bool hasMsecs = false;
-        int midLen = qMin(3, bytes.size() - dotIndex - 1);
-        int msecs = bytes.mid(dotIndex + 1, midLen).toUInt(&hasMsecs);
-        if (hasMsecs)
-            tempTime = tempTime.addMSecs(msecs);
-    }
-
-    if (tempTime.isValid()) {
-        *time = tempTime;
-        return true;
-    }
-    return false;
+    return qlocationutils_getNmeaTime(bytes.constData(), bytes.size(), time);
 }
 
 bool QLocationUtils::getNmeaLatLong(const QByteArray &latString, char latDirection, const QByteArray &lngString, char lngDirection, double *lat, double *lng)
 {
-    if ((latDirection != 'N' && latDirection != 'S')
-            || (lngDirection != 'E' && lngDirection != 'W')) {
-        return false;
-    }
-
-    bool hasLat = false;
-    bool hasLong = false;
-    double tempLat = latString.toDouble(&hasLat);
-    double tempLng = lngString.toDouble(&hasLong);
-    if (hasLat && hasLong) {
-        tempLat = qlocationutils_nmeaDegreesToDecimal(tempLat);
-        if (latDirection == 'S')
-            tempLat *= -1;
-        tempLng = qlocationutils_nmeaDegreesToDecimal(tempLng);
-        if (lngDirection == 'W')
-            tempLng *= -1;
-
-        if (isValidLat(tempLat) && isValidLong(tempLng)) {
-            *lat = tempLat;
-            *lng = tempLng;
-            return true;
-        }
-    }
-    return false;
+    const NmeaField latField = { latString.constData(), latString.size() };
+    const NmeaField lngField = { lngString.constData(), lngString.size() };
+    return qlocationutils_getNmeaLatLong(latField, latDirection, lngField, lngDirection, lat, lng);
 }
 
 QT_END_NAMESPACE
-
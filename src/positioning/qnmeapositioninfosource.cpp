@@ -41,9 +41,231 @@
 #include <QTimer>
 #include <QtCore/QtNumeric>
 
+#include <string.h>
+
 
 QT_BEGIN_NAMESPACE
 
+QNmeaSentenceReader::QNmeaSentenceReader()
+        : m_position(0)
+{
+}
+
+/*
+    Points \a data and \a size at the next complete line of \a device,
+    newline included, which stays valid until the next call. A last line
+    without a newline is only returned with \a partialAtEnd, as a live
+    device may still complete it.
+*/
+bool QNmeaSentenceReader::readSentence(QIODevice *device, const char **data, int *size,
+                                       bool partialAtEnd)
+{
+    forever {
+        const char *begin = m_buffer.constData() + m_position;
+        const int available = m_buffer.size() - m_position;
+        const char *newline = static_cast<const char *>(memchr(begin, '\n', available));
+        if (newline) {
+            *data = begin;
+            *size = newline + 1 - begin;
+            m_position += *size;
+            return true;
+        }
+
+        if (m_position > 0) {
+            m_buffer.remove(0, m_position);
+            m_position = 0;
+        }
+
+        if (!device || device->bytesAvailable() <= 0)
+            break;
+
+        const int oldSize = m_buffer.size();
+        m_buffer.resize(oldSize + ChunkSize);
+        const qint64 read = device->read(m_buffer.data() + oldSize, ChunkSize);
+        m_buffer.resize(oldSize + int(qMax(read, qint64(0))));
+        if (read <= 0)
+            break;
+    }
+
+    if (partialAtEnd && m_position < m_buffer.size()) {
+        *data = m_buffer.constData() + m_position;
+        *size = m_buffer.size() - m_position;
+        m_position = m_buffer.size();
+        return true;
+    }
+    return false;
+}
+
+void QNmeaSentenceReader::clear()
+{
+    m_buffer.clear();
+    m_position = 0;
+}
+
+
+//============================================================
+
+QNmeaSentenceContext::QNmeaSentenceContext()
+        : m_horizontalAccuracy(qQNaN()),
+        m_verticalAccuracy(qQNaN())
+{
+}
+
+void QNmeaSentenceContext::complete(QGeoPositionInfo *update)
+{
+    QDate date = update->timestamp().date();
+    if (date.isValid()) {
+        m_currentDate = date;
+    } else {
+        // some sentence have time but no date
+        QTime time = update->timestamp().time();
+        if (time.isValid() && m_currentDate.isValid())
+            update->setTimestamp(QDateTime(m_currentDate, time, Qt::UTC));
+    }
+
+    // Some attributes are sent in separate NMEA sentences. Save and restore the accuracy
+    // measurements.
+    if (update->hasAttribute(QGeoPositionInfo::HorizontalAccuracy))
+        m_horizontalAccuracy = update->attribute(QGeoPositionInfo::HorizontalAccuracy);
+    else if (!qIsNaN(m_horizontalAccuracy))
+        update->setAttribute(QGeoPositionInfo::HorizontalAccuracy, m_horizontalAccuracy);
+    if (update->hasAttribute(QGeoPositionInfo::VerticalAccuracy))
+        m_verticalAccuracy = update->attribute(QGeoPositionInfo::VerticalAccuracy);
+    else if (!qIsNaN(m_verticalAccuracy))
+        update->setAttribute(QGeoPositionInfo::VerticalAccuracy, m_verticalAccuracy);
+}
+
+
+//============================================================
+
+QNmeaEpochAssembler::QNmeaEpochAssembler()
+        : m_hasFix(false),
+        m_given(false)
+{
+}
+
+/*
+    Adds the update parsed from one sentence. Returns true and stores the
+    previous epoch in \a completed if the sentence begins a new epoch and
+    the previous one holds a fix that has not been given out yet. Sentences
+    of an epoch that has been given out already are merged but do not give
+    it out again.
+*/
+bool QNmeaEpochAssembler::add(const QGeoPositionInfo &sentence, bool hasFix,
+                              QGeoPositionInfo *completed)
+{
+    bool ready = false;
+
+    // sentences without a time (GSA, VTG) belong to the epoch they follow
+    QTime time = sentence.timestamp().time();
+    QTime epochTime = m_epoch.timestamp().time();
+    if (time.isValid() && epochTime.isValid() && time != epochTime) {
+        ready = flush(completed);
+        m_epoch = QGeoPositionInfo();
+        m_hasFix = false;
+        m_given = false;
+    }
+
+    merge(sentence, hasFix);
+    return ready;
+}
+
+/*
+    Gives out the current epoch in \a completed if it holds a fix and has
+    not been given out yet. Used when no more sentences of the epoch are
+    expected.
+*/
+bool QNmeaEpochAssembler::flush(QGeoPositionInfo *completed)
+{
+    if (m_given || !m_hasFix || !m_epoch.isValid())
+        return false;
+
+    m_given = true;
+    *completed = m_epoch;
+    return true;
+}
+
+void QNmeaEpochAssembler::merge(const QGeoPositionInfo &sentence, bool hasFix)
+{
+    QDateTime timestamp = sentence.timestamp();
+    if (timestamp.isValid() || (!m_epoch.timestamp().isValid() && timestamp.time().isValid()))
+        m_epoch.setTimestamp(timestamp);
+
+    QGeoCoordinate coordinate = sentence.coordinate();
+    if (coordinate.isValid()) {
+        // GSA reports a fix without a position; only count fixes that have one
+        m_hasFix = m_hasFix || hasFix;
+
+        QGeoCoordinate merged = m_epoch.coordinate();
+        merged.setLatitude(coordinate.latitude());
+        merged.setLongitude(coordinate.longitude());
+        if (coordinate.type() == QGeoCoordinate::Coordinate3D)
+            merged.setAltitude(coordinate.altitude());
+        m_epoch.setCoordinate(merged);
+    }
+
+    for (int i = QGeoPositionInfo::Direction; i <= QGeoPositionInfo::VerticalAccuracy; ++i) {
+        QGeoPositionInfo::Attribute attribute = QGeoPositionInfo::Attribute(i);
+        if (sentence.hasAttribute(attribute))
+            m_epoch.setAttribute(attribute, sentence.attribute(attribute));
+    }
+}
+
+
+//============================================================
+
+QNmeaPositionReader::QNmeaPositionReader(QIODevice *device, double uere)
+        : m_device(device),
+        m_userEquivalentRangeError(uere)
+{
+}
+
+/*
+    Reads up to the next fix and stores it in \a info. Returns false once
+    the data of the device is used up.
+*/
+bool QNmeaPositionReader::readNext(QGeoPositionInfo *info)
+{
+    const char *data;
+    int size;
+    while (m_sentences.readSentence(m_device, &data, &size, true)) {
+        QGeoPositionInfo update;
+        bool hasFix = false;
+        if (!QLocationUtils::getPosInfoFromNmea(data, size, &update, m_userEquivalentRangeError,
+                                                &hasFix)) {
+            continue;
+        }
+
+        m_context.complete(&update);
+        if (m_epochs.add(update, hasFix, info))
+            return true;
+    }
+    return m_epochs.flush(info);
+}
+
+/*
+    Appends up to \a maximum fixes to \a batch and returns how many were
+    appended, fewer only at the end of the data.
+*/
+int QNmeaPositionReader::readBatch(QList<QGeoPositionInfo> *batch, int maximum)
+{
+    int count = 0;
+    QGeoPositionInfo info;
+    while (count < maximum && readNext(&info)) {
+        batch->append(info);
+        ++count;
+    }
+    return count;
+}
+
+
+//============================================================
+
+bool QNmeaReader::readSentence(const char **data, int *size, bool partialAtEnd)
+{
+    return m_sentences.readSentence(m_proxy->m_device, data, size, partialAtEnd);
+}
+
 QNmeaRealTimeReader::QNmeaRealTimeReader(QNmeaPositionInfoSourcePrivate *sourcePrivate)
         : QNmeaReader(sourcePrivate)
 {
@@ -51,15 +273,19 @@ QNmeaRealTimeReader::QNmeaRealTimeReader(QNmeaPositionInfoSourcePrivate *sourceP
 
 void QNmeaRealTimeReader::readAvailableData()
 {
-    while (m_proxy->m_device->canReadLine()){
+    const char *data;
+    int size;
+    while (readSentence(&data, &size, false)) {
         QGeoPositionInfo update;
         bool hasFix = false;
 
-        char buf[1024];
-        qint64 size = m_proxy->m_device->readLine(buf, sizeof(buf));
-        if (m_proxy->parsePosInfoFromNmeaData(buf, size, &update, &hasFix))
+        if (m_proxy->parsePosInfoFromNmeaData(data, size, &update, &hasFix))
             m_proxy->notifyNewUpdate(&update, hasFix);
     }
+
+    // The rest of the epoch may still be on its way. It is given out when
+    // the next epoch begins, or once the device has been quiet for a while.
+    m_proxy->scheduleEpochFlush();
 }
 
 
@@ -97,7 +323,7 @@ void QNmeaSimulatedReader::readAvailableData()
 
     } else {
         // previously read to EOF, but now new data has arrived
-        processNextSentence();
+        scheduleNextUpdate(processNextSentence());
     }
 }
 
@@ -106,12 +332,10 @@ bool QNmeaSimulatedReader::setFirstDateTime()
     // find the first update with valid date and time
     QGeoPositionInfo update;
     bool hasFix = false;
-    while (m_proxy->m_device->bytesAvailable() > 0) {
-        char buf[1024];
-        qint64 size = m_proxy->m_device->readLine(buf, sizeof(buf));
-        if (size <= 0)
-            continue;
-        bool ok = m_proxy->parsePosInfoFromNmeaData(buf, size, &update, &hasFix);
+    const char *data;
+    int size;
+    while (readSentence(&data, &size, true)) {
+        bool ok = m_proxy->parsePosInfoFromNmeaData(data, size, &update, &hasFix);
         if (ok && update.timestamp().isValid()) {
             QPendingGeoPositionInfo pending;
             pending.info = update;
@@ -125,13 +349,41 @@ bool QNmeaSimulatedReader::setFirstDateTime()
 
 void QNmeaSimulatedReader::simulatePendingUpdate()
 {
-    if (m_pendingUpdates.size() > 0) {
-        // will be dequeued in processNextSentence()
-        QPendingGeoPositionInfo &pending = m_pendingUpdates.head();
-        m_proxy->notifyNewUpdate(&pending.info, pending.hasFix);
+    // When replaying without waiting, updates go out in batches, returning
+    // to the event loop in between. A receiver may delete the source.
+    QPointer<QNmeaSimulatedReader> guard(this);
+    for (int sent = 1; ; ++sent) {
+        if (m_pendingUpdates.size() > 0) {
+            // will be dequeued in processNextSentence()
+            QPendingGeoPositionInfo &pending = m_pendingUpdates.head();
+            m_proxy->notifyNewUpdate(&pending.info, pending.hasFix);
+            if (!guard)
+                return;
+        }
+
+        const int msec = processNextSentence();
+        if (msec != 0) {
+            // the next sentence, if any, begins a later epoch
+            m_proxy->flushEpoch();
+            if (!guard)
+                return;
+        }
+        if (msec < 0)
+            return;
+        if (m_proxy->m_replaySpeed > 0 || sent >= ReplayBatchSize) {
+            scheduleNextUpdate(msec);
+            return;
+        }
     }
+}
 
-    processNextSentence();
+void QNmeaSimulatedReader::scheduleNextUpdate(int msec)
+{
+    if (msec < 0)
+        return;
+
+    const qreal speed = m_proxy->m_replaySpeed;
+    m_currTimerId = startTimer(speed > 0 ? qRound(msec / speed) : 0);
 }
 
 void QNmeaSimulatedReader::timerEvent(QTimerEvent *event)
@@ -141,7 +393,11 @@ void QNmeaSimulatedReader::timerEvent(QTimerEvent *event)
     simulatePendingUpdate();
 }
 
-void QNmeaSimulatedReader::processNextSentence()
+/*
+    Queues the next update and returns the recorded time in milliseconds
+    until it, or -1 if there is none yet.
+*/
+int QNmeaSimulatedReader::processNextSentence()
 {
     QGeoPositionInfo info;
     bool hasFix = false;
@@ -152,12 +408,10 @@ void QNmeaSimulatedReader::processNextSentence()
 
     // find the next update with a valid time (as long as the time is valid,
     // we can calculate when the update should be emitted)
-    while (m_proxy->m_device && m_proxy->m_device->bytesAvailable() > 0) {
-        char buf[1024];
-        qint64 size = m_proxy->m_device->readLine(buf, sizeof(buf));
-        if (size <= 0)
-            continue;
-        if (m_proxy->parsePosInfoFromNmeaData(buf, size, &info, &hasFix)) {
+    const char *data;
+    int size;
+    while (m_proxy->m_device && readSentence(&data, &size, true)) {
+        if (m_proxy->parsePosInfoFromNmeaData(data, size, &info, &hasFix)) {
             QTime time = info.timestamp().time();
             if (time.isValid()) {
                 if (!prevTime.isValid()) {
@@ -175,7 +429,7 @@ void QNmeaSimulatedReader::processNextSentence()
     }
 
     if (timeToNextUpdate < 0)
-        return;
+        return -1;
 
     m_pendingUpdates.dequeue();
 
@@ -183,7 +437,7 @@ void QNmeaSimulatedReader::processNextSentence()
     pending.info = info;
     pending.hasFix = hasFix;
     m_pendingUpdates.enqueue(pending);
-    m_currTimerId = startTimer(timeToNextUpdate);
+    return timeToNextUpdate;
 }
 
 
@@ -197,12 +451,12 @@ QNmeaPositionInfoSourcePrivate::QNmeaPositionInfoSourcePrivate(QNmeaPositionInfo
         m_invokedStart(false),
         m_positionError(QGeoPositionInfoSource::UnknownSourceError),
         m_userEquivalentRangeError(qQNaN()),
+        m_replaySpeed(1.0),
         m_source(parent),
         m_nmeaReader(0),
         m_updateTimer(0),
         m_requestTimer(0),
-        m_horizontalAccuracy(qQNaN()),
-        m_verticalAccuracy(qQNaN()),
+        m_epochTimer(0),
         m_noUpdateLastInterval(false),
         m_updateTimeoutSent(false),
         m_connectedReadyRead(false)
@@ -297,6 +551,7 @@ void QNmeaPositionInfoSourcePrivate::startUpdates()
 
     if (m_updateMode == QNmeaPositionInfoSource::RealTimeMode) {
         // skip over any buffered data - we only want the newest data
+        m_nmeaReader->clearBuffer();
         if (m_device->bytesAvailable()) {
             if (m_device->isSequential())
                 m_device->readAll();
@@ -365,45 +620,59 @@ void QNmeaPositionInfoSourcePrivate::notifyNewUpdate(QGeoPositionInfo *update, b
     // include <QDebug> before uncommenting
     //qDebug() << "QNmeaPositionInfoSourcePrivate::notifyNewUpdate()" << update->timestamp() << hasFix << m_invokedStart << (m_requestTimer && m_requestTimer->isActive());
 
-    QDate date = update->timestamp().date();
-    if (date.isValid()) {
-        m_currentDate = date;
-    } else {
-        // some sentence have time but no date
-        QTime time = update->timestamp().time();
-        if (time.isValid() && m_currentDate.isValid())
-            update->setTimestamp(QDateTime(m_currentDate, time, Qt::UTC));
-    }
+    m_context.complete(update);
 
-    // Some attributes are sent in separate NMEA sentences. Save and restore the accuracy
-    // measurements.
-    if (update->hasAttribute(QGeoPositionInfo::HorizontalAccuracy))
-        m_horizontalAccuracy = update->attribute(QGeoPositionInfo::HorizontalAccuracy);
-    else if (!qIsNaN(m_horizontalAccuracy))
-        update->setAttribute(QGeoPositionInfo::HorizontalAccuracy, m_horizontalAccuracy);
-    if (update->hasAttribute(QGeoPositionInfo::VerticalAccuracy))
-        m_verticalAccuracy = update->attribute(QGeoPositionInfo::VerticalAccuracy);
-    else if (!qIsNaN(m_verticalAccuracy))
-        update->setAttribute(QGeoPositionInfo::VerticalAccuracy, m_verticalAccuracy);
+    QGeoPositionInfo epoch;
+    if (m_epochs.add(*update, hasFix, &epoch))
+        deliverUpdate(epoch);
+}
 
-    if (hasFix && update->isValid()) {
-        if (m_requestTimer && m_requestTimer->isActive()) {
-            m_requestTimer->stop();
-            emitUpdated(*update);
-        } else if (m_invokedStart) {
-            if (m_updateTimer && m_updateTimer->isActive()) {
-                // for periodic updates, only want the most recent update
-                m_pendingUpdate = *update;
-                if (m_noUpdateLastInterval) {
-                    emitPendingUpdate();
-                    m_noUpdateLastInterval = false;
-                }
-            } else {
-                emitUpdated(*update);
+void QNmeaPositionInfoSourcePrivate::flushEpoch()
+{
+    QGeoPositionInfo epoch;
+    if (m_epochs.flush(&epoch))
+        deliverUpdate(epoch);
+}
+
+void QNmeaPositionInfoSourcePrivate::scheduleEpochFlush()
+{
+    if (!m_epochTimer) {
+        m_epochTimer = new QTimer(this);
+        m_epochTimer->setSingleShot(true);
+        m_epochTimer->setInterval(EpochQuietTime);
+        connect(m_epochTimer, SIGNAL(timeout()), SLOT(flushEpoch()));
+    }
+    m_epochTimer->start();
+}
+
+void QNmeaPositionInfoSourcePrivate::deliverUpdate(const QGeoPositionInfo &update)
+{
+    if (m_requestTimer && m_requestTimer->isActive()) {
+        m_requestTimer->stop();
+        emitUpdated(update);
+    } else if (m_invokedStart) {
+        if (m_updateTimer && m_updateTimer->isActive()) {
+            // for periodic updates, only want the most recent update
+            m_pendingUpdate = update;
+            if (m_noUpdateLastInterval) {
+                emitPendingUpdate();
+                m_noUpdateLastInterval = false;
             }
+        } else {
+            emitUpdated(update);
         }
-        m_lastUpdate = *update;
     }
+    m_lastUpdate = update;
+}
+
+void QNmeaPositionInfoSourcePrivate::setReplaySpeed(QNmeaPositionInfoSource *source, qreal speed)
+{
+    source->d->m_replaySpeed = qMax(qreal(0), speed);
+}
+
+qreal QNmeaPositionInfoSourcePrivate::replaySpeed(const QNmeaPositionInfoSource *source)
+{
+    return source->d->m_replaySpeed;
 }
 
 void QNmeaPositionInfoSourcePrivate::timerEvent(QTimerEvent *)
@@ -463,6 +732,12 @@ void QNmeaPositionInfoSourcePrivate::emitUpdated(const QGeoPositionInfo &update)
     In both cases the position information is received via the positionUpdated() signal and the
     last known position can be accessed with lastKnownPosition().
 
+    The sentences that report the same fix time are merged into a single update, so a
+    receiver that sends, for example, GGA, RMC, GSA and VTG sentences for every fix gives one
+    update per fix that carries the position, altitude, speed, direction and accuracy together.
+    In RealTimeMode a fix is emitted once the sentences of the next fix begin to arrive, or once
+    the device has been quiet for a short while, and never more than once.
+
     QNmeaPositionInfoSource supports reporting the accuracy of the horizontal and vertical position.
     To enable position accuracy reporting an estimate of the User Equivalent Range Error associated
     with the NMEA source must be set with setUserEquivalentRangeError().
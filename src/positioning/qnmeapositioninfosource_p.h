@@ -47,9 +47,13 @@
 #include "qnmeapositioninfosource.h"
 #include "qgeopositioninfo.h"
 
+#include <QtCore/qnumeric.h>
+
 #include <QObject>
 #include <QQueue>
 #include <QPointer>
+#include <QByteArray>
+#include <QDate>
 
 QT_BEGIN_NAMESPACE
 
@@ -65,6 +69,87 @@ struct QPendingGeoPositionInfo
 };
 
 
+/*
+    Splits the data of a device into sentences, reading it in large chunks
+    instead of a line at a time.
+*/
+class QNmeaSentenceReader
+{
+public:
+    enum { ChunkSize = 64 * 1024 };
+
+    QNmeaSentenceReader();
+
+    bool readSentence(QIODevice *device, const char **data, int *size, bool partialAtEnd);
+    void clear();
+
+private:
+    QByteArray m_buffer;
+    int m_position;
+};
+
+
+/*
+    What earlier sentences tell about later ones: the date, which some
+    sentences lack, and the accuracy, which comes in sentences of its own.
+*/
+class QNmeaSentenceContext
+{
+public:
+    QNmeaSentenceContext();
+
+    void complete(QGeoPositionInfo *update);
+
+private:
+    QDate m_currentDate;
+    qreal m_horizontalAccuracy;
+    qreal m_verticalAccuracy;
+};
+
+
+/*
+    Merges the sentences that report the same fix time (an epoch) into one
+    update, so that a receiver sending GGA, RMC, GSA and VTG every second
+    gives one complete update per second instead of four partial ones.
+*/
+class QNmeaEpochAssembler
+{
+public:
+    QNmeaEpochAssembler();
+
+    bool add(const QGeoPositionInfo &sentence, bool hasFix, QGeoPositionInfo *completed);
+    bool flush(QGeoPositionInfo *completed);
+
+private:
+    void merge(const QGeoPositionInfo &sentence, bool hasFix);
+
+    QGeoPositionInfo m_epoch;
+    bool m_hasFix;
+    bool m_given;
+};
+
+
+/*
+    Reads the fixes of recorded NMEA data one at a time, as fast as they can
+    be parsed, giving the same updates as QNmeaPositionInfoSource would.
+*/
+class Q_POSITIONING_EXPORT QNmeaPositionReader
+{
+public:
+    explicit QNmeaPositionReader(QIODevice *device, double uere = qQNaN());
+
+    bool readNext(QGeoPositionInfo *info);
+    int readBatch(QList<QGeoPositionInfo> *batch, int maximum);
+
+private:
+    QIODevice *m_device;
+    double m_userEquivalentRangeError;
+    QNmeaSentenceReader m_sentences;
+    QNmeaSentenceContext m_context;
+    QNmeaEpochAssembler m_epochs;
+};
+
+
 class QNmeaPositionInfoSourcePrivate : public QObject
 {
     Q_OBJECT
@@ -81,7 +166,15 @@ public:
                                   QGeoPositionInfo *posInfo,
                                   bool *hasFix);
 
+    // ms without data from a real time device after which the current epoch is given out
+    enum { EpochQuietTime = 50 };
+
     void notifyNewUpdate(QGeoPositionInfo *update, bool fixStatus);
+    void scheduleEpochFlush();
+
+    // in SimulationMode, how many times faster than recorded to replay, 0 for no waiting
+    Q_POSITIONING_EXPORT static void setReplaySpeed(QNmeaPositionInfoSource *source, qreal speed);
+    Q_POSITIONING_EXPORT static qreal replaySpeed(const QNmeaPositionInfoSource *source);
 
     QNmeaPositionInfoSource::UpdateMode m_updateMode;
     QPointer<QIODevice> m_device;
@@ -89,9 +182,11 @@ public:
     bool m_invokedStart;
     QGeoPositionInfoSource::Error m_positionError;
     double m_userEquivalentRangeError;
+    qreal m_replaySpeed;
 
 public Q_SLOTS:
     void readyRead();
+    void flushEpoch();
 
 protected:
     void timerEvent(QTimerEvent *event);
@@ -106,15 +201,16 @@ private:
     bool initialize();
     void prepareSourceDevice();
     void emitUpdated(const QGeoPositionInfo &update);
+    void deliverUpdate(const QGeoPositionInfo &update);
 
     QNmeaPositionInfoSource *m_source;
     QNmeaReader *m_nmeaReader;
     QBasicTimer *m_updateTimer;
     QGeoPositionInfo m_pendingUpdate;
-    QDate m_currentDate;
+    QNmeaSentenceContext m_context;
+    QNmeaEpochAssembler m_epochs;
     QTimer *m_requestTimer;
-    qreal m_horizontalAccuracy;
-    qreal m_verticalAccuracy;
+    QTimer *m_epochTimer;
     bool m_noUpdateLastInterval;
     bool m_updateTimeoutSent;
     bool m_connectedReadyRead;
@@ -130,8 +226,15 @@ public:
 
     virtual void readAvailableData() = 0;
 
+    void clearBuffer() { m_sentences.clear(); }
+
 protected:
+    bool readSentence(const char **data, int *size, bool partialAtEnd);
+
     QNmeaPositionInfoSourcePrivate *m_proxy;
+
+private:
+    QNmeaSentenceReader m_sentences;
 };
 
 
@@ -147,6 +250,9 @@ class QNmeaSimulatedReader : public QObject, public QNmeaReader
 {
     Q_OBJECT
 public:
+    // updates sent per event loop pass when replaying without waiting
+    enum { ReplayBatchSize = 256 };
+
     explicit QNmeaSimulatedReader(QNmeaPositionInfoSourcePrivate *sourcePrivate);
     ~QNmeaSimulatedReader();
     virtual void readAvailableData();
@@ -159,7 +265,8 @@ private Q_SLOTS:
 
 private:
     bool setFirstDateTime();
-    void processNextSentence();
+    int processNextSentence();
+    void scheduleNextUpdate(int msec);
 
     QQueue<QPendingGeoPositionInfo> m_pendingUpdates;
     int m_currTimerId;
@@ -42,14 +42,23 @@ qtHaveModule(location) {
            qgeocodereply \
            qgeocodingmanager \
            qgeomaneuver \
+           qgeomapitemindex \
            qgeomapscene \
+           qgeopolygontessellator \
+           qgeosimplifiedpath \
            qgeoroute \
            qgeoroutereply \
            qgeorouterequest \
            qgeoroutesegment \
+           qgeoroutetracker \
            qgeoroutingmanager \
            qgeoroutingmanagerplugins \
            qgeotilespec \
+           qgeotilepackstore \
+           qconcurrentcache3q \
+           qgeotilefetcher \
+           qgeotileprefetcher \
+           qgeotileregiondownload \
            qgeoroutexmlparser \
            qgeomapcontroller \
            maptype \
@@ -74,9 +83,11 @@ SUBDIRS += \
            qgeorectangle \
            qgeocircle \
            qgeocoordinate \
+           qgeocoordinatearray \
            qgeolocation \
            qgeopositioninfo \
            qgeopositioninfosource \
            qgeosatelliteinfo \
            qgeosatelliteinfosource \
+           qlocationutils \
            qnmeapositioninfosource
@@ -237,6 +237,8 @@ Item {
             SignalSpy {id: preMapRouteLineColorChanged; target: parent.line; signalName: "colorChanged"}
         }
     }
+    SignalSpy {id: mapItemBatchingChanged; target: map; signalName: "mapItemBatchingChanged"}
+
     TestCase {
         name: "Map Items"
         when: windowShown
@@ -580,6 +582,132 @@ Item {
             preMapQuickItemSourceItemChanged.clear()
         }
 
+        function test_ad_batching() {
+            clear_data()
+            compare(map.mapItemBatching, false)
+            map.mapItemBatching = true
+            compare(mapItemBatchingChanged.count, 1)
+            map.mapItemBatching = true
+            compare(mapItemBatchingChanged.count, 1)
+            wait(10)
+
+            // batched items keep their interaction
+            map.center = preMapPolygon.path[1]
+            var point = map.toScreenPosition(preMapPolygon.path[1])
+            mouseClick(map, point.x - 5, point.y)
+            compare(preMapPolygonClicked.count, 1)
+
+            // items move in and out of the batches
+            preMapPolygon.z = 1
+            preMapPolyline.visible = false
+            wait(10)
+            mouseClick(map, point.x - 5, point.y)
+            compare(preMapPolygonClicked.count, 2)
+            preMapPolygon.z = 0
+            preMapPolyline.visible = true
+            map.removeMapItem(preMapPolyline)
+            map.addMapItem(preMapPolyline)
+            wait(10)
+            mouseClick(map, point.x - 5, point.y)
+            compare(preMapPolygonClicked.count, 3)
+
+            // lines of one color are merged into one node
+            var lines = []
+            for (var i = 0; i < 3; ++i) {
+                var line = Qt.createQmlObject('import QtLocation 5.3; MapPolyline { line.color: "darkred" }', map)
+                line.path = [ QtPositioning.coordinate(20 + i, 15), QtPositioning.coordinate(21 + i, 25) ]
+                map.addMapItem(line)
+                lines.push(line)
+            }
+            var statistics = map.frameStatisticsMap()
+            for (i = 0; i < 50 && statistics.batchedItems < 4; ++i) {
+                wait(20)
+                statistics = map.frameStatisticsMap()
+            }
+            verify(statistics.batchedItems >= 4)
+            verify(statistics.batches > 0)
+            verify(statistics.batches < statistics.batchedItems)
+            verify(statistics.drawCalls < statistics.batchedItems + statistics.unbatchedItems)
+            for (i = 0; i < lines.length; ++i) {
+                map.removeMapItem(lines[i])
+                lines[i].destroy()
+            }
+
+            map.mapItemBatching = false
+            compare(mapItemBatchingChanged.count, 2)
+            wait(10)
+        }
+
+        // long paths are stroked on a worker thread
+        function longPath(fromLongitude, toLongitude) {
+            var path = []
+            var count = 20000
+            for (var i = 0; i < count; ++i) {
+                path.push(QtPositioning.coordinate(20 + (i % 2) * 0.01,
+                          fromLongitude + (toLongitude - fromLongitude) * i / (count - 1)))
+            }
+            return path
+        }
+
+        function test_ae_stale_geometry() {
+            map.center = mapDefaultCenter
+            var polyline = Qt.createQmlObject('import QtLocation 5.3; MapPolyline { '
+                                              + 'property var widths: []; '
+                                              + 'onWidthChanged: widths.push(width) }', map)
+            map.addMapItem(polyline)
+            polyline.path = longPath(0, 40)
+            for (var i = 0; i < 100 && polyline.width === 0; ++i)
+                wait(20)
+            var wideWidth = polyline.width
+            verify(wideWidth > 0)
+
+            // change the path while the job for the previous one runs; the
+            // result for the wide path must never be shown afterwards
+            polyline.path = longPath(18, 42)
+            wait(0)
+            polyline.widths = []
+            polyline.path = longPath(18, 22)
+            for (i = 0; i < 100 && (polyline.widths.length === 0
+                                    || polyline.width > wideWidth / 2); ++i)
+                wait(20)
+            verify(polyline.widths.length > 0)
+            for (i = 0; i < polyline.widths.length; ++i)
+                verify(polyline.widths[i] < wideWidth / 2)
+
+            map.removeMapItem(polyline)
+            polyline.destroy()
+            wait(10)
+        }
+
+        function test_af_delete_during_geometry_job() {
+            map.center = mapDefaultCenter
+            var itemCount = map.mapItems.length
+            for (var i = 0; i < 5; ++i) {
+                var polyline = Qt.createQmlObject('import QtLocation 5.3; MapPolyline {}', map)
+                var polygon = Qt.createQmlObject('import QtLocation 5.3; MapPolygon {}', map)
+                map.addMapItem(polyline)
+                map.addMapItem(polygon)
+                polyline.path = longPath(0, 40)
+                polygon.path = longPath(0, 40)
+                // let the polish start the jobs, then delete the items
+                // before the jobs report back
+                wait(0)
+                map.removeMapItem(polyline)
+                map.removeMapItem(polygon)
+                polyline.destroy()
+                polygon.destroy()
+            }
+            wait(200)
+            compare(map.mapItems.length, itemCount)
+
+            // the map keeps updating its remaining items
+            preMapPolyline.addCoordinate(someCoordinate1)
+            wait(10)
+            verify(preMapPolyline.width > 0)
+            preMapPolyline.removeCoordinate(someCoordinate1)
+            wait(10)
+        }
+
         function fuzzy_compare(val, ref, tol) {
             var tolerance = 2
             if (tol !== undefined)
@@ -348,6 +348,38 @@ Item {
             verify(extMapPolygon.path.length == 0)
         }
 
+        function test_polygon_pan() {
+            map.clearMapItems()
+            clear_data()
+            extMapPolygon.path = [
+                { latitude: 25, longitude: 5 },
+                { latitude: 20, longitude: 10 },
+                { latitude: 15, longitude: 6 }
+            ]
+            map.zoomLevel = 4
+            map.center = extMapPolygon.path[1]
+            map.addMapItem(extMapPolygon)
+
+            // panning reuses the screen geometry, which has to follow the map
+            var i
+            var point
+            for (i = 0; i < 10; ++i) {
+                map.center = QtPositioning.coordinate(20 - i * 0.5, 10 + i * 0.5)
+                point = map.toScreenPosition(extMapPolygon.path[1])
+                mouseClick(map, point.x - 5, point.y)
+                compare(extMapPolygonClicked.count, i + 1)
+            }
+
+            // zooming out by a whole level scales the source geometry
+            map.zoomLevel = 3
+            point = map.toScreenPosition(extMapPolygon.path[1])
+            mouseClick(map, point.x - 5, point.y)
+            compare(extMapPolygonClicked.count, 11)
+
+            map.center = mapDefaultCenter
+            map.clearMapItems()
+        }
+
         function test_polyline() {
             map.clearMapItems()
             clear_data()
@@ -232,6 +232,35 @@ Item {
         }
     }
 
+    TestModel {
+        id: testModelVirtual
+        datatype: 'coordinate'
+        datacount: 100
+        delay: 0
+    }
+
+    Map {
+        id: mapForVirtualView
+        plugin: testPlugin
+        center: QtPositioning.coordinate(-30, 153)
+        width: 100
+        height: 100
+        zoomLevel: 8
+        property int itemCount: mapItems.length
+        MapItemView {
+            id: virtualItemView
+            model: testModelVirtual
+            virtualized: true
+            coordinateRole: "modeldata"
+            delegate: Component {
+                MapCircle {
+                    radius: 1000
+                    center: modeldata.coordinate
+                }
+            }
+        }
+    }
+
     Map {
         id: mapForTestingRouteModel;
         plugin: testPlugin;
@@ -256,6 +285,27 @@ Item {
             mapItemSpy.clear()
         }
 
+        function test_virtualized() {
+            // the rows are 0.2 degrees apart, only the first few are near the viewport
+            wait(100)
+            var nearCount = mapForVirtualView.itemCount
+            verify(nearCount > 0)
+            verify(nearCount < 100)
+
+            // zooming out brings every row into view
+            mapForVirtualView.zoomLevel = 1
+            tryCompare(mapForVirtualView, "itemCount", 100)
+
+            // and zooming back in gives the delegates back
+            mapForVirtualView.zoomLevel = 8
+            tryCompare(mapForVirtualView, "itemCount", nearCount)
+
+            virtualItemView.virtualized = false
+            compare(mapForVirtualView.itemCount, 100)
+            virtualItemView.virtualized = true
+            tryCompare(mapForVirtualView, "itemCount", nearCount)
+        }
+
         function test_basics() {
             compare(theItemView.delegate, theItemViewsComponent);
             compare(theItemView.model, testModel);
@@ -47,6 +47,7 @@
 #include <QDebug>
 #include <QTimerEvent>
 #include <QVariant>
+#include <QPointer>
 
 QT_USE_NAMESPACE
 
@@ -116,7 +117,10 @@ public:
         mappingReply_->callSetMapImageData(bytes);
         mappingReply_->callSetMapImageFormat("png");
 
-        timer_.start(500, this);
+        // several requests are in flight at once, the timer finishes all of them
+        pendingReplies_.append(mappingReply_);
+        if (!timer_.isActive())
+            timer_.start(500, this);
 
         return mappingReply_;
     }
@@ -150,18 +154,25 @@ protected:
 
          Q_ASSERT(mappingReply_);
          timer_.stop();
-         if (errorCode_) {
-             mappingReply_->callSetError(errorCode_, errorString_);
-             emit tileError(mappingReply_->tileSpec(), errorString_);
-         } else {
-             mappingReply_->callSetError(QGeoTiledMapReply::NoError, "no error");
-             mappingReply_->callSetFinished(true);
+         QList<QPointer<TiledMapReplyTest> > replies = pendingReplies_;
+         pendingReplies_.clear();
+         foreach (TiledMapReplyTest *reply, replies) {
+             if (!reply)
+                 continue;
+             if (errorCode_) {
+                 reply->callSetError(errorCode_, errorString_);
+                 emit tileError(reply->tileSpec(), errorString_);
+             } else {
+                 reply->callSetError(QGeoTiledMapReply::NoError, "no error");
+                 reply->callSetFinished(true);
+             }
          }
      }
 
 private:
     bool finishRequestImmediately_;
     TiledMapReplyTest* mappingReply_;
+    QList<QPointer<TiledMapReplyTest> > pendingReplies_;
     QBasicTimer timer_;
     QGeoTiledMapReply::Error errorCode_;
     QString errorString_;
@@ -0,0 +1,10 @@
+TEMPLATE = app
+CONFIG += testcase
+TARGET = tst_qconcurrentcache3q
+
+INCLUDEPATH += ../../../src/location/maps
+
+SOURCES += tst_qconcurrentcache3q.cpp
+
+QT += location testlib
+DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0
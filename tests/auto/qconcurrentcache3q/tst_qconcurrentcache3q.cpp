@@ -0,0 +1,191 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia. For licensing terms and
+** conditions see http://qt.digia.com/licensing. For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights. These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtCore/QThread>
+#include <QtTest/QtTest>
+
+#include "qconcurrentcache3q_p.h"
+
+QT_USE_NAMESPACE
+
+struct CountingPolicy
+{
+    static QAtomicInt removed;
+    static void aboutToBeRemoved(const int &, QSharedPointer<int>) { removed.ref(); }
+    static void aboutToBeEvicted(const int &, QSharedPointer<int>) {}
+};
+
+QAtomicInt CountingPolicy::removed;
+
+typedef QConcurrentCache3Q<int, int> IntCache;
+
+class InsertThread : public QThread
+{
+public:
+    InsertThread(IntCache *cache, int first, int count)
+        : cache_(cache), first_(first), count_(count) {}
+
+protected:
+    void run()
+    {
+        for (int i = first_; i < first_ + count_; ++i) {
+            cache_->insert(i, QSharedPointer<int>(new int(i)));
+            cache_->object(i);
+        }
+    }
+
+private:
+    IntCache *cache_;
+    int first_;
+    int count_;
+};
+
+class tst_QConcurrentCache3Q : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void insertObject();
+    void costBudget();
+    void hitMissCounters();
+    void remove();
+    void serializeRoundTrip();
+    void concurrentInsert();
+};
+
+void tst_QConcurrentCache3Q::insertObject()
+{
+    IntCache cache(1000, 4);
+    QCOMPARE(cache.shardCount(), 4);
+
+    for (int i = 0; i < 100; ++i)
+        QVERIFY(cache.insert(i, QSharedPointer<int>(new int(i * 2))));
+
+    for (int i = 0; i < 100; ++i) {
+        QSharedPointer<int> v = cache.object(i);
+        QVERIFY(v);
+        QCOMPARE(*v, i * 2);
+        QVERIFY(cache.contains(i));
+    }
+    QVERIFY(!cache.object(1000));
+    QVERIFY(!cache.contains(1000));
+}
+
+void tst_QConcurrentCache3Q::costBudget()
+{
+    IntCache cache(64, 8);
+    for (int i = 0; i < 1000; ++i)
+        cache.insert(i, QSharedPointer<int>(new int(i)));
+
+    QVERIFY(cache.totalCost() <= cache.maxCost());
+
+    cache.setMaxCost(16);
+    QCOMPARE(cache.maxCost(), 16);
+    QVERIFY(cache.totalCost() <= 16);
+
+    cache.clear();
+    QCOMPARE(cache.totalCost(), 0);
+}
+
+void tst_QConcurrentCache3Q::hitMissCounters()
+{
+    IntCache cache(100, 2);
+    cache.insert(1, QSharedPointer<int>(new int(1)));
+
+    cache.object(1);
+    cache.object(1);
+    cache.object(2);
+
+    QCOMPARE(cache.hitCount(), 2);
+    QCOMPARE(cache.missCount(), 1);
+}
+
+void tst_QConcurrentCache3Q::remove()
+{
+    QConcurrentCache3Q<int, int, CountingPolicy> cache(100, 4);
+    CountingPolicy::removed.store(0);
+
+    cache.insert(7, QSharedPointer<int>(new int(7)));
+    QVERIFY(cache.contains(7));
+    cache.remove(7);
+    QVERIFY(!cache.contains(7));
+    QCOMPARE(CountingPolicy::removed.load(), 1);
+
+    // removing an unknown key is harmless
+    cache.remove(8);
+    QCOMPARE(CountingPolicy::removed.load(), 1);
+}
+
+void tst_QConcurrentCache3Q::serializeRoundTrip()
+{
+    IntCache cache(1000, 4);
+    for (int i = 0; i < 50; ++i)
+        cache.insert(i, QSharedPointer<int>(new int(i)));
+
+    QList<int> keys;
+    QList<QSharedPointer<int> > values;
+    QList<int> costs;
+    QList<quint64> pops;
+    cache.serializeQueue(1, keys, values, costs, pops);
+    QCOMPARE(keys.size(), 50);
+
+    IntCache restored(1000, 4);
+    restored.deserializeQueue(1, keys, values, costs, pops);
+    for (int i = 0; i < 50; ++i) {
+        QSharedPointer<int> v = restored.object(i);
+        QVERIFY(v);
+        QCOMPARE(*v, i);
+    }
+}
+
+void tst_QConcurrentCache3Q::concurrentInsert()
+{
+    IntCache cache(100000, 8);
+
+    QList<InsertThread *> threads;
+    for (int i = 0; i < 4; ++i)
+        threads.append(new InsertThread(&cache, i * 1000, 1000));
+    foreach (InsertThread *t, threads)
+        t->start();
+    foreach (InsertThread *t, threads)
+        QVERIFY(t->wait(10000));
+    qDeleteAll(threads);
+
+    QCOMPARE(cache.hitCount() + cache.missCount(), 4000);
+    for (int i = 0; i < 4000; ++i)
+        QVERIFY(cache.contains(i));
+}
+
+QTEST_APPLESS_MAIN(tst_QConcurrentCache3Q)
+
+#include "tst_qconcurrentcache3q.moc"
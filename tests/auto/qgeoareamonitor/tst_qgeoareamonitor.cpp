@@ -42,6 +42,7 @@
 
 #include <QDebug>
 #include <QDataStream>
+#include <QtCore/qmath.h>
 
 #include <qgeoareamonitorinfo.h>
 #include <qgeoareamonitorsource.h>
@@ -60,6 +61,40 @@ QT_USE_NAMESPACE
 Q_DECLARE_METATYPE(QGeoPositionInfo)
 Q_DECLARE_METATYPE(QGeoAreaMonitorInfo)
 
+// delivers the positions it is given, without a timer
+class ManualPositionSource : public QGeoPositionInfoSource
+{
+    Q_OBJECT
+public:
+    ManualPositionSource(QObject *parent = 0)
+        : QGeoPositionInfoSource(parent) {}
+
+    void setPosition(const QGeoCoordinate &coordinate, qreal groundSpeed = -1.0)
+    {
+        lastPosition = QGeoPositionInfo(coordinate, QDateTime::currentDateTime());
+        if (groundSpeed >= 0.0)
+            lastPosition.setAttribute(QGeoPositionInfo::GroundSpeed, groundSpeed);
+        emit positionUpdated(lastPosition);
+    }
+
+    QGeoPositionInfo lastKnownPosition(bool /*fromSatellitePositioningMethodsOnly*/ = false) const
+    {
+        return lastPosition;
+    }
+
+    PositioningMethods supportedPositioningMethods() const { return AllPositioningMethods; }
+    int minimumUpdateInterval() const { return 0; }
+    Error error() const { return NoError; }
+
+public slots:
+    void startUpdates() {}
+    void stopUpdates() {}
+    void requestUpdate(int /*timeout*/ = 5000) {}
+
+private:
+    QGeoPositionInfo lastPosition;
+};
+
 class tst_QGeoAreaMonitorSource : public QObject
 {
     Q_OBJECT
@@ -693,6 +728,142 @@ private slots:
         //obj was deleted when setting new source
         delete obj2;
     }
+
+    void tst_manyMonitors()
+    {
+        QGeoAreaMonitorSource *obj = QGeoAreaMonitorSource::createSource(QStringLiteral("positionpoll"), 0);
+        QVERIFY(obj != 0);
+        ManualPositionSource *source = new ManualPositionSource;
+        obj->setPositionInfoSource(source);
+        QSignalSpy enteredSpy(obj, SIGNAL(areaEntered(QGeoAreaMonitorInfo,QGeoPositionInfo)));
+        QSignalSpy exitedSpy(obj, SIGNAL(areaExited(QGeoAreaMonitorInfo,QGeoPositionInfo)));
+
+        // 200m circles every 0.01 degrees, one of which is entered
+        for (int i = 0; i < 20; ++i) {
+            for (int j = 0; j < 20; ++j) {
+                QGeoAreaMonitorInfo circle(QString::number(i * 20 + j));
+                circle.setArea(QGeoCircle(QGeoCoordinate(-27.5 + i * 0.01, 153.0 + j * 0.01), 200));
+                QVERIFY(obj->startMonitoring(circle));
+            }
+        }
+
+        // larger and dateline crossing areas still get their events
+        QGeoAreaMonitorInfo wide("wide");
+        wide.setArea(QGeoRectangle(QGeoCoordinate(-20.0, 150.0), QGeoCoordinate(-30.0, 160.0)));
+        QVERIFY(obj->startMonitoring(wide));
+        QGeoAreaMonitorInfo dateline("dateline");
+        dateline.setArea(QGeoRectangle(QGeoCoordinate(1.0, 179.995), QGeoCoordinate(-1.0, -179.995)));
+        QVERIFY(obj->startMonitoring(dateline));
+
+        source->setPosition(QGeoCoordinate(-27.45, 153.051));
+        QCOMPARE(enteredSpy.count(), 2);
+        QStringList entered;
+        entered << enteredSpy.at(0).at(0).value<QGeoAreaMonitorInfo>().name()
+                << enteredSpy.at(1).at(0).value<QGeoAreaMonitorInfo>().name();
+        entered.sort();
+        QCOMPARE(entered, QStringList() << QStringLiteral("105") << QStringLiteral("wide"));
+        enteredSpy.clear();
+
+        // far away, both are left even though neither is near the position
+        source->setPosition(QGeoCoordinate(0.0, -179.999));
+        QCOMPARE(exitedSpy.count(), 2);
+        QCOMPARE(enteredSpy.count(), 1);
+        QCOMPARE(enteredSpy.at(0).at(0).value<QGeoAreaMonitorInfo>().name(), QStringLiteral("dateline"));
+
+        source->setPosition(QGeoCoordinate(0.0, 179.999));
+        QCOMPARE(exitedSpy.count(), 2);
+        QCOMPARE(enteredSpy.count(), 1);
+
+        delete obj;
+    }
+
+    void tst_adaptiveInterval()
+    {
+        QGeoAreaMonitorSource *obj = QGeoAreaMonitorSource::createSource(QStringLiteral("positionpoll"), 0);
+        QVERIFY(obj != 0);
+        ManualPositionSource *source = new ManualPositionSource;
+        obj->setPositionInfoSource(source);
+        QCOMPARE(source->updateInterval(), 5000);
+        QSignalSpy enteredSpy(obj, SIGNAL(areaEntered(QGeoAreaMonitorInfo,QGeoPositionInfo)));
+
+        QGeoAreaMonitorInfo circle("circle");
+        circle.setArea(QGeoCircle(QGeoCoordinate(0.0, 0.0), 100));
+        QVERIFY(obj->startMonitoring(circle));
+
+        QVERIFY(obj->setProperty("maximumDetectionLatency", 10000));
+        QCOMPARE(source->updateInterval(), 10000);
+
+        // far away and without a speed, the interval is at its maximum
+        source->setPosition(QGeoCoordinate(0.0, 1.0));
+        QCOMPARE(source->updateInterval(), 600000);
+
+        // about a kilometer from the border at 10 m/s
+        source->setPosition(QGeoCoordinate(0.0, 0.01), 10.0);
+        const int expected = 10000 + 1000 * (QGeoCoordinate(0.0, 0.0).distanceTo(QGeoCoordinate(0.0, 0.01)) - 100) / 10;
+        QVERIFY(qAbs(source->updateInterval() - expected) < 100);
+
+        // inside, the border is as near
+        source->setPosition(QGeoCoordinate(0.0, 0.0001), 10.0);
+        QCOMPARE(enteredSpy.count(), 1);
+        QVERIFY(qAbs(source->updateInterval() - 18900) < 100);
+
+        // a slow fix does not count on the device staying slow
+        source->setPosition(QGeoCoordinate(0.0, 0.002), 0.0);
+        const int slow = 10000 + 1000 * (QGeoCoordinate(0.0, 0.0).distanceTo(QGeoCoordinate(0.0, 0.002)) - 100) / 1.5;
+        QVERIFY(qAbs(source->updateInterval() - slow) < 100);
+
+        // a new monitor may be close, so sampling starts over
+        source->setPosition(QGeoCoordinate(0.0, 1.0));
+        QCOMPARE(source->updateInterval(), 600000);
+        QGeoAreaMonitorInfo second("second");
+        second.setArea(QGeoCircle(QGeoCoordinate(0.0, 1.0), 100));
+        QVERIFY(obj->startMonitoring(second));
+        QCOMPARE(source->updateInterval(), 10000);
+
+        QVERIFY(obj->setProperty("maximumDetectionLatency", 0));
+        QCOMPARE(source->updateInterval(), 5000);
+
+        delete obj;
+    }
+
+    void benchmark_positionUpdated_data()
+    {
+        QTest::addColumn<int>("monitors");
+
+        QTest::newRow("100 monitors") << 100;
+        QTest::newRow("10000 monitors") << 10000;
+        QTest::newRow("50000 monitors") << 50000;
+    }
+
+    void benchmark_positionUpdated()
+    {
+        QFETCH(int, monitors);
+
+        QGeoAreaMonitorSource *obj = QGeoAreaMonitorSource::createSource(QStringLiteral("positionpoll"), 0);
+        QVERIFY(obj != 0);
+        ManualPositionSource *source = new ManualPositionSource;
+        obj->setPositionInfoSource(source);
+        QSignalSpy enteredSpy(obj, SIGNAL(areaEntered(QGeoAreaMonitorInfo,QGeoPositionInfo)));
+
+        // delivery zones of 300m spread over a city, 0.005 degrees apart
+        const int side = qCeil(qSqrt(monitors));
+        for (int i = 0; i < monitors; ++i) {
+            QGeoAreaMonitorInfo zone(QString::number(i));
+            zone.setArea(QGeoCircle(QGeoCoordinate(-27.5 + (i / side) * 0.005,
+                                                   153.0 + (i % side) * 0.005), 300));
+            QVERIFY(obj->startMonitoring(zone));
+        }
+
+        int fix = 0;
+        QBENCHMARK {
+            const int zone = (fix++ * 7919) % monitors;
+            source->setPosition(QGeoCoordinate(-27.5 + (zone / side) * 0.005 + 0.001,
+                                               153.0 + (zone % side) * 0.005));
+        }
+        QVERIFY(enteredSpy.count() > 0);
+
+        delete obj;
+    }
 };
 
 
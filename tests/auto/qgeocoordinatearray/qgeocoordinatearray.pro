@@ -0,0 +1,8 @@
+TEMPLATE = app
+CONFIG += testcase
+TARGET = tst_qgeocoordinatearray
+
+SOURCES += tst_qgeocoordinatearray.cpp
+
+QT += positioning-private testlib
+DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0
@@ -0,0 +1,215 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia. For licensing terms and
+** conditions see http://qt.digia.com/licensing. For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights. These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include <QtTest/QtTest>
+#include <QtPositioning/private/qgeocoordinatearray_p.h>
+#include <QtPositioning/private/qgeoprojection_p.h>
+#include <QtPositioning/private/qdoublevector2d_p.h>
+
+QT_USE_NAMESPACE
+
+class tst_QGeoCoordinateArray : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void packed();
+    void roundTrip();
+    void access();
+    void edit();
+    void equality();
+    void sharing();
+    void projection();
+};
+
+void tst_QGeoCoordinateArray::packed()
+{
+    QCOMPARE(sizeof(QGeoPackedCoordinate), 3 * sizeof(double));
+
+    QGeoCoordinateArray array;
+    array.append(1.0, 2.0, 3.0);
+    array.append(4.0, 5.0);
+
+    const QGeoPackedCoordinate *data = array.constData();
+    QCOMPARE(data[0].latitude, 1.0);
+    QCOMPARE(data[0].longitude, 2.0);
+    QCOMPARE(data[0].altitude, 3.0);
+    QCOMPARE(data[1].latitude, 4.0);
+    QVERIFY(qIsNaN(data[1].altitude));
+}
+
+void tst_QGeoCoordinateArray::roundTrip()
+{
+    QGeoCoordinate invalid;
+    invalid.setLatitude(100.0);
+    invalid.setLongitude(10.0);
+
+    QList<QGeoCoordinate> list;
+    list << QGeoCoordinate(10.0, 20.0)
+         << QGeoCoordinate(-30.0, 40.0, 50.0)
+         << invalid
+         << QGeoCoordinate();
+
+    QGeoCoordinateArray array(list);
+    QCOMPARE(array.size(), 4);
+    QCOMPARE(array.toList(), list);
+
+    QCOMPARE(array.at(1).type(), QGeoCoordinate::Coordinate3D);
+    QCOMPARE(array.at(2).latitude(), 100.0);
+    QVERIFY(!array.isValid(2));
+    QVERIFY(!array.isValid(3));
+    QVERIFY(array.isValid(0));
+
+    QVERIFY(QGeoCoordinateArray().toList().isEmpty());
+}
+
+void tst_QGeoCoordinateArray::access()
+{
+    QGeoCoordinateArray array;
+    array.append(QGeoCoordinate(10.0, 20.0, 30.0));
+    array.append(QGeoCoordinate(-10.0, -20.0));
+
+    QCOMPARE(array.latitude(0), 10.0);
+    QCOMPARE(array.longitude(0), 20.0);
+    QCOMPARE(array.altitude(0), 30.0);
+    QCOMPARE(array.first(), QGeoCoordinate(10.0, 20.0, 30.0));
+    QCOMPARE(array.last(), QGeoCoordinate(-10.0, -20.0));
+
+    // the coordinate is reused and takes the altitude of each point
+    QGeoCoordinate c;
+    array.coordinateAt(0, &c);
+    QCOMPARE(c, QGeoCoordinate(10.0, 20.0, 30.0));
+    array.coordinateAt(1, &c);
+    QCOMPARE(c, QGeoCoordinate(-10.0, -20.0));
+    QCOMPARE(c.type(), QGeoCoordinate::Coordinate2D);
+}
+
+void tst_QGeoCoordinateArray::edit()
+{
+    QGeoCoordinateArray array;
+    for (int i = 0; i < 5; ++i)
+        array.append(QGeoCoordinate(i, i));
+    array.append(QGeoCoordinate(1.0, 1.0));
+
+    QCOMPARE(array.lastIndexOf(QGeoCoordinate(1.0, 1.0)), 5);
+    QCOMPARE(array.lastIndexOf(QGeoCoordinate(1.0, 2.0)), -1);
+
+    array.removeAt(5);
+    QCOMPARE(array.lastIndexOf(QGeoCoordinate(1.0, 1.0)), 1);
+
+    array.replace(2, QGeoCoordinate(20.0, 30.0));
+    QCOMPARE(array.at(2), QGeoCoordinate(20.0, 30.0));
+    array.replace(3, 40.0, 50.0, 60.0);
+    QCOMPARE(array.at(3), QGeoCoordinate(40.0, 50.0, 60.0));
+
+    QGeoCoordinateArray middle = array.mid(1, 2);
+    QCOMPARE(middle.size(), 2);
+    QCOMPARE(middle.at(0), QGeoCoordinate(1.0, 1.0));
+
+    QGeoCoordinateArray joined = middle;
+    joined.append(array.mid(3));
+    QCOMPARE(joined.size(), 4);
+    QCOMPARE(joined.at(3), QGeoCoordinate(4.0, 4.0));
+
+    array.clear();
+    QVERIFY(array.isEmpty());
+}
+
+void tst_QGeoCoordinateArray::equality()
+{
+    QGeoCoordinateArray a;
+    a.append(QGeoCoordinate(10.0, 20.0));
+    a.append(QGeoCoordinate(90.0, 20.0));
+
+    // the same fuzzy comparison as QGeoCoordinate, longitudes at the poles
+    // do not matter
+    QGeoCoordinateArray b;
+    b.append(QGeoCoordinate(10.0, 20.0 + 1e-14));
+    b.append(QGeoCoordinate(90.0, -100.0));
+    QVERIFY(a == b);
+
+    b.replace(0, QGeoCoordinate(10.0, 21.0));
+    QVERIFY(a != b);
+
+    b.removeAt(0);
+    QVERIFY(a != b);
+}
+
+void tst_QGeoCoordinateArray::sharing()
+{
+    QGeoCoordinateArray a;
+    for (int i = 0; i < 100; ++i)
+        a.append(i * 0.5, i);
+
+    QGeoCoordinateArray b = a;
+    QCOMPARE(b.constData(), a.constData());
+
+    b.replace(0, QGeoCoordinate(1.0, 1.0));
+    QVERIFY(b.constData() != a.constData());
+    QCOMPARE(a.at(0), QGeoCoordinate(0.0, 0.0));
+}
+
+void tst_QGeoCoordinateArray::projection()
+{
+    QGeoCoordinateArray coords;
+    for (int i = 0; i <= 36; ++i)
+        coords.append(-90.0 + i * 5.0, -180.0 + i * 10.0);
+    coords.append(qQNaN(), qQNaN());
+
+    // the batch gives exactly the results of one point at a time
+    QVector<QDoubleVector2D> mercator(coords.size());
+    QGeoProjection::coordToMercator(coords, mercator.data());
+    for (int i = 0; i < coords.size() - 1; ++i) {
+        QDoubleVector2D single = QGeoProjection::coordToMercator(coords.at(i));
+        QCOMPARE(mercator.at(i).x(), single.x());
+        QCOMPARE(mercator.at(i).y(), single.y());
+    }
+
+    QGeoCoordinateArray back;
+    back.append(1.0, 2.0);
+    QGeoProjection::mercatorToCoord(mercator.constData(), mercator.size() - 1, &back);
+    QCOMPARE(back.size(), coords.size());
+    QCOMPARE(back.at(0), QGeoCoordinate(1.0, 2.0));
+    for (int i = 0; i < mercator.size() - 1; ++i)
+        QCOMPARE(back.at(i + 1), QGeoProjection::mercatorToCoord(mercator.at(i)));
+
+    QDoubleVector2D invalid(qQNaN(), qQNaN());
+    QGeoProjection::mercatorToCoord(&invalid, 1, &back);
+    QVERIFY(!back.isValid(back.size() - 1));
+    QCOMPARE(back.last(), QGeoProjection::mercatorToCoord(invalid));
+}
+
+QTEST_APPLESS_MAIN(tst_QGeoCoordinateArray)
+
+#include "tst_qgeocoordinatearray.moc"
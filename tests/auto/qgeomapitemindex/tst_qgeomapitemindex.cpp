@@ -0,0 +1,274 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia. For licensing terms and
+** conditions see http://qt.digia.com/licensing. For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights. These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include <QtTest/QtTest>
+#include <QtCore/QObject>
+
+#include "qgeomapitemindex_p.h"
+
+QT_USE_NAMESPACE
+
+class tst_QGeoMapItemIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    tst_QGeoMapItemIndex();
+    ~tst_QGeoMapItemIndex();
+
+private slots:
+    void insertAndQuery();
+    void pointQuery();
+    void removeAndMove();
+    void unbounded();
+    void dateline();
+    void mixedSizes();
+    void matchesLinearScan();
+    void queryThroughput();
+
+private:
+    QObject *newItem();
+    static QSet<QObject *> toSet(const QVector<QObject *> &items);
+
+    QList<QObject *> items_;
+};
+
+tst_QGeoMapItemIndex::tst_QGeoMapItemIndex()
+{
+}
+
+tst_QGeoMapItemIndex::~tst_QGeoMapItemIndex()
+{
+    qDeleteAll(items_);
+}
+
+QObject *tst_QGeoMapItemIndex::newItem()
+{
+    QObject *item = new QObject;
+    items_.append(item);
+    return item;
+}
+
+QSet<QObject *> tst_QGeoMapItemIndex::toSet(const QVector<QObject *> &items)
+{
+    QSet<QObject *> result;
+    foreach (QObject *item, items)
+        result.insert(item);
+    // every item is reported once
+    Q_ASSERT(result.size() == items.size());
+    return result;
+}
+
+void tst_QGeoMapItemIndex::insertAndQuery()
+{
+    QGeoMapItemIndex index;
+    QObject *a = newItem();
+    QObject *b = newItem();
+
+    index.insert(a, QRectF(0.1, 0.1, 0.05, 0.05));
+    index.insert(b, QRectF(0.6, 0.6, 0.01, 0.01));
+    QCOMPARE(index.size(), 2);
+    QVERIFY(index.contains(a));
+    QVERIFY(index.isBounded(b));
+    QCOMPARE(index.bounds(a), QRectF(0.1, 0.1, 0.05, 0.05));
+
+    QCOMPARE(toSet(index.query(QRectF(0.0, 0.0, 0.2, 0.2))), QSet<QObject *>() << a);
+    QCOMPARE(toSet(index.query(QRectF(0.5, 0.5, 0.2, 0.2))), QSet<QObject *>() << b);
+    QCOMPARE(toSet(index.query(QRectF(0.0, 0.0, 1.0, 1.0))), QSet<QObject *>() << a << b);
+    QVERIFY(index.query(QRectF(0.3, 0.3, 0.1, 0.1)).isEmpty());
+
+    // overlapping the edge of an item is enough
+    QCOMPARE(toSet(index.query(QRectF(0.14, 0.14, 0.2, 0.2))), QSet<QObject *>() << a);
+}
+
+void tst_QGeoMapItemIndex::pointQuery()
+{
+    QGeoMapItemIndex index;
+    QObject *marker = newItem();
+    QObject *area = newItem();
+
+    index.insert(marker, QRectF(0.25, 0.25, 0.0, 0.0));
+    index.insert(area, QRectF(0.2, 0.2, 0.1, 0.1));
+
+    QCOMPARE(toSet(index.query(QRectF(0.25, 0.25, 0.0, 0.0))),
+             QSet<QObject *>() << marker << area);
+    QCOMPARE(toSet(index.query(QRectF(0.21, 0.21, 0.0, 0.0))), QSet<QObject *>() << area);
+    QVERIFY(index.query(QRectF(0.31, 0.25, 0.0, 0.0)).isEmpty());
+}
+
+void tst_QGeoMapItemIndex::removeAndMove()
+{
+    QGeoMapItemIndex index;
+    QObject *a = newItem();
+    QObject *b = newItem();
+
+    index.insert(a, QRectF(0.1, 0.1, 0.001, 0.001));
+    index.insert(b, QRectF(0.1, 0.1, 0.001, 0.001));
+
+    // moving an item replaces its old bounds
+    index.insert(a, QRectF(0.8, 0.8, 0.001, 0.001));
+    QCOMPARE(index.size(), 2);
+    QCOMPARE(toSet(index.query(QRectF(0.0, 0.0, 0.5, 0.5))), QSet<QObject *>() << b);
+    QCOMPARE(toSet(index.query(QRectF(0.5, 0.5, 0.5, 0.5))), QSet<QObject *>() << a);
+
+    index.remove(b);
+    QVERIFY(!index.contains(b));
+    QCOMPARE(index.size(), 1);
+    QVERIFY(index.query(QRectF(0.0, 0.0, 0.5, 0.5)).isEmpty());
+
+    // removing twice is harmless
+    index.remove(b);
+    QCOMPARE(index.size(), 1);
+
+    index.clear();
+    QCOMPARE(index.size(), 0);
+    QVERIFY(index.query(QRectF(0.0, 0.0, 1.0, 1.0)).isEmpty());
+}
+
+void tst_QGeoMapItemIndex::unbounded()
+{
+    QGeoMapItemIndex index;
+    QObject *a = newItem();
+    QObject *b = newItem();
+
+    index.insertUnbounded(a);
+    index.insert(b, QRectF(0.5, 0.5, 0.01, 0.01));
+    QVERIFY(index.contains(a));
+    QVERIFY(!index.isBounded(a));
+    QCOMPARE(index.bounds(a), QRectF());
+
+    QCOMPARE(toSet(index.query(QRectF(0.0, 0.0, 0.1, 0.1))), QSet<QObject *>() << a);
+    QCOMPARE(toSet(index.query(QRectF(0.45, 0.45, 0.1, 0.1))), QSet<QObject *>() << a << b);
+
+    // giving it bounds makes it a regular item
+    index.insert(a, QRectF(0.9, 0.9, 0.01, 0.01));
+    QVERIFY(index.isBounded(a));
+    QVERIFY(index.query(QRectF(0.0, 0.0, 0.1, 0.1)).isEmpty());
+}
+
+void tst_QGeoMapItemIndex::dateline()
+{
+    QGeoMapItemIndex index;
+    QObject *east = newItem();
+    QObject *across = newItem();
+    QObject *west = newItem();
+
+    index.insert(east, QRectF(0.98, 0.5, 0.01, 0.01));
+    index.insert(across, QRectF(0.99, 0.4, 0.02, 0.01));
+    // bounds left of the dateline are folded back into the world
+    index.insert(west, QRectF(-0.99, 0.5, 0.01, 0.01));
+    QVERIFY(qAbs(index.bounds(west).left() - 0.01) < 1e-12);
+
+    // a viewport straddling the dateline, expressed either way
+    const QSet<QObject *> all = QSet<QObject *>() << east << across << west;
+    QCOMPARE(toSet(index.query(QRectF(-0.05, 0.3, 0.1, 0.3))), all);
+    QCOMPARE(toSet(index.query(QRectF(0.95, 0.3, 0.1, 0.3))), all);
+
+    // only the part of the item east of the dateline
+    QCOMPARE(toSet(index.query(QRectF(0.002, 0.4, 0.001, 0.01))), QSet<QObject *>() << across);
+    QCOMPARE(toSet(index.query(QRectF(1.002, 0.4, 0.001, 0.01))), QSet<QObject *>() << across);
+}
+
+void tst_QGeoMapItemIndex::mixedSizes()
+{
+    QGeoMapItemIndex index;
+    QObject *world = newItem();
+    QObject *country = newItem();
+    QObject *street = newItem();
+
+    index.insert(world, QRectF(0.0, 0.2, 1.0, 0.6));
+    index.insert(country, QRectF(0.5, 0.3, 0.05, 0.05));
+    index.insert(street, QRectF(0.52, 0.32, 1e-7, 1e-7));
+
+    QCOMPARE(toSet(index.query(QRectF(0.52, 0.32, 1e-6, 1e-6))),
+             QSet<QObject *>() << world << country << street);
+    QCOMPARE(toSet(index.query(QRectF(0.1, 0.5, 0.01, 0.01))), QSet<QObject *>() << world);
+    QVERIFY(index.query(QRectF(0.1, 0.9, 0.01, 0.01)).isEmpty());
+}
+
+void tst_QGeoMapItemIndex::matchesLinearScan()
+{
+    QGeoMapItemIndex index;
+    QHash<QObject *, QRectF> bounds;
+
+    qsrand(7);
+    for (int i = 0; i < 2000; ++i) {
+        QObject *item = newItem();
+        const double size = std::pow(10.0, -1.0 - 6.0 * (qrand() / double(RAND_MAX)));
+        const QRectF rect((qrand() / double(RAND_MAX)) * 1.2 - 0.1,
+                          qrand() / double(RAND_MAX),
+                          size * (qrand() % 3), size);
+        index.insert(item, rect);
+        bounds.insert(item, index.bounds(item));
+    }
+
+    for (int i = 0; i < 200; ++i) {
+        const double size = std::pow(10.0, -4.0 * (qrand() / double(RAND_MAX)));
+        const QRectF query((qrand() / double(RAND_MAX)) * 1.2 - 0.1,
+                           qrand() / double(RAND_MAX),
+                           size, size * 0.75);
+
+        QSet<QObject *> expected;
+        QHash<QObject *, QRectF>::const_iterator it;
+        for (it = bounds.constBegin(); it != bounds.constEnd(); ++it) {
+            if (QGeoMapItemIndex::intersects(it.value(), query))
+                expected.insert(it.key());
+        }
+        QCOMPARE(toSet(index.query(query)), expected);
+    }
+}
+
+void tst_QGeoMapItemIndex::queryThroughput()
+{
+    // 20000 markers spread over a city, viewed at street level
+    QGeoMapItemIndex index;
+    qsrand(11);
+    for (int i = 0; i < 20000; ++i) {
+        const double x = 0.5 + 0.001 * (qrand() / double(RAND_MAX));
+        const double y = 0.3 + 0.001 * (qrand() / double(RAND_MAX));
+        index.insert(newItem(), QRectF(x, y, 2e-7, 2e-7));
+    }
+
+    const QRectF viewport(0.5004, 0.3004, 0.0001, 0.0001);
+    int found = 0;
+    QBENCHMARK {
+        found = index.query(viewport).size();
+    }
+    QVERIFY(found > 0);
+    QVERIFY(found < 20000 / 10);
+}
+
+QTEST_APPLESS_MAIN(tst_QGeoMapItemIndex)
+
+#include "tst_qgeomapitemindex.moc"
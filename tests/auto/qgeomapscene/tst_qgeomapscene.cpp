@@ -41,6 +41,7 @@
 
 #include <QtPositioning/private/qgeoprojection_p.h>
 #include <QtPositioning/private/qdoublevector2d_p.h>
+#include <QtPositioning/private/qgeocoordinatearray_p.h>
 
 #include <qtest.h>
 
@@ -386,6 +387,101 @@ class tst_QGeoMapScene : public QObject
             populateScreenMercatorData();
         }
 
+        void mercatorToScreenPositionsBatch(){
+            QFETCH(double, cameraCenterX);
+            QFETCH(double, cameraCenterY);
+            QFETCH(double, zoom);
+            QFETCH(int, tileSize);
+            QFETCH(int, screenWidth);
+            QFETCH(int, screenHeight);
+            QFETCH(double, mercatorX);
+            QFETCH(double, mercatorY);
+
+            QGeoCameraData camera;
+            camera.setZoomLevel(zoom);
+            camera.setCenter(QGeoProjection::mercatorToCoord(QDoubleVector2D(cameraCenterX, cameraCenterY)));
+
+            QGeoMapScene mapGeometry;
+            mapGeometry.setTileSize(tileSize);
+            mapGeometry.setScreenSize(QSize(screenWidth,screenHeight));
+            mapGeometry.setCameraData(camera);
+
+            // the point itself and points around it, across the dateline
+            QVector<QDoubleVector2D> mercator;
+            for (int i = -2; i <= 2; ++i)
+                mercator << QDoubleVector2D(mercatorX + i * 0.3, mercatorY);
+
+            QVector<QDoubleVector2D> screen(mercator.size());
+            mapGeometry.mercatorToScreenPositions(mercator.constData(), mercator.size(), screen.data());
+
+            for (int i = 0; i < mercator.size(); ++i) {
+                QDoubleVector2D single = mapGeometry.mercatorToScreenPosition(mercator.at(i));
+                QCOMPARE(screen.at(i).x(), single.x());
+                QCOMPARE(screen.at(i).y(), single.y());
+            }
+
+            // in place
+            mapGeometry.mercatorToScreenPositions(mercator.constData(), mercator.size(), mercator.data());
+            QCOMPARE(mercator, screen);
+        }
+
+        void mercatorToScreenPositionsBatch_data(){
+            populateScreenMercatorData();
+        }
+
+        void projectionThroughput(){
+            QFETCH(bool, batch);
+
+            QGeoCameraData camera;
+            camera.setZoomLevel(10);
+            camera.setCenter(QGeoCoordinate(60.17, 24.94));
+
+            QGeoMapScene mapGeometry;
+            mapGeometry.setTileSize(256);
+            mapGeometry.setScreenSize(QSize(1024, 768));
+            mapGeometry.setCameraData(camera);
+
+            // a 100k point track around the camera
+            const int count = 100000;
+            QGeoCoordinateArray track;
+            track.reserve(count);
+            for (int i = 0; i < count; ++i)
+                track.append(60.17 + std::sin(i * 0.001) * 0.2, 24.94 + std::cos(i * 0.0007) * 0.4);
+
+            QVector<QDoubleVector2D> screen(count);
+            QBENCHMARK {
+                if (batch) {
+                    QGeoProjection::coordToMercator(track, screen.data());
+                    mapGeometry.mercatorToScreenPositions(screen.constData(), count, screen.data());
+                } else {
+                    for (int i = 0; i < count; ++i) {
+                        QDoubleVector2D mercator = QGeoProjection::coordToMercator(track.at(i));
+                        screen[i] = mapGeometry.mercatorToScreenPosition(mercator);
+                    }
+                }
+            }
+
+            // the other path has to put the track in the same place
+            QVector<QDoubleVector2D> other(count);
+            if (batch) {
+                for (int i = 0; i < count; ++i)
+                    other[i] = mapGeometry.mercatorToScreenPosition(QGeoProjection::coordToMercator(track.at(i)));
+            } else {
+                QGeoProjection::coordToMercator(track, other.data());
+                mapGeometry.mercatorToScreenPositions(other.constData(), count, other.data());
+            }
+            for (int i = 0; i < count; ++i) {
+                QCOMPARE(screen.at(i).x(), other.at(i).x());
+                QCOMPARE(screen.at(i).y(), other.at(i).y());
+            }
+        }
+
+        void projectionThroughput_data(){
+            QTest::addColumn<bool>("batch");
+            QTest::newRow("single") << false;
+            QTest::newRow("batch") << true;
+        }
+
 };
 
 QTEST_GUILESS_MAIN(tst_QGeoMapScene)
@@ -0,0 +1,371 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia. For licensing terms and
+** conditions see http://qt.digia.com/licensing. For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights. These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include <QtTest/QtTest>
+#include <QtCore/QObject>
+#include <QtCore/qmath.h>
+
+#include "qgeopolygontessellator_p.h"
+
+QT_USE_NAMESPACE
+
+class tst_QGeoPolygonTessellator : public QObject
+{
+    Q_OBJECT
+
+public:
+    tst_QGeoPolygonTessellator();
+    ~tst_QGeoPolygonTessellator();
+
+private slots:
+    void emptyAndDegenerate();
+    void convex();
+    void concave();
+    void hole();
+    void manyHoles();
+    void multipolygon();
+    void painterPath();
+    void clipped_data();
+    void clipped();
+    void clippedAway();
+    void clippedHole();
+    void largePolygon();
+    void reuse();
+    void tessellateLandUse_data();
+    void tessellateLandUse();
+
+private:
+    static QVector<QPointF> rectangle(double x, double y, double w, double h);
+    static QVector<QPointF> boundary(int count, int seed);
+    static double ringArea(const QVector<QPointF> &ring);
+    static double triangleArea(const QGeoPolygonTessellator &tessellator);
+};
+
+tst_QGeoPolygonTessellator::tst_QGeoPolygonTessellator()
+{
+}
+
+tst_QGeoPolygonTessellator::~tst_QGeoPolygonTessellator()
+{
+}
+
+QVector<QPointF> tst_QGeoPolygonTessellator::rectangle(double x, double y, double w, double h)
+{
+    return QVector<QPointF>() << QPointF(x, y) << QPointF(x + w, y)
+                              << QPointF(x + w, y + h) << QPointF(x, y + h);
+}
+
+// an admin boundary: a ring with a wandering radius
+QVector<QPointF> tst_QGeoPolygonTessellator::boundary(int count, int seed)
+{
+    QVector<QPointF> ring;
+    ring.reserve(count);
+    qsrand(seed);
+
+    double radius = 500.0;
+    for (int i = 0; i < count; ++i) {
+        const double angle = 2.0 * M_PI * i / count;
+        radius = qBound(100.0, radius + 4.0 * (qrand() / double(RAND_MAX) - 0.5), 900.0);
+        ring.append(QPointF(radius * qCos(angle), radius * qSin(angle)));
+    }
+    return ring;
+}
+
+double tst_QGeoPolygonTessellator::ringArea(const QVector<QPointF> &ring)
+{
+    double sum = 0.0;
+    for (int i = 0, j = ring.size() - 1; i < ring.size(); j = i++)
+        sum += (ring.at(j).x() - ring.at(i).x()) * (ring.at(j).y() + ring.at(i).y());
+    return qAbs(sum) / 2.0;
+}
+
+double tst_QGeoPolygonTessellator::triangleArea(const QGeoPolygonTessellator &tessellator)
+{
+    const QVector<QPointF> &v = tessellator.vertices();
+    const QVector<quint32> &ix = tessellator.indices();
+    double sum = 0.0;
+    for (int i = 0; i + 2 < ix.size(); i += 3) {
+        const QPointF &a = v.at(ix.at(i));
+        const QPointF &b = v.at(ix.at(i + 1));
+        const QPointF &c = v.at(ix.at(i + 2));
+        sum += qAbs((b.x() - a.x()) * (c.y() - a.y()) - (c.x() - a.x()) * (b.y() - a.y())) / 2.0;
+    }
+    return sum;
+}
+
+void tst_QGeoPolygonTessellator::emptyAndDegenerate()
+{
+    QGeoPolygonTessellator tessellator;
+    tessellator.tessellate();
+    QCOMPARE(tessellator.ringCount(), 0);
+    QVERIFY(tessellator.indices().isEmpty());
+
+    // fewer than three points, even with the closing point repeated
+    tessellator.addRing(QVector<QPointF>() << QPointF(0, 0) << QPointF(1, 1) << QPointF(0, 0));
+    tessellator.tessellate();
+    QCOMPARE(tessellator.ringCount(), 0);
+
+    // no area
+    tessellator.clear();
+    tessellator.addRing(QVector<QPointF>() << QPointF(0, 0) << QPointF(1, 1) << QPointF(2, 2));
+    tessellator.tessellate();
+    QCOMPARE(tessellator.ringCount(), 1);
+    QCOMPARE(triangleArea(tessellator), 0.0);
+}
+
+void tst_QGeoPolygonTessellator::convex()
+{
+    QGeoPolygonTessellator tessellator;
+    tessellator.addRing(rectangle(0, 0, 10, 20));
+    tessellator.tessellate();
+
+    QCOMPARE(tessellator.vertices().size(), 4);
+    QCOMPARE(tessellator.indices().size(), 6);
+    QCOMPARE(triangleArea(tessellator), 200.0);
+}
+
+void tst_QGeoPolygonTessellator::concave()
+{
+    // an L, in both windings
+    QVector<QPointF> l;
+    l << QPointF(0, 0) << QPointF(10, 0) << QPointF(10, 3) << QPointF(3, 3)
+      << QPointF(3, 10) << QPointF(0, 10);
+
+    QGeoPolygonTessellator tessellator;
+    tessellator.addRing(l);
+    tessellator.tessellate();
+    QCOMPARE(tessellator.indices().size(), 3 * 4);
+    QCOMPARE(triangleArea(tessellator), 51.0);
+
+    std::reverse(l.begin(), l.end());
+    tessellator.clear();
+    tessellator.addRing(l);
+    tessellator.tessellate();
+    QCOMPARE(triangleArea(tessellator), 51.0);
+}
+
+void tst_QGeoPolygonTessellator::hole()
+{
+    QGeoPolygonTessellator tessellator;
+    tessellator.addRing(rectangle(0, 0, 10, 10));
+    tessellator.addRing(rectangle(3, 3, 3, 3));
+    tessellator.tessellate();
+
+    QCOMPARE(tessellator.ringCount(), 2);
+    QCOMPARE(triangleArea(tessellator), 91.0);
+
+    // the order of the rings does not matter
+    tessellator.clear();
+    tessellator.addRing(rectangle(3, 3, 3, 3));
+    tessellator.addRing(rectangle(0, 0, 10, 10));
+    tessellator.tessellate();
+    QCOMPARE(triangleArea(tessellator), 91.0);
+}
+
+void tst_QGeoPolygonTessellator::manyHoles()
+{
+    // holes on the same lines bridge to each other and to the same corners
+    QGeoPolygonTessellator tessellator;
+    tessellator.addRing(rectangle(0, 0, 100, 10));
+    double holes = 0.0;
+    for (int i = 0; i < 12; ++i) {
+        tessellator.addRing(rectangle(2 + i * 8, 2 + i % 3, 3, 3));
+        holes += 9.0;
+    }
+    tessellator.tessellate();
+
+    QCOMPARE(tessellator.ringCount(), 13);
+    QCOMPARE(triangleArea(tessellator), 1000.0 - holes);
+}
+
+void tst_QGeoPolygonTessellator::multipolygon()
+{
+    // two polygons, one of them with a hole that has an island in it
+    QGeoPolygonTessellator tessellator;
+    tessellator.addRing(rectangle(0, 0, 10, 10));
+    tessellator.addRing(rectangle(2, 2, 6, 6));
+    tessellator.addRing(rectangle(4, 4, 2, 2));
+    tessellator.addRing(rectangle(20, 0, 5, 5));
+    tessellator.tessellate();
+
+    QCOMPARE(tessellator.ringCount(), 4);
+    QCOMPARE(triangleArea(tessellator), 100.0 - 36.0 + 4.0 + 25.0);
+}
+
+void tst_QGeoPolygonTessellator::painterPath()
+{
+    QPainterPath path;
+    path.addPolygon(QPolygonF(rectangle(0, 0, 10, 10)));
+    path.closeSubpath();
+    path.addPolygon(QPolygonF(rectangle(3, 3, 3, 3)));
+    path.closeSubpath();
+
+    QGeoPolygonTessellator tessellator;
+    tessellator.addPath(path);
+    tessellator.tessellate();
+
+    QCOMPARE(tessellator.ringCount(), 2);
+    QCOMPARE(tessellator.ringSize(0), 4);
+    QCOMPARE(triangleArea(tessellator), 91.0);
+}
+
+void tst_QGeoPolygonTessellator::clipped_data()
+{
+    QTest::addColumn<QVector<QPointF> >("ring");
+    QTest::addColumn<QRectF>("clipRect");
+    QTest::addColumn<double>("area");
+
+    QVector<QPointF> u;
+    u << QPointF(0, 0) << QPointF(0, 20) << QPointF(3, 20) << QPointF(3, 3)
+      << QPointF(7, 3) << QPointF(7, 20) << QPointF(10, 20) << QPointF(10, 0);
+
+    QTest::newRow("inside") << rectangle(0, 0, 10, 10) << QRectF(-5, -5, 20, 20) << 100.0;
+    QTest::newRow("corner") << rectangle(0, 0, 10, 10) << QRectF(5, 5, 20, 20) << 25.0;
+    QTest::newRow("covering") << rectangle(0, 0, 10, 10) << QRectF(2, 2, 4, 4) << 16.0;
+    QTest::newRow("concave, one piece") << u << QRectF(-5, -5, 20, 15) << 100.0 - 28.0;
+    // the arms of the U leave and enter the viewport, which must not fill
+    // the gap between them
+    QTest::newRow("concave, two pieces") << u << QRectF(-5, 10, 20, 20) << 60.0;
+}
+
+void tst_QGeoPolygonTessellator::clipped()
+{
+    QFETCH(QVector<QPointF>, ring);
+    QFETCH(QRectF, clipRect);
+    QFETCH(double, area);
+
+    QGeoPolygonTessellator tessellator;
+    tessellator.setClipRect(clipRect);
+    tessellator.addRing(ring);
+    tessellator.tessellate();
+
+    QCOMPARE(tessellator.ringCount(), 1);
+    QCOMPARE(triangleArea(tessellator), area);
+    foreach (const QPointF &p, tessellator.vertices())
+        QVERIFY(clipRect.adjusted(-1e-9, -1e-9, 1e-9, 1e-9).contains(p));
+}
+
+void tst_QGeoPolygonTessellator::clippedAway()
+{
+    QGeoPolygonTessellator tessellator;
+    tessellator.setClipRect(QRectF(100, 100, 10, 10));
+    tessellator.addRing(rectangle(0, 0, 10, 10));
+    tessellator.tessellate();
+
+    QCOMPARE(tessellator.ringCount(), 0);
+    QVERIFY(tessellator.vertices().isEmpty());
+    QVERIFY(tessellator.indices().isEmpty());
+}
+
+void tst_QGeoPolygonTessellator::clippedHole()
+{
+    QGeoPolygonTessellator tessellator;
+    tessellator.setClipRect(QRectF(0, 0, 5, 10));
+    tessellator.addRing(rectangle(0, 0, 10, 10));
+    tessellator.addRing(rectangle(3, 3, 4, 4));
+    tessellator.tessellate();
+
+    QCOMPARE(triangleArea(tessellator), 50.0 - 8.0);
+
+    // a hole outside the viewport is dropped, the outline is not
+    tessellator.clear();
+    tessellator.setClipRect(QRectF(0, 0, 2, 10));
+    tessellator.addRing(rectangle(0, 0, 10, 10));
+    tessellator.addRing(rectangle(3, 3, 4, 4));
+    tessellator.tessellate();
+
+    QCOMPARE(tessellator.ringCount(), 1);
+    QCOMPARE(triangleArea(tessellator), 20.0);
+}
+
+void tst_QGeoPolygonTessellator::largePolygon()
+{
+    // large enough for the grid of reflex corners
+    const QVector<QPointF> ring = boundary(12000, 3);
+
+    QGeoPolygonTessellator tessellator;
+    tessellator.addRing(ring);
+    tessellator.tessellate();
+
+    QCOMPARE(tessellator.indices().size(), 3 * (ring.size() - 2));
+    QVERIFY(qAbs(triangleArea(tessellator) - ringArea(ring)) < 1e-6 * ringArea(ring));
+}
+
+void tst_QGeoPolygonTessellator::reuse()
+{
+    QGeoPolygonTessellator tessellator;
+    tessellator.addRing(boundary(1000, 5));
+    tessellator.tessellate();
+    const int capacity = tessellator.vertices().capacity();
+
+    // a shape of the same size does not need more memory
+    tessellator.clear();
+    tessellator.addRing(boundary(1000, 6));
+    tessellator.tessellate();
+    QCOMPARE(tessellator.vertices().capacity(), capacity);
+    QCOMPARE(tessellator.indices().size(), 3 * 998);
+}
+
+void tst_QGeoPolygonTessellator::tessellateLandUse_data()
+{
+    QTest::addColumn<int>("count");
+    QTest::addColumn<bool>("clip");
+
+    QTest::newRow("10k points") << 10000 << false;
+    QTest::newRow("10k points, clipped") << 10000 << true;
+    QTest::newRow("50k points") << 50000 << false;
+    QTest::newRow("50k points, clipped") << 50000 << true;
+}
+
+void tst_QGeoPolygonTessellator::tessellateLandUse()
+{
+    QFETCH(int, count);
+    QFETCH(bool, clip);
+
+    const QVector<QPointF> ring = boundary(count, 17);
+    QGeoPolygonTessellator tessellator;
+
+    QBENCHMARK {
+        tessellator.clear();
+        if (clip)
+            tessellator.setClipRect(QRectF(-400, -300, 800, 600));
+        tessellator.addRing(ring);
+        tessellator.tessellate();
+    }
+    QVERIFY(!tessellator.indices().isEmpty());
+}
+
+QTEST_APPLESS_MAIN(tst_QGeoPolygonTessellator)
+
+#include "tst_qgeopolygontessellator.moc"
@@ -6,5 +6,5 @@ TARGET=tst_qgeoroute
 HEADERS += tst_qgeoroute.h
 SOURCES += tst_qgeoroute.cpp
 
-QT += location testlib
+QT += location-private positioning-private testlib
 DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0
@@ -291,5 +291,118 @@ void tst_QGeoRoute::operators()
 }
 
 
+static QList<QGeoCoordinate> linePath(int first, int count)
+{
+    QList<QGeoCoordinate> path;
+    for (int i = first; i < first + count; ++i)
+        path.append(QGeoCoordinate(i, 2 * i));
+    return path;
+}
+
+void tst_QGeoRoute::segmentPathRange()
+{
+    QGeoCoordinateArray buffer(linePath(0, 10));
+
+    QGeoRouteSegment range;
+    QGeoRouteSegmentPrivate::setPathRange(range, buffer, 4, 3);
+    QVERIFY(range.isValid());
+    QCOMPARE(range.path(), linePath(4, 3));
+    QCOMPARE(QGeoRouteSegmentPrivate::compactPath(range), QGeoCoordinateArray(linePath(4, 3)));
+
+    QGeoRouteSegment copy;
+    copy.setPath(linePath(4, 3));
+    QVERIFY(range == copy);
+
+    copy.setPath(linePath(5, 3));
+    QVERIFY(range != copy);
+}
+
+void tst_QGeoRoute::compactSegments()
+{
+    QGeoRoute route;
+    route.setPath(linePath(0, 10));
+
+    // consecutive segments share their end points, as in routing responses
+    QList<QGeoRouteSegment> segments;
+    for (int i = 0; i < 3; ++i) {
+        QGeoRouteSegment segment;
+        segment.setPath(linePath(3 * i, 4));
+        segment.setDistance(i);
+        segments.append(segment);
+    }
+
+    QGeoRoutePrivate::setSegments(route, segments);
+
+    // the segments are ranges of the route path, which is stored once
+    const QGeoCoordinateArray routePath = QGeoRoutePrivate::compactPath(route);
+    for (int i = 0; i < 3; ++i) {
+        QCOMPARE(QGeoRouteSegmentPrivate::pathBuffer(segments.at(i)).constData(), routePath.constData());
+        QCOMPARE(QGeoRouteSegmentPrivate::pathOffset(segments.at(i)), 3 * i);
+        QCOMPARE(segments.at(i).path(), linePath(3 * i, 4));
+    }
+    QCOMPARE(route.path(), linePath(0, 10));
+
+    QCOMPARE(QGeoRoutePrivate::segmentCount(route), 3);
+    QGeoRouteSegment segment = route.firstRouteSegment();
+    for (int i = 0; i < 3; ++i) {
+        QVERIFY(segment.isValid());
+        QCOMPARE(segment.distance(), qreal(i));
+        QVERIFY(segment == QGeoRoutePrivate::segmentAt(route, i));
+        segment = segment.nextRouteSegment();
+    }
+    QVERIFY(!segment.isValid());
+
+    // replacing the chain drops the index
+    route.setFirstRouteSegment(segments.at(1));
+    QCOMPARE(QGeoRoutePrivate::segmentCount(route), 2);
+    QCOMPARE(QGeoRoutePrivate::segmentAt(route, 0).distance(), qreal(1));
+}
+
+void tst_QGeoRoute::compactSegmentsWithoutPath()
+{
+    QGeoRoute route;
+
+    QList<QGeoRouteSegment> segments;
+    QGeoRouteSegment first;
+    first.setPath(linePath(0, 3));
+    segments.append(first);
+    QGeoRouteSegment second;
+    second.setPath(linePath(10, 2));
+    segments.append(second);
+
+    QGeoRoutePrivate::setSegments(route, segments);
+
+    // disjoint segments still get one buffer, the route path is untouched
+    QVERIFY(route.path().isEmpty());
+    QCOMPARE(QGeoRouteSegmentPrivate::pathBuffer(first).constData(),
+             QGeoRouteSegmentPrivate::pathBuffer(second).constData());
+    QCOMPARE(QGeoRouteSegmentPrivate::pathBuffer(first).size(), 5);
+    QCOMPARE(first.path(), linePath(0, 3));
+    QCOMPARE(second.path(), linePath(10, 2));
+    QVERIFY(route.firstRouteSegment() == first);
+    QVERIFY(route.firstRouteSegment().nextRouteSegment() == second);
+}
+
+void tst_QGeoRoute::compactPathUpdates()
+{
+    // path() follows every change made through the compact setters
+    QGeoRoute route;
+    QGeoRoutePrivate::setCompactPath(route, QGeoCoordinateArray(linePath(0, 10)));
+    QList<QGeoCoordinate> path = route.path();
+    QCOMPARE(path, linePath(0, 10));
+    QCOMPARE(route.path(), path);
+
+    QGeoRoutePrivate::setCompactPath(route, QGeoCoordinateArray(linePath(5, 2)));
+    QCOMPARE(route.path(), linePath(5, 2));
+
+    QGeoRouteSegment segment;
+    QGeoRouteSegmentPrivate::setPathRange(segment, QGeoCoordinateArray(linePath(0, 10)), 2, 4);
+    path = segment.path();
+    QCOMPARE(path, linePath(2, 4));
+    QCOMPARE(segment.path(), path);
+
+    QGeoRouteSegmentPrivate::setPathRange(segment, QGeoCoordinateArray(linePath(0, 10)), 6, 3);
+    QCOMPARE(segment.path(), linePath(6, 3));
+}
 
 QTEST_APPLESS_MAIN(tst_QGeoRoute);
@@ -43,6 +43,8 @@
 #include <qgeocoordinate.h>
 #include <qgeorouterequest.h>
 #include <qgeoroutesegment.h>
+#include <QtLocation/private/qgeoroute_p.h>
+#include <QtLocation/private/qgeoroutesegment_p.h>
 
 
 QT_USE_NAMESPACE
@@ -75,6 +77,10 @@ private Q_SLOTS:
     void travelMode_data();
     void travelTime();
     void operators();
+    void segmentPathRange();
+    void compactSegments();
+    void compactSegmentsWithoutPath();
+    void compactPathUpdates();
     //End Unit Test for QGeoRoute
 
 private:
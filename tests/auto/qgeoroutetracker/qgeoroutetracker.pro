@@ -0,0 +1,10 @@
+TEMPLATE = app
+CONFIG += testcase
+TARGET = tst_qgeoroutetracker
+
+INCLUDEPATH += ../../../src/location/maps
+
+SOURCES += tst_qgeoroutetracker.cpp
+
+QT += location-private positioning-private testlib
+DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0
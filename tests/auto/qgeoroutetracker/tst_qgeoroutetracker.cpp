@@ -0,0 +1,357 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia. For licensing terms and
+** conditions see http://qt.digia.com/licensing. For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights. These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include <QtTest/QtTest>
+#include <QtTest/QSignalSpy>
+#include <QtCore/QObject>
+#include <QtCore/qmath.h>
+#include <QtPositioning/QGeoPositionInfo>
+
+#include "qgeoroute_p.h"
+#include "qgeoroutesegment_p.h"
+#include "qgeoroutetracker_p.h"
+
+QT_USE_NAMESPACE
+
+class tst_QGeoRouteTracker : public QObject
+{
+    Q_OBJECT
+
+public:
+    tst_QGeoRouteTracker();
+
+private slots:
+    void emptyRoute();
+    void snap_data();
+    void snap();
+    void maneuvers();
+    void remainingTime();
+    void offRoute();
+    void dateline();
+    void doublingBack();
+    void benchmark_update_data();
+    void benchmark_update();
+
+private:
+    static QGeoRoute equatorRoute(int points, double step);
+    static QGeoPositionInfo position(double latitude, double longitude);
+};
+
+tst_QGeoRouteTracker::tst_QGeoRouteTracker()
+{
+}
+
+// a route along the equator from longitude 0, with one segment per half
+QGeoRoute tst_QGeoRouteTracker::equatorRoute(int points, double step)
+{
+    QList<QGeoCoordinate> path;
+    for (int i = 0; i < points; ++i)
+        path.append(QGeoCoordinate(0.0, i * step));
+
+    QGeoRoute route;
+    route.setPath(path);
+    route.setTravelTime(300);
+
+    const int middle = points / 2;
+    QList<QGeoRouteSegment> segments;
+    for (int i = 0; i < 2; ++i) {
+        QGeoRouteSegment segment;
+        segment.setPath(i == 0 ? path.mid(0, middle + 1) : path.mid(middle));
+        segment.setDistance(path.first().distanceTo(path.last()) / 2);
+        segment.setTravelTime(i == 0 ? 100 : 200);
+
+        QGeoManeuver maneuver;
+        maneuver.setPosition(i == 0 ? path.at(middle) : path.last());
+        maneuver.setInstructionText(i == 0 ? QStringLiteral("turn") : QStringLiteral("arrive"));
+        segment.setManeuver(maneuver);
+        segments.append(segment);
+    }
+    QGeoRoutePrivate::setSegments(route, segments);
+    return route;
+}
+
+QGeoPositionInfo tst_QGeoRouteTracker::position(double latitude, double longitude)
+{
+    return QGeoPositionInfo(QGeoCoordinate(latitude, longitude), QDateTime());
+}
+
+void tst_QGeoRouteTracker::emptyRoute()
+{
+    QGeoRouteTracker tracker;
+    QSignalSpy spy(&tracker, SIGNAL(progressChanged()));
+
+    tracker.updatePosition(position(1.0, 1.0));
+    QCOMPARE(spy.count(), 0);
+    QVERIFY(!tracker.snappedCoordinate().isValid());
+    QCOMPARE(tracker.remainingDistance(), 0.0);
+    QCOMPARE(tracker.remainingTime(), 0);
+    QVERIFY(!tracker.nextManeuver().isValid());
+    QVERIFY(!tracker.isOffRoute());
+
+    tracker.setRoute(QGeoRoute());
+    tracker.updatePosition(position(1.0, 1.0));
+    QCOMPARE(spy.count(), 0);
+}
+
+void tst_QGeoRouteTracker::snap_data()
+{
+    QTest::addColumn<double>("latitude");
+    QTest::addColumn<double>("longitude");
+    QTest::addColumn<double>("snappedLongitude");
+
+    QTest::newRow("on a point") << 0.0 << 0.03 << 0.03;
+    QTest::newRow("beside an edge") << 0.0001 << 0.025 << 0.025;
+    QTest::newRow("below an edge") << -0.0002 << 0.0575 << 0.0575;
+    QTest::newRow("before the start") << 0.0 << -0.01 << 0.0;
+    QTest::newRow("past the end") << 0.0001 << 0.2 << 0.1;
+}
+
+void tst_QGeoRouteTracker::snap()
+{
+    QFETCH(double, latitude);
+    QFETCH(double, longitude);
+    QFETCH(double, snappedLongitude);
+
+    QGeoRouteTracker tracker;
+    tracker.setRoute(equatorRoute(11, 0.01));
+    QSignalSpy spy(&tracker, SIGNAL(progressChanged()));
+
+    tracker.updatePosition(position(latitude, longitude));
+    QCOMPARE(spy.count(), 1);
+
+    const QGeoCoordinate snapped = tracker.snappedCoordinate();
+    const QGeoCoordinate expected(0.0, snappedLongitude);
+    QVERIFY(qAbs(snapped.latitude()) < 1e-9);
+    QVERIFY(qAbs(snapped.longitude() - snappedLongitude) < 1e-9);
+
+    const qreal length = QGeoCoordinate(0.0, 0.0).distanceTo(QGeoCoordinate(0.0, 0.1));
+    const qreal traveled = QGeoCoordinate(0.0, 0.0).distanceTo(expected);
+    QVERIFY(qAbs(tracker.distanceTraveled() - traveled) < 0.01);
+    QVERIFY(qAbs(tracker.remainingDistance() - (length - traveled)) < 0.01);
+    QVERIFY(qAbs(tracker.deviation() - QGeoCoordinate(latitude, longitude).distanceTo(expected)) < 0.01);
+}
+
+void tst_QGeoRouteTracker::maneuvers()
+{
+    QGeoRouteTracker tracker;
+    tracker.setRoute(equatorRoute(11, 0.01));
+
+    const qreal halfway = QGeoCoordinate(0.0, 0.0).distanceTo(QGeoCoordinate(0.0, 0.05));
+
+    tracker.updatePosition(position(0.0, 0.0));
+    QCOMPARE(tracker.nextManeuver().instructionText(), QStringLiteral("turn"));
+    QVERIFY(qAbs(tracker.distanceToNextManeuver() - halfway) < 0.01);
+
+    tracker.updatePosition(position(0.0, 0.06));
+    QCOMPARE(tracker.nextManeuver().instructionText(), QStringLiteral("arrive"));
+
+    tracker.updatePosition(position(0.0, 0.1));
+    QVERIFY(!tracker.nextManeuver().isValid());
+    QVERIFY(qAbs(tracker.distanceToNextManeuver()) < 0.01);
+}
+
+void tst_QGeoRouteTracker::remainingTime()
+{
+    QGeoRouteTracker tracker;
+    tracker.setRoute(equatorRoute(11, 0.01));
+
+    // the first half takes 100 seconds and the second 200
+    tracker.updatePosition(position(0.0, 0.0));
+    QCOMPARE(tracker.remainingTime(), 300);
+    tracker.updatePosition(position(0.0, 0.025));
+    QCOMPARE(tracker.remainingTime(), 250);
+    tracker.updatePosition(position(0.0, 0.075));
+    QCOMPARE(tracker.remainingTime(), 100);
+    tracker.updatePosition(position(0.0, 0.1));
+    QCOMPARE(tracker.remainingTime(), 0);
+}
+
+void tst_QGeoRouteTracker::offRoute()
+{
+    QGeoRouteTracker tracker;
+    tracker.setRoute(equatorRoute(11, 0.01));
+    tracker.setOffRouteDistance(50.0);
+    QSignalSpy spy(&tracker, SIGNAL(offRouteChanged(bool)));
+
+    // about 111 meters away
+    const double away = 0.001;
+
+    // single outliers do not leave the route
+    tracker.updatePosition(position(away, 0.01));
+    tracker.updatePosition(position(0.0, 0.02));
+    tracker.updatePosition(position(away, 0.03));
+    QVERIFY(!tracker.isOffRoute());
+    QCOMPARE(spy.count(), 0);
+
+    tracker.updatePosition(position(0.0, 0.035));
+    for (int i = 0; i < QGeoRouteTracker::OffRouteUpdates; ++i) {
+        QVERIFY(!tracker.isOffRoute());
+        tracker.updatePosition(position(away, 0.04));
+    }
+    QVERIFY(tracker.isOffRoute());
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.at(0).at(0).toBool(), true);
+
+    // within the off route distance, but not yet back
+    tracker.updatePosition(position(away * 0.4, 0.05));
+    QVERIFY(tracker.isOffRoute());
+
+    tracker.updatePosition(position(away * 0.1, 0.05));
+    QVERIFY(!tracker.isOffRoute());
+    QCOMPARE(spy.count(), 2);
+    QCOMPARE(spy.at(1).at(0).toBool(), false);
+
+    // a poor fix widens the off route distance
+    QGeoPositionInfo info = position(away, 0.06);
+    info.setAttribute(QGeoPositionInfo::HorizontalAccuracy, 100.0);
+    for (int i = 0; i < QGeoRouteTracker::OffRouteUpdates; ++i)
+        tracker.updatePosition(info);
+    QVERIFY(!tracker.isOffRoute());
+}
+
+void tst_QGeoRouteTracker::dateline()
+{
+    QGeoRoute route;
+    QList<QGeoCoordinate> path;
+    path << QGeoCoordinate(0.0, 179.98) << QGeoCoordinate(0.0, 179.99)
+         << QGeoCoordinate(0.0, -179.99) << QGeoCoordinate(0.0, -179.98);
+    route.setPath(path);
+
+    QGeoRouteTracker tracker;
+    tracker.setRoute(route);
+
+    tracker.updatePosition(position(0.0001, 180.0));
+    QVERIFY(tracker.deviation() < 12.0);
+    QVERIFY(qAbs(tracker.distanceTraveled() - path.at(0).distanceTo(QGeoCoordinate(0.0, 180.0))) < 0.01);
+
+    tracker.updatePosition(position(0.0, -179.985));
+    QVERIFY(tracker.deviation() < 0.01);
+    QVERIFY(qAbs(tracker.remainingDistance() - path.at(3).distanceTo(QGeoCoordinate(0.0, -179.985))) < 0.01);
+}
+
+void tst_QGeoRouteTracker::doublingBack()
+{
+    // out along the equator and back the same way
+    QList<QGeoCoordinate> out;
+    for (int i = 0; i <= 10; ++i)
+        out.append(QGeoCoordinate(0.0, i * 0.005));
+    QList<QGeoCoordinate> back;
+    for (int i = 10; i >= 0; --i)
+        back.append(QGeoCoordinate(0.0, i * 0.005));
+    QList<QGeoCoordinate> path = out;
+    path.append(back.mid(1));
+
+    QGeoRoute route;
+    route.setPath(path);
+    route.setTravelTime(200);
+
+    QList<QGeoRouteSegment> segments;
+    for (int i = 0; i < 2; ++i) {
+        QGeoRouteSegment segment;
+        segment.setPath(i == 0 ? out : back);
+        segment.setDistance(out.first().distanceTo(out.last()));
+        segment.setTravelTime(100);
+
+        QGeoManeuver maneuver;
+        maneuver.setPosition(i == 0 ? out.last() : back.last());
+        maneuver.setInstructionText(i == 0 ? QStringLiteral("turn") : QStringLiteral("arrive"));
+        segment.setManeuver(maneuver);
+        segments.append(segment);
+    }
+    QGeoRoutePrivate::setSegments(route, segments);
+
+    QGeoRouteTracker tracker;
+    tracker.setRoute(route);
+
+    const qreal length = out.first().distanceTo(out.last());
+
+    // the arrival is at the end of the route, not at its start
+    tracker.updatePosition(position(0.00005, 0.0));
+    QVERIFY(tracker.distanceTraveled() < 10.0);
+    QCOMPARE(tracker.nextManeuver().instructionText(), QStringLiteral("turn"));
+
+    qreal traveled = tracker.distanceTraveled();
+    bool turned = false;
+    for (int i = 1; i <= 100; ++i) {
+        const double longitude = (i <= 50 ? i : 100 - i) * 0.001;
+        tracker.updatePosition(position(0.00005, longitude));
+        QVERIFY(!tracker.isOffRoute());
+        QVERIFY(tracker.deviation() < 10.0);
+        QVERIFY(tracker.distanceTraveled() > traveled);
+        traveled = tracker.distanceTraveled();
+
+        // the maneuvers are passed in order, the turn on reaching the end
+        // of the way out
+        if (tracker.nextManeuver().instructionText() == QStringLiteral("arrive"))
+            turned = true;
+        if (i != 50)
+            QCOMPARE(turned, i > 50);
+    }
+
+    QVERIFY(qAbs(traveled - 2 * length) < 10.0);
+    QVERIFY(tracker.remainingDistance() < 10.0);
+}
+
+void tst_QGeoRouteTracker::benchmark_update_data()
+{
+    QTest::addColumn<int>("points");
+
+    QTest::newRow("1000 points") << 1000;
+    QTest::newRow("100000 points") << 100000;
+}
+
+void tst_QGeoRouteTracker::benchmark_update()
+{
+    QFETCH(int, points);
+
+    // a winding route, so that the boxes overlap as they would in a city
+    QList<QGeoCoordinate> path;
+    for (int i = 0; i < points; ++i)
+        path.append(QGeoCoordinate(0.01 * qSin(i * 0.01), i * 0.0001));
+    QGeoRoute route;
+    route.setPath(path);
+
+    QGeoRouteTracker tracker;
+    tracker.setRoute(route);
+
+    int i = 0;
+    QBENCHMARK {
+        const int point = (i++ * 7919) % points;
+        tracker.updatePosition(position(path.at(point).latitude() + 0.0001, path.at(point).longitude()));
+    }
+}
+
+QTEST_APPLESS_MAIN(tst_QGeoRouteTracker)
+
+#include "tst_qgeoroutetracker.moc"
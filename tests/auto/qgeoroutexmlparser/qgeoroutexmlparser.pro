@@ -4,11 +4,11 @@ TARGET = tst_qgeoroutexmlparser
 plugin.path = ../../../src/plugins/geoservices/here/
 
 SOURCES += tst_qgeoroutexmlparser.cpp \
-           $$plugin.path/qgeoroutexmlparser.cpp
-HEADERS += $$plugin.path/qgeoroutexmlparser.h
-INCLUDEPATH += $$plugin.path
+           $$plugin.path/routing/qgeoroutexmlparser.cpp
+HEADERS += $$plugin.path/routing/qgeoroutexmlparser.h
+INCLUDEPATH += $$plugin.path $$plugin.path/routing
 RESOURCES += fixtures.qrc
 
-QT += location testlib
+QT += location-private testlib
 
 DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0
@@ -39,12 +39,79 @@
 #include <QMetaType>
 #include <QDebug>
 #include <QFile>
+#include <QPointer>
 #include <QSignalSpy>
+#include <QThread>
 
 Q_DECLARE_METATYPE(QList<QGeoRoute>)
 
 QT_USE_NAMESPACE
 
+class SynchronousRouteXmlParser : public QGeoRouteXmlParser
+{
+public:
+    explicit SynchronousRouteXmlParser(const QGeoRouteRequest &request)
+        : QGeoRouteXmlParser(request)
+    {
+    }
+
+    using QGeoRouteXmlParser::parseData;
+};
+
+static QByteArray coordinatePair(int index)
+{
+    return QByteArray::number(40.0 + index * 1e-4, 'f', 7) + ',' +
+           QByteArray::number(-120.0 + index * 1e-4, 'f', 7);
+}
+
+// A response in the layout of the recorded ones, for a route long enough to
+// cross a continent: maneuver i leads onto the first of linksPerManeuver
+// links, and the final maneuver has no link.
+static QByteArray crossCountryRoute(int maneuvers, int linksPerManeuver, int pointsPerLink)
+{
+    QByteArray shape;
+    QByteArray maneuverXml;
+    QByteArray linkXml;
+
+    int point = 0;
+    for (int i = 0; i < maneuvers; ++i) {
+        maneuverXml += "<Maneuver id=\"M" + QByteArray::number(i) + "\"><Position><Latitude>"
+                + QByteArray::number(40.0 + point * 1e-4, 'f', 7) + "</Latitude><Longitude>"
+                + QByteArray::number(-120.0 + point * 1e-4, 'f', 7) + "</Longitude></Position>"
+                + "<Instruction>Maneuver " + QByteArray::number(i) + "</Instruction>"
+                + "<TravelTime>60</TravelTime><Length>1000.0</Length>";
+        if (i < maneuvers - 1)
+            maneuverXml += "<ToLink>+" + QByteArray::number(i * linksPerManeuver) + "</ToLink>";
+        maneuverXml += "<Direction>forward</Direction></Maneuver>";
+
+        if (i == maneuvers - 1)
+            break;
+
+        for (int j = 0; j < linksPerManeuver; ++j) {
+            QByteArray linkShape;
+            for (int k = 0; k < pointsPerLink; ++k, ++point) {
+                if (k > 0)
+                    linkShape += ' ';
+                linkShape += coordinatePair(point);
+            }
+            if (!shape.isEmpty())
+                shape += ' ';
+            shape += linkShape;
+
+            linkXml += "<Link><LinkId>+" + QByteArray::number(i * linksPerManeuver + j) + "</LinkId>"
+                    + "<Shape>" + linkShape + "</Shape><Length>100.0</Length>"
+                    + "<Maneuver>M" + QByteArray::number(i) + "</Maneuver>"
+                    + "<DynamicSpeedInfo><TrafficSpeed>20.0</TrafficSpeed><TrafficTime>5.0</TrafficTime>"
+                    + "<BaseSpeed>25.0</BaseSpeed><BaseTime>4.0</BaseTime></DynamicSpeedInfo></Link>";
+        }
+    }
+
+    return "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>"
+           "<CalculateRoute><Response><Route><RouteId>crossCountry</RouteId>"
+           "<Shape>" + shape + "</Shape><Leg>" + maneuverXml + linkXml + "</Leg>"
+           "</Route></Response></CalculateRoute>";
+}
+
 class tst_QGeoRouteXmlParser : public QObject
 {
     Q_OBJECT
@@ -52,15 +119,23 @@ class tst_QGeoRouteXmlParser : public QObject
 public:
     tst_QGeoRouteXmlParser()
         : start(0.0, 0.0),
-          end(1.0, 1.0)
+          end(1.0, 1.0),
+          destroyedIn(0)
     {
         qRegisterMetaType<QList<QGeoRoute> >();
     }
 
+public slots:
+    void parserDestroyed()
+    {
+        destroyedIn = QThread::currentThread();
+    }
+
 private:
     // dummy values for creating the request object
     QGeoCoordinate start;
     QGeoCoordinate end;
+    QThread *destroyedIn;
 
 private slots:
     void test_realData1()
@@ -170,6 +245,140 @@ private slots:
         QVERIFY(segments.at(7).maneuver().instructionText().contains("Bear right onto Vulture St"));
         QCOMPARE(segments.at(7).maneuver().direction(), QGeoManeuver::DirectionLightRight);
     }
+
+    void test_invalidData()
+    {
+        QGeoRouteRequest req(start, end);
+        QGeoRouteXmlParser xp(req);
+        xp.setAutoDelete(false);
+
+        QSignalSpy resultsSpy(&xp, SIGNAL(results(QList<QGeoRoute>)));
+        QSignalSpy errorSpy(&xp, SIGNAL(error(QString)));
+
+        xp.parse("<CalculateRoute><Route>");
+
+        QTRY_COMPARE(errorSpy.count(), 1);
+        QCOMPARE(resultsSpy.count(), 0);
+        QVERIFY(!errorSpy.first().at(0).toString().isEmpty());
+    }
+
+    void test_deletedOnOwnThread()
+    {
+        // runs on the pool, but is deleted where it lives once it is done
+        QGeoRouteRequest req(start, end);
+        QPointer<QGeoRouteXmlParser> xp = new QGeoRouteXmlParser(req);
+        connect(xp.data(), SIGNAL(destroyed()), this, SLOT(parserDestroyed()),
+                Qt::DirectConnection);
+        QSignalSpy errorSpy(xp.data(), SIGNAL(error(QString)));
+
+        destroyedIn = 0;
+        xp->parse("<CalculateRoute><Route>");
+
+        QTRY_VERIFY(xp.isNull());
+        QCOMPARE(errorSpy.count(), 1);
+        QCOMPARE(destroyedIn, QThread::currentThread());
+    }
+
+    void test_invalidShape_data()
+    {
+        QTest::addColumn<QByteArray>("shape");
+
+        QTest::newRow("missing comma") << QByteArray("1.0,2.0 3.0");
+        QTest::newRow("extra comma") << QByteArray("1.0,2.0,3.0");
+        QTest::newRow("bad latitude") << QByteArray("1.0,2.0 x,3.0");
+        QTest::newRow("bad longitude") << QByteArray("1.0,2.0 3.0,");
+    }
+
+    void test_invalidShape()
+    {
+        QFETCH(QByteArray, shape);
+
+        QGeoRouteRequest req(start, end);
+        SynchronousRouteXmlParser xp(req);
+        QVERIFY(!xp.parseData("<CalculateRoute><Response><Route><Shape>" + shape
+                              + "</Shape></Route></Response></CalculateRoute>"));
+        QVERIFY(!xp.errorString().isEmpty());
+    }
+
+    void test_linkCompaction()
+    {
+        const int maneuvers = 5;
+        const int linksPerManeuver = 4;
+        const int pointsPerLink = 3;
+
+        QGeoRouteRequest req(start, end);
+        SynchronousRouteXmlParser xp(req);
+
+        QSignalSpy resultsSpy(&xp, SIGNAL(results(QList<QGeoRoute>)));
+        QVERIFY(xp.parseData(crossCountryRoute(maneuvers, linksPerManeuver, pointsPerLink)));
+        QCOMPARE(resultsSpy.count(), 1);
+
+        QList<QGeoRoute> results = resultsSpy.first().at(0).value<QList<QGeoRoute> >();
+        QCOMPARE(results.size(), 1);
+        QGeoRoute route = results.first();
+
+        const int linkPoints = (maneuvers - 1) * linksPerManeuver * pointsPerLink;
+        QCOMPARE(route.path().size(), linkPoints);
+        QCOMPARE(route.path().at(0), QGeoCoordinate(40.0, -120.0));
+
+        QList<QGeoRouteSegment> segments;
+        QGeoRouteSegment segment = route.firstRouteSegment();
+        while (segment.isValid()) {
+            segments << segment;
+            segment = segment.nextRouteSegment();
+        }
+
+        // links without a maneuver are merged into the next maneuver's segment
+        QCOMPARE(segments.size(), maneuvers);
+        for (int i = 0; i < maneuvers; ++i)
+            QCOMPARE(segments.at(i).maneuver().instructionText(), QString("Maneuver %1").arg(i));
+
+        QCOMPARE(segments.first().path().size(), pointsPerLink);
+        for (int i = 1; i < maneuvers - 1; ++i)
+            QCOMPARE(segments.at(i).path().size(), linksPerManeuver * pointsPerLink);
+        // the final maneuver adds its position as a one point path
+        QCOMPARE(segments.last().path().size(), (linksPerManeuver - 1) * pointsPerLink + 1);
+
+        int pathPoints = 0;
+        double distance = 0.0;
+        int travelTime = 0;
+        foreach (const QGeoRouteSegment &s, segments) {
+            pathPoints += s.path().size();
+            distance += s.distance();
+            travelTime += s.travelTime();
+        }
+        QCOMPARE(pathPoints, linkPoints + 1);
+        QCOMPARE(distance, (maneuvers - 1) * linksPerManeuver * 100.0);
+        QCOMPARE(travelTime, (maneuvers - 1) * linksPerManeuver * 5);
+
+        QCOMPARE(segments.at(1).path().first(), QGeoCoordinate(40.0 + pointsPerLink * 1e-4,
+                                                               -120.0 + pointsPerLink * 1e-4));
+    }
+
+    void benchmark_parse_data()
+    {
+        QTest::addColumn<QByteArray>("data");
+
+        QFile f(":/route2.xml");
+        if (!f.open(QIODevice::ReadOnly))
+            QFAIL("could not open route2.xml");
+
+        QTest::newRow("recorded") << f.readAll();
+        QTest::newRow("cross-country 20k points") << crossCountryRoute(100, 20, 10);
+        QTest::newRow("cross-country 200k points") << crossCountryRoute(400, 50, 10);
+    }
+
+    void benchmark_parse()
+    {
+        QFETCH(QByteArray, data);
+
+        QGeoRouteRequest req(start, end);
+
+        QBENCHMARK {
+            SynchronousRouteXmlParser xp(req);
+            QVERIFY(xp.parseData(data));
+        }
+    }
 };
 
 QTEST_GUILESS_MAIN(tst_QGeoRouteXmlParser)
@@ -0,0 +1,353 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia. For licensing terms and
+** conditions see http://qt.digia.com/licensing. For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights. These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include <QtTest/QtTest>
+#include <QtCore/QObject>
+#include <QtCore/qmath.h>
+#include <QtPositioning/private/qgeoprojection_p.h>
+#include <QtPositioning/private/qdoublevector2d_p.h>
+
+#include "qgeosimplifiedpath_p.h"
+
+QT_USE_NAMESPACE
+
+class tst_QGeoSimplifiedPath : public QObject
+{
+    Q_OBJECT
+
+public:
+    tst_QGeoSimplifiedPath();
+    ~tst_QGeoSimplifiedPath();
+
+private slots:
+    void emptyPath();
+    void invalidCoordinates();
+    void straightLine();
+    void dateline();
+    void levelsAreNested();
+    void toleranceBound();
+    void matchesDouglasPeucker();
+    void levelForWorldSize();
+    void simplifyTrack();
+    void projectTrack_data();
+    void projectTrack();
+
+private:
+    static QGeoCoordinateArray track(int count, int seed);
+    static QVector<QDoubleVector2D> mercator(const QGeoCoordinateArray &path);
+    static double segmentDistance(const QDoubleVector2D &p,
+                                  const QDoubleVector2D &a, const QDoubleVector2D &b);
+    static void douglasPeucker(const QVector<QDoubleVector2D> &points, int first, int last,
+                               double tolerance, QVector<bool> *keep);
+};
+
+tst_QGeoSimplifiedPath::tst_QGeoSimplifiedPath()
+{
+}
+
+tst_QGeoSimplifiedPath::~tst_QGeoSimplifiedPath()
+{
+}
+
+// a GPS track: small steps with a slowly wandering heading
+QGeoCoordinateArray tst_QGeoSimplifiedPath::track(int count, int seed)
+{
+    QGeoCoordinateArray path;
+    path.reserve(count);
+    qsrand(seed);
+
+    double latitude = 60.17;
+    double longitude = 24.94;
+    double heading = 0.0;
+    for (int i = 0; i < count; ++i) {
+        path.append(latitude, longitude);
+        heading += 0.3 * (qrand() / double(RAND_MAX) - 0.5);
+        latitude += 0.0001 * qCos(heading);
+        longitude += 0.0002 * qSin(heading);
+    }
+    return path;
+}
+
+QVector<QDoubleVector2D> tst_QGeoSimplifiedPath::mercator(const QGeoCoordinateArray &path)
+{
+    QVector<QDoubleVector2D> points(path.size());
+    QGeoProjection::coordToMercator(path, points.data());
+    return points;
+}
+
+double tst_QGeoSimplifiedPath::segmentDistance(const QDoubleVector2D &p,
+                                               const QDoubleVector2D &a, const QDoubleVector2D &b)
+{
+    const QDoubleVector2D ab = b - a;
+    const double lengthSquared = ab.x() * ab.x() + ab.y() * ab.y();
+
+    QDoubleVector2D closest = a;
+    if (lengthSquared > 0.0) {
+        const QDoubleVector2D ap = p - a;
+        const double t = qBound(0.0, (ap.x() * ab.x() + ap.y() * ab.y()) / lengthSquared, 1.0);
+        closest = a + ab * t;
+    }
+
+    const QDoubleVector2D d = p - closest;
+    return d.x() * d.x() + d.y() * d.y();
+}
+
+void tst_QGeoSimplifiedPath::douglasPeucker(const QVector<QDoubleVector2D> &points, int first, int last,
+                                            double tolerance, QVector<bool> *keep)
+{
+    if (last - first < 2)
+        return;
+
+    int split = first + 1;
+    double maxDistance = -1.0;
+    for (int i = first + 1; i < last; ++i) {
+        const double distance = segmentDistance(points.at(i), points.at(first), points.at(last));
+        if (distance > maxDistance) {
+            maxDistance = distance;
+            split = i;
+        }
+    }
+
+    if (qSqrt(maxDistance) <= tolerance)
+        return;
+
+    (*keep)[split] = true;
+    douglasPeucker(points, first, split, tolerance, keep);
+    douglasPeucker(points, split, last, tolerance, keep);
+}
+
+void tst_QGeoSimplifiedPath::emptyPath()
+{
+    QGeoSimplifiedPath simplified;
+    QVERIFY(simplified.isEmpty());
+    QCOMPARE(simplified.levelCount(), 0);
+    QCOMPARE(simplified.size(3), 0);
+    QVERIFY(simplified.path(3).isEmpty());
+
+    QGeoSimplifiedPath fromEmpty((QGeoCoordinateArray()));
+    QVERIFY(fromEmpty.isEmpty());
+    QVERIFY(fromEmpty.indices(0).isEmpty());
+}
+
+void tst_QGeoSimplifiedPath::invalidCoordinates()
+{
+    QGeoCoordinateArray path;
+    path.append(QGeoCoordinate());
+    path.append(10.0, 10.0);
+    path.append(QGeoCoordinate());
+    path.append(10.0, 11.0);
+    path.append(11.0, 12.0);
+    path.append(QGeoCoordinate());
+
+    QGeoSimplifiedPath simplified(path);
+    QVERIFY(!simplified.isEmpty());
+
+    const QVector<int> all = simplified.indices(QGeoSimplifiedPath::MaximumLevel + 1);
+    QCOMPARE(all, QVector<int>() << 1 << 3 << 4);
+
+    // the ends are kept on every level
+    const QVector<int> coarsest = simplified.indices(0);
+    QCOMPARE(coarsest.first(), 1);
+    QCOMPARE(coarsest.last(), 4);
+
+    const QGeoCoordinateArray points = simplified.path(QGeoSimplifiedPath::MaximumLevel + 1);
+    QCOMPARE(points.size(), 3);
+    QCOMPARE(points.at(1), QGeoCoordinate(10.0, 11.0));
+}
+
+void tst_QGeoSimplifiedPath::straightLine()
+{
+    QGeoCoordinateArray path;
+    for (int i = 0; i <= 100; ++i)
+        path.append(0.0, i * 0.01);
+
+    QGeoSimplifiedPath simplified(path);
+    QCOMPARE(simplified.indices(0), QVector<int>() << 0 << 100);
+    QCOMPARE(simplified.indices(12), QVector<int>() << 0 << 100);
+    QCOMPARE(simplified.size(simplified.levelCount() - 1), 101);
+}
+
+void tst_QGeoSimplifiedPath::dateline()
+{
+    // a straight line across the dateline is still straight
+    QGeoCoordinateArray path;
+    path.append(0.0, 179.0);
+    path.append(0.0, 179.5);
+    path.append(0.0, 180.0);
+    path.append(0.0, -179.5);
+    path.append(0.0, -179.0);
+
+    QGeoSimplifiedPath simplified(path);
+    QCOMPARE(simplified.indices(10), QVector<int>() << 0 << 4);
+
+    // and a detour on the far side is not lost
+    path.replace(3, 1.0, -179.5, qQNaN());
+    QGeoSimplifiedPath detour(path);
+    QVERIFY(detour.indices(10).contains(3));
+}
+
+void tst_QGeoSimplifiedPath::levelsAreNested()
+{
+    const QGeoCoordinateArray path = track(5000, 3);
+    QGeoSimplifiedPath simplified(path);
+
+    QVERIFY(simplified.levelCount() > 1);
+    QCOMPARE(simplified.size(simplified.levelCount() - 1), path.size());
+
+    for (int level = 0; level < simplified.levelCount(); ++level) {
+        const QVector<int> &indices = simplified.indices(level);
+        QVERIFY(indices.size() >= 2);
+        QCOMPARE(indices.first(), 0);
+        QCOMPARE(indices.last(), path.size() - 1);
+        for (int i = 1; i < indices.size(); ++i)
+            QVERIFY(indices.at(i - 1) < indices.at(i));
+
+        if (level > 0) {
+            const QVector<int> &coarser = simplified.indices(level - 1);
+            QVERIFY(coarser.size() <= indices.size());
+            const QSet<int> finer = indices.toList().toSet();
+            foreach (int index, coarser)
+                QVERIFY(finer.contains(index));
+        }
+    }
+
+    // levels past the last give the whole path
+    QCOMPARE(simplified.indices(simplified.levelCount() + 5),
+             simplified.indices(simplified.levelCount() - 1));
+}
+
+void tst_QGeoSimplifiedPath::toleranceBound()
+{
+    const QGeoCoordinateArray path = track(5000, 5);
+    const QVector<QDoubleVector2D> points = mercator(path);
+    QGeoSimplifiedPath simplified(path);
+
+    for (int level = 0; level < simplified.levelCount(); ++level) {
+        const QVector<int> &indices = simplified.indices(level);
+        const double tolerance = QGeoSimplifiedPath::tolerance(level);
+        for (int i = 1; i < indices.size(); ++i) {
+            const QDoubleVector2D &a = points.at(indices.at(i - 1));
+            const QDoubleVector2D &b = points.at(indices.at(i));
+            for (int j = indices.at(i - 1) + 1; j < indices.at(i); ++j)
+                QVERIFY(qSqrt(segmentDistance(points.at(j), a, b)) <= tolerance);
+        }
+    }
+}
+
+void tst_QGeoSimplifiedPath::matchesDouglasPeucker()
+{
+    const QGeoCoordinateArray path = track(2000, 7);
+    const QVector<QDoubleVector2D> points = mercator(path);
+    QGeoSimplifiedPath simplified(path);
+
+    // the last level may keep everything regardless of the tolerance
+    const int levels = qMin(simplified.levelCount(), int(QGeoSimplifiedPath::MaximumLevel) + 1);
+    for (int level = 0; level < levels; ++level) {
+        QVector<bool> keep(points.size(), false);
+        keep[0] = true;
+        keep[points.size() - 1] = true;
+        douglasPeucker(points, 0, points.size() - 1, QGeoSimplifiedPath::tolerance(level), &keep);
+
+        QVector<int> expected;
+        for (int i = 0; i < keep.size(); ++i) {
+            if (keep.at(i))
+                expected.append(i);
+        }
+        QCOMPARE(simplified.indices(level), expected);
+    }
+}
+
+void tst_QGeoSimplifiedPath::levelForWorldSize()
+{
+    QCOMPARE(QGeoSimplifiedPath::levelForWorldSize(0.0), 0);
+    QCOMPARE(QGeoSimplifiedPath::levelForWorldSize(200.0), 0);
+    QCOMPARE(QGeoSimplifiedPath::levelForWorldSize(256.0), 0);
+    QCOMPARE(QGeoSimplifiedPath::levelForWorldSize(512.0), 1);
+    QCOMPARE(QGeoSimplifiedPath::levelForWorldSize(513.0), 2);
+    QCOMPARE(QGeoSimplifiedPath::levelForWorldSize(256.0 * 1024), 10);
+    QCOMPARE(QGeoSimplifiedPath::levelForWorldSize(1e30), int(QGeoSimplifiedPath::MaximumLevel) + 1);
+
+    // a level is accurate to a pixel on the worlds it is chosen for
+    QCOMPARE(QGeoSimplifiedPath::tolerance(0) * 256.0, 1.0);
+    QCOMPARE(QGeoSimplifiedPath::tolerance(10) * 256.0 * 1024, 1.0);
+}
+
+void tst_QGeoSimplifiedPath::simplifyTrack()
+{
+    const QGeoCoordinateArray path = track(100000, 13);
+    QGeoSimplifiedPath simplified;
+    QBENCHMARK {
+        simplified = QGeoSimplifiedPath(path);
+    }
+    QCOMPARE(simplified.size(simplified.levelCount() - 1), path.size());
+}
+
+void tst_QGeoSimplifiedPath::projectTrack_data()
+{
+    QTest::addColumn<int>("zoomLevel");
+
+    QTest::newRow("zoom 4") << 4;
+    QTest::newRow("zoom 8") << 8;
+    QTest::newRow("zoom 12") << 12;
+    QTest::newRow("zoom 16") << 16;
+    QTest::newRow("full path") << -1;
+}
+
+void tst_QGeoSimplifiedPath::projectTrack()
+{
+    // what an item does with a 100k point track on every zoom change
+    QFETCH(int, zoomLevel);
+
+    static const QGeoCoordinateArray path = track(100000, 13);
+    static const QGeoSimplifiedPath simplified(path);
+    QVector<QDoubleVector2D> projected(path.size());
+
+    int vertices = 0;
+    QBENCHMARK {
+        const QGeoCoordinateArray points = zoomLevel < 0 ? path : simplified.path(zoomLevel);
+        QGeoProjection::coordToMercator(points, projected.data());
+        vertices = points.size();
+    }
+
+    // even at zoom 16 a pixel covers several points of the track
+    QVERIFY(vertices >= 2);
+    if (zoomLevel >= 0)
+        QVERIFY(vertices < path.size() / 2);
+    else
+        QCOMPARE(vertices, path.size());
+}
+
+QTEST_APPLESS_MAIN(tst_QGeoSimplifiedPath)
+
+#include "tst_qgeosimplifiedpath.moc"
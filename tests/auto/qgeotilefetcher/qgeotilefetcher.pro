@@ -0,0 +1,10 @@
+TEMPLATE = app
+CONFIG += testcase
+TARGET = tst_qgeotilefetcher
+
+INCLUDEPATH += ../../../src/location/maps
+
+SOURCES += tst_qgeotilefetcher.cpp
+
+QT += location positioning-private testlib
+DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0
@@ -0,0 +1,256 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia. For licensing terms and
+** conditions see http://qt.digia.com/licensing. For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights. These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include <QtTest/QtTest>
+#include <QtTest/QSignalSpy>
+#include <QtCore/QPointer>
+
+#include "qgeotilespec_p.h"
+#include "qgeotiledmapreply_p.h"
+#include "qgeotilefetcher_p.h"
+
+QT_USE_NAMESPACE
+
+class FetchReply : public QGeoTiledMapReply
+{
+    Q_OBJECT
+public:
+    FetchReply(const QGeoTileSpec &spec, QObject *parent)
+        : QGeoTiledMapReply(spec, parent), aborted(false) {}
+
+    void finish()
+    {
+        setMapImageData(QByteArray("tile"));
+        setMapImageFormat(QStringLiteral("png"));
+        setFinished(true);
+    }
+
+    void abort() { aborted = true; }
+
+    bool aborted;
+};
+
+class TestFetcher : public QGeoTileFetcher
+{
+    Q_OBJECT
+public:
+    TestFetcher() : QGeoTileFetcher(0) {}
+
+    FetchReply *reply(const QGeoTileSpec &spec) const
+    {
+        foreach (FetchReply *r, replies) {
+            if (r && r->tileSpec() == spec)
+                return r;
+        }
+        return 0;
+    }
+
+    // finished replies are deleted by the fetcher
+    QList<QPointer<FetchReply> > replies;
+    QList<QGeoTileSpec> requested;
+
+protected:
+    QString hostForTile(const QGeoTileSpec &spec) const
+    {
+        return QString::number(spec.mapId());
+    }
+
+private:
+    QGeoTiledMapReply *getTileImage(const QGeoTileSpec &spec)
+    {
+        FetchReply *r = new FetchReply(spec, this);
+        replies.append(r);
+        requested.append(spec);
+        return r;
+    }
+};
+
+class tst_QGeoTileFetcher : public QObject
+{
+    Q_OBJECT
+
+private:
+    QGeoTileSpec tile(int mapId, int zoom, int x, int y) const;
+
+private Q_SLOTS:
+    void initTestCase();
+    void perHostLimit();
+    void priorityOrder();
+    void cancelQueued();
+    void cancelInFlight();
+    void statistics();
+};
+
+QGeoTileSpec tst_QGeoTileFetcher::tile(int mapId, int zoom, int x, int y) const
+{
+    return QGeoTileSpec(QStringLiteral("test"), mapId, zoom, x, y);
+}
+
+void tst_QGeoTileFetcher::initTestCase()
+{
+    qRegisterMetaType<QGeoTileSpec>();
+}
+
+void tst_QGeoTileFetcher::perHostLimit()
+{
+    TestFetcher fetcher;
+    fetcher.setMaxRequestsPerHost(2);
+    QCOMPARE(fetcher.maxRequestsPerHost(), 2);
+
+    QSet<QGeoTileSpec> tiles;
+    for (int i = 0; i < 5; ++i)
+        tiles.insert(tile(1, 3, i, 0));
+    for (int i = 0; i < 3; ++i)
+        tiles.insert(tile(2, 3, i, 0));
+
+    fetcher.updateTileRequests(tiles, QSet<QGeoTileSpec>());
+    QCOMPARE(fetcher.queueDepth(), 8);
+
+    QTRY_COMPARE(fetcher.replies.size(), 4);
+    QCOMPARE(fetcher.inFlightCount(), 4);
+    QCOMPARE(fetcher.queueDepth(), 4);
+
+    QSignalSpy spy(&fetcher, SIGNAL(tileFinished(QGeoTileSpec,QByteArray,QString)));
+    fetcher.replies.first()->finish();
+
+    QTRY_COMPARE(spy.count(), 1);
+    QTRY_COMPARE(fetcher.replies.size(), 5);
+    QCOMPARE(fetcher.inFlightCount(), 4);
+    QCOMPARE(fetcher.queueDepth(), 3);
+}
+
+void tst_QGeoTileFetcher::priorityOrder()
+{
+    TestFetcher fetcher;
+    fetcher.setMaxRequestsPerHost(1);
+
+    // the center falls into tile (2, 2) of zoom level 2
+    fetcher.setPriorityCenter(0.6, 0.6, 2);
+
+    QList<QGeoTileSpec> expected;
+    expected << tile(1, 2, 2, 2)
+             << tile(1, 2, 3, 3)
+             << tile(1, 2, 0, 0)
+             << tile(1, 1, 1, 1)
+             << tile(1, 1, 0, 0);
+
+    fetcher.updateTileRequests(expected.toSet(), QSet<QGeoTileSpec>());
+
+    for (int i = 0; i < expected.size(); ++i) {
+        QTRY_COMPARE(fetcher.replies.size(), i + 1);
+        QCOMPARE(fetcher.requested.last(), expected.at(i));
+        fetcher.replies.last()->finish();
+    }
+}
+
+void tst_QGeoTileFetcher::cancelQueued()
+{
+    TestFetcher fetcher;
+    fetcher.setMaxRequestsPerHost(1);
+
+    QGeoTileSpec a = tile(1, 4, 0, 0);
+    QGeoTileSpec b = tile(1, 4, 1, 0);
+    QGeoTileSpec c = tile(1, 4, 2, 0);
+
+    fetcher.setPriorityCenter(0.0, 0.0, 4);
+    fetcher.updateTileRequests(QSet<QGeoTileSpec>() << a << b << c, QSet<QGeoTileSpec>());
+    QTRY_COMPARE(fetcher.replies.size(), 1);
+    QCOMPARE(fetcher.requested.first(), a);
+
+    fetcher.updateTileRequests(QSet<QGeoTileSpec>(), QSet<QGeoTileSpec>() << b);
+    QCOMPARE(fetcher.queueDepth(), 1);
+
+    fetcher.replies.first()->finish();
+    QTRY_COMPARE(fetcher.replies.size(), 2);
+    QCOMPARE(fetcher.requested.last(), c);
+    QVERIFY(!fetcher.reply(b));
+
+    // requesting it again queues it behind the tiles already waiting
+    fetcher.updateTileRequests(QSet<QGeoTileSpec>() << b, QSet<QGeoTileSpec>());
+    QCOMPARE(fetcher.queueDepth(), 1);
+    fetcher.replies.last()->finish();
+    QTRY_COMPARE(fetcher.replies.size(), 3);
+    QCOMPARE(fetcher.requested.last(), b);
+}
+
+void tst_QGeoTileFetcher::cancelInFlight()
+{
+    TestFetcher fetcher;
+    fetcher.setMaxRequestsPerHost(1);
+
+    QGeoTileSpec a = tile(1, 4, 0, 0);
+    QGeoTileSpec b = tile(1, 4, 1, 0);
+
+    fetcher.setPriorityCenter(0.0, 0.0, 4);
+    fetcher.updateTileRequests(QSet<QGeoTileSpec>() << a << b, QSet<QGeoTileSpec>());
+    QTRY_COMPARE(fetcher.replies.size(), 1);
+
+    fetcher.updateTileRequests(QSet<QGeoTileSpec>(), QSet<QGeoTileSpec>() << a);
+    QVERIFY(fetcher.reply(a)->aborted);
+    QCOMPARE(fetcher.inFlightCount(), 0);
+
+    // the freed slot goes to the next tile
+    QTRY_COMPARE(fetcher.replies.size(), 2);
+    QCOMPARE(fetcher.requested.last(), b);
+    QCOMPARE(fetcher.inFlightCount(), 1);
+
+    // a late reply for the cancelled tile is dropped
+    QSignalSpy spy(&fetcher, SIGNAL(tileFinished(QGeoTileSpec,QByteArray,QString)));
+    fetcher.reply(a)->finish();
+    QTest::qWait(10);
+    QCOMPARE(spy.count(), 0);
+    QCOMPARE(fetcher.inFlightCount(), 1);
+}
+
+void tst_QGeoTileFetcher::statistics()
+{
+    TestFetcher fetcher;
+    QCOMPARE(fetcher.queueDepth(), 0);
+    QCOMPARE(fetcher.inFlightCount(), 0);
+    QCOMPARE(fetcher.averageTimeToFirstByte(), 0.0);
+
+    fetcher.updateTileRequests(QSet<QGeoTileSpec>() << tile(1, 1, 0, 0), QSet<QGeoTileSpec>());
+    QTRY_COMPARE(fetcher.inFlightCount(), 1);
+
+    QTest::qWait(20);
+    emit fetcher.replies.first()->firstByteReceived();
+    fetcher.replies.first()->finish();
+
+    QTRY_COMPARE(fetcher.inFlightCount(), 0);
+    QVERIFY(fetcher.averageTimeToFirstByte() >= 20.0);
+}
+
+QTEST_MAIN(tst_QGeoTileFetcher)
+
+#include "tst_qgeotilefetcher.moc"
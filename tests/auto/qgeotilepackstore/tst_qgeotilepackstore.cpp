@@ -0,0 +1,305 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia. For licensing terms and
+** conditions see http://qt.digia.com/licensing. For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights. These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtCore/QString>
+#include <QtCore/QTemporaryDir>
+#include <QtTest/QtTest>
+
+#include "qgeotilespec_p.h"
+#include "qgeotilepackstore_p.h"
+#include "qgeotilecache_p.h"
+
+QT_USE_NAMESPACE
+
+class tst_QGeoTilePackStore : public QObject
+{
+    Q_OBJECT
+
+private:
+    QString packName() const;
+    QByteArray tileBytes(int seed, int size) const;
+
+private Q_SLOTS:
+    void init();
+    void writeRead();
+    void reopen();
+    void overwrite();
+    void cacheOverwrite();
+    void removeTile();
+    void truncatedRecord();
+    void compaction();
+    void interruptedSwap();
+
+private:
+    QTemporaryDir dir_;
+};
+
+QString tst_QGeoTilePackStore::packName() const
+{
+    return QDir(dir_.path()).filePath(QStringLiteral("tiles.pack"));
+}
+
+QByteArray tst_QGeoTilePackStore::tileBytes(int seed, int size) const
+{
+    QByteArray bytes(size, Qt::Uninitialized);
+    for (int i = 0; i < size; ++i)
+        bytes[i] = char((seed + i) & 0xff);
+    return bytes;
+}
+
+void tst_QGeoTilePackStore::init()
+{
+    QVERIFY(dir_.isValid());
+    QFile::remove(packName());
+    QFile::remove(packName() + QStringLiteral(".compact"));
+    QFile::remove(packName() + QStringLiteral(".old"));
+}
+
+void tst_QGeoTilePackStore::writeRead()
+{
+    QGeoTilePackStore store(packName());
+    QVERIFY(store.open());
+    QVERIFY(store.tiles().isEmpty());
+
+    QGeoTileSpec spec(QStringLiteral("test"), 1, 5, 10, 12);
+    QByteArray bytes = tileBytes(1, 1000);
+
+    QVERIFY(!store.contains(spec));
+    QCOMPARE(store.size(spec), -1);
+
+    // served from the write buffer
+    store.write(spec, bytes, QStringLiteral("png"));
+    QVERIFY(store.contains(spec));
+    QCOMPARE(store.size(spec), 1000);
+    QCOMPARE(store.format(spec), QStringLiteral("png"));
+    QCOMPARE(store.read(spec), bytes);
+
+    // served from the mapped file
+    store.flush();
+    QCOMPARE(store.read(spec), bytes);
+    QCOMPARE(store.tiles().size(), 1);
+}
+
+void tst_QGeoTilePackStore::reopen()
+{
+    QGeoTileSpec spec1(QStringLiteral("test"), 1, 5, 10, 12);
+    QGeoTileSpec spec2(QStringLiteral("test"), 2, 6, 11, 13, 7);
+
+    {
+        QGeoTilePackStore store(packName());
+        QVERIFY(store.open());
+        store.write(spec1, tileBytes(1, 500), QStringLiteral("png"));
+        store.write(spec2, tileBytes(2, 700), QStringLiteral("jpg"));
+    }
+
+    QGeoTilePackStore store(packName());
+    QVERIFY(store.open());
+    QCOMPARE(store.tiles().size(), 2);
+    QCOMPARE(store.read(spec1), tileBytes(1, 500));
+    QCOMPARE(store.read(spec2), tileBytes(2, 700));
+    QCOMPARE(store.format(spec2), QStringLiteral("jpg"));
+    QCOMPARE(store.deadBytes(), qint64(0));
+}
+
+void tst_QGeoTilePackStore::overwrite()
+{
+    QGeoTileSpec spec(QStringLiteral("test"), 1, 5, 10, 12);
+
+    {
+        QGeoTilePackStore store(packName());
+        QVERIFY(store.open());
+        store.write(spec, tileBytes(1, 500), QStringLiteral("png"));
+        store.write(spec, tileBytes(2, 300), QStringLiteral("png"));
+        QCOMPARE(store.read(spec), tileBytes(2, 300));
+        QVERIFY(store.deadBytes() > 0);
+    }
+
+    QGeoTilePackStore store(packName());
+    QVERIFY(store.open());
+    QCOMPARE(store.tiles().size(), 1);
+    QCOMPARE(store.read(spec), tileBytes(2, 300));
+}
+
+void tst_QGeoTilePackStore::cacheOverwrite()
+{
+    QGeoTileSpec spec(QStringLiteral("test"), 1, 5, 10, 12);
+    QString referenceName = QDir(dir_.path()).filePath(QStringLiteral("reference.pack"));
+    QFile::remove(referenceName);
+
+    {
+        QGeoTileCache cache(dir_.path(), 0, QGeoTiledMappingManagerEngine::PackedFileLayout);
+        QCOMPARE(cache.diskLayout(), QGeoTiledMappingManagerEngine::PackedFileLayout);
+        cache.insert(spec, tileBytes(1, 500), QStringLiteral("png"),
+                     QGeoTiledMappingManagerEngine::DiskCache);
+        cache.insert(spec, tileBytes(2, 300), QStringLiteral("png"),
+                     QGeoTiledMappingManagerEngine::DiskCache);
+    }
+    {
+        QGeoTilePackStore reference(referenceName);
+        QVERIFY(reference.open());
+        reference.write(spec, tileBytes(1, 500), QStringLiteral("png"));
+        reference.write(spec, tileBytes(2, 300), QStringLiteral("png"));
+    }
+
+    // replacing the tile in the cache leaves no tombstone behind
+    QGeoTilePackStore store(packName());
+    QVERIFY(store.open());
+    QCOMPARE(store.tiles().size(), 1);
+    QCOMPARE(store.read(spec), tileBytes(2, 300));
+
+    QGeoTilePackStore reference(referenceName);
+    QVERIFY(reference.open());
+    QCOMPARE(store.deadBytes(), reference.deadBytes());
+}
+
+void tst_QGeoTilePackStore::removeTile()
+{
+    QGeoTileSpec spec1(QStringLiteral("test"), 1, 5, 10, 12);
+    QGeoTileSpec spec2(QStringLiteral("test"), 1, 5, 10, 13);
+
+    {
+        QGeoTilePackStore store(packName());
+        QVERIFY(store.open());
+        store.write(spec1, tileBytes(1, 500), QStringLiteral("png"));
+        store.write(spec2, tileBytes(2, 500), QStringLiteral("png"));
+        store.remove(spec1);
+        QVERIFY(!store.contains(spec1));
+        QVERIFY(store.read(spec1).isEmpty());
+    }
+
+    QGeoTilePackStore store(packName());
+    QVERIFY(store.open());
+    QVERIFY(!store.contains(spec1));
+    QVERIFY(store.contains(spec2));
+}
+
+void tst_QGeoTilePackStore::truncatedRecord()
+{
+    QGeoTileSpec spec1(QStringLiteral("test"), 1, 5, 10, 12);
+    QGeoTileSpec spec2(QStringLiteral("test"), 1, 5, 10, 13);
+
+    qint64 goodSize = 0;
+    {
+        QGeoTilePackStore store(packName());
+        QVERIFY(store.open());
+        store.write(spec1, tileBytes(1, 500), QStringLiteral("png"));
+        store.flush();
+        goodSize = QFileInfo(packName()).size();
+        store.write(spec2, tileBytes(2, 500), QStringLiteral("png"));
+    }
+
+    // simulate a crash in the middle of writing the second tile
+    QFile file(packName());
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QVERIFY(file.resize(goodSize + 100));
+    file.close();
+
+    QGeoTilePackStore store(packName());
+    QVERIFY(store.open());
+    QVERIFY(store.contains(spec1));
+    QVERIFY(!store.contains(spec2));
+    QCOMPARE(QFileInfo(packName()).size(), goodSize);
+}
+
+void tst_QGeoTilePackStore::compaction()
+{
+    QGeoTilePackStore store(packName());
+    QVERIFY(store.open());
+
+    const int tileCount = 100;
+    const int tileSize = 64 * 1024;
+    for (int i = 0; i < tileCount; ++i)
+        store.write(QGeoTileSpec(QStringLiteral("test"), 1, 10, i, 0), tileBytes(i, tileSize), QStringLiteral("png"));
+    store.flush();
+
+    qint64 sizeBefore = QFileInfo(packName()).size();
+
+    QSignalSpy spy(&store, SIGNAL(compacted()));
+    for (int i = 0; i < tileCount - 10; ++i)
+        store.remove(QGeoTileSpec(QStringLiteral("test"), 1, 10, i, 0));
+
+    QTRY_COMPARE(spy.count(), 1);
+    QVERIFY(!store.isCompacting());
+    QVERIFY(QFileInfo(packName()).size() < sizeBefore);
+    QCOMPARE(store.tiles().size(), 10);
+    for (int i = tileCount - 10; i < tileCount; ++i)
+        QCOMPARE(store.read(QGeoTileSpec(QStringLiteral("test"), 1, 10, i, 0)), tileBytes(i, tileSize));
+}
+
+void tst_QGeoTilePackStore::interruptedSwap()
+{
+    const QString compactName = packName() + QStringLiteral(".compact");
+    const QString oldName = packName() + QStringLiteral(".old");
+    QGeoTileSpec spec1(QStringLiteral("test"), 1, 5, 10, 12);
+    QGeoTileSpec spec2(QStringLiteral("test"), 1, 5, 11, 12);
+
+    // the old pack holds two tiles, the compacted one only the first
+    {
+        QGeoTilePackStore store(packName());
+        QVERIFY(store.open());
+        store.write(spec1, tileBytes(1, 500), QStringLiteral("png"));
+    }
+    QVERIFY(QFile::copy(packName(), compactName));
+    {
+        QGeoTilePackStore store(packName());
+        QVERIFY(store.open());
+        store.write(spec2, tileBytes(2, 500), QStringLiteral("png"));
+    }
+
+    // interrupted after the old pack was moved aside: the new one moves in
+    QVERIFY(QFile::rename(packName(), oldName));
+    QVERIFY(QFile::copy(oldName, packName() + QStringLiteral(".backup")));
+    {
+        QGeoTilePackStore store(packName());
+        QVERIFY(store.open());
+        QCOMPARE(store.tiles().size(), 1);
+        QCOMPARE(store.read(spec1), tileBytes(1, 500));
+    }
+    QVERIFY(!QFile::exists(compactName));
+    QVERIFY(!QFile::exists(oldName));
+
+    // without a new pack the old one is moved back
+    QVERIFY(QFile::remove(packName()));
+    QVERIFY(QFile::rename(packName() + QStringLiteral(".backup"), oldName));
+    {
+        QGeoTilePackStore store(packName());
+        QVERIFY(store.open());
+        QCOMPARE(store.tiles().size(), 2);
+        QCOMPARE(store.read(spec2), tileBytes(2, 500));
+    }
+    QVERIFY(!QFile::exists(oldName));
+}
+
+QTEST_GUILESS_MAIN(tst_QGeoTilePackStore)
+
+#include "tst_qgeotilepackstore.moc"
@@ -0,0 +1,192 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia. For licensing terms and
+** conditions see http://qt.digia.com/licensing. For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights. These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include <QtTest/QtTest>
+
+#include "qgeotilespec_p.h"
+#include "qgeotileprefetcher_p.h"
+#include "qgeocameradata_p.h"
+#include "qgeomaptype_p.h"
+
+#include <QtPositioning/private/qgeoprojection_p.h>
+#include <QtPositioning/private/qdoublevector2d_p.h>
+
+QT_USE_NAMESPACE
+
+class tst_QGeoTilePrefetcher : public QObject
+{
+    Q_OBJECT
+
+private:
+    void setup(QGeoTilePrefetcher &prefetcher) const;
+    QGeoCameraData camera(double tileX, double tileY, double zoom) const;
+
+private Q_SLOTS:
+    void stationary();
+    void followsMotion();
+    void bandwidthBudget();
+    void zoomingOut();
+    void followsRoute();
+};
+
+// a 3 x 3 tile viewport at zoom level 4, where the map is 16 tiles wide
+void tst_QGeoTilePrefetcher::setup(QGeoTilePrefetcher &prefetcher) const
+{
+    prefetcher.setScreenSize(QSize(512, 512));
+    prefetcher.setTileSize(256);
+    prefetcher.setMinimumZoomLevel(0);
+    prefetcher.setMaximumZoomLevel(20);
+    prefetcher.setPluginString(QStringLiteral("test"));
+    prefetcher.setMapType(QGeoMapType(QGeoMapType::StreetMap, "street map", "street map", false, false, 1));
+    prefetcher.setBandwidthBudget(1000 * 1000);
+    prefetcher.setEstimatedTileBytes(1000);
+    prefetcher.setLookAhead(5000);
+}
+
+QGeoCameraData tst_QGeoTilePrefetcher::camera(double tileX, double tileY, double zoom) const
+{
+    double side = std::pow(2.0, std::floor(zoom));
+    QGeoCameraData cam;
+    cam.setCenter(QGeoProjection::mercatorToCoord(QDoubleVector2D(tileX / side, tileY / side)));
+    cam.setZoomLevel(zoom);
+    return cam;
+}
+
+void tst_QGeoTilePrefetcher::stationary()
+{
+    QGeoTilePrefetcher prefetcher;
+    setup(prefetcher);
+
+    QVERIFY(prefetcher.predictedTiles().isEmpty());
+
+    prefetcher.addCameraSample(camera(8.5, 8.5, 4), 0);
+    prefetcher.addCameraSample(camera(8.5, 8.5, 4), 500);
+    QVERIFY(prefetcher.predictedTiles().isEmpty());
+}
+
+void tst_QGeoTilePrefetcher::followsMotion()
+{
+    QGeoTilePrefetcher prefetcher;
+    setup(prefetcher);
+
+    // one tile per second to the east
+    prefetcher.addCameraSample(camera(8.5, 8.5, 4), 0);
+    prefetcher.addCameraSample(camera(9.5, 8.5, 4), 1000);
+
+    QList<QGeoTileSpec> tiles = prefetcher.predictedTiles();
+    QVERIFY(!tiles.isEmpty());
+
+    bool nextLevel = false;
+    foreach (const QGeoTileSpec &tile, tiles) {
+        QCOMPARE(tile.mapId(), 1);
+        if (tile.zoom() == 5) {
+            nextLevel = true;
+            continue;
+        }
+        QCOMPARE(tile.zoom(), 4);
+        // nothing behind the camera or inside the viewport
+        QVERIFY(tile.x() >= 11);
+        QVERIFY(tile.x() <= 15);
+        QVERIFY(tile.y() >= 7 && tile.y() <= 9);
+    }
+    QVERIFY(nextLevel);
+
+    // the closest tiles come first
+    QCOMPARE(tiles.first().zoom(), 4);
+    QCOMPARE(tiles.first().x(), 11);
+}
+
+void tst_QGeoTilePrefetcher::bandwidthBudget()
+{
+    QGeoTilePrefetcher prefetcher;
+    setup(prefetcher);
+
+    // five seconds at one tile per second
+    prefetcher.setBandwidthBudget(1000);
+    QCOMPARE(prefetcher.bandwidthBudget(), 1000);
+
+    prefetcher.addCameraSample(camera(8.5, 8.5, 4), 0);
+    prefetcher.addCameraSample(camera(9.5, 8.5, 4), 1000);
+    QCOMPARE(prefetcher.predictedTiles().size(), 5);
+
+    prefetcher.setBandwidthBudget(0);
+    QVERIFY(prefetcher.predictedTiles().isEmpty());
+}
+
+void tst_QGeoTilePrefetcher::zoomingOut()
+{
+    QGeoTilePrefetcher prefetcher;
+    setup(prefetcher);
+
+    prefetcher.addCameraSample(camera(17.0, 17.0, 5.0), 0);
+    prefetcher.addCameraSample(camera(9.5, 8.5, 4.0), 1000);
+
+    bool nextLevel = false;
+    foreach (const QGeoTileSpec &tile, prefetcher.predictedTiles()) {
+        QVERIFY(tile.zoom() == 4 || tile.zoom() == 3);
+        if (tile.zoom() == 3)
+            nextLevel = true;
+    }
+    QVERIFY(nextLevel);
+}
+
+void tst_QGeoTilePrefetcher::followsRoute()
+{
+    QGeoTilePrefetcher prefetcher;
+    setup(prefetcher);
+
+    // a route heading south from the camera, which does not move
+    QList<QGeoCoordinate> route;
+    route << QGeoProjection::mercatorToCoord(QDoubleVector2D(8.5 / 16, 8.5 / 16))
+          << QGeoProjection::mercatorToCoord(QDoubleVector2D(8.5 / 16, 14.5 / 16));
+    prefetcher.setRoute(route);
+    QCOMPARE(prefetcher.route().size(), 2);
+
+    prefetcher.addCameraSample(camera(8.5, 8.5, 4), 0);
+
+    QList<QGeoTileSpec> tiles = prefetcher.predictedTiles();
+    QVERIFY(!tiles.isEmpty());
+
+    foreach (const QGeoTileSpec &tile, tiles) {
+        if (tile.zoom() != 4)
+            continue;
+        QVERIFY(tile.y() >= 10);
+        QVERIFY(tile.x() >= 7 && tile.x() <= 9);
+    }
+    QCOMPARE(tiles.first().y(), 10);
+}
+
+QTEST_APPLESS_MAIN(tst_QGeoTilePrefetcher)
+
+#include "tst_qgeotileprefetcher.moc"
@@ -0,0 +1,410 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia. For licensing terms and
+** conditions see http://qt.digia.com/licensing. For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights. These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include <QtTest/QtTest>
+#include <QtTest/QSignalSpy>
+#include <QtCore/QPointer>
+#include <QtCore/QTemporaryDir>
+
+#include <QtPositioning/QGeoCoordinate>
+#include <QtPositioning/QGeoRectangle>
+
+#include "qgeotilespec_p.h"
+#include "qgeotiledmapreply_p.h"
+#include "qgeotilefetcher_p.h"
+#include "qgeotilecache_p.h"
+#include "qgeotileregiondownload_p.h"
+
+QT_USE_NAMESPACE
+
+class FetchReply : public QGeoTiledMapReply
+{
+    Q_OBJECT
+public:
+    FetchReply(const QGeoTileSpec &spec, QObject *parent)
+        : QGeoTiledMapReply(spec, parent) {}
+
+    void finish()
+    {
+        setMapImageData(QByteArray("tile"));
+        setMapImageFormat(QStringLiteral("png"));
+        setFinished(true);
+    }
+};
+
+// serves every tile from memory, right away or when told to
+class TestFetcher : public QGeoTileFetcher
+{
+    Q_OBJECT
+public:
+    TestFetcher(bool immediate) : QGeoTileFetcher(0), immediate_(immediate) {}
+
+    int finishPending(int count)
+    {
+        int finished = 0;
+        foreach (FetchReply *r, replies) {
+            if (finished == count)
+                break;
+            if (r && !r->isFinished()) {
+                r->finish();
+                ++finished;
+            }
+        }
+        return finished;
+    }
+
+    // finished replies are deleted by the fetcher
+    QList<QPointer<FetchReply> > replies;
+    QList<QGeoTileSpec> requested;
+
+private:
+    QGeoTiledMapReply *getTileImage(const QGeoTileSpec &spec)
+    {
+        FetchReply *r = new FetchReply(spec, this);
+        requested.append(spec);
+        if (immediate_)
+            r->finish();
+        else
+            replies.append(r);
+        return r;
+    }
+
+    bool immediate_;
+};
+
+class tst_QGeoTileRegionDownload : public QObject
+{
+    Q_OBJECT
+
+private:
+    QGeoRectangle smallArea() const;
+    QGeoRectangle world() const;
+
+private Q_SLOTS:
+    void initTestCase();
+    void countTiles();
+    void dateline();
+    void polygon();
+    void download();
+    void skipCached();
+    void pauseAndResume();
+    void pauseCounts();
+    void cancel();
+};
+
+// one tile at zoom 0, and two tiles on top of each other at zoom 1 and 2
+QGeoRectangle tst_QGeoTileRegionDownload::smallArea() const
+{
+    return QGeoRectangle(QGeoCoordinate(10.0, 10.0), QGeoCoordinate(-10.0, 20.0));
+}
+
+QGeoRectangle tst_QGeoTileRegionDownload::world() const
+{
+    return QGeoRectangle(QGeoCoordinate(85.0, -180.0), QGeoCoordinate(-85.0, 180.0));
+}
+
+void tst_QGeoTileRegionDownload::initTestCase()
+{
+    qRegisterMetaType<QGeoTileSpec>();
+}
+
+void tst_QGeoTileRegionDownload::countTiles()
+{
+    TestFetcher fetcher(true);
+    QGeoTileRegionDownload download(&fetcher, 0);
+    download.setRegion(smallArea());
+    download.setZoomRange(0, 2);
+    QCOMPARE(download.totalTiles(), qint64(5));
+
+    download.setRegion(world());
+    download.setZoomRange(0, 3);
+    QCOMPARE(download.totalTiles(), qint64(1 + 4 + 16 + 64));
+
+    download.setZoomRange(4, 4);
+    QCOMPARE(download.totalTiles(), qint64(256));
+}
+
+void tst_QGeoTileRegionDownload::dateline()
+{
+    TestFetcher fetcher(true);
+    QGeoTileRegionDownload download(&fetcher, 0);
+    download.setPluginString(QStringLiteral("test"));
+    download.setMapId(1);
+    download.setRegion(QGeoRectangle(QGeoCoordinate(10.0, 170.0), QGeoCoordinate(-10.0, -170.0)));
+    download.setZoomRange(2, 2);
+    QCOMPARE(download.totalTiles(), qint64(4));
+
+    download.start();
+    QTRY_COMPARE(download.state(), QGeoTileRegionDownload::Finished);
+
+    QCOMPARE(fetcher.requested.size(), 4);
+    foreach (const QGeoTileSpec &spec, fetcher.requested) {
+        QVERIFY(spec.x() == 3 || spec.x() == 0);
+        QVERIFY(spec.y() == 1 || spec.y() == 2);
+    }
+}
+
+void tst_QGeoTileRegionDownload::polygon()
+{
+    TestFetcher fetcher(true);
+    QGeoTileRegionDownload download(&fetcher, 0);
+
+    QList<QGeoCoordinate> square;
+    square << QGeoCoordinate(10.0, 10.0) << QGeoCoordinate(10.0, 20.0)
+           << QGeoCoordinate(-10.0, 20.0) << QGeoCoordinate(-10.0, 10.0);
+    download.setRegion(square);
+    download.setZoomRange(0, 2);
+    QCOMPARE(download.totalTiles(), qint64(5));
+
+    // the same square across the dateline
+    QList<QGeoCoordinate> dateline;
+    dateline << QGeoCoordinate(10.0, 170.0) << QGeoCoordinate(10.0, -170.0)
+             << QGeoCoordinate(-10.0, -170.0) << QGeoCoordinate(-10.0, 170.0);
+    download.setRegion(dateline);
+    download.setZoomRange(2, 2);
+    QCOMPARE(download.totalTiles(), qint64(4));
+
+    // a triangle leaves out the tiles of its bounding box it does not touch
+    QList<QGeoCoordinate> triangle;
+    triangle << QGeoCoordinate(80.0, -170.0) << QGeoCoordinate(80.0, 0.0)
+             << QGeoCoordinate(-80.0, -170.0);
+    download.setRegion(triangle);
+    download.setZoomRange(3, 3);
+    QVERIFY(download.totalTiles() < 32);
+    QVERIFY(download.totalTiles() > 16);
+
+    // the tiles downloaded are the ones counted
+    QSignalSpy finishedSpy(&download, SIGNAL(finished()));
+    download.start();
+    QTRY_COMPARE(finishedSpy.count(), 1);
+    QCOMPARE(qint64(fetcher.requested.size()), download.totalTiles());
+    QCOMPARE(fetcher.requested.toSet().size(), fetcher.requested.size());
+}
+
+void tst_QGeoTileRegionDownload::download()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QGeoTileCache cache(dir.path());
+
+    TestFetcher fetcher(true);
+    fetcher.setMaxRequestsPerHost(2);
+
+    QGeoTileRegionDownload download(&fetcher, &cache);
+    download.setPluginString(QStringLiteral("test"));
+    download.setMapId(1);
+    download.setRegion(world());
+    download.setZoomRange(0, 3);
+    download.setJournal(dir.path() + QStringLiteral("/download.journal"));
+
+    QSignalSpy progressSpy(&download, SIGNAL(progress(qint64,qint64)));
+    QSignalSpy finishedSpy(&download, SIGNAL(finished()));
+
+    download.start();
+    QCOMPARE(download.state(), QGeoTileRegionDownload::Running);
+    QTRY_COMPARE(finishedSpy.count(), 1);
+
+    QCOMPARE(download.state(), QGeoTileRegionDownload::Finished);
+    QCOMPARE(download.finishedTiles(), qint64(85));
+    QCOMPARE(download.failedTiles(), qint64(0));
+    QCOMPARE(download.skippedTiles(), qint64(0));
+    QCOMPARE(fetcher.requested.size(), 85);
+    QCOMPARE(fetcher.requested.toSet().size(), 85);
+
+    QVERIFY(!progressSpy.isEmpty());
+    QCOMPARE(progressSpy.last().at(0).toLongLong(), qint64(85));
+    QCOMPARE(progressSpy.last().at(1).toLongLong(), qint64(85));
+
+    foreach (const QGeoTileSpec &spec, fetcher.requested)
+        QVERIFY(cache.contains(spec));
+
+    QVERIFY(!QFile::exists(download.journal()));
+}
+
+void tst_QGeoTileRegionDownload::skipCached()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QGeoTileCache cache(dir.path());
+
+    for (int x = 0; x < 4; ++x) {
+        cache.insert(QGeoTileSpec(QStringLiteral("test"), 1, 2, x, 0),
+                     QByteArray("tile"), QStringLiteral("png"));
+    }
+
+    TestFetcher fetcher(true);
+    QGeoTileRegionDownload download(&fetcher, &cache);
+    download.setPluginString(QStringLiteral("test"));
+    download.setMapId(1);
+    download.setRegion(world());
+    download.setZoomRange(2, 2);
+
+    download.start();
+    QTRY_COMPARE(download.state(), QGeoTileRegionDownload::Finished);
+
+    QCOMPARE(download.finishedTiles(), qint64(16));
+    QCOMPARE(download.skippedTiles(), qint64(4));
+    QCOMPARE(fetcher.requested.size(), 12);
+    foreach (const QGeoTileSpec &spec, fetcher.requested)
+        QVERIFY(spec.y() != 0);
+}
+
+void tst_QGeoTileRegionDownload::pauseAndResume()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QGeoTileCache cache(dir.path());
+    QString journal = dir.path() + QStringLiteral("/download.journal");
+
+    qint64 done = 0;
+    {
+        // downloads get half of the requests
+        TestFetcher fetcher(false);
+        fetcher.setMaxRequestsPerHost(4);
+
+        QGeoTileRegionDownload download(&fetcher, &cache);
+        download.setPluginString(QStringLiteral("test"));
+        download.setMapId(1);
+        download.setRegion(world());
+        download.setZoomRange(0, 3);
+        download.setJournal(journal);
+
+        download.start();
+        QTRY_COMPARE(fetcher.replies.size(), 2);
+        QCOMPARE(fetcher.finishPending(2), 2);
+        QTRY_COMPARE(download.finishedTiles(), qint64(2));
+
+        download.pause();
+        QCOMPARE(download.state(), QGeoTileRegionDownload::Paused);
+        QVERIFY(QFile::exists(journal));
+
+        // the tiles still outstanding are given up
+        done = download.finishedTiles();
+        QCOMPARE(done, qint64(2));
+    }
+
+    TestFetcher fetcher(true);
+    QGeoTileRegionDownload *download = QGeoTileRegionDownload::resume(journal, &fetcher, &cache);
+    QVERIFY(download);
+    QCOMPARE(download->state(), QGeoTileRegionDownload::Paused);
+    QCOMPARE(download->totalTiles(), qint64(85));
+    QCOMPARE(download->finishedTiles(), done);
+
+    download->start();
+    QTRY_COMPARE(download->state(), QGeoTileRegionDownload::Finished);
+    QCOMPARE(download->finishedTiles(), qint64(85));
+
+    // tiles downloaded before the pause are neither downloaded nor counted again
+    QCOMPARE(download->skippedTiles(), qint64(0));
+    QCOMPARE(fetcher.requested.size(), 83);
+    QVERIFY(!QFile::exists(journal));
+    delete download;
+
+    QVERIFY(!QGeoTileRegionDownload::resume(journal, &fetcher, &cache));
+}
+
+void tst_QGeoTileRegionDownload::pauseCounts()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QGeoTileCache cache(dir.path());
+
+    TestFetcher fetcher(false);
+    fetcher.setMaxRequestsPerHost(4);
+    QGeoTileRegionDownload download(&fetcher, &cache);
+    download.setPluginString(QStringLiteral("test"));
+    download.setMapId(1);
+    download.setRegion(world());
+    download.setZoomRange(0, 3);
+
+    QSignalSpy progressSpy(&download, SIGNAL(progress(qint64,qint64)));
+
+    // pause a few times with tiles outstanding
+    download.start();
+    for (int i = 0; i < 3; ++i) {
+        QTRY_VERIFY(fetcher.finishPending(1) == 1);
+        QTRY_COMPARE(download.finishedTiles(), qint64(i + 1));
+        download.pause();
+        QCOMPARE(download.finishedTiles(), qint64(i + 1));
+        download.start();
+    }
+
+    for (int i = 0; i < 200 && download.state() != QGeoTileRegionDownload::Finished; ++i) {
+        fetcher.finishPending(8);
+        QTest::qWait(10);
+    }
+    QCOMPARE(download.state(), QGeoTileRegionDownload::Finished);
+
+    // the withdrawn tiles were requested again, but counted once
+    QCOMPARE(download.finishedTiles(), qint64(85));
+    QCOMPARE(download.skippedTiles(), qint64(0));
+    QCOMPARE(download.failedTiles(), qint64(0));
+    QCOMPARE(fetcher.requested.toSet().size(), 85);
+    for (int i = 1; i < progressSpy.count(); ++i)
+        QVERIFY(progressSpy.at(i).at(0).toLongLong() >= progressSpy.at(i - 1).at(0).toLongLong());
+    QCOMPARE(progressSpy.last().at(0).toLongLong(), qint64(85));
+}
+
+void tst_QGeoTileRegionDownload::cancel()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QGeoTileCache cache(dir.path());
+
+    TestFetcher fetcher(false);
+    QGeoTileRegionDownload download(&fetcher, &cache);
+    download.setPluginString(QStringLiteral("test"));
+    download.setMapId(1);
+    download.setRegion(world());
+    download.setZoomRange(0, 3);
+    download.setJournal(dir.path() + QStringLiteral("/download.journal"));
+
+    download.start();
+    QTRY_VERIFY(!fetcher.replies.isEmpty());
+    download.pause();
+    QCOMPARE(download.state(), QGeoTileRegionDownload::Paused);
+    QVERIFY(QFile::exists(download.journal()));
+
+    download.cancel();
+    QCOMPARE(download.state(), QGeoTileRegionDownload::Cancelled);
+    QVERIFY(!QFile::exists(download.journal()));
+
+    // the tiles given up are cancelled in the fetcher
+    QTRY_COMPARE(fetcher.queueDepth(), 0);
+    QTRY_COMPARE(fetcher.inFlightCount(), 0);
+}
+
+QTEST_GUILESS_MAIN(tst_QGeoTileRegionDownload)
+
+#include "tst_qgeotileregiondownload.moc"
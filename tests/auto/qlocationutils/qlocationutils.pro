@@ -0,0 +1,11 @@
+TEMPLATE = app
+CONFIG += testcase
+TARGET = tst_qlocationutils
+
+SOURCES += tst_qlocationutils.cpp
+
+OTHER_FILES += ../../../examples/positioning/geoflickr/flickrmobile/nmealog.txt
+TESTDATA = $$OTHER_FILES
+
+QT += positioning-private testlib
+DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0
@@ -0,0 +1,261 @@
+/****************************************************************************
+**
+** Copyright (C) 2014 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+** This file is part of the test suite of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL21$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia. For licensing terms and
+** conditions see http://qt.digia.com/licensing. For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 or version 3 as published by the Free
+** Software Foundation and appearing in the file LICENSE.LGPLv21 and
+** LICENSE.LGPLv3 included in the packaging of this file. Please review the
+** following information to ensure the GNU Lesser General Public License
+** requirements will be met: https://www.gnu.org/licenses/lgpl.html and
+** http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights. These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include <QtTest/QtTest>
+#include <QtCore/QObject>
+#include <QtCore/QFile>
+#include <QtPositioning/QGeoPositionInfo>
+#include <QtPositioning/private/qlocationutils_p.h>
+
+QT_USE_NAMESPACE
+
+class tst_QLocationUtils : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void checksum_data();
+    void checksum();
+    void nmeaTime_data();
+    void nmeaTime();
+    void nmeaLatLong_data();
+    void nmeaLatLong();
+    void gga();
+    void gsa();
+    void rmc();
+    void vtgAndZda();
+    void benchmark_nmeaLog();
+
+private:
+    static QByteArray withChecksum(const QByteArray &sentence);
+};
+
+// appends *hh to $sentence
+QByteArray tst_QLocationUtils::withChecksum(const QByteArray &sentence)
+{
+    int checksum = 0;
+    for (int i = 1; i < sentence.size(); ++i)
+        checksum ^= sentence.at(i);
+    return sentence + '*' + QByteArray::number(checksum, 16).rightJustified(2, '0').toUpper();
+}
+
+void tst_QLocationUtils::checksum_data()
+{
+    QTest::addColumn<QByteArray>("sentence");
+    QTest::addColumn<bool>("valid");
+
+    QTest::newRow("valid") << QByteArray("$GPGLL,2734.33926,S,15305.44310,E,222437.000,A,A*49") << true;
+    QTest::newRow("lower case") << QByteArray("$GPGSA,A,3,16,25,23,20,13,27,11,,,,,,2.3,1.3,1.9*3d") << true;
+    QTest::newRow("wrong") << QByteArray("$GPGLL,2734.33926,S,15305.44310,E,222437.000,A,A*48") << false;
+    QTest::newRow("not hex") << QByteArray("$GPGLL,2734.33926,S,15305.44310,E,222437.000,A,A*4G") << false;
+    QTest::newRow("short") << QByteArray("$GPGLL,2734.33926,S,15305.44310,E,222437.000,A,A*4") << false;
+    QTest::newRow("no asterisk") << QByteArray("$GPGLL,2734.33926,S,15305.44310,E,222437.000,A,A") << false;
+}
+
+void tst_QLocationUtils::checksum()
+{
+    QFETCH(QByteArray, sentence);
+    QFETCH(bool, valid);
+
+    QCOMPARE(QLocationUtils::hasValidNmeaChecksum(sentence.constData(), sentence.size()), valid);
+}
+
+void tst_QLocationUtils::nmeaTime_data()
+{
+    QTest::addColumn<QByteArray>("bytes");
+    QTest::addColumn<bool>("valid");
+    QTest::addColumn<QTime>("time");
+
+    QTest::newRow("seconds") << QByteArray("222437") << true << QTime(22, 24, 37);
+    QTest::newRow("milliseconds") << QByteArray("222437.123") << true << QTime(22, 24, 37, 123);
+    QTest::newRow("more digits") << QByteArray("222437.1234") << true << QTime(22, 24, 37, 123);
+    QTest::newRow("empty fraction") << QByteArray("222437.") << true << QTime(22, 24, 37);
+    QTest::newRow("out of range") << QByteArray("246000") << false << QTime();
+    QTest::newRow("too short") << QByteArray("22243") << false << QTime();
+    QTest::newRow("not digits") << QByteArray("22a437") << false << QTime();
+    QTest::newRow("empty") << QByteArray() << false << QTime();
+}
+
+void tst_QLocationUtils::nmeaTime()
+{
+    QFETCH(QByteArray, bytes);
+    QFETCH(bool, valid);
+    QFETCH(QTime, time);
+
+    QTime result;
+    QCOMPARE(QLocationUtils::getNmeaTime(bytes, &result), valid);
+    QCOMPARE(result, time);
+}
+
+void tst_QLocationUtils::nmeaLatLong_data()
+{
+    QTest::addColumn<QByteArray>("latString");
+    QTest::addColumn<char>("latDirection");
+    QTest::addColumn<QByteArray>("lngString");
+    QTest::addColumn<char>("lngDirection");
+    QTest::addColumn<bool>("valid");
+    QTest::addColumn<double>("lat");
+    QTest::addColumn<double>("lng");
+
+    QTest::newRow("south east") << QByteArray("2734.7964") << 'S' << QByteArray("15306.0124") << 'E'
+                                << true << -(27 + 34.7964 / 60) << (153 + 6.0124 / 60);
+    QTest::newRow("north west") << QByteArray("0000.5") << 'N' << QByteArray("00030") << 'W'
+                                << true << 0.5 / 60 << -0.5;
+    QTest::newRow("exponent") << QByteArray("2.7347964e3") << 'N' << QByteArray("15306.0124") << 'E'
+                              << true << (27 + 34.7964 / 60) << (153 + 6.0124 / 60);
+    QTest::newRow("bad direction") << QByteArray("2734.7964") << 'E' << QByteArray("15306.0124") << 'E'
+                                   << false << 0.0 << 0.0;
+    QTest::newRow("out of range") << QByteArray("9134.7964") << 'N' << QByteArray("15306.0124") << 'E'
+                                  << false << 0.0 << 0.0;
+    QTest::newRow("not a number") << QByteArray("27x4.7964") << 'N' << QByteArray("15306.0124") << 'E'
+                                  << false << 0.0 << 0.0;
+    QTest::newRow("empty") << QByteArray() << 'N' << QByteArray("15306.0124") << 'E'
+                           << false << 0.0 << 0.0;
+}
+
+void tst_QLocationUtils::nmeaLatLong()
+{
+    QFETCH(QByteArray, latString);
+    QFETCH(char, latDirection);
+    QFETCH(QByteArray, lngString);
+    QFETCH(char, lngDirection);
+    QFETCH(bool, valid);
+    QFETCH(double, lat);
+    QFETCH(double, lng);
+
+    double resultLat = 0.0;
+    double resultLng = 0.0;
+    QCOMPARE(QLocationUtils::getNmeaLatLong(latString, latDirection, lngString, lngDirection,
+                                            &resultLat, &resultLng), valid);
+    QVERIFY(qAbs(resultLat - lat) < 1e-12);
+    QVERIFY(qAbs(resultLng - lng) < 1e-12);
+}
+
+void tst_QLocationUtils::gga()
+{
+    const QByteArray sentence = withChecksum("$GPGGA,222437.000,2734.33926,S,15305.44310,E,1,07,1.3,50.6,M,39.2,M,,");
+
+    QGeoPositionInfo info;
+    bool hasFix = false;
+    QVERIFY(QLocationUtils::getPosInfoFromNmea(sentence.constData(), sentence.size(), &info, 2.0, &hasFix));
+    QVERIFY(hasFix);
+    QCOMPARE(info.timestamp().time(), QTime(22, 24, 37));
+    QVERIFY(!info.timestamp().date().isValid());
+    QCOMPARE(info.coordinate().latitude(), -(27 + 34.33926 / 60));
+    QCOMPARE(info.coordinate().longitude(), 153 + 5.44310 / 60);
+    QCOMPARE(info.coordinate().altitude(), 50.6);
+    QCOMPARE(info.attribute(QGeoPositionInfo::HorizontalAccuracy), 2 * 1.3 * 2.0);
+
+    // no fix, and fields past the end are ignored
+    const QByteArray noFix = withChecksum("$GPGGA,222437.000,,,,,0");
+    info = QGeoPositionInfo();
+    hasFix = true;
+    QVERIFY(QLocationUtils::getPosInfoFromNmea(noFix.constData(), noFix.size(), &info, 2.0, &hasFix));
+    QVERIFY(!hasFix);
+    QVERIFY(!info.coordinate().isValid());
+}
+
+void tst_QLocationUtils::gsa()
+{
+    const QByteArray sentence("$GPGSA,A,3,16,25,23,20,13,27,11,,,,,,2.3,1.3,1.9*3D");
+
+    QGeoPositionInfo info;
+    bool hasFix = false;
+    QVERIFY(QLocationUtils::getPosInfoFromNmea(sentence.constData(), sentence.size(), &info, 2.0, &hasFix));
+    QVERIFY(hasFix);
+    QCOMPARE(info.attribute(QGeoPositionInfo::HorizontalAccuracy), 2 * 1.3 * 2.0);
+    QCOMPARE(info.attribute(QGeoPositionInfo::VerticalAccuracy), 2 * 1.9 * 2.0);
+}
+
+void tst_QLocationUtils::rmc()
+{
+    const QByteArray sentence = withChecksum("$GPRMC,222437.500,A,2734.33926,S,15305.44310,E,10.0,84.4,290212,11.5,W");
+
+    QGeoPositionInfo info;
+    bool hasFix = false;
+    QVERIFY(QLocationUtils::getPosInfoFromNmea(sentence.constData(), sentence.size(), &info, 2.0, &hasFix));
+    QVERIFY(hasFix);
+    QCOMPARE(info.timestamp(), QDateTime(QDate(2012, 2, 29), QTime(22, 24, 37, 500), Qt::UTC));
+    QCOMPARE(info.coordinate().latitude(), -(27 + 34.33926 / 60));
+    QCOMPARE(info.attribute(QGeoPositionInfo::GroundSpeed), qreal(10.0 * 1.852 / 3.6));
+    QCOMPARE(info.attribute(QGeoPositionInfo::Direction), qreal(84.4));
+    QCOMPARE(info.attribute(QGeoPositionInfo::MagneticVariation), qreal(-11.5));
+
+    // 1900 was no leap year, so this date is rejected as it always was
+    const QByteArray leap = withChecksum("$GPRMC,222437.500,V,,,,,,,290200,,");
+    info = QGeoPositionInfo();
+    QVERIFY(QLocationUtils::getPosInfoFromNmea(leap.constData(), leap.size(), &info, 2.0, &hasFix));
+    QVERIFY(!hasFix);
+    QVERIFY(!info.timestamp().date().isValid());
+}
+
+void tst_QLocationUtils::vtgAndZda()
+{
+    const QByteArray vtg = withChecksum("$GPVTG,84.4,T,,M,10.0,N,18.5,K");
+    QGeoPositionInfo info;
+    QVERIFY(QLocationUtils::getPosInfoFromNmea(vtg.constData(), vtg.size(), &info, 2.0));
+    QCOMPARE(info.attribute(QGeoPositionInfo::Direction), qreal(84.4));
+    QCOMPARE(info.attribute(QGeoPositionInfo::GroundSpeed), qreal(18.5 / 3.6));
+
+    const QByteArray zda = withChecksum("$GPZDA,222437.25,29,02,2012,,");
+    info = QGeoPositionInfo();
+    QVERIFY(QLocationUtils::getPosInfoFromNmea(zda.constData(), zda.size(), &info, 2.0));
+    QCOMPARE(info.timestamp(), QDateTime(QDate(2012, 2, 29), QTime(22, 24, 37, 25), Qt::UTC));
+
+    const QByteArray gsv("$GPGSV,3,1,10,16,49,115,42,25,39,269,36,23,58,176,29,20,72,335,35*75");
+    QVERIFY(!QLocationUtils::getPosInfoFromNmea(gsv.constData(), gsv.size(), &info, 2.0));
+}
+
+void tst_QLocationUtils::benchmark_nmeaLog()
+{
+    QFile file(QFINDTESTDATA("../../../examples/positioning/geoflickr/flickrmobile/nmealog.txt"));
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QList<QByteArray> sentences = file.readAll().split('\n');
+    QVERIFY(sentences.size() > 1000);
+
+    int positions = 0;
+    QBENCHMARK {
+        positions = 0;
+        QGeoPositionInfo info;
+        foreach (const QByteArray &sentence, sentences) {
+            if (QLocationUtils::getPosInfoFromNmea(sentence.constData(), sentence.size(), &info, 2.0))
+                ++positions;
+        }
+    }
+    QVERIFY(positions > 0);
+}
+
+QTEST_APPLESS_MAIN(tst_QLocationUtils)
+
+#include "tst_qlocationutils.moc"
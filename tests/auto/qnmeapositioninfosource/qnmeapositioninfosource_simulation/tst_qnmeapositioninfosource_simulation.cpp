@@ -35,12 +35,111 @@
 
 #include "tst_qnmeapositioninfosource.h"
 
+#include <QtPositioning/private/qnmeapositioninfosource_p.h>
+#include <QElapsedTimer>
+
 class tst_QNmeaPositionInfoSource_Simulation : public tst_QNmeaPositionInfoSource
 {
     Q_OBJECT
 public:
     tst_QNmeaPositionInfoSource_Simulation()
         : tst_QNmeaPositionInfoSource(QNmeaPositionInfoSource::SimulationMode) {}
+
+private:
+    // count RMC sentences, one recorded every second
+    static QByteArray recording(int count)
+    {
+        const QDateTime start(QDate(2014, 6, 1), QTime(0, 0), Qt::UTC);
+        QByteArray data;
+        for (int i = 0; i < count; ++i)
+            data += QLocationTestUtils::createRmcSentence(start.addSecs(i)).toLatin1();
+        return data;
+    }
+
+private slots:
+    void replayAsFastAsPossible()
+    {
+        QByteArray data = recording(2000);
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::ReadOnly);
+
+        QNmeaPositionInfoSource source(QNmeaPositionInfoSource::SimulationMode);
+        QNmeaPositionInfoSourcePrivate::setReplaySpeed(&source, 0);
+        QCOMPARE(QNmeaPositionInfoSourcePrivate::replaySpeed(&source), qreal(0));
+        source.setDevice(&buffer);
+        QSignalSpy spy(&source, SIGNAL(positionUpdated(QGeoPositionInfo)));
+
+        // over half an hour of recording
+        source.startUpdates();
+        QTRY_COMPARE_WITH_TIMEOUT(spy.count(), 2000, 10000);
+        QCOMPARE(spy.last().at(0).value<QGeoPositionInfo>().timestamp(),
+                 QDateTime(QDate(2014, 6, 1), QTime(0, 33, 19), Qt::UTC));
+    }
+
+    void replaySpeed()
+    {
+        QByteArray data = recording(4);
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::ReadOnly);
+
+        QNmeaPositionInfoSource source(QNmeaPositionInfoSource::SimulationMode);
+        QCOMPARE(QNmeaPositionInfoSourcePrivate::replaySpeed(&source), qreal(1));
+        QNmeaPositionInfoSourcePrivate::setReplaySpeed(&source, 10);
+        source.setDevice(&buffer);
+        QSignalSpy spy(&source, SIGNAL(positionUpdated(QGeoPositionInfo)));
+
+        // three seconds recorded, three tenths replayed
+        QElapsedTimer timer;
+        timer.start();
+        source.startUpdates();
+        QTRY_COMPARE_WITH_TIMEOUT(spy.count(), 4, 2500);
+        QVERIFY(timer.elapsed() >= 250);
+    }
+
+    void positionReader()
+    {
+        QByteArray data = QLocationTestUtils::createZdaSentence(
+                    QDateTime(QDate(2014, 6, 1), QTime(10, 0), Qt::UTC)).toLatin1();
+        data += QLocationTestUtils::createGsaSentence().toLatin1();
+        data += "not a sentence\n";
+        for (int i = 0; i < 3; ++i)
+            data += QLocationTestUtils::createGgaSentence(QTime(10, 0, i)).toLatin1();
+        data.chop(2);   // no line break after the last sentence
+
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::ReadOnly);
+        QNmeaPositionReader reader(&buffer, 5.1);
+
+        // the date and accuracy come from the earlier sentences
+        QGeoPositionInfo info;
+        QVERIFY(reader.readNext(&info));
+        QCOMPARE(info.timestamp(), QDateTime(QDate(2014, 6, 1), QTime(10, 0), Qt::UTC));
+        QVERIFY(info.hasAttribute(QGeoPositionInfo::VerticalAccuracy));
+        QVERIFY(info.hasAttribute(QGeoPositionInfo::HorizontalAccuracy));
+
+        QList<QGeoPositionInfo> batch;
+        QCOMPARE(reader.readBatch(&batch, 10), 2);
+        QCOMPARE(batch.last().timestamp(), QDateTime(QDate(2014, 6, 1), QTime(10, 0, 2), Qt::UTC));
+        QVERIFY(!reader.readNext(&info));
+    }
+
+    void benchmark_positionReader()
+    {
+        QByteArray data = recording(20000);
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::ReadOnly);
+
+        int count = 0;
+        QBENCHMARK {
+            buffer.seek(0);
+            QNmeaPositionReader reader(&buffer);
+            QGeoPositionInfo info;
+            count = 0;
+            while (reader.readNext(&info))
+                ++count;
+        }
+        QCOMPARE(count, 20000);
+    }
 };
 
 #include "tst_qnmeapositioninfosource_simulation.moc"
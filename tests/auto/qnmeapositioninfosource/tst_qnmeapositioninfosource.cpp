@@ -417,16 +417,29 @@ void tst_QNmeaPositionInfoSource::startUpdates_waitForValidDateTime_data()
             << (QList<bool>() << true)
             << (QList<bool>() << false);
 
-    // Feed ZDA,GGA,GSA,GGA; expect vertical accuracy from second GGA.
+    // Feed ZDA,GGA,GSA,GGA; expect vertical accuracy from the GSA following the first GGA,
+    // which belongs to the same fix, and carried over to the second GGA.
     bytes.clear();
     bytes += QLocationTestUtils::createZdaSentence(dt.addSecs(1)).toLatin1();
     bytes += QLocationTestUtils::createGgaSentence(dt.addSecs(2).time()).toLatin1();
     bytes += QLocationTestUtils::createGsaSentence().toLatin1();
     bytes += QLocationTestUtils::createGgaSentence(dt.addSecs(3).time()).toLatin1();
-    QTest::newRow("Feed ZDA,GGA,GSA,GGA; expect vertical accuracy from second GGA")
+    QTest::newRow("Feed ZDA,GGA,GSA,GGA; expect vertical accuracy from both GGA")
             << bytes << (QList<QDateTime>() << dt.addSecs(2) << dt.addSecs(3))
             << (QList<bool>() << true << true)
-            << (QList<bool>() << false << true);
+            << (QList<bool>() << true << true);
+
+    // Feed RMC, then GGA,RMC,GSA of one fix, then RMC; expect one update per fix
+    bytes.clear();
+    bytes += QLocationTestUtils::createRmcSentence(dt.addSecs(1)).toLatin1();
+    bytes += QLocationTestUtils::createGgaSentence(dt.addSecs(2).time()).toLatin1();
+    bytes += QLocationTestUtils::createRmcSentence(dt.addSecs(2)).toLatin1();
+    bytes += QLocationTestUtils::createGsaSentence().toLatin1();
+    bytes += QLocationTestUtils::createRmcSentence(dt.addSecs(3)).toLatin1();
+    QTest::newRow("Feed RMC,GGA,RMC,GSA,RMC; expect the GGA,RMC,GSA of one fix merged")
+            << bytes << (QList<QDateTime>() << dt.addSecs(1) << dt.addSecs(2) << dt.addSecs(3))
+            << (QList<bool>() << false << true << true)
+            << (QList<bool>() << false << true << true);
 
     if (m_mode == QNmeaPositionInfoSource::SimulationMode) {
         // In sim m_mode, should ignore sentence with a date/time before the known date/time
@@ -442,6 +455,38 @@ void tst_QNmeaPositionInfoSource::startUpdates_waitForValidDateTime_data()
     }
 }
 
+void tst_QNmeaPositionInfoSource::startUpdates_epochAcrossReads()
+{
+    // The sentences of one fix may arrive in more than one read; they are
+    // still emitted as one update, and only once.
+    if (m_mode != QNmeaPositionInfoSource::RealTimeMode)
+        QSKIP("The device is read as it arrives in real time mode only");
+
+    QNmeaPositionInfoSource source(m_mode);
+    source.setUserEquivalentRangeError(5.1);
+    QNmeaPositionInfoSourceProxyFactory factory;
+    QNmeaPositionInfoSourceProxy *proxy = static_cast<QNmeaPositionInfoSourceProxy*>(factory.createProxy(&source));
+
+    QSignalSpy spy(proxy->source(), SIGNAL(positionUpdated(QGeoPositionInfo)));
+    proxy->source()->startUpdates();
+
+    QDateTime dt = QDateTime::currentDateTime().toUTC();
+    proxy->feedBytes(QLocationTestUtils::createRmcSentence(dt).toLatin1());
+    QTest::qWait(10);
+    QCOMPARE(spy.count(), 0);
+    proxy->feedBytes(QLocationTestUtils::createGgaSentence(dt.time()).toLatin1()
+                     + QLocationTestUtils::createGsaSentence().toLatin1());
+
+    QTRY_COMPARE(spy.count(), 1);
+    QTest::qWait(300);
+    QCOMPARE(spy.count(), 1);
+
+    QGeoPositionInfo info = spy[0][0].value<QGeoPositionInfo>();
+    QCOMPARE(info.timestamp(), dt);
+    QVERIFY(info.hasAttribute(QGeoPositionInfo::HorizontalAccuracy));
+    QVERIFY(info.hasAttribute(QGeoPositionInfo::VerticalAccuracy));
+}
+
 void tst_QNmeaPositionInfoSource::requestUpdate_waitForValidDateTime()
 {
     QFETCH(QByteArray, bytes);
@@ -107,6 +107,8 @@ private slots:
     void startUpdates_waitForValidDateTime();
     void startUpdates_waitForValidDateTime_data();
 
+    void startUpdates_epochAcrossReads();
+
     void requestUpdate_waitForValidDateTime();
     void requestUpdate_waitForValidDateTime_data();
 